@@ -267,6 +267,10 @@ public:
 
     virtual void writeData(const uint8_t* data, uint32_t bytes) override 
     {
+#ifdef ARDUINO_ARCH_RP2040
+        // The RP2040 core can transfer a buffer without overwriting it with the received data
+        SPI.transfer(data, nullptr, bytes);
+#else
         // TODO: Use SPI driver which accepts const uint8_t pointer.
         // The Arduino transfer() method saves the received data in the given buffer, which then
         // destoryes texture memory and so on (when using a const_cast). To avoid that, copy
@@ -275,6 +279,7 @@ public:
         uint8_t bla[2048];
         memcpy(bla, data, bytes);
         SPI.transfer((void*)bla, bytes);
+#endif
     }
 
     virtual bool clearToSend() override 
@@ -282,7 +287,34 @@ public:
         return digitalRead(CMD_CTS);
     }
 
-    virtual void startColorBufferTransfer(const uint8_t) override {
+#ifdef ARDUINO_ARCH_RP2040
+    virtual void submitData(const DataDescriptor* descriptors, const uint32_t count) override
+    {
+        m_chain = descriptors;
+        m_chainLength = count;
+        m_chainIndex = 0;
+        m_transferRunning = false;
+        transferComplete();
+    }
+
+    virtual bool transferComplete() override
+    {
+        // Every chunk is transferred via DMA. The CPU is only required to start the next chunk
+        // when the last one is finished and the RasteriCEr is clear to send.
+        if (m_transferRunning && SPI.finishedAsync())
+        {
+            m_transferRunning = false;
+            m_chainIndex++;
+        }
+        if (!m_transferRunning && (m_chainIndex < m_chainLength) && clearToSend())
+        {
+            m_transferRunning = SPI.transferAsync(m_chain[m_chainIndex].data, nullptr, m_chain[m_chainIndex].bytes);
+        }
+        return m_chainIndex == m_chainLength;
+    }
+#endif
+
+    virtual void startColorBufferTransfer(const uint8_t, const Window&) override {
         // Nothing to do here, data is automatically streamed to the display
     }
 
@@ -333,6 +365,14 @@ public:
     {
         digitalWrite(CMD_TFT_MUX, select);
     }
+
+private:
+#ifdef ARDUINO_ARCH_RP2040
+    const DataDescriptor* m_chain = nullptr;
+    uint32_t m_chainLength = 0;
+    uint32_t m_chainIndex = 0;
+    bool m_transferRunning = false;
+#endif
 };
 
 // Instantiate the BusConnector
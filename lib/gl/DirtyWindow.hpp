@@ -0,0 +1,93 @@
+// RasteriCEr
+// https://github.com/ToNi3141/RasteriCEr
+// Copyright (c) 2021 ToNi3141
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DIRTYWINDOW_HPP
+#define DIRTYWINDOW_HPP
+
+#include <stdint.h>
+#include "IBusConnector.hpp"
+#include "Rasterizer.hpp"
+
+// Collects the area of a display line which is changed by a frame (see RENDERER_DIRTY_WINDOW in the Renderer).
+// The area is the union of the bounding boxes of the triangles in the display line. A memset of the color buffer
+// changes the whole display line. The window uses the orientation of the frame buffer stream (see IBusConnector::Window),
+// which is upside down compared to the orientation of the rasterizer.
+template <uint16_t LINE_RESOLUTION>
+class DirtyWindow
+{
+public:
+    // Window which covers the whole display line
+    static constexpr IBusConnector::Window FULL_LINE { 0, UINT16_MAX, 0, LINE_RESOLUTION - 1 };
+
+    DirtyWindow()
+    {
+        clear();
+    }
+
+    /// @brief Resets the window to an empty area
+    void clear()
+    {
+        m_window = { UINT16_MAX, 0, UINT16_MAX, 0 };
+    }
+
+    /// @brief Marks the whole display line as changed
+    void addLine()
+    {
+        m_window = FULL_LINE;
+    }
+
+    /// @brief Adds the bounding box of a triangle to the window
+    /// @param triangle The triangle, already moved into the display line (see Rasterizer::calcLineIncrement())
+    void addTriangle(const Rasterizer::TriangleDescriptor& triangle)
+    {
+        // The bounding box of the first display line is not clamped to the display line (see calcLineIncrement())
+        const uint16_t bbEndY = (triangle.bbEndY < LINE_RESOLUTION) ? triangle.bbEndY : LINE_RESOLUTION;
+        if ((triangle.bbStartX >= triangle.bbEndX) || (triangle.bbStartY >= bbEndY))
+        {
+            return;
+        }
+        // The end of the bounding box is exclusive, the end of the window inclusive
+        const IBusConnector::Window bb { triangle.bbStartX,
+                                         static_cast<uint16_t>(triangle.bbEndX - 1),
+                                         static_cast<uint16_t>(LINE_RESOLUTION - bbEndY),
+                                         static_cast<uint16_t>(LINE_RESOLUTION - 1 - triangle.bbStartY) };
+        if (bb.xStart < m_window.xStart) m_window.xStart = bb.xStart;
+        if (bb.xEnd > m_window.xEnd) m_window.xEnd = bb.xEnd;
+        if (bb.yStart < m_window.yStart) m_window.yStart = bb.yStart;
+        if (bb.yEnd > m_window.yEnd) m_window.yEnd = bb.yEnd;
+    }
+
+    /// @brief Returns if nothing was changed in the display line
+    bool empty() const
+    {
+        return m_window.xStart > m_window.xEnd;
+    }
+
+    /// @brief Returns the window. Only valid if the window is not empty.
+    const IBusConnector::Window& get() const
+    {
+        return m_window;
+    }
+
+private:
+    IBusConnector::Window m_window;
+};
+
+template <uint16_t LINE_RESOLUTION>
+constexpr IBusConnector::Window DirtyWindow<LINE_RESOLUTION>::FULL_LINE;
+
+#endif // DIRTYWINDOW_HPP
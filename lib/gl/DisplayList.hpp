@@ -19,6 +19,9 @@
 #define DISPLAYLIST_HPP
 
 #include <stdint.h>
+#ifdef RENDERER_THREADED
+#include <atomic>
+#endif
 
 template <uint32_t DISPLAY_LIST_SIZE, uint8_t ALIGNMENT>
 class DisplayList {
@@ -45,6 +48,18 @@ public:
         return nullptr;
     }
 
+    // Allocates a block of memory for already prepared commands. The size must be a multiple of the ALIGNMENT.
+    uint8_t* createBlock(const uint32_t size)
+    {
+        if ((size + consumedMemory) <= DISPLAY_LIST_SIZE)
+        {
+            uint8_t* memPlace = &mem[consumedMemory];
+            consumedMemory += size;
+            return memPlace;
+        }
+        return nullptr;
+    }
+
     template <typename GET_TYPE>
     void remove()
     {
@@ -64,8 +79,8 @@ public:
 
     void clear()
     {
-        listState = State::IDLE;
         consumedMemory = 0;
+        setState(State::IDLE);
     }
 
     const uint8_t* getMemPtr() const
@@ -85,17 +100,21 @@ public:
 
     State state() const
     {
+#ifdef RENDERER_THREADED
+        return listState.load(std::memory_order_acquire);
+#else
         return listState;
+#endif
     }
 
     void enqueue()
     {
-        listState = State::QUEUED;
+        setState(State::QUEUED);
     }
 
     void transfer()
     {
-        listState = State::TRANSFERRING;
+        setState(State::TRANSFERRING);
     }
 
     // Interface for reading the display list
@@ -134,9 +153,35 @@ public:
         getPos = 0;
     }
 
+    // The read position can be saved and restored to look ahead several entries
+    uint32_t getGetPos() const
+    {
+        return getPos;
+    }
+
+    void setGetPos(const uint32_t pos)
+    {
+        getPos = pos;
+    }
+
 private:
+    void setState(const State state)
+    {
+#ifdef RENDERER_THREADED
+        listState.store(state, std::memory_order_release);
+#else
+        listState = state;
+#endif
+    }
+
     uint8_t mem[DISPLAY_LIST_SIZE];
+#ifdef RENDERER_THREADED
+    // The state is the handshake between the thread which fills the list and the thread which uploads it. The content
+    // of the list is published with the state change, therefore it must be the last write.
+    std::atomic<State> listState{State::IDLE};
+#else
     State listState = State::IDLE;
+#endif
     uint32_t consumedMemory = 0;
     uint32_t getPos = 0;
 };
@@ -32,9 +32,61 @@ public:
     /// @return true if the FIFO is empty
     virtual bool clearToSend() = 0;
 
+    /// @brief Area of a display line in pixels. The origin is the first pixel of the frame buffer stream of the display
+    /// line (upper left corner), the end positions are inclusive. The x end can exceed the width of the display line.
+    struct Window
+    {
+        uint16_t xStart;
+        uint16_t xEnd;
+        uint16_t yStart;
+        uint16_t yEnd;
+    };
+
     /// @brief Will start a dma transfer from the internal buffer to an external memory
     /// @param index The index of the frame buffer line which has to be transferred
-    virtual void startColorBufferTransfer(const uint8_t index) = 0;
+    /// @param window The area of the display line which was changed. It covers the whole display line, except the
+    /// renderer is build with RENDERER_DIRTY_WINDOW. Then display lines without changes are not transferred at all.
+    virtual void startColorBufferTransfer(const uint8_t index, const Window& window) = 0;
+
+    /// @brief Describes a chunk of data which has to be transferred
+    struct DataDescriptor
+    {
+        const uint8_t* data;
+        uint32_t bytes;
+    };
+
+    /// @brief Submits a chain of chunks which are asynchronously transferred to the target. Every chunk has to wait till
+    /// the target signals that it is clear to send. The descriptors and the data they are pointing to must be valid till
+    /// transferComplete() returns true. A new chain is only submitted after the previous one completed.
+    /// The default implementation emulates this with writeData() and clearToSend(): It transfers one chunk every time
+    /// the target is clear to send and is driven by transferComplete(). A connector with a (scatter/gather) DMA should
+    /// override this method and transferComplete() to offload the transfer from the CPU.
+    /// @param descriptors The chain of chunks
+    /// @param count The number of descriptors in the chain
+    virtual void submitData(const DataDescriptor* descriptors, const uint32_t count)
+    {
+        m_descriptors = descriptors;
+        m_descriptorCount = count;
+        m_descriptorIndex = 0;
+        transferComplete();
+    }
+
+    /// @brief Signals if the last chain submitted with submitData() is completely transferred (fence)
+    /// @return true if all chunks are transferred and the memory of the chain can be reused
+    virtual bool transferComplete()
+    {
+        while ((m_descriptorIndex < m_descriptorCount) && clearToSend())
+        {
+            writeData(m_descriptors[m_descriptorIndex].data, m_descriptors[m_descriptorIndex].bytes);
+            m_descriptorIndex++;
+        }
+        return m_descriptorIndex == m_descriptorCount;
+    }
+
+private:
+    const DataDescriptor* m_descriptors = nullptr;
+    uint32_t m_descriptorCount = 0;
+    uint32_t m_descriptorIndex = 0;
 };
 
 #endif // IBUSCONNECTOR_HPP
@@ -23,7 +23,9 @@
 #include <array>
 #include <utility>
 #include <memory>
+#include <vector>
 #include "Vec.hpp"
+#include "Statistics.hpp"
 
 class IRenderer
 {
@@ -95,35 +97,97 @@ public:
         REPEAT,
         CLAMP_TO_EDGE
     };
+    enum TextureFormat : uint8_t
+    {
+        RGBA4444, // 16 bit per texel
+        PALETTE4_RGBA4444 // 4 bit index per texel into a palette with PALETTE4_SIZE RGBA4444 colors
+    };
+
+    // Number of colors of a PALETTE4_RGBA4444 texture
+    static constexpr uint16_t PALETTE4_SIZE = 16;
+
+#ifdef TNL_FIX_POINT
+    // The fix point TnL delivers the vertices already in the fix point formats of the rasterizer
+    // (see Rasterizer::SCREEN_COORD_DECIMALS, Rasterizer::DEPTH_W_DECIMALS and Rasterizer::TEX_COORD_DECIMALS)
+    using Vertex = Vec4i;
+    using TexCoord = Vec2i;
+#else
+    using Vertex = Vec4;
+    using TexCoord = Vec2;
+#endif
 
     /// @brief Will render a triangle which is constructed with the given parameters
     /// TODO: Document ranges, the vectors should be in screen coordinates, textures should be in the range of 0..1.0
     /// color 0..255
     /// @return true if the triangle was rendered, otherwise the display list was full and the triangle can't be added
-    virtual bool drawTriangle(const Vec4& v0,
-                              const Vec4& v1,
-                              const Vec4& v2,
-                              const Vec2& st0,
-                              const Vec2& st1,
-                              const Vec2& st2,
+    virtual bool drawTriangle(const Vertex& v0,
+                              const Vertex& v1,
+                              const Vertex& v2,
+                              const TexCoord& st0,
+                              const TexCoord& st1,
+                              const TexCoord& st2,
                               const Vec4i& color) = 0;
 
+    /// @brief Starts the recording of triangles. All triangles which are added with drawTriangle() are additionally
+    /// appended (already rasterized) to the buffer, until the recording is stopped. The recorded triangles are
+    /// only valid for the same viewport.
+    /// @param buffer The buffer for the recorded triangles. nullptr stops the recording.
+    virtual void recordTriangles(std::vector<uint8_t>* buffer) = 0;
+
+    /// @brief Adds triangles which were recorded with recordTriangles() without rasterizing them again.
+    /// They are drawn with the current configuration (textures, blend function, depth test and so on).
+    /// @param buffer The recorded triangles
+    /// @return true if succeeded, false if the display list is full
+    virtual bool drawRecordedTriangles(const std::vector<uint8_t>& buffer) = 0;
+
     /// @brief Will send a picture from working buffers, caches or whatever to the buffer which is
     ///    read from the display
     virtual void commit() = 0;
 
+    /// @brief Same as commit(), but it does not block when the renderer is still busy with previous frames
+    /// @return true if the frame was committed. false if the renderer is busy, then nothing is changed and
+    ///    tryCommit() has to be called again later. No geometry should be added until the frame is committed.
+    virtual bool tryCommit() = 0;
+
+    /// @brief Returns the counters of the renderer which were collected until the last commit(). The counters are only
+    ///    collected with ICEGL_STATISTICS (see Statistics.hpp).
+    /// @param stats The renderer and upload counters of stats are set
+    virtual void getFrameStats(FrameStats& stats) const = 0;
+
     /// @brief Creates a new texture 
     /// @return pair with the first value to indicate if the operation succeeded (true) and the second value with the id
     virtual std::pair<bool, uint16_t> createTexture() = 0;
 
     /// @brief This will update the texture data of the texture with the given id
     /// @param texId The texture id which texture has to be updated
-    /// @param pixels The texture as RGBA4444
+    /// @param pixels The texture as RGBA4444. For PALETTE4_RGBA4444 the texture starts with the PALETTE4_SIZE colors of the
+    ///    palette (RGBA4444) followed by the indices. Four indices are packed in one uint16_t, the first index is in the lowest nibble.
     /// @param texWidth The width of the texture
     /// @param texHeight The height of the texture
+    /// @param format The format of pixels
     /// @return true if succeeded, false if it was not possible to apply this command (for instance, displaylist was out if memory)
-    virtual bool updateTexture(const uint16_t texId, std::shared_ptr<const uint16_t> pixels, const uint16_t texWidth, const uint16_t texHeight) = 0;
-    
+    virtual bool updateTexture(const uint16_t texId,
+                               std::shared_ptr<const uint16_t> pixels,
+                               const uint16_t texWidth,
+                               const uint16_t texHeight,
+                               const TextureFormat format) = 0;
+
+    /// @brief Updates a mip level of a texture. The renderer selects for every triangle the level which fits best to
+    ///    the size of the triangle on the screen. Only consecutive levels starting at level 1 are used.
+    /// @param texId The texture id which texture has to be updated. Level 0 must already be set with updateTexture().
+    /// @param level The mip level, starting at 1
+    /// @param pixels The texture, same layout as in updateTexture()
+    /// @param texWidth The width of the level. Must be the width of level 0 >> level and at least 32.
+    /// @param texHeight The height of the level
+    /// @param format The format of pixels. Must be the format of level 0.
+    /// @return true if succeeded
+    virtual bool updateTextureLevel(const uint16_t texId,
+                                    const uint8_t level,
+                                    std::shared_ptr<const uint16_t> pixels,
+                                    const uint16_t texWidth,
+                                    const uint16_t texHeight,
+                                    const TextureFormat format) = 0;
+
     /// @brief Activates a texture which then is used for rendering
     /// @param texId The id of the texture to use
     /// @return true if succeeded, false if it was not possible to apply this command (for instance, displaylist was out if memory)
@@ -216,6 +280,21 @@ public:
     /// @return true if succeeded
     virtual bool setTextureWrapModeT(const TextureWrapMode mode) = 0;
 
+    /// @brief Sets the viewport. Triangles are only rasterized within the viewport. This is required,
+    /// because the TnL doesn't clip triangles against the edges of the viewport when a guard band is used.
+    /// @param x The start of the viewport in x direction (lower left corner)
+    /// @param y The start of the viewport in y direction (lower left corner)
+    /// @param width The width of the viewport in pixels
+    /// @param height The height of the viewport in pixels
+    /// @return true if succeeded
+    virtual bool setViewport(const int16_t x, const int16_t y, const int16_t width, const int16_t height) = 0;
+
+    /// @brief Hints that the application overwrites every pixel of the color buffer in every frame, for instance
+    /// with a sky box. clear() does then not clear the color buffer, which saves the memset on every display line.
+    /// When the hint is set and not every pixel is written, the pixels of the previous frames remain on the screen.
+    /// @param covered true if every pixel of the color buffer is overwritten
+    virtual void setFrameCoveredHint(const bool covered) = 0;
+
 };
 
 #endif // IRENDERER_HPP
@@ -50,6 +50,35 @@ IceGL::IceGL(IRenderer &renderer)
 void IceGL::commit()
 {
     m_renderer.commit();
+    m_tnl.commitStatistics();
+}
+
+bool IceGL::tryCommit()
+{
+    if (m_renderer.tryCommit())
+    {
+        m_tnl.commitStatistics();
+        return true;
+    }
+    return false;
+}
+
+uint32_t IceGL::getNumberOfCulledTriangles() const
+{
+    return m_tnl.getNumberOfCulledTriangles();
+}
+
+FrameStats IceGL::getFrameStats() const
+{
+    FrameStats stats;
+    stats.tnl = m_tnl.getStatistics();
+    m_renderer.getFrameStats(stats);
+    return stats;
+}
+
+void IceGL::setFrameCoveredHint(const bool covered)
+{
+    m_renderer.setFrameCoveredHint(covered);
 }
 
 void IceGL::glMatrixMode(GLenum mm)
@@ -60,16 +89,23 @@ void IceGL::glMatrixMode(GLenum mm)
 void IceGL::glMultMatrixf(const GLfloat* m)
 {
     const Mat44 *m44 = reinterpret_cast<const Mat44*>(m);
+    const bool affine = (m[3] == 0.0f) && (m[7] == 0.0f) && (m[11] == 0.0f) && (m[15] == 1.0f);
+    multMatrix(*m44, affine ? MatrixKind::AFFINE : MatrixKind::GENERAL);
+}
+
+void IceGL::multMatrix(const Mat44& m, const MatrixKind kind)
+{
     if (matrixMode == GL_MODELVIEW)
     {
-        m_m = *m44 * m_m;
+        m_m = m * m_m;
+        m_mKind = (kind > m_mKind) ? kind : m_mKind;
+        m_modelMatrixOutdated = true;
     }
     else
     {
-        m_p = *m44 * m_p;
+        m_p = m * m_p;
+        m_projectionMatrixOutdated = true;
     }
-
-    m_matricesOutdated = true;
 }
 
 void IceGL::glMultMatrixd(const GLdouble* m)
@@ -89,8 +125,7 @@ void IceGL::glTranslatef(GLfloat x, GLfloat y, GLfloat z)
     m[3][0] = x;
     m[3][1] = y;
     m[3][2] = z;
-    glMultMatrixf(&m[0][0]);
-    m_matricesOutdated = true;
+    multMatrix(m, MatrixKind::TRANSLATION);
 }
 
 void IceGL::glScalef(GLfloat x, GLfloat y, GLfloat z)
@@ -100,8 +135,7 @@ void IceGL::glScalef(GLfloat x, GLfloat y, GLfloat z)
     m[0][0] = x;
     m[1][1] = y;
     m[2][2] = z;
-    glMultMatrixf(&m[0][0]);
-    m_matricesOutdated = true;
+    multMatrix(m, MatrixKind::AFFINE);
 }
 
 void IceGL::glRotatef(GLfloat angle, GLfloat x, GLfloat y, GLfloat z)
@@ -120,8 +154,10 @@ void IceGL::glRotatef(GLfloat angle, GLfloat x, GLfloat y, GLfloat z)
                 {0.0f,      0.0f,       0.0f,       1.0f}
             }}};
 
-    glMultMatrixf(&m[0][0]);
-    m_matricesOutdated = true;
+    // The matrix is only a pure rotation when the axis is a unit vector
+    const float axisLength = (x * x) + (y * y) + (z * z);
+    const bool unitAxis = fabsf(axisLength - 1.0f) < 0.0001f;
+    multMatrix(m, unitAxis ? MatrixKind::RIGID : MatrixKind::AFFINE);
 }
 
 void IceGL::glLoadIdentity()
@@ -129,12 +165,14 @@ void IceGL::glLoadIdentity()
     if (matrixMode == GL_MODELVIEW)
     {
         m_m.identity();
+        m_mKind = MatrixKind::IDENTITY;
+        m_modelMatrixOutdated = true;
     }
     else
     {
         m_p.identity();
+        m_projectionMatrixOutdated = true;
     }
-    m_matricesOutdated = true;
 }
 
 void IceGL::gluPerspective(GLfloat fovy, GLfloat aspect, GLfloat zNear, GLfloat zFar)
@@ -195,7 +233,7 @@ void IceGL::gluLookAt(GLfloat eyex, GLfloat eyey, GLfloat eyez, GLfloat centerx,
     m[1][2] = -forward[1];
     m[2][2] = -forward[2];
 
-    glMultMatrixf(&m[0][0]);
+    multMatrix(m, MatrixKind::RIGID);
     glTranslatef(-eyex, -eyey, -eyez);
 }
 
@@ -213,6 +251,7 @@ void IceGL::glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
     // 480 x 272. The view port transformation would go from 0 to 480 which are then 481px. Thats the reason why we
     // decrement here the resolution by one.
     m_tnl.setViewport(x, y, width, height);
+    m_renderer.setViewport(x, y, width, height);
 }
 
 void IceGL::glDepthRange(GLclampd zNear, GLclampd zFar)
@@ -233,10 +272,14 @@ void IceGL::glBegin(GLenum mode)
             || (mode == GL_TRIANGLE_STRIP))
     {
         m_beginMode = mode;
-        m_textureVertexBuffer.clear();
-        m_vertexBuffer.clear();
-        m_normalVertexBuffer.clear();
-        m_colorVertexBuffer.clear();
+        m_immediateVertexCount = 0;
+        // The matrices can't be changed between glBegin() and glEnd(), therefore the triangles can be directly
+        // transformed when they are complete
+        recalculateAndSetTnLMatrices();
+        if (m_currentList)
+        {
+            m_currentList->draws.emplace_back();
+        }
         m_error = GL_NO_ERROR;
     }
     else
@@ -247,101 +290,61 @@ void IceGL::glBegin(GLenum mode)
 
 void IceGL::glEnd()
 {
-    recalculateAndSetTnLMatrices();
+    // The triangles are already drawn in glVertex3f(). Incomplete triangles are discarded.
+    m_immediateVertexCount = 0;
+}
+
+void IceGL::glTexCoord2f(GLfloat s, GLfloat t)
+{
+    m_textureCoord = {s, t};
+    m_error = GL_NO_ERROR;
+}
+
+void IceGL::glVertex3f(GLfloat x, GLfloat y, GLfloat z)
+{
+    // The vertices are stored in a ring of three vertices. A triangle is drawn as soon as it is complete.
+    const uint32_t n = m_immediateVertexCount;
+    uint32_t slot = n % m_immediateVertices.size();
+    if (m_beginMode == GL_TRIANGLE_FAN)
+    {
+        // The first vertex stays in slot 0, the others alternate between slot 1 and 2
+        slot = (n == 0) ? 0 : (1 + ((n - 1) & 0x1));
+    }
+    m_immediateVertices[slot] = {{{x, y, z, 1.0f}}, m_textureCoord, m_normal, m_vertexColor};
+    m_immediateVertexCount++;
+
+    if (n < 2)
+    {
+        return;
+    }
+
     if (m_beginMode == GL_TRIANGLES)
     {
-        for (uint32_t i = 0; i < m_vertexBuffer.size() - 2; i += 3)
+        if (slot == 2)
         {
-            m_tnl.drawTriangle(m_renderer,
-            {m_vertexBuffer[i],
-             m_vertexBuffer[i + 1],
-             m_vertexBuffer[i + 2],
-             m_textureVertexBuffer[i],
-             m_textureVertexBuffer[i + 1],
-             m_textureVertexBuffer[i + 2],
-             m_normalVertexBuffer[i],
-             m_normalVertexBuffer[i + 1],
-             m_normalVertexBuffer[i + 2],
-             m_colorVertexBuffer[i],
-             m_colorVertexBuffer[i + 1],
-             m_colorVertexBuffer[i + 2]});
+            drawImmediateTriangle(m_immediateVertices[0], m_immediateVertices[1], m_immediateVertices[2]);
         }
     }
-    if (m_beginMode == GL_TRIANGLE_FAN)
+    else if (m_beginMode == GL_TRIANGLE_FAN)
     {
-        for (uint32_t i = 0; i < m_vertexBuffer.size() - 2; i++)
-        {
-            m_tnl.drawTriangle(m_renderer,
-            {m_vertexBuffer[0],
-             m_vertexBuffer[i + 1],
-             m_vertexBuffer[i + 2],
-             m_textureVertexBuffer[0],
-             m_textureVertexBuffer[i + 1],
-             m_textureVertexBuffer[i + 2],
-             m_normalVertexBuffer[0],
-             m_normalVertexBuffer[i + 1],
-             m_normalVertexBuffer[i + 2],
-             m_colorVertexBuffer[0],
-             m_colorVertexBuffer[i + 1],
-             m_colorVertexBuffer[i + 2]});
-        }
+        drawImmediateTriangle(m_immediateVertices[0], m_immediateVertices[3 - slot], m_immediateVertices[slot]);
     }
-
-    if (m_beginMode == GL_TRIANGLE_STRIP)
+    else if (m_beginMode == GL_TRIANGLE_STRIP)
     {
-        for (uint32_t i = 0; i < m_vertexBuffer.size() - 2; i++)
+        // Every second triangle is flipped to keep the winding of the strip
+        const ImmediateVertex& v0 = m_immediateVertices[(n - 2) % m_immediateVertices.size()];
+        const ImmediateVertex& v1 = m_immediateVertices[(n - 1) % m_immediateVertices.size()];
+        if (n & 0x1)
         {
-            if (i & 0x1)
-            {
-                m_tnl.drawTriangle(m_renderer,
-                {m_vertexBuffer[i + 1],
-                 m_vertexBuffer[i],
-                 m_vertexBuffer[i + 2],
-                 m_textureVertexBuffer[i + 1],
-                 m_textureVertexBuffer[i],
-                 m_textureVertexBuffer[i + 2],
-                 m_normalVertexBuffer[i + 1],
-                 m_normalVertexBuffer[i],
-                 m_normalVertexBuffer[i + 2],
-                 m_colorVertexBuffer[i + 1],
-                 m_colorVertexBuffer[i],
-                 m_colorVertexBuffer[i + 2]});
-            }
-            else
-            {
-                m_tnl.drawTriangle(m_renderer,
-                {m_vertexBuffer[i],
-                 m_vertexBuffer[i + 1],
-                 m_vertexBuffer[i + 2],
-                 m_textureVertexBuffer[i],
-                 m_textureVertexBuffer[i + 1],
-                 m_textureVertexBuffer[i + 2],
-                 m_normalVertexBuffer[i],
-                 m_normalVertexBuffer[i + 1],
-                 m_normalVertexBuffer[i + 2],
-                 m_colorVertexBuffer[i],
-                 m_colorVertexBuffer[i + 1],
-                 m_colorVertexBuffer[i + 2]});
-            }
-
+            drawImmediateTriangle(v1, v0, m_immediateVertices[slot]);
+        }
+        else
+        {
+            drawImmediateTriangle(v0, v1, m_immediateVertices[slot]);
         }
     }
 }
 
-void IceGL::glTexCoord2f(GLfloat s, GLfloat t)
-{
-    m_textureCoord = {s, t};
-    m_error = GL_NO_ERROR;
-}
-
-void IceGL::glVertex3f(GLfloat x, GLfloat y, GLfloat z)
-{
-    m_vertexBuffer.push_back({{x, y, z, 1.0f}});
-    m_normalVertexBuffer.push_back(m_normal);
-    m_textureVertexBuffer.push_back(m_textureCoord);
-    m_colorVertexBuffer.push_back(m_vertexColor);
-}
-
 void IceGL::glNormal3f(GLfloat nx, GLfloat ny, GLfloat nz)
 {
     m_normal = {nx, ny, nz};
@@ -394,7 +397,53 @@ void IceGL::glColor4fv(const GLfloat *v)
 void IceGL::glTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid *pixels)
 {
     (void)internalformat; // Currently only RGBA4444 is supported, all unsupported formats are converted to RGBA4444
-    m_error = GL_NO_ERROR;
+    m_error = checkTexImage2D(target, level, width, height, border, format, type);
+    if (m_error != GL_NO_ERROR)
+    {
+        return;
+    }
+
+    if (pixels == nullptr)
+    {
+        m_error = GL_INVALID_VALUE;
+        return;
+    }
+
+    std::shared_ptr<uint16_t> texMemShared(new uint16_t[(width * height)], [] (const uint16_t *p) { delete [] p; });
+    if (!texMemShared)
+    {
+        m_error = GL_OUT_OF_MEMORY;
+        return;
+    }
+
+    convertTexture(texMemShared.get(), pixels, width * height, format, type);
+    updateBoundTexture(target, level, texMemShared, width, height, IRenderer::RGBA4444);
+}
+
+void IceGL::texImage2DInPlace(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, GLvoid *pixels)
+{
+    (void)internalformat; // Currently only RGBA4444 is supported, all unsupported formats are converted to RGBA4444
+    m_error = checkTexImage2D(target, level, width, height, border, format, type);
+    if (m_error != GL_NO_ERROR)
+    {
+        return;
+    }
+
+    if ((pixels == nullptr) || (reinterpret_cast<uintptr_t>(pixels) % alignof(uint16_t)))
+    {
+        m_error = GL_INVALID_VALUE;
+        return;
+    }
+
+    // All supported formats have at least 16 bit per texel. Because of that, the converted texel never overwrites
+    // texels which are not converted yet.
+    uint16_t* texMem = reinterpret_cast<uint16_t*>(pixels);
+    convertTexture(texMem, pixels, width * height, format, type);
+    updateBoundTexture(target, level, std::shared_ptr<uint16_t>(texMem, [] (const uint16_t *) { }), width, height, IRenderer::RGBA4444);
+}
+
+GLint IceGL::checkTexImage2D(GLenum target, GLint level, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type)
+{
     if (target != GL_TEXTURE_2D
             || !(format == GL_ALPHA
                  || format == GL_RGB
@@ -406,110 +455,267 @@ void IceGL::glTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsi
                  || type == GL_UNSIGNED_SHORT_5_5_5_1
                  || type == GL_UNSIGNED_SHORT_5_6_5))
     {
-        m_error = GL_INVALID_ENUM;
-        return;
+        return GL_INVALID_ENUM;
     }
 
-    if (/*level < 0
-                    || !(level & GL_TEXTURE_SUPPORTED_SIZES)*/ // Level is rightnow not supported
-            !(width & GL_TEXTURE_SUPPORTED_SIZES)
+    if (level < 0
+            || level > 2 // A texture has at most three levels (128px down to 32px), the size of a level is checked by the renderer
+            || !(width & GL_TEXTURE_SUPPORTED_SIZES)
             || !(height & GL_TEXTURE_SUPPORTED_SIZES)
             || border != 0) // In OpenGL ES 1.1 it has to be 0. What does border mean: //https://stackoverflow.com/questions/913801/what-does-border-mean-in-the-glteximage2d-function
     {
-        m_error = GL_INVALID_VALUE;
-        return;
+        return GL_INVALID_VALUE;
     }
 
     if (((type == GL_UNSIGNED_SHORT_5_6_5) && (format != GL_RGB))
             || (((type == GL_UNSIGNED_SHORT_4_4_4_4) || (type == GL_UNSIGNED_SHORT_5_5_5_1)) && (format != GL_RGBA)))
     {
-        m_error = GL_INVALID_OPERATION;
-        return;
+        return GL_INVALID_OPERATION;
     }
 
-    if (level != 0
-            || format == GL_ALPHA
+    if (format == GL_ALPHA
             || format == GL_LUMINANCE
             || format == GL_LUMINANCE_ALPHA
             || height != width) // Only square textures are supported
     {
-        m_error = GL_SPEC_DEVIATION;
-        return;
+        return GL_SPEC_DEVIATION;
     }
+    return GL_NO_ERROR;
+}
 
-    std::shared_ptr<uint16_t> texMemShared(new uint16_t[(width * height * 2)], [] (const uint16_t *p) { delete [] p; });
-    if (!texMemShared)
+void IceGL::updateBoundTexture(GLenum target, GLint level, std::shared_ptr<const uint16_t> pixels, GLsizei width, GLsizei height, IRenderer::TextureFormat format)
+{
+    if (level == 0)
     {
-        m_error = GL_OUT_OF_MEMORY;
+        if (!m_renderer.updateTexture(m_boundTexture, pixels, width, height, format))
+        {
+            m_error = GL_INVALID_VALUE;
+            return;
+        }
+        if (isGenerateMipmapEnabled(m_boundTexture) && (format == IRenderer::RGBA4444))
+        {
+            generateMipmaps(pixels.get(), width);
+        }
+    }
+    else if (!m_renderer.updateTextureLevel(m_boundTexture, level, pixels, width, height, format))
+    {
+        // The size or the format does not match level 0, or the renderer does not support this level
+        m_error = GL_INVALID_VALUE;
         return;
     }
 
-    if (pixels != nullptr)
-    {
-        // Currently only GL_RGB and GL_RGBA is supported
-        const int32_t colorComponents = (format == GL_RGB) ? 3 : 4;
+    // Rebind texture to update the rasterizer with the new texture meta information
+    glBindTexture(target, m_boundTexture);
+}
 
-        // Convert color to RGBA4444
-        if (type == GL_UNSIGNED_BYTE)
-        {
-            uint16_t tmpColor = 0;
-            uint8_t shift = 12;
-            for (int32_t i = 0; i < width * height * colorComponents; i++)
-            {
-                tmpColor |= (reinterpret_cast<const uint8_t*>(pixels)[i] >> 4) << shift;
-                shift -= 4;
-                if ((i % colorComponents) == (colorComponents - 1))
-                {
-                    if (colorComponents == 3)
-                        tmpColor |= 0xf; // Set alpha to 0xf to make the texture opaque
-                    texMemShared.get()[i / colorComponents] = tmpColor;
-                    tmpColor = 0;
-                    shift = 12;
-                }
-            }
-        }
-        // This is the native format, just memcpy it.
-        else if (type == GL_UNSIGNED_SHORT_4_4_4_4)
+bool IceGL::isGenerateMipmapEnabled(const GLuint texture) const
+{
+    return (texture < m_generateMipmap.size()) && m_generateMipmap[texture];
+}
+
+void IceGL::generateMipmaps(const uint16_t* pixels, GLsizei width)
+{
+    // The renderer uses levels down to the smallest texture size
+    const uint16_t* src = pixels;
+    for (GLint level = 1; (width / 2) >= GL_TEXTURE_SIZE_32; level++)
+    {
+        width /= 2;
+        std::shared_ptr<uint16_t> texMemShared(new uint16_t[(width * width)], [] (const uint16_t *p) { delete [] p; });
+        if (!texMemShared)
         {
-            memcpy(texMemShared.get(), pixels, width * height * 2);
+            m_error = GL_OUT_OF_MEMORY;
+            return;
         }
-        // Convert to RGBA4444
-        else if (type == GL_UNSIGNED_SHORT_5_5_5_1)
+        downsampleRgba4444(texMemShared.get(), src, width);
+        if (!m_renderer.updateTextureLevel(m_boundTexture, level, texMemShared, width, width, IRenderer::RGBA4444))
         {
-            for (int32_t i = 0; i < width * height; i++)
-            {
-                uint16_t tmp = reinterpret_cast<const uint16_t*>(pixels)[i];
-                texMemShared.get()[i] = ((tmp << 1) & 0xf000)
-                        | ((tmp << 2) & 0x0f00)
-                        | ((tmp << 3) & 0x00f0)
-                        | ((tmp & 0x1) ? 0xf : 0x0);
-            }
+            // The renderer does not support more levels
+            return;
         }
-        else if (type == GL_UNSIGNED_SHORT_5_6_5)
+        src = texMemShared.get(); // Still owned by the renderer
+    }
+}
+
+void IceGL::downsampleRgba4444(uint16_t* dst, const uint16_t* src, const GLsizei dstWidth)
+{
+    const GLsizei srcWidth = dstWidth * 2;
+    for (GLsizei y = 0; y < dstWidth; y++)
+    {
+        const uint16_t* line0 = src + (y * 2 * srcWidth);
+        const uint16_t* line1 = line0 + srcWidth;
+        for (GLsizei x = 0; x < dstWidth; x++)
         {
-            for (int32_t i = 0; i < width * height; i++)
+            const uint16_t t00 = line0[x * 2];
+            const uint16_t t01 = line0[(x * 2) + 1];
+            const uint16_t t10 = line1[x * 2];
+            const uint16_t t11 = line1[(x * 2) + 1];
+            uint16_t texel = 0;
+            for (uint8_t shift = 0; shift < 16; shift += 4)
             {
-                uint16_t tmp = reinterpret_cast<const uint16_t*>(pixels)[i];
-                texMemShared.get()[i] = ((tmp << 1) & 0xf000)
-                        | ((tmp << 3) & 0x0f00)
-                        | ((tmp << 4) & 0x00f0)
-                        | 0x0;
+                const uint16_t sum = ((t00 >> shift) & 0xf) + ((t01 >> shift) & 0xf) + ((t10 >> shift) & 0xf) + ((t11 >> shift) & 0xf);
+                texel |= ((sum + 2) / 4) << shift;
             }
+            dst[(y * dstWidth) + x] = texel;
         }
+    }
+}
+
+void IceGL::convertTexture(uint16_t* dst, const GLvoid* src, const int32_t texels, GLenum format, GLenum type)
+{
+    // Currently only GL_RGB and GL_RGBA is supported
+    // The kernels are working on whole texels with a constant number of components and without branches,
+    // so that the compiler can unroll and vectorize them.
+    if (type == GL_UNSIGNED_BYTE)
+    {
+        if (format == GL_RGB)
+            convertUnsignedByteToRgba4444<3>(dst, reinterpret_cast<const uint8_t*>(src), texels);
+        else
+            convertUnsignedByteToRgba4444<4>(dst, reinterpret_cast<const uint8_t*>(src), texels);
+    }
+    // This is the native format, just memcpy it.
+    else if (type == GL_UNSIGNED_SHORT_4_4_4_4)
+    {
+        memmove(dst, src, texels * sizeof(uint16_t));
+    }
+    else if (type == GL_UNSIGNED_SHORT_5_5_5_1)
+    {
+        convertRgba5551ToRgba4444(dst, reinterpret_cast<const uint16_t*>(src), texels);
+    }
+    else if (type == GL_UNSIGNED_SHORT_5_6_5)
+    {
+        convertRgb565ToRgba4444(dst, reinterpret_cast<const uint16_t*>(src), texels);
+    }
+}
+
+template <uint8_t COMPONENTS>
+void IceGL::convertUnsignedByteToRgba4444(uint16_t* dst, const uint8_t* src, const int32_t texels)
+{
+    for (int32_t i = 0; i < texels; i++)
+    {
+        const uint8_t* texel = src + (i * COMPONENTS);
+        // Set alpha to 0xf to make the texture opaque when it has no alpha channel
+        const uint16_t alpha = (COMPONENTS == 4) ? (texel[COMPONENTS - 1] >> 4) : 0xf;
+        dst[i] = ((texel[0] & 0xf0) << 8)
+                | ((texel[1] & 0xf0) << 4)
+                | (texel[2] & 0xf0)
+                | alpha;
+    }
+}
+
+void IceGL::convertRgba5551ToRgba4444(uint16_t* dst, const uint16_t* src, const int32_t texels)
+{
+    for (int32_t i = 0; i < texels; i++)
+    {
+        const uint16_t tmp = src[i];
+        // Replicates the alpha bit into all four alpha bits
+        dst[i] = ((tmp << 1) & 0xf000)
+                | ((tmp << 2) & 0x0f00)
+                | ((tmp << 3) & 0x00f0)
+                | ((0 - (tmp & 0x1)) & 0x000f);
+    }
+}
+
+void IceGL::convertRgb565ToRgba4444(uint16_t* dst, const uint16_t* src, const int32_t texels)
+{
+    for (int32_t i = 0; i < texels; i++)
+    {
+        const uint16_t tmp = src[i];
+        dst[i] = ((tmp << 1) & 0xf000)
+                | ((tmp << 3) & 0x0f00)
+                | ((tmp << 4) & 0x00f0)
+                | 0xf; // The texture has no alpha channel, therefore it is opaque
+    }
+}
+
+void IceGL::glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid *data)
+{
+    m_error = GL_NO_ERROR;
+    if (target != GL_TEXTURE_2D
+            || internalformat < GL_PALETTE4_RGB8_OES
+            || internalformat > GL_PALETTE8_RGB5_A1_OES)
+    {
+        m_error = GL_INVALID_ENUM;
+        return;
+    }
+
+    if (level > 0 // Paletted textures are using negative levels to specify the number of mip levels
+            || !(width & GL_TEXTURE_SUPPORTED_SIZES)
+            || !(height & GL_TEXTURE_SUPPORTED_SIZES)
+            || border != 0)
+    {
+        m_error = GL_INVALID_VALUE;
+        return;
+    }
+
+    if (height != width) // Only square textures are supported
+    {
+        m_error = GL_SPEC_DEVIATION;
+        return;
+    }
+
+    const bool palette4 = (internalformat <= GL_PALETTE4_RGB5_A1_OES);
+    const int32_t paletteSize = palette4 ? 16 : 256;
+    int32_t colorSize = 2;
+    if ((internalformat == GL_PALETTE4_RGB8_OES) || (internalformat == GL_PALETTE8_RGB8_OES))
+        colorSize = 3;
+    else if ((internalformat == GL_PALETTE4_RGBA8_OES) || (internalformat == GL_PALETTE8_RGBA8_OES))
+        colorSize = 4;
+
+    // Only the first level is used, the other mip levels are ignored
+    const int32_t texels = width * height;
+    if ((data == nullptr) || (imageSize < ((paletteSize * colorSize) + (palette4 ? (texels / 2) : texels))))
+    {
+        m_error = GL_INVALID_VALUE;
+        return;
+    }
 
-        if (!m_renderer.updateTexture(m_boundTexture, texMemShared, width, height))
+    const uint8_t* palette = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* indices = palette + (paletteSize * colorSize);
+    std::shared_ptr<uint16_t> texMemShared;
+    IRenderer::TextureFormat format;
+    if (palette4)
+    {
+        // The renderer supports 4 bit palettes directly. This texture requires only a fourth of the memory and of
+        // the bandwidth of a RGBA4444 texture. The palette is followed by the indices.
+        static_assert(IRenderer::PALETTE4_SIZE == 16, "Size of the palette does not match OES_compressed_paletted_texture");
+        texMemShared = std::shared_ptr<uint16_t>(new uint16_t[IRenderer::PALETTE4_SIZE + (texels / 4)], [] (const uint16_t *p) { delete [] p; });
+        if (!texMemShared)
         {
-            m_error = GL_INVALID_VALUE;
+            m_error = GL_OUT_OF_MEMORY;
             return;
         }
-
-        // Rebind texture to update the rasterizer with the new texture meta information
-        glBindTexture(target, m_boundTexture);
+        uint16_t* texMem = texMemShared.get();
+        for (int32_t i = 0; i < IRenderer::PALETTE4_SIZE; i++)
+        {
+            texMem[i] = convertPaletteColor(internalformat, palette + (i * colorSize));
+        }
+        texMem += IRenderer::PALETTE4_SIZE;
+        memset(texMem, 0, (texels / 4) * sizeof(uint16_t));
+        for (int32_t i = 0; i < texels; i++)
+        {
+            // In OpenGL, the first index is in the high nibble, the renderer expects it in the lowest nibble
+            const uint16_t index = (i & 0x1) ? (indices[i / 2] & 0xf) : (indices[i / 2] >> 4);
+            texMem[i / 4] |= index << ((i % 4) * 4);
+        }
+        format = IRenderer::PALETTE4_RGBA4444;
     }
     else
     {
-        m_error = GL_INVALID_VALUE;
+        // 8 bit palettes are not supported by the renderer. Decompress them to RGBA4444.
+        texMemShared = std::shared_ptr<uint16_t>(new uint16_t[texels], [] (const uint16_t *p) { delete [] p; });
+        if (!texMemShared)
+        {
+            m_error = GL_OUT_OF_MEMORY;
+            return;
+        }
+        for (int32_t i = 0; i < texels; i++)
+        {
+            texMemShared.get()[i] = convertPaletteColor(internalformat, palette + (indices[i] * colorSize));
+        }
+        format = IRenderer::RGBA4444;
     }
+
+    updateBoundTexture(target, 0, texMemShared, width, height, format);
 }
 
 void IceGL::glPixelStorei(GLenum pname, GLint param)
@@ -582,7 +788,16 @@ void IceGL::glDeleteTextures(GLsizei n, const GLuint *textures)
         // From the specification: glDeleteTextures silently ignores 0's and names that do not correspond to existing textures.
         if (textures[i] != 0) 
         {
-            m_renderer.deleteTexture(textures[i]);
+            if (!m_renderer.deleteTexture(textures[i]))
+            {
+                // The texels are still used by a display list which is not uploaded and can't be retired
+                m_error = GL_OUT_OF_MEMORY;
+            }
+            else if (textures[i] < m_generateMipmap.size())
+            {
+                // The name can be reused by glGenTextures(), which starts with the default parameters
+                m_generateMipmap[textures[i]] = false;
+            }
         }
         
     }
@@ -614,7 +829,16 @@ void IceGL::glBindTexture(GLenum target, GLuint texture)
 void IceGL::glTexParameteri(GLenum target, GLenum pname, GLint param)
 {
     m_error = GL_NO_ERROR;
-    if (target == GL_TEXTURE_2D)
+    if ((target == GL_TEXTURE_2D) && (pname == GL_GENERATE_MIPMAP))
+    {
+        // The levels are generated with the next glTexImage2D() of level 0 of the bound texture
+        if (m_boundTexture >= m_generateMipmap.size())
+        {
+            m_generateMipmap.resize(m_boundTexture + 1, false);
+        }
+        m_generateMipmap[m_boundTexture] = (param != GL_FALSE);
+    }
+    else if (target == GL_TEXTURE_2D)
     {
         auto mode = convertGlTextureWrapMode(static_cast<GLenum>(param));
         if (m_error == GL_NO_ERROR)
@@ -1323,7 +1547,7 @@ void IceGL::glDrawArrays(GLenum mode, GLint first, GLsizei count)
 
     if (m_error == GL_NO_ERROR)
     {
-        m_tnl.drawObj(m_renderer, m_renderObj);
+        drawObj(m_renderObj);
     }
 }
 
@@ -1355,7 +1579,302 @@ void IceGL::glDrawElements(GLenum mode, GLsizei count, GLenum type, const void *
 
     if (m_error == GL_NO_ERROR)
     {
-        m_tnl.drawObj(m_renderer, m_renderObj);
+        drawObj(m_renderObj);
+    }
+}
+
+GLuint IceGL::glGenLists(GLsizei range)
+{
+    if (range < 0)
+    {
+        m_error = GL_INVALID_VALUE;
+        return 0;
+    }
+    if (range == 0)
+    {
+        return 0;
+    }
+    // The lists are always appended, the names of deleted lists are not reused
+    const GLuint first = m_compiledLists.size() + 1;
+    for (GLsizei i = 0; i < range; i++)
+    {
+        m_compiledLists.emplace_back(new CompiledList());
+    }
+    return first;
+}
+
+void IceGL::glDeleteLists(GLuint list, GLsizei range)
+{
+    if (range < 0)
+    {
+        m_error = GL_INVALID_VALUE;
+        return;
+    }
+    for (GLsizei i = 0; i < range; i++)
+    {
+        const GLuint index = list + i - 1;
+        if ((index < m_compiledLists.size()) && (m_compiledLists[index].get() != m_currentList))
+        {
+            m_compiledLists[index].reset();
+        }
+    }
+}
+
+GLboolean IceGL::glIsList(GLuint list)
+{
+    return (getCompiledList(list) != nullptr) ? GL_TRUE : GL_FALSE;
+}
+
+void IceGL::glNewList(GLuint list, GLenum mode)
+{
+    if ((mode != GL_COMPILE) && (mode != GL_COMPILE_AND_EXECUTE))
+    {
+        m_error = GL_INVALID_ENUM;
+        return;
+    }
+    if (m_currentList)
+    {
+        m_error = GL_INVALID_OPERATION;
+        return;
+    }
+    CompiledList* compiledList = getCompiledList(list);
+    if (!compiledList)
+    {
+        m_error = GL_INVALID_VALUE;
+        return;
+    }
+    compiledList->draws.clear();
+    compiledList->rasterizedTriangles.clear();
+    compiledList->rasterizedTrianglesValid = false;
+    m_currentList = compiledList;
+    m_currentListMode = mode;
+}
+
+void IceGL::glEndList()
+{
+    if (!m_currentList)
+    {
+        m_error = GL_INVALID_OPERATION;
+        return;
+    }
+    m_currentList = nullptr;
+}
+
+void IceGL::glCallList(GLuint list)
+{
+    CompiledList* compiledList = getCompiledList(list);
+    if (!compiledList)
+    {
+        // Calling a list which does not exist is not an error
+        return;
+    }
+
+    if (m_currentList)
+    {
+        // A list called while compiling is inlined in the new list, a list can't contain itself
+        if (compiledList != m_currentList)
+        {
+            m_currentList->draws.insert(m_currentList->draws.end(), compiledList->draws.begin(), compiledList->draws.end());
+        }
+        if (m_currentListMode == GL_COMPILE)
+        {
+            return;
+        }
+    }
+
+    recalculateAndSetTnLMatrices();
+
+    // Reuse the rasterized triangles when they were created with the same transformation. This skips the whole TnL
+    // and the triangle setup of the renderer.
+    if (compiledList->rasterizedTrianglesValid
+        && (compiledList->tnlStateVersion == m_tnl.getStateVersion())
+        && (compiledList->modelMatrix == m_m)
+        && (compiledList->projectionMatrix == m_p))
+    {
+        if (!m_renderer.drawRecordedTriangles(compiledList->rasterizedTriangles))
+        {
+            m_error = GL_OUT_OF_MEMORY;
+        }
+        return;
+    }
+
+    // Transform the geometry again and record the result for the next call
+    compiledList->rasterizedTriangles.clear();
+    m_renderer.recordTriangles(&compiledList->rasterizedTriangles);
+    const GLint error = m_error;
+    m_error = GL_NO_ERROR;
+    for (CompiledList::Draw& draw : compiledList->draws)
+    {
+        executeDraw(draw);
+    }
+    m_renderer.recordTriangles(nullptr);
+
+    // If a triangle was not drawn, the recording is incomplete
+    compiledList->rasterizedTrianglesValid = (m_error == GL_NO_ERROR);
+    compiledList->modelMatrix = m_m;
+    compiledList->projectionMatrix = m_p;
+    compiledList->tnlStateVersion = m_tnl.getStateVersion();
+    if (m_error == GL_NO_ERROR)
+    {
+        m_error = error;
+    }
+}
+
+IceGL::CompiledList* IceGL::getCompiledList(const GLuint list)
+{
+    if ((list == 0) || (list > m_compiledLists.size()))
+    {
+        return nullptr;
+    }
+    return m_compiledLists[list - 1].get();
+}
+
+void IceGL::drawTriangle(const TnL::Triangle& triangle)
+{
+    if (m_currentList)
+    {
+        m_currentList->draws.back().triangles.push_back(triangle);
+        if (m_currentListMode == GL_COMPILE)
+        {
+            return;
+        }
+    }
+    m_tnl.drawTriangle(m_renderer, triangle);
+}
+
+void IceGL::drawImmediateTriangle(const ImmediateVertex& v0, const ImmediateVertex& v1, const ImmediateVertex& v2)
+{
+    drawTriangle({v0.vertex, v1.vertex, v2.vertex,
+                  v0.texCoord, v1.texCoord, v2.texCoord,
+                  v0.normal, v1.normal, v2.normal,
+                  v0.color, v1.color, v2.color});
+}
+
+void IceGL::drawObj(const TnL::RenderObj& obj)
+{
+    if (m_currentList)
+    {
+        m_currentList->draws.emplace_back();
+        compileObj(m_currentList->draws.back(), obj);
+        if (m_currentListMode == GL_COMPILE)
+        {
+            return;
+        }
+    }
+    m_tnl.drawObj(m_renderer, obj);
+}
+
+void IceGL::compileObj(CompiledList::Draw& draw, const TnL::RenderObj& obj)
+{
+    // The client arrays can change after the list is compiled, therefore the referenced vertices are copied.
+    // They are converted into floats, which results in the same values as when they are read from the original arrays.
+    draw.obj = obj;
+    uint32_t numberOfVertices = 0;
+    if (obj.count >= 3)
+    {
+        // Float indices are not supported, they are compiled like disabled indices (see TnL::drawObj())
+        const TnL::RenderObj::Type indicesType = obj.indicesEnabled ? obj.indicesType : TnL::RenderObj::Type::FLOAT;
+        switch (indicesType)
+        {
+        case TnL::RenderObj::Type::BYTE:
+            numberOfVertices = copyIndices(draw.indices, static_cast<const uint8_t*>(obj.indicesPointer), obj.count);
+            break;
+        case TnL::RenderObj::Type::SHORT:
+            numberOfVertices = copyIndices(draw.indices, static_cast<const uint16_t*>(obj.indicesPointer), obj.count);
+            break;
+        case TnL::RenderObj::Type::UNSIGNED_INT:
+            numberOfVertices = copyIndices(draw.indices, static_cast<const uint32_t*>(obj.indicesPointer), obj.count);
+            break;
+        default:
+            draw.obj.indicesEnabled = false;
+            numberOfVertices = obj.count;
+            break;
+        }
+    }
+    else
+    {
+        draw.obj.count = 0;
+    }
+    draw.obj.indicesType = TnL::RenderObj::Type::UNSIGNED_INT;
+
+    // The arrays are read with the same readers as in TnL::drawObj()
+    const TnL::RenderObj::ArrayReaders readers = obj.prepareArrays();
+    for (uint32_t i = 0; i < numberOfVertices; i++)
+    {
+        if (obj.vertexArrayEnabled)
+        {
+            Vec4 v;
+            v.initHomogeneous();
+            readers.vertex.read(v, i);
+            draw.vertices.insert(draw.vertices.end(), v.vec.begin(), v.vec.end());
+        }
+        if (obj.texCoordArrayEnabled)
+        {
+            Vec2 st{{0.0f, 0.0f}};
+            readers.texCoord.read(st, i);
+            draw.texCoords.insert(draw.texCoords.end(), st.vec.begin(), st.vec.end());
+        }
+        if (obj.normalArrayEnabled)
+        {
+            Vec3 n{{0.0f, 0.0f, 0.0f}};
+            readers.normal.read(n, i);
+            draw.normals.insert(draw.normals.end(), n.vec.begin(), n.vec.end());
+        }
+        if (obj.colorArrayEnabled)
+        {
+            Vec4 c{{0.0f, 0.0f, 0.0f, 1.0f}};
+            readers.color.read(c, i);
+            draw.colors.insert(draw.colors.end(), c.vec.begin(), c.vec.end());
+        }
+    }
+    draw.obj.vertexSize = 4;
+    draw.obj.vertexType = TnL::RenderObj::Type::FLOAT;
+    draw.obj.vertexStride = 0;
+    draw.obj.texCoordSize = 2;
+    draw.obj.texCoordType = TnL::RenderObj::Type::FLOAT;
+    draw.obj.texCoordStride = 0;
+    draw.obj.normalType = TnL::RenderObj::Type::FLOAT;
+    draw.obj.normalStride = 0;
+    draw.obj.colorSize = 4;
+    draw.obj.colorType = TnL::RenderObj::Type::FLOAT;
+    draw.obj.colorStride = 0;
+}
+
+template <typename T>
+uint32_t IceGL::copyIndices(std::vector<uint32_t>& dst, const T* src, const uint32_t count)
+{
+    uint32_t numberOfVertices = 0;
+    dst.resize(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        dst[i] = src[i];
+        numberOfVertices = (dst[i] >= numberOfVertices) ? dst[i] + 1 : numberOfVertices;
+    }
+    return numberOfVertices;
+}
+
+void IceGL::executeDraw(CompiledList::Draw& draw)
+{
+    for (const TnL::Triangle& triangle : draw.triangles)
+    {
+        if (!m_tnl.drawTriangle(m_renderer, triangle))
+        {
+            m_error = GL_OUT_OF_MEMORY;
+        }
+    }
+
+    if (draw.obj.count > 0)
+    {
+        // The vectors might be reallocated when the list was copied, so set the pointers right before the draw
+        draw.obj.vertexPointer = draw.vertices.data();
+        draw.obj.texCoordPointer = draw.texCoords.data();
+        draw.obj.normalPointer = draw.normals.data();
+        draw.obj.colorPointer = draw.colors.data();
+        draw.obj.indicesPointer = draw.indices.data();
+        if (!m_tnl.drawObj(m_renderer, draw.obj))
+        {
+            m_error = GL_OUT_OF_MEMORY;
+        }
     }
 }
 
@@ -1431,8 +1950,8 @@ void IceGL::glPushMatrix()
         if (m_mStackIndex < MODEL_MATRIX_STACK_DEPTH)
         {
             m_mStack[m_mStackIndex] = m_m;
+            m_mKindStack[m_mStackIndex] = m_mKind;
             m_mStackIndex++;
-            m_matricesOutdated = true;
         }
         else
         {
@@ -1445,7 +1964,6 @@ void IceGL::glPushMatrix()
         {
             m_pStack[m_pStackIndex] = m_p;
             m_pStackIndex++;
-            m_matricesOutdated = true;
         }
         else
         {
@@ -1467,7 +1985,8 @@ void IceGL::glPopMatrix()
         {
             m_mStackIndex--;
             m_m = m_mStack[m_mStackIndex];
-            m_matricesOutdated = true;
+            m_mKind = m_mKindStack[m_mStackIndex];
+            m_modelMatrixOutdated = true;
         }
         else
         {
@@ -1480,7 +1999,7 @@ void IceGL::glPopMatrix()
         {
             m_pStackIndex--;
             m_p = m_pStack[m_pStackIndex];
-            m_matricesOutdated = true;
+            m_projectionMatrixOutdated = true;
         }
         else
         {
@@ -1495,22 +2014,49 @@ void IceGL::glPopMatrix()
 
 void IceGL::recalculateAndSetTnLMatrices()
 {
-    if (m_matricesOutdated)
+    if (m_modelMatrixOutdated || m_projectionMatrixOutdated)
     {
         // Update transformation matrix
         Mat44 t{m_m};
         t *= m_p;
         m_tnl.setModelProjectionMatrix(t);
+    }
+
+    if (m_modelMatrixOutdated)
+    {
         m_tnl.setModelMatrix(m_m);
+        m_normalMatrixOutdated = true;
+    }
 
+    // The normal matrix is only used for the lighting. Postpone the calculation till it is required.
+    if (m_normalMatrixOutdated && m_tnl.normalMatrixRequired())
+    {
+        // Use the inverse transpose matrix for the normals. This is the standard way how OpenGL transforms normals.
+        // The normals are only transformed by the upper 3x3 part of the matrix.
         Mat44 inv{m_m};
-        inv.invert();
-        inv.transpose();
-        // Use the inverse transpose matrix for the normals. This is the standard way how OpenGL transforms normals
+        switch (m_mKind)
+        {
+        case MatrixKind::IDENTITY:
+        case MatrixKind::TRANSLATION:
+            inv.identity();
+            break;
+        case MatrixKind::RIGID:
+            // The inverse of a rotation is its transpose, so the inverse transpose is the matrix itself
+            break;
+        case MatrixKind::AFFINE:
+            inv.invertTranspose3x3();
+            break;
+        default:
+            inv.invert();
+            inv.transpose();
+            break;
+        }
         m_tnl.setNormalMatrix(inv);
-
-        m_matricesOutdated = false;
+        m_normalMatrixOutdated = false;
     }
+
+    m_modelMatrixOutdated = false;
+    m_projectionMatrixOutdated = false;
 }
 
 void IceGL::glTexGeni(GLenum coord, GLenum pname, GLint param)
@@ -1710,6 +2256,35 @@ void IceGL::glCullFace(GLenum mode)
     }
 }
 
+uint16_t IceGL::convertPaletteColor(const GLenum internalformat, const uint8_t* color)
+{
+    uint16_t tmp;
+    switch (internalformat)
+    {
+    case GL_PALETTE4_RGB8_OES:
+    case GL_PALETTE8_RGB8_OES:
+        return ((color[0] >> 4) << 12) | ((color[1] >> 4) << 8) | ((color[2] >> 4) << 4) | 0xf;
+    case GL_PALETTE4_RGBA8_OES:
+    case GL_PALETTE8_RGBA8_OES:
+        return ((color[0] >> 4) << 12) | ((color[1] >> 4) << 8) | ((color[2] >> 4) << 4) | (color[3] >> 4);
+    case GL_PALETTE4_R5_G6_B5_OES:
+    case GL_PALETTE8_R5_G6_B5_OES:
+        memcpy(&tmp, color, sizeof(tmp));
+        return ((tmp << 1) & 0xf000) | ((tmp << 3) & 0x0f00) | ((tmp << 4) & 0x00f0) | 0xf;
+    case GL_PALETTE4_RGBA4_OES:
+    case GL_PALETTE8_RGBA4_OES:
+        // This is the native format
+        memcpy(&tmp, color, sizeof(tmp));
+        return tmp;
+    case GL_PALETTE4_RGB5_A1_OES:
+    case GL_PALETTE8_RGB5_A1_OES:
+        memcpy(&tmp, color, sizeof(tmp));
+        return ((tmp << 1) & 0xf000) | ((tmp << 2) & 0x0f00) | ((tmp << 3) & 0x00f0) | ((tmp & 0x1) ? 0xf : 0x0);
+    default:
+        return 0;
+    }
+}
+
 IRenderer::TextureWrapMode IceGL::convertGlTextureWrapMode(const GLenum mode)
 {
     switch (mode) {
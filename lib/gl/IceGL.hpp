@@ -20,6 +20,7 @@
 
 #include <vector>
 #include <array>
+#include <memory>
 #include "IRenderer.hpp"
 #include "TnL.hpp"
 #include "Vec.hpp"
@@ -67,8 +68,20 @@ public:
     void glEnableClientState(GLenum array);
     void glDisableClientState(GLenum array);
 
+    GLuint glGenLists(GLsizei range);
+    void glDeleteLists(GLuint list, GLsizei range);
+    GLboolean glIsList(GLuint list);
+    void glNewList(GLuint list, GLenum mode);
+    void glEndList();
+    void glCallList(GLuint list);
+
 
     void glTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid *pixels);
+    void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid *data);
+    /// @brief Same as glTexImage2D(), but the texture is converted in place into RGBA4444 and the renderer uses the
+    /// memory of pixels directly. This avoids the allocation and the copy of the texture. pixels has to be aligned
+    /// to 16 bit and must be valid and unchanged as long as the texture uses it (until it is deleted or replaced).
+    void texImage2DInPlace(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, GLvoid *pixels);
     void glPixelStorei(GLenum pname, GLint param);
     void glGenTextures(GLsizei n, GLuint *textures);
     void glDeleteTextures(GLsizei n, const GLuint * textures);
@@ -118,19 +131,109 @@ public:
 
     void commit();
 
+    /// @brief Same as commit(), but does not block when the renderer is not able to take the frame yet
+    /// @return true if the frame was committed, false if tryCommit() has to be called again (no draw calls in between)
+    bool tryCommit();
+
+    /// @brief Returns the number of triangles which were discarded by the face culling (see glCullFace()).
+    /// The culling happens before the triangles are lit and clipped.
+    /// @return Number of culled triangles
+    uint32_t getNumberOfCulledTriangles() const;
+
+    /// @brief Returns the counters of the last committed frame. The counters are only collected when the driver is
+    /// built with ICEGL_STATISTICS (see Statistics.hpp), otherwise they are zero.
+    /// @return The counters of the TnL and the renderer
+    FrameStats getFrameStats() const;
+
+    /// @brief Hints that the application overwrites every pixel of the color buffer in every frame (for instance with
+    /// a sky box). glClear(GL_COLOR_BUFFER_BIT) is then skipped (see IRenderer::setFrameCoveredHint()).
+    /// @param covered true if every pixel of the color buffer is overwritten
+    void setFrameCoveredHint(const bool covered);
+
 private:
 
     static constexpr uint8_t MODEL_MATRIX_STACK_DEPTH = 16;
     static constexpr uint8_t PROJECTION_MATRIX_STACK_DEPTH = 4;
 
+    // Describes which transformations a model view matrix contains. It is used to select a cheaper way
+    // to calculate the normal matrix. The product of two matrices has the kind of the more general one.
+    enum MatrixKind : uint8_t
+    {
+        IDENTITY,
+        TRANSLATION, // Only translations
+        RIGID, // Rotations and translations
+        AFFINE, // Rotations, translations, scales and shears
+        GENERAL
+    };
+
+    // A compiled display list (see glNewList()). It contains the geometry of all draw calls between glNewList() and
+    // glEndList(). State changes are not compiled, they are executed immediately.
+    // When the list is called, the triangles are transformed, lit and rasterized once. The renderer records the
+    // rasterized triangles, which are reused as long as the matrices and the TnL state are unchanged.
+    struct CompiledList
+    {
+        // The geometry of one draw call. Immediate mode triangles are stored in triangles, vertex arrays are
+        // copied into the vectors and obj points to them when the draw is executed.
+        struct Draw
+        {
+            std::vector<TnL::Triangle> triangles;
+            TnL::RenderObj obj{};
+            std::vector<float> vertices;
+            std::vector<float> texCoords;
+            std::vector<float> normals;
+            std::vector<float> colors;
+            std::vector<uint32_t> indices;
+        };
+        std::vector<Draw> draws;
+
+        // The rasterized triangles and the state with which they were created
+        std::vector<uint8_t> rasterizedTriangles;
+        bool rasterizedTrianglesValid = false;
+        Mat44 modelMatrix;
+        Mat44 projectionMatrix;
+        uint32_t tnlStateVersion = 0; // See TnL::getStateVersion()
+    };
+
+    // An immediate mode vertex with the attributes it got in glVertex3f()
+    struct ImmediateVertex
+    {
+        Vec4 vertex;
+        Vec2 texCoord;
+        Vec3 normal;
+        Vec4i color;
+    };
 
     void setClientState(const GLenum array, bool enable);
+    void drawTriangle(const TnL::Triangle& triangle);
+    void drawImmediateTriangle(const ImmediateVertex& v0, const ImmediateVertex& v1, const ImmediateVertex& v2);
+    void drawObj(const TnL::RenderObj& obj);
+    void compileObj(CompiledList::Draw& draw, const TnL::RenderObj& obj);
+    /// @brief Copies the indices of a draw call
+    /// @return The number of vertices which are referenced by the indices
+    template <typename T>
+    static uint32_t copyIndices(std::vector<uint32_t>& dst, const T* src, const uint32_t count);
+    void executeDraw(CompiledList::Draw& draw);
+    CompiledList* getCompiledList(const GLuint list);
     // It would be nice to have std::optional, but it does not work with arduino
     // If we have this, we could make all this functions const and return an empty optional if the conversion failed
     IRenderer::BlendFunc convertGlBlendFuncToRenderBlendFunc(const GLenum blendFunc);
     TnL::RenderObj::Type convertType(GLenum type);
     TnL::RenderObj::DrawMode convertDrawMode(GLenum drawMode);
     IRenderer::TextureWrapMode convertGlTextureWrapMode(const GLenum mode);
+    static uint16_t convertPaletteColor(const GLenum internalformat, const uint8_t* color);
+    GLint checkTexImage2D(GLenum target, GLint level, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type);
+    void updateBoundTexture(GLenum target, GLint level, std::shared_ptr<const uint16_t> pixels, GLsizei width, GLsizei height, IRenderer::TextureFormat format);
+    bool isGenerateMipmapEnabled(const GLuint texture) const;
+    void generateMipmaps(const uint16_t* pixels, GLsizei width);
+    // Box filter which halves the size of a RGBA4444 texture
+    static void downsampleRgba4444(uint16_t* dst, const uint16_t* src, const GLsizei dstWidth);
+    // Conversion kernels to RGBA4444. dst and src can point to the same memory.
+    static void convertTexture(uint16_t* dst, const GLvoid* src, const int32_t texels, GLenum format, GLenum type);
+    template <uint8_t COMPONENTS>
+    static void convertUnsignedByteToRgba4444(uint16_t* dst, const uint8_t* src, const int32_t texels);
+    static void convertRgba5551ToRgba4444(uint16_t* dst, const uint16_t* src, const int32_t texels);
+    static void convertRgb565ToRgba4444(uint16_t* dst, const uint16_t* src, const int32_t texels);
+    void multMatrix(const Mat44& m, const MatrixKind kind);
     void recalculateAndSetTnLMatrices();
     static Vec4 calcTexGenEyePlane(const Mat44& mat, const Vec4& plane);
 
@@ -138,11 +241,9 @@ private:
     TnL m_tnl;
     TnL::RenderObj m_renderObj;
 
-    // Buffer
-    std::vector<Vec4> m_vertexBuffer;
-    std::vector<Vec2> m_textureVertexBuffer;
-    std::vector<Vec3> m_normalVertexBuffer;
-    std::vector<Vec4i> m_colorVertexBuffer;
+    // Immediate mode vertices between glBegin() and glEnd(). Only the vertices of the current triangle are kept.
+    std::array<ImmediateVertex, 3> m_immediateVertices;
+    uint32_t m_immediateVertexCount = 0;
 
     // State values
     Vec4i m_vertexColor;
@@ -154,17 +255,23 @@ private:
     // Matrix modes
     GLenum matrixMode = GL_PROJECTION;
     Mat44 m_mStack[MODEL_MATRIX_STACK_DEPTH];
+    MatrixKind m_mKindStack[MODEL_MATRIX_STACK_DEPTH];
     Mat44 m_pStack[PROJECTION_MATRIX_STACK_DEPTH];
     uint8_t m_mStackIndex{0};
     uint8_t m_pStackIndex{0};
     Mat44 m_m; // Model matrix
     Mat44 m_p; // Projection matrix
     Mat44 m_t;
-    bool m_matricesOutdated{true}; // Marks when the model and projection matrices have changed so that the transformation and normal matrices have to be recalculated
+    MatrixKind m_mKind{MatrixKind::IDENTITY};
+    // Marks when the model and projection matrices have changed so that the transformation and normal matrices have to be recalculated
+    bool m_modelMatrixOutdated{true};
+    bool m_projectionMatrixOutdated{true};
+    bool m_normalMatrixOutdated{true}; // The normal matrix is only recalculated when it is used
 
     // Textures
     GLint m_unpackAlignment = 4;
     GLuint m_boundTexture = 0;
+    std::vector<bool> m_generateMipmap; // GL_GENERATE_MIPMAP of every texture, indexed by the texture name
     bool m_enableTextureMapping = true;
     GLint m_texEnvParam = GL_REPLACE;
 
@@ -182,6 +289,11 @@ private:
     bool m_enableCulling = false;
     GLenum m_cullMode = GL_BACK;
 
+    // Display lists
+    std::vector<std::unique_ptr<CompiledList>> m_compiledLists; // The name of a list is its index + 1
+    CompiledList* m_currentList = nullptr; // The list which is currently compiled
+    GLenum m_currentListMode = GL_COMPILE;
+
     // Errors
     GLint m_error = GL_NO_ERROR;
 };
@@ -209,7 +209,22 @@ typedef enum {
     GL_REPEAT,
     GL_TEXTURE_WRAP_S,
     GL_CLAMP_TO_BORDER,
-    GL_CLAMP_TO_EDGE
+    GL_CLAMP_TO_EDGE,
+    GL_GENERATE_MIPMAP,
+    GL_COMPILE,
+    GL_COMPILE_AND_EXECUTE,
+
+    // OES_compressed_paletted_texture
+    GL_PALETTE4_RGB8_OES,
+    GL_PALETTE4_RGBA8_OES,
+    GL_PALETTE4_R5_G6_B5_OES,
+    GL_PALETTE4_RGBA4_OES,
+    GL_PALETTE4_RGB5_A1_OES,
+    GL_PALETTE8_RGB8_OES,
+    GL_PALETTE8_RGBA8_OES,
+    GL_PALETTE8_R5_G6_B5_OES,
+    GL_PALETTE8_RGBA4_OES,
+    GL_PALETTE8_RGB5_A1_OES
 } GLenum;
 
 #define GL_COLOR_BUFFER_BIT     0x1
@@ -61,7 +61,14 @@ void glDrawArrays(GLenum mode, GLint first, GLsizei count) {iceGlCWrap->glDrawAr
 void glDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {iceGlCWrap->glDrawElements(mode, count, type, indices);}
 void glEnableClientState(GLenum array) {iceGlCWrap->glEnableClientState(array);}
 void glDisableClientState(GLenum array) {iceGlCWrap->glDisableClientState(array);}
+GLuint glGenLists(GLsizei range) {return iceGlCWrap->glGenLists(range);}
+void glDeleteLists(GLuint list, GLsizei range) {iceGlCWrap->glDeleteLists(list, range);}
+GLboolean glIsList(GLuint list) {return iceGlCWrap->glIsList(list);}
+void glNewList(GLuint list, GLenum mode) {iceGlCWrap->glNewList(list, mode);}
+void glEndList() {iceGlCWrap->glEndList();}
+void glCallList(GLuint list) {iceGlCWrap->glCallList(list);}
 void glTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid *pixels) {iceGlCWrap->glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);}
+void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid *data) {iceGlCWrap->glCompressedTexImage2D(target, level, internalformat, width, height, border, imageSize, data);}
 void glPixelStorei(GLenum pname, GLint param) {iceGlCWrap->glPixelStorei(pname, param);}
 void glGenTextures(GLsizei n, GLuint *textures) {iceGlCWrap->glGenTextures(n, textures);}
 void glDeleteTextures(GLsizei n, const GLuint * textures) {iceGlCWrap->glDeleteTextures(n, textures);}
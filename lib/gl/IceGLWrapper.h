@@ -64,7 +64,14 @@ void glDrawArrays(GLenum mode, GLint first, GLsizei count);
 void glDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
 void glEnableClientState(GLenum array);
 void glDisableClientState(GLenum array);
+GLuint glGenLists(GLsizei range);
+void glDeleteLists(GLuint list, GLsizei range);
+GLboolean glIsList(GLuint list);
+void glNewList(GLuint list, GLenum mode);
+void glEndList();
+void glCallList(GLuint list);
 void glTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid *pixels);
+void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid *data);
 void glPixelStorei(GLenum pname, GLint param);
 void glGenTextures(GLsizei n, GLuint *textures);
 void glDeleteTextures(GLsizei n, const GLuint * textures);
@@ -21,6 +21,12 @@
 #include <math.h>
 #include "Vec.hpp"
 
+// Define MAT44_USE_CMSIS_DSP to use the CMSIS-DSP library for the batch transformation.
+// The CMSIS-DSP library will then use the FPU, DSP extension or Helium (MVE) of the ARM core, depending on how it is compiled.
+#ifdef MAT44_USE_CMSIS_DSP
+#include "arm_math.h"
+#endif
+
 class Mat44
 {
 public:
@@ -99,6 +105,38 @@ public:
         return true;
     }
 
+    /// @brief Replaces the matrix with the inverse transpose of its upper 3x3 part. The projection and translation
+    /// parts are cleared. This is sufficient and much cheaper than invert() and transpose() for a normal matrix of
+    /// an affine transformation.
+    /// @return false if the matrix is not invertible
+    bool invertTranspose3x3()
+    {
+        float cof[3][3];
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            for (uint8_t j = 0; j < 3; j++)
+            {
+                const uint8_t i1 = (i + 1) % 3;
+                const uint8_t i2 = (i + 2) % 3;
+                const uint8_t j1 = (j + 1) % 3;
+                const uint8_t j2 = (j + 2) % 3;
+                cof[i][j] = mat[i1][j1] * mat[i2][j2] - mat[i1][j2] * mat[i2][j1];
+            }
+        }
+        float det = mat[0][0] * cof[0][0] + mat[0][1] * cof[0][1] + mat[0][2] * cof[0][2];
+        if (det == 0.0f) return false;
+        det = 1.0f / det;
+        identity();
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            for (uint8_t j = 0; j < 3; j++)
+            {
+                mat[i][j] = cof[i][j] * det;
+            }
+        }
+        return true;
+    }
+
     void transform(Vec4& dst, const Vec4& src) const
     {
         const float src0 = src[0];
@@ -140,6 +178,64 @@ public:
         dst[2] = src0 * mat[0][2] + src1 * mat[1][2] + src2 * mat[2][2];
     }
 
+    /// @brief Transforms a batch of vectors. The vectors are stored as structure of arrays: first all x components
+    /// of the vectors, then all y components and so on. This allows the compiler or the CMSIS-DSP to vectorize the
+    /// calculation.
+    /// @tparam VecSize The size of the vectors. Use 4 for vertices (x, y, z, w) and 3 for normals (x, y, z).
+    /// @param dst The destination. Must have place for VecSize * count floats. Must not overlap with src.
+    /// @param src The source with VecSize * count floats
+    /// @param count Number of vectors
+    template <uint8_t VecSize>
+    void transform(float* dst, const float* src, const uint16_t count) const
+    {
+        static_assert((VecSize == 3) || (VecSize == 4), "Only Vec3 and Vec4 are supported");
+#ifdef MAT44_USE_CMSIS_DSP
+        // The CMSIS-DSP multiplies from the left, therefore the matrix has to be transposed
+        float m[VecSize * VecSize];
+        for (uint8_t i = 0; i < VecSize; i++)
+        {
+            for (uint8_t j = 0; j < VecSize; j++)
+            {
+                m[(i * VecSize) + j] = mat[j][i];
+            }
+        }
+        arm_matrix_instance_f32 a;
+        arm_matrix_instance_f32 b;
+        arm_matrix_instance_f32 c;
+        arm_mat_init_f32(&a, VecSize, VecSize, m);
+        arm_mat_init_f32(&b, VecSize, count, const_cast<float*>(src));
+        arm_mat_init_f32(&c, VecSize, count, dst);
+        arm_mat_mult_f32(&a, &b, &c);
+#else
+        const float* src0 = src;
+        const float* src1 = src + count;
+        const float* src2 = src + (count * 2);
+        const float* src3 = src + (count * 3);
+        for (uint8_t j = 0; j < VecSize; j++)
+        {
+            float* d = dst + (count * j);
+            const float m0 = mat[0][j];
+            const float m1 = mat[1][j];
+            const float m2 = mat[2][j];
+            if constexpr (VecSize == 4)
+            {
+                const float m3 = mat[3][j];
+                for (uint16_t i = 0; i < count; i++)
+                {
+                    d[i] = src0[i] * m0 + src1[i] * m1 + src2[i] * m2 + src3[i] * m3;
+                }
+            }
+            else
+            {
+                for (uint16_t i = 0; i < count; i++)
+                {
+                    d[i] = src0[i] * m0 + src1[i] * m1 + src2[i] * m2;
+                }
+            }
+        }
+#endif
+    }
+
     void operator*= (const Mat44& rhs)
     {
         Mat44 m{*this};
@@ -169,6 +265,11 @@ public:
         operator= (&m[0][0]);
     }
 
+    bool operator== (const Mat44& rhs) const
+    {
+        return mat == rhs.mat;
+    }
+
     std::array<float, 4>& operator[] (const uint8_t rhs)
     {
         return mat[rhs];
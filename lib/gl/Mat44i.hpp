@@ -0,0 +1,109 @@
+// RasteriCEr
+// https://github.com/ToNi3141/RasteriCEr
+// Copyright (c) 2021 ToNi3141
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef MAT44I_HPP
+#define MAT44I_HPP
+#include <array>
+#include "Veci.hpp"
+#include "Mat44.hpp"
+
+// This is a fixed point version of the Mat44. It is used for the vertex transformations on MCUs without FPU.
+// It has the same memory layout as the Mat44 (mat[column][row]). The products are accumulated with 64 bit,
+// so that the intermediate results can't overflow.
+class Mat44i
+{
+public:
+    using ValType = std::array<std::array<VecInt, 4>, 4>;
+    Mat44i() {}
+    ~Mat44i() {}
+
+    /// @brief Converts a float matrix into a fixed point matrix
+    /// @tparam shift Number of fractional bits
+    /// @param m The float matrix
+    template <uint8_t shift>
+    void fromMat(const Mat44& m)
+    {
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            for (uint8_t j = 0; j < 4; j++)
+            {
+                const float val = m[i][j] * (1ul << shift);
+                mat[i][j] = (val < 0.0f) ? (val - 0.5f) : (val + 0.5f);
+            }
+        }
+    }
+
+    /// @brief Transforms a vector. The vector and the matrix must use the same number of fractional bits.
+    /// @tparam shift Number of fractional bits
+    template <uint8_t shift>
+    void transform(Vec4i& dst, const Vec4i& src) const
+    {
+        const int64_t src0 = src[0];
+        const int64_t src1 = src[1];
+        const int64_t src2 = src[2];
+        const int64_t src3 = src[3];
+
+        int64_t dst0 = src0 * mat[0][0] + src1 * mat[1][0] + src2 * mat[2][0];
+        int64_t dst1 = src0 * mat[0][1] + src1 * mat[1][1] + src2 * mat[2][1];
+        int64_t dst2 = src0 * mat[0][2] + src1 * mat[1][2] + src2 * mat[2][2];
+        int64_t dst3 = src0 * mat[0][3] + src1 * mat[1][3] + src2 * mat[2][3];
+
+        // Same special case as in the Mat44: Typically the w value of a Vec4 is 1.0, which saves four multiplications
+        if (src3 == (1l << shift))
+        {
+            dst[0] = (dst0 >> shift) + mat[3][0];
+            dst[1] = (dst1 >> shift) + mat[3][1];
+            dst[2] = (dst2 >> shift) + mat[3][2];
+            dst[3] = (dst3 >> shift) + mat[3][3];
+        }
+        else
+        {
+            dst[0] = (dst0 + (src3 * mat[3][0])) >> shift;
+            dst[1] = (dst1 + (src3 * mat[3][1])) >> shift;
+            dst[2] = (dst2 + (src3 * mat[3][2])) >> shift;
+            dst[3] = (dst3 + (src3 * mat[3][3])) >> shift;
+        }
+    }
+
+    /// @brief Transforms a vector without the translation (for instance a normal)
+    /// @tparam shift Number of fractional bits
+    template <uint8_t shift>
+    void transform(Vec3i& dst, const Vec3i& src) const
+    {
+        const int64_t src0 = src[0];
+        const int64_t src1 = src[1];
+        const int64_t src2 = src[2];
+
+        dst[0] = (src0 * mat[0][0] + src1 * mat[1][0] + src2 * mat[2][0]) >> shift;
+        dst[1] = (src0 * mat[0][1] + src1 * mat[1][1] + src2 * mat[2][1]) >> shift;
+        dst[2] = (src0 * mat[0][2] + src1 * mat[1][2] + src2 * mat[2][2]) >> shift;
+    }
+
+    std::array<VecInt, 4>& operator[] (const uint8_t rhs)
+    {
+        return mat[rhs];
+    }
+
+    const std::array<VecInt, 4>& operator[] (const uint8_t rhs) const
+    {
+        return mat[rhs];
+    }
+
+    ValType mat;
+};
+
+#endif // MAT44I_HPP
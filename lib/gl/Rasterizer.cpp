@@ -17,6 +17,7 @@
 
 #include "Rasterizer.hpp"
 #include <cstring>
+#include <cmath>
 
 // The Arduino IDE will produce compile errors when using std::min and std::max
 #include <algorithm>    // std::max
@@ -34,10 +35,51 @@ bool Rasterizer::rasterize(RasterizedTriangle &rasterizedTriangle,
                            const Vec4 &v1f,
                            const Vec2& st1f,
                            const Vec4 &v2f,
-                           const Vec2& st2f)
+                           const Vec2& st2f,
+                           const Viewport &viewport)
 {
     //   return rasterizeFloat(rasterizedTriangle, v0f, st0f, v1f, st1f, v2f, st2f);
-    return rasterizeFixPoint(rasterizedTriangle, v0f, st0f, v1f, st1f, v2f, st2f);
+
+    // Convert to a fixed point representation
+    // Use here 4 bits for the integer part. That offers the possibility to use texture coordinates which have a maximum value of 16.
+    // This is required for repetitions. On the hardware, overflows are not a big deal during repeats but if we want to clamp, then an overflow
+    // destroyes the clamp. Keep in mind that the end result is still a s1.30 number which is send to the hardware.
+    Vec3i stx, sty;
+    stx.fromVec<TEX_COORD_DECIMALS>({st0f[0], st1f[0], st2f[0]});
+    sty.fromVec<TEX_COORD_DECIMALS>({st0f[1], st1f[1], st2f[1]});
+
+    Vec2i v0, v1, v2;
+    v0.fromVec<SCREEN_COORD_DECIMALS>({v0f[0], v0f[1]});
+    v1.fromVec<SCREEN_COORD_DECIMALS>({v1f[0], v1f[1]});
+    v2.fromVec<SCREEN_COORD_DECIMALS>({v2f[0], v2f[1]});
+
+    Vec3i vW;
+    // TODO / Note: Using now the w component for the z buffer, which converts the z buffer to a w buffer.
+    // Advantage of a w buffer: All values are equally distributed between 0 and intmax. It seems also to be a better fit for 16bit z buffers
+    // Advantage of a z buffer: More precise than the w buffer on near objects. Distribution is therefore uneven. Seems to be a better choice for more precise z buffers.
+    vW.fromVec<DEPTH_W_DECIMALS>({v0f[3], v1f[3], v2f[3]});
+
+    return rasterizeFixPoint(rasterizedTriangle, v0, v1, v2, stx, sty, vW, viewport);
+}
+
+bool Rasterizer::rasterize(RasterizedTriangle &rasterizedTriangle,
+                           const Vec4i &v0,
+                           const Vec2i &st0,
+                           const Vec4i &v1,
+                           const Vec2i &st1,
+                           const Vec4i &v2,
+                           const Vec2i &st2,
+                           const Viewport &viewport)
+{
+    // The values are already in the fix point formats, they just have to be rearranged
+    return rasterizeFixPoint(rasterizedTriangle,
+                             {{v0[0], v0[1]}},
+                             {{v1[0], v1[1]}},
+                             {{v2[0], v2[1]}},
+                             {{st0[0], st1[0], st2[0]}},
+                             {{st0[1], st1[1], st2[1]}},
+                             {{v0[3], v1[3], v2[3]}},
+                             viewport);
 }
 
 bool Rasterizer::calcLineIncrement(RasterizedTriangle &incrementedTriangle,
@@ -130,6 +172,237 @@ bool Rasterizer::calcLineIncrement(RasterizedTriangle &incrementedTriangle,
     return false;
 }
 
+bool Rasterizer::rasterize(CompactTriangle &compactTriangle,
+                           const Vec4 &v0f,
+                           const Vec2& st0f,
+                           const Vec4 &v1f,
+                           const Vec2& st1f,
+                           const Vec4 &v2f,
+                           const Vec2& st2f,
+                           const Viewport &viewport)
+{
+    // Use the same fix point formats as for the RasterizedTriangle, the hardware expects exactly the same values
+    Vec2i v0, v1, v2;
+    v0.fromVec<SCREEN_COORD_DECIMALS>({v0f[0], v0f[1]});
+    v1.fromVec<SCREEN_COORD_DECIMALS>({v1f[0], v1f[1]});
+    v2.fromVec<SCREEN_COORD_DECIMALS>({v2f[0], v2f[1]});
+
+    Vec3i stx, sty, vW;
+    vW.fromVec<DEPTH_W_DECIMALS>({v0f[3], v1f[3], v2f[3]});
+    stx.fromVec<TEX_COORD_DECIMALS>({st0f[0], st1f[0], st2f[0]});
+    sty.fromVec<TEX_COORD_DECIMALS>({st0f[1], st1f[1], st2f[1]});
+
+    return rasterizeFixPoint(compactTriangle, v0, v1, v2, stx, sty, vW, viewport);
+}
+
+bool Rasterizer::rasterize(CompactTriangle &compactTriangle,
+                           const Vec4i &v0,
+                           const Vec2i &st0,
+                           const Vec4i &v1,
+                           const Vec2i &st1,
+                           const Vec4i &v2,
+                           const Vec2i &st2,
+                           const Viewport &viewport)
+{
+    return rasterizeFixPoint(compactTriangle,
+                             {{v0[0], v0[1]}},
+                             {{v1[0], v1[1]}},
+                             {{v2[0], v2[1]}},
+                             {{st0[0], st1[0], st2[0]}},
+                             {{st0[1], st1[1], st2[1]}},
+                             {{v0[3], v1[3], v2[3]}},
+                             viewport);
+}
+
+bool Rasterizer::rasterizeFixPoint(CompactTriangle &compactTriangle,
+                                   const Vec2i &v0,
+                                   const Vec2i &v1,
+                                   const Vec2i &v2,
+                                   const Vec3i &stx,
+                                   const Vec3i &sty,
+                                   const Vec3i &vW,
+                                   const Viewport &viewport)
+{
+    static constexpr uint32_t EDGE_FUNC_SIZE = SCREEN_COORD_DECIMALS;
+    static constexpr int32_t HALF_EDGE_FUNC_SIZE = (1 << (EDGE_FUNC_SIZE-1));
+
+    // Discard degenerated triangles already here, that saves the bandwidth
+    if (edgeFunctionFixPoint(v0, v1, v2) == 0)
+        return false;
+
+    int32_t bbStartX = min(min(v0[0], v1[0]), v2[0]);
+    int32_t bbStartY = min(min(v0[1], v1[1]), v2[1]);
+    int32_t bbEndX = max(max(v0[0], v1[0]), v2[0]);
+    int32_t bbEndY = max(max(v0[1], v1[1]), v2[1]);
+    bbStartX = (bbStartX + HALF_EDGE_FUNC_SIZE) >> EDGE_FUNC_SIZE;
+    bbStartY = (bbStartY + HALF_EDGE_FUNC_SIZE) >> EDGE_FUNC_SIZE;
+    bbEndX = ((bbEndX + HALF_EDGE_FUNC_SIZE) >> EDGE_FUNC_SIZE) + 1;
+    bbEndY = ((bbEndY + HALF_EDGE_FUNC_SIZE) >> EDGE_FUNC_SIZE) + 1;
+
+    // The hardware calculates the edge functions at the start of the clamped bounding box
+    if (!clampBoundingBox(bbStartX, bbStartY, bbEndX, bbEndY, viewport))
+        return false;
+
+    compactTriangle.bbStartX = bbStartX;
+    compactTriangle.bbStartY = bbStartY;
+    compactTriangle.bbEndX = bbEndX;
+    compactTriangle.bbEndY = bbEndY;
+
+    compactTriangle.vXY = {{static_cast<int16_t>(v0[0]), static_cast<int16_t>(v0[1]),
+                            static_cast<int16_t>(v1[0]), static_cast<int16_t>(v1[1]),
+                            static_cast<int16_t>(v2[0]), static_cast<int16_t>(v2[1])}};
+
+    compactTriangle.depthW = vW;
+    compactTriangle.texS = stx;
+    compactTriangle.texT = sty;
+#ifndef NO_PERSP_CORRECT
+    compactTriangle.texS.mul<30>(compactTriangle.depthW);
+    compactTriangle.texT.mul<30>(compactTriangle.depthW);
+#endif
+
+    // The lower bound of the depth must be calculated from the same increments as the TriangleSetup calculates them
+    RasterizedTriangle rasterizedTriangle;
+    setup(rasterizedTriangle, compactTriangle);
+    compactTriangle.triangleConfiguration = calcMinDepth(rasterizedTriangle);
+    return true;
+}
+
+bool Rasterizer::calcLineIncrement(CompactTriangle &incrementedTriangle,
+                                   const CompactTriangle &triangleToIncrement,
+                                   const uint16_t lineStart,
+                                   const uint16_t lineEnd)
+{
+    // Same conditions as the calcLineIncrement() of the RasterizedTriangle
+    if ((triangleToIncrement.bbEndY < lineStart) || (triangleToIncrement.bbStartY >= lineEnd))
+    {
+        return false;
+    }
+
+    // The hardware calculates the edge functions from the vertices. It is enough to move the vertices and the
+    // bounding box into the current display line
+    incrementedTriangle = triangleToIncrement;
+    if (lineStart != 0)
+    {
+        const int16_t lineStartFix = lineStart << 2; // S13.2
+        incrementedTriangle.vXY[1] -= lineStartFix;
+        incrementedTriangle.vXY[3] -= lineStartFix;
+        incrementedTriangle.vXY[5] -= lineStartFix;
+        incrementedTriangle.bbStartY = (triangleToIncrement.bbStartY < lineStart) ? 0 : (triangleToIncrement.bbStartY - lineStart);
+        incrementedTriangle.bbEndY -= lineStart;
+    }
+    return true;
+}
+
+void Rasterizer::setup(RasterizedTriangle &rasterizedTriangle, const CompactTriangle &compactTriangle)
+{
+    rasterizedTriangle.triangleConfiguration = compactTriangle.triangleConfiguration;
+    rasterizedTriangle.triangleStaticColor = compactTriangle.triangleStaticColor;
+    rasterizedTriangle.bbStartX = compactTriangle.bbStartX;
+    rasterizedTriangle.bbStartY = compactTriangle.bbStartY;
+    rasterizedTriangle.bbEndX = compactTriangle.bbEndX;
+    rasterizedTriangle.bbEndY = compactTriangle.bbEndY;
+
+    const Vec2i v0 = {{compactTriangle.vXY[0], compactTriangle.vXY[1]}};
+    const Vec2i v1 = {{compactTriangle.vXY[2], compactTriangle.vXY[3]}};
+    const Vec2i v2 = {{compactTriangle.vXY[4], compactTriangle.vXY[5]}};
+
+    interpolateFixPoint(rasterizedTriangle, v0, v1, v2, compactTriangle.texS, compactTriangle.texT, compactTriangle.depthW,
+                        static_cast<int16_t>(compactTriangle.bbStartX), static_cast<int16_t>(compactTriangle.bbStartY));
+}
+
+uint8_t Rasterizer::calcMipLevel(const Vec4 &v0f,
+                                 const Vec2 &st0f,
+                                 const Vec4 &v1f,
+                                 const Vec2 &st1f,
+                                 const Vec4 &v2f,
+                                 const Vec2 &st2f,
+                                 const uint16_t texSize,
+                                 const uint8_t levels)
+{
+    const float screenArea = std::fabs(edgeFunctionFloat(v0f, v1f, v2f));
+    const float texArea = std::fabs(((st2f[0] - st0f[0]) * (st1f[1] - st0f[1])) - ((st2f[1] - st0f[1]) * (st1f[0] - st0f[0])));
+    const float texelsPerPixel = (texArea * texSize * texSize) / screenArea;
+
+    // Every level has a quarter of the texels of the previous one. Switch to the next level in the geometric middle
+    // between two levels.
+    uint8_t level = 0;
+    while (((level + 1) < levels) && (texelsPerPixel >= static_cast<float>(2 << (2 * level))))
+    {
+        level++;
+    }
+    return level;
+}
+
+uint8_t Rasterizer::calcMipLevel(const Vec4i &v0,
+                                 const Vec2i &st0,
+                                 const Vec4i &v1,
+                                 const Vec2i &st1,
+                                 const Vec4i &v2,
+                                 const Vec2i &st2,
+                                 const uint16_t texSize,
+                                 const uint8_t levels)
+{
+    // Reduce the texture coordinates to 12 fractional bits, so that the areas fit into 64 bit
+    static constexpr uint8_t ST_SHIFT = TEX_COORD_DECIMALS - 12;
+    const int64_t s1 = (st1[0] - st0[0]) >> ST_SHIFT;
+    const int64_t t1 = (st1[1] - st0[1]) >> ST_SHIFT;
+    const int64_t s2 = (st2[0] - st0[0]) >> ST_SHIFT;
+    const int64_t t2 = (st2[1] - st0[1]) >> ST_SHIFT;
+    int64_t texArea = (s2 * t1) - (t2 * s1); // Sn.24
+    texArea = (texArea < 0) ? -texArea : texArea;
+    texArea *= static_cast<int64_t>(texSize) * texSize;
+
+    const int64_t x1 = v1[0] - v0[0];
+    const int64_t y1 = v1[1] - v0[1];
+    const int64_t x2 = v2[0] - v0[0];
+    const int64_t y2 = v2[1] - v0[1];
+    int64_t screenArea = (x2 * y1) - (y2 * x1); // Sn.4 (SCREEN_COORD_DECIMALS * 2)
+    screenArea = (screenArea < 0) ? -screenArea : screenArea;
+    screenArea <<= 24 - (SCREEN_COORD_DECIMALS * 2);
+
+    // Same selection as in the floating point version
+    uint8_t level = 0;
+    while (((level + 1) < levels) && (texArea >= (screenArea * (2 << (2 * level)))))
+    {
+        level++;
+    }
+    return level;
+}
+
+uint16_t Rasterizer::calcMinDepth(const RasterizedTriangle &rasterizedTriangle)
+{
+    // The depth is calculated in the FragmentPipeline with Recip(W >> 15). The interpolated W is linear, so within the
+    // bounding box it is between the minimum and the maximum W of the corners. In the range of 257 to 65535, the
+    // Recip is monotonically decreasing and never below 0xffffff / x. Below 257, the Recip overflows.
+    static constexpr int64_t RECIP_NUMERATOR = 0xffffff;
+    static constexpr int64_t RECIP_MIN_INPUT = 257;
+    static constexpr uint8_t RECIP_INPUT_SHIFT = 15;
+
+    const int64_t dx = rasterizedTriangle.bbEndX - rasterizedTriangle.bbStartX - 1;
+    const int64_t dy = rasterizedTriangle.bbEndY - rasterizedTriangle.bbStartY - 1;
+    const int64_t init = rasterizedTriangle.depthWInit;
+    const int64_t corners[4] = {
+        init,
+        init + (dx * rasterizedTriangle.depthWXInc),
+        init + (dy * rasterizedTriangle.depthWYInc),
+        init + (dx * rasterizedTriangle.depthWXInc) + (dy * rasterizedTriangle.depthWYInc)
+    };
+
+    int64_t minW = corners[0];
+    int64_t maxW = corners[0];
+    for (const int64_t corner : corners)
+    {
+        minW = min(minW, corner);
+        maxW = max(maxW, corner);
+    }
+
+    // The hardware truncates W to 31 bits. Outside of this range, the interpolated W is not linear anymore.
+    if ((minW < 0) || (maxW >= (1ll << 31)) || ((minW >> RECIP_INPUT_SHIFT) < RECIP_MIN_INPUT))
+        return 0;
+
+    return RECIP_NUMERATOR / (maxW >> RECIP_INPUT_SHIFT);
+}
+
 VecInt Rasterizer::calcRecip(VecInt val)
 {
     // Assume DECIMAL_POINT is 12.
@@ -146,35 +419,17 @@ VecInt Rasterizer::edgeFunctionFixPoint(const Vec2i &a, const Vec2i &b, const Ve
 }
 
 bool Rasterizer::rasterizeFixPoint(RasterizedTriangle &rasterizedTriangle,
-                                   const Vec4 &v0f,
-                                   const Vec2& st0f,
-                                   const Vec4 &v1f,
-                                   const Vec2& st1f,
-                                   const Vec4 &v2f,
-                                   const Vec2& st2f)
+                                   const Vec2i &v0,
+                                   const Vec2i &v1,
+                                   const Vec2i &v2,
+                                   const Vec3i &stx,
+                                   const Vec3i &sty,
+                                   const Vec3i &vW,
+                                   const Viewport &viewport)
 {
-    static constexpr uint32_t EDGE_FUNC_SIZE = 2;
-    static constexpr uint32_t HALF_EDGE_FUNC_SIZE = (1 << (EDGE_FUNC_SIZE-1));
-
-    // Convert to a fixed point representation
-    // Use here 4 bits for the integer part. That offers the possibility to use texture coordinates which have a maximum value of 16.
-    // This is required for repetitions. On the hardware, overflows are not a big deal during repeats but if we want to clamp, then an overflow
-    // destroyes the clamp. Keep in mind that the end result is still a s1.30 number which is send to the hardware.
-    Vec3i stx, sty;
-    stx.fromVec<27>({st0f[0], st1f[0], st2f[0]});
-    sty.fromVec<27>({st0f[1], st1f[1], st2f[1]});
-
-    Vec2i v0, v1, v2;
-    v0.fromVec<EDGE_FUNC_SIZE>({v0f[0], v0f[1]});
-    v1.fromVec<EDGE_FUNC_SIZE>({v1f[0], v1f[1]});
-    v2.fromVec<EDGE_FUNC_SIZE>({v2f[0], v2f[1]});
+    static constexpr uint32_t EDGE_FUNC_SIZE = SCREEN_COORD_DECIMALS;
+    static constexpr int32_t HALF_EDGE_FUNC_SIZE = (1 << (EDGE_FUNC_SIZE-1));
 
-    Vec3i vW;
-    // TODO / Note: Using now the w component for the z buffer, which converts the z buffer to a w buffer.
-    // Advantage of a w buffer: All values are equally distributed between 0 and intmax. It seems also to be a better fit for 16bit z buffers
-    // Advantage of a z buffer: More precise than the w buffer on near objects. Distribution is therefore uneven. Seems to be a better choice for more precise z buffers.
-    vW.fromVec<30>({v0f[3], v1f[3], v2f[3]});
-    
     // Initialize Bounding box
     // Get the bounding box
     int32_t bbStartX;
@@ -192,24 +447,66 @@ bool Rasterizer::rasterizeFixPoint(RasterizedTriangle &rasterizedTriangle,
     bbEndX = (bbEndX + HALF_EDGE_FUNC_SIZE) >> EDGE_FUNC_SIZE;
     bbEndY = (bbEndY + HALF_EDGE_FUNC_SIZE) >> EDGE_FUNC_SIZE;
 
-    // Clamp against the view port
-    // Should not be needed when the clipping is enabled
-    //     bbStartX = max(bbStartX, (int32_t)0);
-    //     bbStartY = max(bbStartY, (int32_t)0);
-    //     bbEndX = min(bbEndX + 1, 480); // Increase the size at the end of the bounding box a bit. It can happen otherwise that triangles is discarded because it was too small
-    //     bbEndY = min(bbEndY + 1, 272);
-    // Check if the bounding box has at least a width of one. Otherwise the hardware will stuck.
-    //    if ((bbEndX - bbStartX) == 0)
-    //        return false;
     ++bbEndX; // Increase the size at the end of the bounding box a bit. It can happen otherwise that triangles is discarded because it was too small
     ++bbEndY;
 
+    // Clamp against the view port. The edge functions and attributes are then calculated from the start of the
+    // clamped bounding box.
+    if (!clampBoundingBox(bbStartX, bbStartY, bbEndX, bbEndY, viewport))
+        return false;
+
 
     rasterizedTriangle.bbStartX = bbStartX;
     rasterizedTriangle.bbStartY = bbStartY;
     rasterizedTriangle.bbEndX = bbEndX;
     rasterizedTriangle.bbEndY = bbEndY;
 
+    // Calc perspective correction
+    // For the attribute calculation, always use the w component. The w component at this point is already the reciprocal, so just multiply
+#ifndef NO_PERSP_CORRECT
+    Vec3i stxW{stx};
+    Vec3i styW{sty};
+    stxW.mul<30>(vW);
+    styW.mul<30>(vW);
+    if (!interpolateFixPoint(rasterizedTriangle, v0, v1, v2, stxW, styW, vW, bbStartX, bbStartY))
+        return false;
+#else
+    if (!interpolateFixPoint(rasterizedTriangle, v0, v1, v2, stx, sty, vW, bbStartX, bbStartY))
+        return false;
+#endif
+    rasterizedTriangle.triangleConfiguration = calcMinDepth(rasterizedTriangle);
+    return true;
+}
+
+bool Rasterizer::clampBoundingBox(int32_t &bbStartX,
+                                  int32_t &bbStartY,
+                                  int32_t &bbEndX,
+                                  int32_t &bbEndY,
+                                  const Viewport &viewport)
+{
+    // Triangles which are crossing the edges of the viewport are not always clipped (see the guard band in the TnL).
+    // The hardware can't handle bounding boxes outside of the screen, therefore clamp them against the viewport
+    bbStartX = max(bbStartX, viewport.x);
+    bbStartY = max(bbStartY, viewport.y);
+    bbEndX = min(bbEndX, viewport.x + viewport.width);
+    bbEndY = min(bbEndY, viewport.y + viewport.height);
+
+    // Check if the bounding box has at least a width of one. Otherwise the hardware will stuck.
+    return (bbStartX < bbEndX) && (bbStartY < bbEndY);
+}
+
+bool Rasterizer::interpolateFixPoint(RasterizedTriangle &rasterizedTriangle,
+                                     const Vec2i &v0,
+                                     const Vec2i &v1,
+                                     const Vec2i &v2,
+                                     const Vec3i &stx,
+                                     const Vec3i &sty,
+                                     const Vec3i &vW,
+                                     const int32_t bbStartX,
+                                     const int32_t bbStartY)
+{
+    static constexpr uint32_t EDGE_FUNC_SIZE = 2;
+
     VecInt area = edgeFunctionFixPoint(v0, v1, v2); // Sn.4
 
     VecInt sign = -1; // 1 backface culling; -1 frontface culling
@@ -259,13 +556,6 @@ bool Rasterizer::rasterizeFixPoint(RasterizedTriangle &rasterizedTriangle,
     Vec3i wIncYNorm(wIncY);
     wIncYNorm.mul<6>(areaInv);
 
-    // Calc perspective correction
-    // For the attribute calculation, always use the w component. The w component at this point is already the reciprocal, so just multiply
-#ifndef NO_PERSP_CORRECT
-    stx.mul<30>(vW);
-    sty.mul<30>(vW);
-#endif
-
     // Interpolate texture
     rasterizedTriangle.texStInit[0] = stx.dot<19>(wNorm); // (Sn.27 * Sn.22 = Sn.49 >> 19 = Sn.30)
     rasterizedTriangle.texStInit[1] = sty.dot<19>(wNorm);
@@ -279,21 +569,6 @@ bool Rasterizer::rasterizeFixPoint(RasterizedTriangle &rasterizedTriangle,
     rasterizedTriangle.depthWXInc = vW.dot<22>(wIncXNorm);
     rasterizedTriangle.depthWYInc = vW.dot<22>(wIncYNorm);
 
-#ifdef SOFTWARE_RENDERER
-    // During the H increment, only increment as much, that after the H increment, we are at the beginning of the bounding box
-    // That means, if we have a full line increment, we would be after the H increment again at the end of the bounding box
-    // With this calculation, we substracting from the H increment the width of the bounding box. That causes, that we start
-    // at the beginning of the bounding box
-
-    // Use this when no edge walking algorihm is implemented
-    VecInt bbDiff = bbEndX - bbStartX;
-    wIncY[0] = wIncY[0] - (wIncX[0] * bbDiff);
-    wIncY[1] = wIncY[1] - (wIncX[1] * bbDiff);
-    wIncY[2] = wIncY[2] - (wIncX[2] * bbDiff);
-    rasterizedTriangle.texStYInc[0] = rasterizedTriangle.texStYInc[0] - (rasterizedTriangle.texStXInc[0] * bbDiff);
-    rasterizedTriangle.texStYInc[1] = rasterizedTriangle.texStYInc[1] - (rasterizedTriangle.texStXInc[1] * bbDiff);
-    rasterizedTriangle.depthWYInc  = rasterizedTriangle.depthWYInc  - (rasterizedTriangle.depthWXInc  * bbDiff);
-#endif
     return true;
 }
 
@@ -413,21 +688,6 @@ bool Rasterizer::rasterizeFloat(RasterizedTriangle &rasterizedTriangle,
     float wDepthIncX = vW.dot(wIncXNorm);
     float wDepthIncY = vW.dot(wIncYNorm);
 
-#ifdef SOFTWARE_RENDERER
-    // During the H increment, only increment as much, that after the H increment, we are at the beginning of the bounding box
-    // That means, if we have a full line increment, we would be after the H increment again at the end of the bounding box
-    // With this calculation, we substracting from the H increment the width of the bounding box. That causes, that we start
-    // at the beginning of the bounding box
-
-    // Use this when no edge walking algorihm is implemented
-    VecInt bbDiff = bbEndX - bbStartX;
-    wIncY[0] = wIncY[0] - (wIncX[0] * bbDiff);
-    wIncY[1] = wIncY[1] - (wIncX[1] * bbDiff);
-    wIncY[2] = wIncY[2] - (wIncX[2] * bbDiff);
-    sth[0] = sth[0] - (stw[0] * bbDiff);
-    sth[1] = sth[1] - (stw[1] * bbDiff);
-    wDepthIncY  = wDepthIncY  - (wDepthIncX  * bbDiff);
-#endif
 
     rasterizedTriangle.wInit.fromVec<4>({wi[0], wi[1], wi[2]});
     rasterizedTriangle.wXInc.fromVec<4>({wIncX[0], wIncX[1], wIncX[2]});
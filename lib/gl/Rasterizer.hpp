@@ -26,7 +26,7 @@ class Rasterizer
 public:  
     struct __attribute__ ((__packed__)) RasterizedTriangle
     {
-        uint16_t triangleConfiguration;
+        uint16_t triangleConfiguration; // Lower bound of the depth values of the triangle (see calcMinDepth())
         uint16_t triangleStaticColor;
         uint16_t bbStartX;
         uint16_t bbStartY;
@@ -42,6 +42,46 @@ public:
         VecInt depthWXInc;
         VecInt depthWYInc;
     };
+
+    // Compact triangle descriptor for hardware with its own triangle setup stage (see TriangleSetup.v). It only contains
+    // the screen space vertices, the W and the texture coordinates. The edge functions and the increments are calculated
+    // on the FPGA. The bounding box is still calculated here. It is cheap and required to sort the triangle into the display lines.
+    struct __attribute__ ((__packed__)) CompactTriangle
+    {
+        uint16_t triangleConfiguration; // Same as in the RasterizedTriangle
+        uint16_t triangleStaticColor;
+        uint16_t bbStartX;
+        uint16_t bbStartY;
+        uint16_t bbEndX;
+        uint16_t bbEndY;
+        std::array<int16_t, 6> vXY; // x0, y0, x1, y1, x2, y2 in S13.2
+        Vec3i depthW; // S1.30
+        Vec3i texS; // S4.27, already multiplied with W when perspective correction is enabled
+        Vec3i texT; // S4.27, already multiplied with W when perspective correction is enabled
+    };
+
+    // Area of the screen in pixels in which the triangles are rasterized. The bounding box of a triangle is clamped
+    // to this area, everything outside of it is discarded.
+    struct Viewport
+    {
+        int32_t x;
+        int32_t y;
+        int32_t width;
+        int32_t height;
+    };
+
+    // The triangle descriptor which is sent to the hardware
+#ifdef HARDWARE_TRIANGLE_SETUP
+    using TriangleDescriptor = CompactTriangle;
+#else
+    using TriangleDescriptor = RasterizedTriangle;
+#endif
+
+    // Fix point formats (number of fractional bits) of the vertex attributes which are used by the rasterizer
+    static constexpr uint8_t SCREEN_COORD_DECIMALS = 2; // x and y in screen coordinates
+    static constexpr uint8_t DEPTH_W_DECIMALS = 30; // Reciprocal of w
+    static constexpr uint8_t TEX_COORD_DECIMALS = 27; // Texture coordinates, before the perspective correction
+
     Rasterizer();
     static bool rasterize(RasterizedTriangle &rasterizedTriangle,
                           const Vec4 &v0f,
@@ -49,23 +89,119 @@ public:
                           const Vec4 &v1f,
                           const Vec2 &st1f,
                           const Vec4 &v2f,
-                          const Vec2 &st2f);
+                          const Vec2 &st2f,
+                          const Viewport &viewport);
+
+    static bool rasterize(CompactTriangle &compactTriangle,
+                          const Vec4 &v0f,
+                          const Vec2 &st0f,
+                          const Vec4 &v1f,
+                          const Vec2 &st1f,
+                          const Vec4 &v2f,
+                          const Vec2 &st2f,
+                          const Viewport &viewport);
+
+    /// @brief Rasterizes a triangle which is already in the fix point formats of the rasterizer (see TNL_FIX_POINT)
+    /// @param v0 x and y with SCREEN_COORD_DECIMALS and the reciprocal of w with DEPTH_W_DECIMALS. z is not used.
+    /// @param st0 Texture coordinates with TEX_COORD_DECIMALS
+    /// @return false if the triangle is not visible
+    static bool rasterize(RasterizedTriangle &rasterizedTriangle,
+                          const Vec4i &v0,
+                          const Vec2i &st0,
+                          const Vec4i &v1,
+                          const Vec2i &st1,
+                          const Vec4i &v2,
+                          const Vec2i &st2,
+                          const Viewport &viewport);
+
+    static bool rasterize(CompactTriangle &compactTriangle,
+                          const Vec4i &v0,
+                          const Vec2i &st0,
+                          const Vec4i &v1,
+                          const Vec2i &st1,
+                          const Vec4i &v2,
+                          const Vec2i &st2,
+                          const Viewport &viewport);
 
     static bool calcLineIncrement(RasterizedTriangle &incrementedTriangle,
                                   const RasterizedTriangle &triangleToIncrement,
                                   const uint16_t lineStart,
                                   const uint16_t lineEnd);
 
+    static bool calcLineIncrement(CompactTriangle &incrementedTriangle,
+                                  const CompactTriangle &triangleToIncrement,
+                                  const uint16_t lineStart,
+                                  const uint16_t lineEnd);
+
+    /// @brief Calculates the edge functions and increments of a compact triangle. This is the same calculation
+    /// which is executed on the FPGA in the TriangleSetup and can be used as reference implementation.
+    /// @param rasterizedTriangle The resulting triangle
+    /// @param compactTriangle The compact triangle (already moved into the display line with calcLineIncrement())
+    static void setup(RasterizedTriangle &rasterizedTriangle, const CompactTriangle &compactTriangle);
+
+    /// @brief Selects the mip level of a texture for a triangle. It uses the ratio of the area of the triangle in the
+    /// texture to its area on the screen, which is the average number of texels per pixel. A level is selected, when
+    /// the number of texels per pixel of the level is nearest to one.
+    /// @param texSize The width of level 0 in texels
+    /// @param levels The number of available levels
+    /// @return The level, between 0 and levels - 1
+    static uint8_t calcMipLevel(const Vec4 &v0f,
+                                const Vec2 &st0f,
+                                const Vec4 &v1f,
+                                const Vec2 &st1f,
+                                const Vec4 &v2f,
+                                const Vec2 &st2f,
+                                const uint16_t texSize,
+                                const uint8_t levels);
+
+    /// @brief Same as calcMipLevel() for vertices in the fix point formats of the rasterizer (see TNL_FIX_POINT)
+    static uint8_t calcMipLevel(const Vec4i &v0,
+                                const Vec2i &st0,
+                                const Vec4i &v1,
+                                const Vec2i &st1,
+                                const Vec4i &v2,
+                                const Vec2i &st2,
+                                const uint16_t texSize,
+                                const uint8_t levels);
+
     static float edgeFunctionFloat(const Vec4 &a, const Vec4 &b, const Vec4 &c);
 private:
     static constexpr uint64_t DECIMAL_POINT = 12;
     inline static bool rasterizeFixPoint(RasterizedTriangle &rasterizedTriangle,
-                                         const Vec4 &v0f,
-                                         const Vec2 &st0f,
-                                         const Vec4 &v1f,
-                                         const Vec2 &st1f,
-                                         const Vec4 &v2f,
-                                         const Vec2 &st2f);
+                                         const Vec2i &v0,
+                                         const Vec2i &v1,
+                                         const Vec2i &v2,
+                                         const Vec3i &stx,
+                                         const Vec3i &sty,
+                                         const Vec3i &vW,
+                                         const Viewport &viewport);
+    inline static bool rasterizeFixPoint(CompactTriangle &compactTriangle,
+                                         const Vec2i &v0,
+                                         const Vec2i &v1,
+                                         const Vec2i &v2,
+                                         const Vec3i &stx,
+                                         const Vec3i &sty,
+                                         const Vec3i &vW,
+                                         const Viewport &viewport);
+    inline static bool clampBoundingBox(int32_t &bbStartX,
+                                        int32_t &bbStartY,
+                                        int32_t &bbEndX,
+                                        int32_t &bbEndY,
+                                        const Viewport &viewport);
+    inline static bool interpolateFixPoint(RasterizedTriangle &rasterizedTriangle,
+                                           const Vec2i &v0,
+                                           const Vec2i &v1,
+                                           const Vec2i &v2,
+                                           const Vec3i &stx,
+                                           const Vec3i &sty,
+                                           const Vec3i &vW,
+                                           const int32_t bbStartX,
+                                           const int32_t bbStartY);
+    /// @brief Calculates a lower bound of the depth values which the FragmentPipeline calculates from the interpolated W
+    /// of the triangle. The hierarchical depth test of the hardware and the front to back sorting use it.
+    /// @param rasterizedTriangle The triangle with the interpolated W
+    /// @return The lower bound or zero, if no lower bound can be calculated
+    inline static uint16_t calcMinDepth(const RasterizedTriangle &rasterizedTriangle);
     inline static VecInt edgeFunctionFixPoint(const Vec2i &a, const Vec2i &b, const Vec2i &c);
     inline static VecInt calcRecip(VecInt val);
 
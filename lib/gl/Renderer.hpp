@@ -20,13 +20,23 @@
 
 #include <stdint.h>
 #include <array>
-#include "Vec.hpp"
-#include "IRenderer.hpp"
-#include "IBusConnector.hpp"
-#include "DisplayList.hpp"
-#include "Rasterizer.hpp"
+#include <type_traits>
+#ifdef RENDERER_FRONT_TO_BACK
+#include <algorithm>
+#endif
+#include "RendererBase.hpp"
+#include "DirtyWindow.hpp"
 #include <string.h>
 
+#ifdef RENDERER_THREADED
+#ifndef RENDERER_YIELD
+// Called by commit() while it waits for the upload thread. Redefine it for platforms without std::thread (for instance
+// with a yield of the RTOS or an empty define).
+#include <thread>
+#define RENDERER_YIELD() std::this_thread::yield()
+#endif
+#endif
+
 // Screen
 // <-----------------X_RESOLUTION--------------------------->
 // +--------------------------------------------------------+ ^
@@ -53,70 +63,137 @@
 // This renderer collects all triangles in a single display list. Later, when the display list is uploaded, this renderer
 // will create sub display lists for each display line. This approach is more memory efficient because every triangle is saved
 // only once, but because it has to reinterpret the display list during upload, it is slower then the approach in the
-// RendererBuckets. This renderer will preallocate for every display line one display list and will dispatch each incoming
+// RendererBuckets. The RendererBuckets will preallocate for every display line one display list and will dispatch each incoming
 // triangle to the buckets. It should be faster but it is less memory efficient because a triangle is potentially saved
 // several times.
 // The BUS_WIDTH is used to calculate the alignment in the display list.
-template <uint32_t DISPLAY_LIST_SIZE = 2048, uint16_t DISPLAY_LINES = 1, uint16_t LINE_RESOLUTION = 128, uint16_t BUS_WIDTH = 32, uint16_t MAX_NUMBER_OF_TEXTURES = 64>
-class Renderer : public IRenderer
+// The HARDWARE_BUFFER_SIZE is the size of the chunks which are uploaded. It must match the FIFO of the hardware (see
+// Serial2AXIS::CHUNK_SIZE) and must be a multiple of BUS_WIDTH / 8.
+// The DISPLAY_BUFFERS are the number of display lists. They are used as a ring: one list is filled while the others
+// are uploaded or are waiting for their upload. commit() only blocks when all lists are in use.
+// Define RENDERER_THREADED to split the renderer into two threads (or cores): The thread which is using the renderer
+// fills the back display list, while a second thread compiles and uploads the front list via upload() (see
+// RendererUploadThread.hpp). The lists are handed over with the list state, no mutex is required. The upload of a
+// frame then overlaps with the geometry of the next frame.
+// Define RENDERER_FRONT_TO_BACK to sort the triangles front to back in commit(), so that the hierarchical depth test
+// of the hardware (see HierarchicalDepthBuffer.v) can reject the hidden triangles.
+// Define RENDERER_DIRTY_WINDOW to send only the changed area of a display line to the display: the union of the bounding
+// boxes of its triangles, or the whole line if the color buffer is cleared. Display lines without changes are not
+// committed at all. The area is set with the commit window registers before a commit, it requires a display controller
+// which supports it (see DisplayControllerSpi::ENABLE_COMMIT_WINDOW). The frame buffer of the hardware only holds one
+// display line. With more than one display line, it still contains the previous display line when the color buffer is
+// not cleared, therefore every display line is then committed completely. The dirty window only saves bandwidth when
+// DISPLAY_LINES is 1.
+// The DEVICES are the number of RasteriCEr FPGAs which are rendering the frame together. Every device has its own bus
+// connector and renders a band of consecutive display lines. All devices are reading their display lines from the same
+// front list, each one with its own read position, texture residency and upload list, so that the uploads of the devices
+// are running concurrently. The bands are balanced by the number of triangles of the display lines in the previous frame.
+template <uint32_t DISPLAY_LIST_SIZE = 2048, uint16_t DISPLAY_LINES = 1, uint16_t LINE_RESOLUTION = 128, uint16_t BUS_WIDTH = 32, uint16_t MAX_NUMBER_OF_TEXTURES = 64, uint8_t DISPLAY_BUFFERS = 2, uint32_t HARDWARE_BUFFER_SIZE = 2048, uint8_t DEVICES = 1>
+class Renderer : public RendererBase<BUS_WIDTH, MAX_NUMBER_OF_TEXTURES, HARDWARE_BUFFER_SIZE>
 {
+    static_assert(DISPLAY_BUFFERS >= 2, "At least two display lists are required");
+    static_assert((DEVICES >= 1) && (DEVICES <= DISPLAY_LINES), "Every device requires at least one display line");
 public:
     Renderer(IBusConnector& busConnector)
-        : m_busConnector(busConnector)
+        : Renderer(std::array<IBusConnector*, DEVICES>{{&busConnector}})
     {
-        m_displayList[0].clear();
-        m_displayList[1].clear();
+        static_assert(DEVICES == 1, "Use the constructor with one bus connector per device");
+    }
 
-        for (auto& texture : m_textures)
+    /// @brief Creates a renderer which renders with several devices
+    /// @param busConnectors The bus connectors of the devices, the first device renders the lowest display lines
+    Renderer(const std::array<IBusConnector*, DEVICES>& busConnectors)
+    {
+        for (uint32_t i = 0; i < DEVICES; i++)
         {
-            texture.inUse = false;
+            m_devices[i].busConnector = busConnectors[i];
+        }
+        m_lineTriangles.fill(0);
+        for (auto& displayList : m_displayList)
+        {
+            displayList.clear();
         }
-
-        // Unfortunately the Arduino compiler is too old and does not support C++20 default member initializers in bit fields
-#ifndef NO_PERSP_CORRECT
-        m_confReg2.perspectiveCorrectedTextures = true;
-#else
-        m_confReg2.perspectiveCorrectedTextures = false;
-#endif
-
-        setDepthFunc(TestFunc::LESS);
-        setDepthMask(false);
-        setColorMask(true, true, true, true);
-        setAlphaFunc(TestFunc::ALWAYS, 0xf);
-        setTexEnv(TexEnvTarget::TEXTURE_ENV, TexEnvParamName::TEXTURE_ENV_MODE, TexEnvParam::MODULATE);
-        setBlendFunc(BlendFunc::ONE, BlendFunc::ZERO);
-        setLogicOp(LogicOp::COPY);
-        setTexEnvColor({{0, 0, 0, 0}});
-        setClearColor({{0, 0, 0, 0}});
-        setClearDepth(65535);
     }
 
-    virtual bool drawTriangle(const Vec4& v0,
-                              const Vec4& v1,
-                              const Vec4& v2,
-                              const Vec2& st0,
-                              const Vec2& st1,
-                              const Vec2& st2,
+    virtual bool drawTriangle(const IRenderer::Vertex& v0,
+                              const IRenderer::Vertex& v1,
+                              const IRenderer::Vertex& v2,
+                              const IRenderer::TexCoord& st0,
+                              const IRenderer::TexCoord& st1,
+                              const IRenderer::TexCoord& st2,
                               const Vec4i& color) override
     {
-        Rasterizer::RasterizedTriangle triangleConf;
+        Rasterizer::TriangleDescriptor triangleConf;
 
-        if (!Rasterizer::rasterize(triangleConf, v0, st0, v1, st1, v2, st2))
+        const uint32_t start = m_statistics.start();
+        const bool visible = Rasterizer::rasterize(triangleConf, v0, st0, v1, st1, v2, st2, m_viewport);
+        m_statistics.addTime(&RendererStats::rasterizeTime, start);
+        if (!visible)
         {
             // Triangle is not visible
+            m_statistics.add(&RendererStats::invisibleTriangles);
             return true;
         }
 
         triangleConf.triangleStaticColor = convertColor(color);
 
-        bool retVal = appendStreamCommand(StreamCommand::TRIANGLE_FULL, triangleConf);
+        const Texture* tex = m_boundTexId ? m_textureStore.use(m_boundTexId) : nullptr;
+        uint8_t level = NO_MIP_LEVEL;
+        if (tex && (tex->levels > 1))
+        {
+            // Only the mip level which fits to the size of this triangle is streamed
+            level = Rasterizer::calcMipLevel(v0, st0, v1, st1, v2, st2, tex->width, tex->levels);
+            if (!streamTextureLevel(level))
+            {
+                return false;
+            }
+        }
+
+        if (!hasEnoughSpace(m_displayList[m_backList], TRIANGLE_REGS))
+        {
+            m_statistics.add(&RendererStats::displayListOverflows);
+            return false;
+        }
+        writeRegs(TRIANGLE_REGS);
+        bool retVal = appendStreamCommand(StreamCommand::TRIANGLE_DESCRIPTOR, triangleConf);
+        if (retVal)
+        {
+            m_statistics.add(&RendererStats::rasterizedTriangles);
+            if (m_recordedTriangles)
+            {
+                recordTriangle(triangleConf, level);
+            }
+        }
         // Should have a really low performance impact to trigger a upload after each triangle...
-        uploadDisplayList();
+        triggerUpload();
         return retVal;
     }
 
+    virtual bool drawRecordedTriangles(const std::vector<uint8_t>& buffer) override
+    {
+        // The triangles between two mip level entries (see recordTriangle()) are copied with one memcpy
+        uint32_t runStart = 0;
+        for (uint32_t pos = 0; (pos + RECORDED_TRIANGLE_SIZE) <= buffer.size(); pos += RECORDED_TRIANGLE_SIZE)
+        {
+            uint8_t level;
+            if (isRecordedTriangle(&buffer[pos], level))
+            {
+                continue;
+            }
+            if (!drawRecordedRun(buffer.data() + runStart, pos - runStart) || !streamTextureLevel(level))
+            {
+                return false;
+            }
+            runStart = pos + RECORDED_TRIANGLE_SIZE;
+        }
+        return drawRecordedRun(buffer.data() + runStart, buffer.size() - runStart);
+    }
+
     virtual void commit() override
     {
+#ifdef RENDERER_FRONT_TO_BACK
+        sortFrontToBack(m_displayList[m_backList]);
+#endif
         // Add frame buffer flush command
         SCT *op = m_displayList[m_backList].template create<SCT>();
         if (op)
@@ -129,38 +206,80 @@ public:
             // sync with the display output. Otherwise the hardware will not send the current framebuffer slice
             // to the frame buffer which causes that the image will move because of skiped lines
             m_displayList[m_backList].clear();
+            m_listRegsValid = 0;
+            m_statistics.add(&RendererStats::displayListOverflows);
+            m_statistics.commit();
             return;
         }
+        m_statistics.set(&RendererStats::displayListBytes, m_displayList[m_backList].getSize());
 
-        // Check if all front display lists are empty
-        // If no display list is empty, block as long as all the lists from the frontList are transferred
-        while (uploadDisplayList())
-            ;
-
-        // Enqueue all lists from the back display list
+        // Enqueue the back display list and continue with the next list of the ring
         m_displayList[m_backList].enqueue();
+        m_backList = nextList(m_backList);
+        m_textureStore.frameCommitted();
 
-        // Switch the display lists
-        if (m_backList == 0)
+        // If the ring is full, block as long as the next list is transferred
+        const uint32_t start = m_statistics.start();
+        while (m_displayList[m_backList].state() != List::State::IDLE)
         {
-            m_backList = 1;
-            m_frontList = 0;
+#ifdef RENDERER_THREADED
+            // The upload thread sets the state of the list to IDLE when it is transferred. Give it the CPU meanwhile.
+            // Use tryCommit() to do other work instead of waiting.
+            RENDERER_YIELD();
+#else
+            uploadDisplayList();
+#endif
         }
-        else
+        m_statistics.addTime(&RendererStats::commitTime, start);
+        m_statistics.commit();
+        // The list is idle, so its upload counters are complete and the upload thread does not access them anymore
+        m_uploadStatistics[m_backList].commit();
+
+        // Every display line starts with the state of the end of the previous display line. Therefore force that
+        // the registers are written again into the new list, before they are used the first time.
+        m_listRegsValid = 0;
+
+        // Triggers an upload
+        triggerUpload();
+    }
+
+    virtual bool tryCommit() override
+    {
+        // The commit only blocks, when the next list of the ring is still in use
+        if (m_displayList[nextList(m_backList)].state() != List::State::IDLE)
         {
-            m_backList = 0;
-            m_frontList = 1;
+            triggerUpload();
+            return false;
         }
+        commit();
+        return true;
+    }
 
-        // Triggers an upload
-        uploadDisplayList();
+    virtual void getFrameStats(FrameStats& stats) const override
+    {
+        stats.renderer = m_statistics.get();
+        stats.upload = m_uploadStatistics[m_backList].get();
     }
 
     virtual bool clear(bool colorBuffer, bool depthBuffer) override
     {
+        if (m_frameCovered && colorBuffer)
+        {
+            // The application overwrites every pixel, the clear of the color buffer is not required
+            colorBuffer = false;
+            m_statistics.add(&RendererStats::elidedClears);
+        }
         const SCT opColorBuffer = StreamCommand::FRAMEBUFFER_MEMSET | StreamCommand::FRAMEBUFFER_COLOR;
         const SCT opDepthBuffer = StreamCommand::FRAMEBUFFER_MEMSET | StreamCommand::FRAMEBUFFER_DEPTH;
 
+        if (!hasEnoughSpace(m_displayList[m_backList], CLEAR_REGS))
+        {
+            m_statistics.add(&RendererStats::displayListOverflows);
+            return false;
+        }
+        // The memset uses the clear values and the masks from the conf reg1
+        writeRegs(CLEAR_REGS);
+
         SCT *op = m_displayList[m_backList].template create<SCT>();
         if (op)
         {
@@ -184,354 +303,617 @@ public:
         return op != nullptr;
     }
 
-    virtual bool setClearColor(const Vec4i& color) override
+    virtual bool useTexture(const uint16_t texId) override 
     {
-        return appendStreamCommand(StreamCommand::SET_COLOR_BUFFER_CLEAR_COLOR, convertColor(color));
-    }
+        const Texture* tex = m_textureStore.use(texId);
+        if (!tex || texId == 0)
+        {
+            return false;
+        }
 
-    virtual bool setClearDepth(uint16_t depth) override
-    {
-        return appendStreamCommand(StreamCommand::SET_DEPTH_BUFFER_CLEAR_DEPTH, depth);
-    }
+        SCT op;
+        TextureStreamArg tsa;
+        if (!getTextureStream(op, tsa, *tex, texId, 0))
+        {
+            return false; // Not supported texture format
+        }
 
-    virtual bool setDepthMask(const bool flag) override
-    {
-        m_confReg1.depthMask = flag;
-        return appendStreamCommand(StreamCommand::SET_CONF_REG1, m_confReg1);
+        m_boundTexId = texId;
+        if (tex->levels > 1)
+        {
+            // The level is selected by the first triangle which uses the texture (see drawTriangle())
+            m_boundTextureLevel = LEVEL_NOT_STREAMED;
+            return true;
+        }
+        m_boundTextureLevel = 0;
+        return appendStreamCommand(op, tsa);
     }
 
-    virtual bool enableDepthTest(const bool enable) override
+    virtual bool deleteTexture(const uint16_t texId) override 
     {
-        m_confReg1.enableDepthTest = enable;
-        return appendStreamCommand(StreamCommand::SET_CONF_REG1, m_confReg1);
+        return m_textureStore.destroy(texId);
     }
 
-    virtual bool setColorMask(const bool r, const bool g, const bool b, const bool a) override
+#ifdef RENDERER_THREADED
+    /// @brief Compiles and uploads the display lists which were handed over by commit(). With RENDERER_THREADED,
+    /// this has to be called continuously from a second thread or core (for instance from the core1 entry of a RP2040,
+    /// from a task which is pinned to the second core of an ESP32 or from the RendererUploadThread). This thread
+    /// is the only one which accesses the bus connector.
+    /// @return true if an upload is in progress
+    bool upload()
     {
-        m_confReg1.colorMaskA = a;
-        m_confReg1.colorMaskB = b;
-        m_confReg1.colorMaskG = g;
-        m_confReg1.colorMaskR = r;
-        return appendStreamCommand(StreamCommand::SET_CONF_REG1, m_confReg1);
+        return uploadDisplayList();
     }
+#endif
 
-    virtual bool setDepthFunc(const TestFunc func) override
-    {
-        m_confReg1.depthFunc = func;
-        return appendStreamCommand(StreamCommand::SET_CONF_REG1, m_confReg1);
-    }
 
-    virtual bool setAlphaFunc(const TestFunc func, const uint8_t ref) override
-    {
-        m_confReg1.alphaFunc = func;
-        m_confReg1.referenceAlphaValue = ref;
-        return appendStreamCommand(StreamCommand::SET_CONF_REG1, m_confReg1);
-    }
+private:
+    using Base = RendererBase<BUS_WIDTH, MAX_NUMBER_OF_TEXTURES, HARDWARE_BUFFER_SIZE>;
+    using TestFunc = IRenderer::TestFunc;
+    using BlendFunc = IRenderer::BlendFunc;
+    using typename Base::StreamCommand;
+    using typename Base::SCT;
+    using typename Base::RegMask;
+    using typename Base::TextureStreamArg;
+    using typename Base::Texture;
+    using typename Base::ListUpload;
+    using typename Base::ConfReg1;
+    using typename Base::ConfReg2;
+    using Base::MAX_DESCRIPTORS;
+    using Base::RECORDED_TRIANGLE_SIZE;
+    using Base::NO_MIP_LEVEL;
+    using Base::NUMBER_OF_REGS;
+    using Base::REG_MASK_CONF_REG1;
+    using Base::REG_MASK_CONF_REG2;
+    using Base::TRIANGLE_REGS;
+    using Base::CLEAR_REGS;
+    using Base::isSameTexture;
+    using Base::getTextureStream;
+    using Base::bindTexture;
+    using Base::appendTextureDescriptors;
+    using Base::convertColor;
+    using Base::recordTriangle;
+    using Base::isRecordedTriangle;
+    using Base::m_viewport;
+    using Base::m_recordedTriangles;
+    using Base::m_regs;
+    using Base::m_regsPending;
+    using Base::m_eliminatedRegWrites;
+    using Base::m_frameCovered;
+    using Base::m_statistics;
+    using Base::m_textureStore;
 
-    virtual bool setTexEnv(const TexEnvTarget target, const TexEnvParamName pname, const TexEnvParam param) override
-    {
-        (void)target; // Only TEXTURE_ENV is supported
-        (void)pname; // Only GL_TEXTURE_ENV_MODE is supported
-        m_confReg2.texEnvFunc = param;
-        return appendStreamCommand(StreamCommand::SET_CONF_REG2, m_confReg2);
-    }
+    using List = DisplayList<DISPLAY_LIST_SIZE, BUS_WIDTH / 8>;
+    static constexpr uint8_t LEVEL_NOT_STREAMED = NO_MIP_LEVEL; // The bound texture is not yet in the display list
 
-    virtual bool setBlendFunc(const BlendFunc sfactor, const BlendFunc dfactor) override
+    /// @brief Appends the texture stream command of a mip level of the bound texture, if this level is not already
+    /// the last streamed one
+    /// @param level The mip level
+    /// @return false if the display list is full
+    bool streamTextureLevel(const uint8_t level)
     {
-        m_confReg2.blendFuncSFactor = sfactor;
-        m_confReg2.blendFuncDFactor = dfactor;
-        return appendStreamCommand(StreamCommand::SET_CONF_REG2, m_confReg2);
+        if (level == m_boundTextureLevel)
+        {
+            return true;
+        }
+        const Texture* tex = m_textureStore.use(m_boundTexId);
+        SCT op;
+        TextureStreamArg tsa;
+        if (!tex || (level >= tex->levels) || !getTextureStream(op, tsa, *tex, m_boundTexId, level))
+        {
+            // The texture was changed or deleted since it was bound. Keep the last streamed texture.
+            return true;
+        }
+        if (!appendStreamCommand(op, tsa))
+        {
+            return false;
+        }
+        m_boundTextureLevel = level;
+        return true;
     }
 
-    virtual bool setLogicOp(const LogicOp opcode) override
+    // Upload state of a device (see DEVICES)
+    struct Device
     {
-        (void)opcode;
-        return false;
-    }
+        IBusConnector* busConnector = nullptr;
+        ListUpload displayListUpload __attribute__ ((aligned (8)));
+        std::array<IBusConnector::DataDescriptor, MAX_DESCRIPTORS> descriptors;
+        TextureStreamArg textureStreamArg{nullptr, 0, IRenderer::RGBA4444, 0, 0, 0}; // The texture which is active on the device
+        TextureResidency<> textureResidency;
+#ifdef RENDERER_DIRTY_WINDOW
+        DirtyWindow<LINE_RESOLUTION> dirtyWindow; // Changed area of the display line which is currently uploaded
+#endif
+        uint32_t bandStart = 0; // First display line of the band of this device
+        uint32_t bandEnd = DISPLAY_LINES; // First display line after the band
+        uint32_t uploadIndexPosition = 0; // The display line which is currently uploaded
+        uint32_t getPos = 0; // Read position in the front list
+        bool done = true; // The band of the front list is uploaded
+    };
 
-    virtual bool setTexEnvColor(const Vec4i& color) override
+    /// @brief Writes all registers selected by the mask into the display list, if they differ from the ones which were
+    /// last written into the display list. The display list must have enough space (see hasEnoughSpace())
+    /// @param mask The registers to write
+    void writeRegs(const RegMask mask)
     {
-        return appendStreamCommand(StreamCommand::SET_TEX_ENV_COLOR, convertColor(color));
+        for (uint32_t i = 0; i < NUMBER_OF_REGS; i++)
+        {
+            const RegMask regMask = 1 << i;
+            if (mask & regMask)
+            {
+                if (!(m_listRegsValid & regMask) || (m_listRegs[i] != m_regs[i]))
+                {
+                    *(m_displayList[m_backList].template create<SCT>()) = StreamCommand::SET_REG | i;
+                    *(m_displayList[m_backList].template create<uint16_t>()) = m_regs[i];
+                    m_listRegs[i] = m_regs[i];
+                    m_listRegsValid |= regMask;
+                }
+                else if (m_regsPending & regMask)
+                {
+                    // The register was set to the value which it already has
+                    m_eliminatedRegWrites++;
+                }
+                m_regsPending &= ~regMask;
+            }
+        }
     }
 
-    virtual bool setTextureWrapModeS(const TextureWrapMode mode)  override
+    /// @brief Continues the upload after new data was added to the back list. With RENDERER_THREADED, this is done
+    /// by the upload thread.
+    void triggerUpload()
     {
-        m_confReg2.texClampS = mode == TextureWrapMode::CLAMP_TO_EDGE;
-        return appendStreamCommand(StreamCommand::SET_CONF_REG2, m_confReg2);
+#ifndef RENDERER_THREADED
+        uploadDisplayList();
+#endif
     }
 
-    virtual bool setTextureWrapModeT(const TextureWrapMode mode) override
+    /// @brief This method will try to send a new display list to the hardware, if the last transfer is complete.
+    /// @return true if a upload is in progress
+    ///         false no upload is in progress
+    bool uploadDisplayList()
     {
-        m_confReg2.texClampT = mode == TextureWrapMode::CLAMP_TO_EDGE;
-        return appendStreamCommand(StreamCommand::SET_CONF_REG2, m_confReg2);
-    }
+        List& frontList = m_displayList[m_frontList];
+        // Check if the front list is queued. If so, initialize a new transfer
+        if (frontList.state() == List::State::QUEUED)
+        {
+            // The devices are only idle here when all of them have finished the previous list
+            assignBands();
+            for (Device& device : m_devices)
+            {
+                // Upload the display lists in reverse order because in reality the rendered picture is upside down
+                device.uploadIndexPosition = device.bandEnd - 1;
+                device.getPos = 0;
+                device.done = false;
+#ifdef RENDERER_DIRTY_WINDOW
+                device.dirtyWindow.clear();
+#endif
+            }
+            frontList.transfer();
+        }
 
-    virtual std::pair<bool, uint16_t>  createTexture() override 
-    {
-        for (uint32_t i = 0; i < m_textures.size(); i++)
+        if (frontList.state() == List::State::TRANSFERRING)
         {
-            if (m_textures[i].inUse == false)
+            bool done = true;
+            for (Device& device : m_devices)
+            {
+                if (!device.done)
+                {
+                    uploadDisplayLine(device, frontList);
+                }
+                done = done && device.done;
+            }
+            if (done)
             {
-                m_textures[i].inUse = true;
-                return {true, i};
+                frontList.clear();
+                // The textures of this frame are not used anymore by the upload
+                m_textureStore.frameUploaded();
+                // The lists are committed in the order of the ring
+                m_frontList = nextList(m_frontList);
+                return false;
             }
+            return true;
         }
-        return {false, 0};
-    }
 
-    virtual bool updateTexture(const uint16_t texId, std::shared_ptr<const uint16_t> pixels, const uint16_t texWidth, const uint16_t texHeight) override
-    {
-        if (texWidth != texHeight)
-            return false;
-        m_textures[texId].gramAddr = pixels;
-        m_textures[texId].width = texWidth;
-        m_textures[texId].height = texHeight;
-        return true;
+        return false;
     }
 
-    virtual bool useTexture(const uint16_t texId) override 
+    /// @brief Sends the next chunk of the current display line of a device, if the last transfer of the device is complete
+    /// @param device The device
+    /// @param frontList The list which is uploaded
+    void uploadDisplayLine(Device& device, List& frontList)
     {
-        Texture& tex = m_textures[texId];
-        if (!tex.inUse || texId == 0 || !tex.gramAddr)
+        // Check if the last chain is transferred. The chain points to the upload list and to the texture,
+        // therefore nothing can be changed until the transfer is complete
+        if (!device.busConnector->transferComplete())
+            return;
+
+        frontList.setGetPos(device.getPos);
+        // Check if the whole display line is transferred. If so, start the transfer of the color buffer
+        if (frontList.atEnd())
         {
-            return false;
+#ifdef RENDERER_DIRTY_WINDOW
+            // A display line without changes was not committed (see uploadFramebufferOp())
+            if (device.dirtyWindow.empty())
+            {
+                m_uploadStatistics[m_frontList].add(&UploadStats::skippedLines);
+            }
+            else
+            {
+                device.busConnector->startColorBufferTransfer(device.uploadIndexPosition, device.dirtyWindow.get());
+            }
+            device.dirtyWindow.clear();
+#else
+            device.busConnector->startColorBufferTransfer(device.uploadIndexPosition, DirtyWindow<LINE_RESOLUTION>::FULL_LINE);
+#endif
+            device.getPos = 0;
+            if (device.uploadIndexPosition == device.bandStart)
+            {
+                device.done = true;
+                return;
+            }
+            device.uploadIndexPosition--;
+            return;
         }
 
-        SCT op;
-        TextureStreamArg tsa;
-
-        if (tex.width == 256)
-            op = StreamCommand::TEXTURE_STREAM_256x256;
-        else if (tex.width == 128)
-            op = StreamCommand::TEXTURE_STREAM_128x128;
-        else if (tex.width == 64)
-            op = StreamCommand::TEXTURE_STREAM_64x64;
-        else if (tex.width == 32)
-            op = StreamCommand::TEXTURE_STREAM_32x32;
-        else
-            return false; // Not supported texture format
+        // Build new displaylist (which will be uploaded to the device)
+        Statistics<UploadStats>& uploadStatistics = m_uploadStatistics[m_frontList];
+        const uint32_t start = uploadStatistics.start();
+        ListUpload& displayListUpload = device.displayListUpload;
+        displayListUpload.clear();
+        const uint16_t currentScreenPositionStart = device.uploadIndexPosition * LINE_RESOLUTION;
+        const uint16_t currentScreenPositionEnd = (device.uploadIndexPosition + 1) * LINE_RESOLUTION;
+        uint32_t textureUploadSize = 0;
+        while (!textureUploadSize && hasEnoughSpace(displayListUpload))
+        {
+            SCT *op = frontList.template getNext<SCT>();
+            if (op == nullptr)
+            {
+                break;
+            }
 
-        tsa.texSize = tex.width * tex.height;
-        tsa.counter = 0;
-        tsa.pixels = tex.gramAddr;
+            SCT *opDl = displayListUpload.template create<SCT>();
+            *opDl = *op;
+            switch ((*op) & StreamCommand::STREAM_COMMAND_OP_MASK) {
+            case StreamCommand::TRIANGLE_STREAM:
+            {
+                // Assume, when the op is TRIANGLE_STREAM, then this command must follow a triangle
+                Rasterizer::TriangleDescriptor *triangleConf = frontList.template getNext<Rasterizer::TriangleDescriptor>();
+                Rasterizer::TriangleDescriptor *triangleConfDl = displayListUpload.template create<Rasterizer::TriangleDescriptor>();
+                if (!Rasterizer::calcLineIncrement(*triangleConfDl, *triangleConf, currentScreenPositionStart,
+                                                   currentScreenPositionEnd))
+                {
+                    // Special case in case, the triangle is not visible, just remove it from the display list
+                    // This case can happen when the triangle is not in the current display line
+                    displayListUpload.template remove<Rasterizer::TriangleDescriptor>();
+                    displayListUpload.template remove<SCT>();
+                    uploadStatistics.add(&UploadStats::rejectedTriangles);
+                }
+                else
+                {
+#ifdef RENDERER_DIRTY_WINDOW
+                    device.dirtyWindow.addTriangle(*triangleConfDl);
+#endif
+                    m_lineTriangles[device.uploadIndexPosition]++;
+                    uploadStatistics.add(&UploadStats::uploadedTriangles);
+                }
+            }
+                break;
+            case StreamCommand::FRAMEBUFFER_OP:
+#ifdef RENDERER_DIRTY_WINDOW
+                uploadFramebufferOp(device, *op);
+#endif
+                // Has no argument
+                break;
+            case StreamCommand::NOP:
+                // Has no argument
+                break;
+            case StreamCommand::TEXTURE_STREAM:
+            {
+                // Read texture stream argument
+                TextureStreamArg *dlArg = frontList.template getNext<TextureStreamArg>();
+                // Check if the newly read argument has another texture than the current active one
+                if (isSameTexture(device.textureStreamArg, *dlArg))
+                {
+                    // If this is not the case, we can safely discard this command, because the texture is already in the buffer
+                    displayListUpload.template remove<SCT>();
+                }
+                else if (!isTextureUsedInLine(frontList, currentScreenPositionStart, currentScreenPositionEnd))
+                {
+                    // No visible triangle in this display line uses the texture (for instance, because the triangles
+                    // are in other lines or because the texture is directly replaced by the next one). Skip it to save
+                    // the bandwidth of the upload.
+                    displayListUpload.template remove<SCT>();
+                }
+                else
+                {
+                    // If this is not the case, set the newly read texture as the new stream texture
+                    device.textureStreamArg = *(dlArg);
 
-        return appendStreamCommand<TextureStreamArg, true>(op, tsa);
-    }
+                    // Select the page of the texture. Only upload the texture if it is not already resident,
+                    // otherwise just select the page
+                    textureUploadSize = bindTexture(device.textureResidency, *opDl, *dlArg);
+                }
+            }
+                break;
+            case StreamCommand::SET_REG:
+            {
+                uint16_t *arg = displayListUpload.template create<uint16_t>();
+                *arg = *(frontList.template getNext<uint16_t>());
+            }
+                break;
+            default:
+                // In case the op was not found
+                displayListUpload.template remove<SCT>();
+                break;
+            }
+        }
+        device.getPos = frontList.getGetPos();
 
-    virtual bool deleteTexture(const uint16_t texId) override 
-    {
-        m_textures[texId].inUse = false;
-        m_textures[texId].gramAddr = std::shared_ptr<const uint16_t>();
-        return true;
+        // Queue the display list and, if required, the texture directly from the texture memory
+        uint32_t descriptorCount = 0;
+        device.descriptors[descriptorCount++] = { displayListUpload.getMemPtr(), displayListUpload.getSize() };
+        if (textureUploadSize)
+        {
+            descriptorCount += appendTextureDescriptors(&device.descriptors[descriptorCount], device.textureStreamArg, textureUploadSize);
+        }
+        uploadStatistics.add(&UploadStats::uploadedBytes, displayListUpload.getSize());
+        uploadStatistics.add(&UploadStats::textureBytes, textureUploadSize * sizeof(uint16_t));
+        uploadStatistics.addTime(&UploadStats::time, start);
+        device.busConnector->submitData(device.descriptors.data(), descriptorCount);
     }
 
-private:
-    static constexpr uint32_t HARDWARE_BUFFER_SIZE = 2048;
-    static constexpr uint32_t DISPLAY_BUFFERS = 2; // Note: Right now only two are supported. Other values will not work
-
-    struct Texture
+    /// @brief Splits the display lines into one band per device. The bands are balanced by the number of triangles
+    /// which were uploaded in every display line of the previous frame. Every display line additionally counts as one
+    /// triangle, so that the lines are split equally when there are no triangles.
+    void assignBands()
     {
-        bool inUse;
-        std::shared_ptr<const uint16_t> gramAddr;
-        uint16_t width;
-        uint16_t height;
-    };
-
-    using List = DisplayList<DISPLAY_LIST_SIZE, BUS_WIDTH / 8>;
-    using ListUpload = DisplayList<HARDWARE_BUFFER_SIZE, BUS_WIDTH / 8>;
-
-    struct StreamCommand
-    {
-        // Anathomy of a command:
-        // | 4 bit OP | 12 bit IMM |
-
-        using StreamCommandType = uint16_t;
-
-        // This mask will set the command
-        static constexpr StreamCommandType STREAM_COMMAND_OP_MASK = 0xf000;
-
-        // This mask will set the immediate value
-        static constexpr StreamCommandType STREAM_COMMAND_IMM_MASK = 0x0fff;
-
-        // Calculate the triangle size with align overhead.
-        static constexpr StreamCommandType TRIANGLE_SIZE_ALIGNED = ListUpload::template sizeOf<Rasterizer::RasterizedTriangle>();
-
-        // OPs
-        static constexpr StreamCommandType NOP              = 0x0000;
-        static constexpr StreamCommandType TEXTURE_STREAM   = 0x1000;
-        static constexpr StreamCommandType SET_REG          = 0x2000;
-        static constexpr StreamCommandType FRAMEBUFFER_OP   = 0x3000;
-        static constexpr StreamCommandType TRIANGLE_STREAM  = 0x4000;
-
-        // Immediate values
-        static constexpr StreamCommandType TEXTURE_STREAM_32x32     = TEXTURE_STREAM | 0x0011;
-        static constexpr StreamCommandType TEXTURE_STREAM_64x64     = TEXTURE_STREAM | 0x0022;
-        static constexpr StreamCommandType TEXTURE_STREAM_128x128   = TEXTURE_STREAM | 0x0044;
-        static constexpr StreamCommandType TEXTURE_STREAM_256x256   = TEXTURE_STREAM | 0x0088;
-
-        static constexpr StreamCommandType SET_COLOR_BUFFER_CLEAR_COLOR = SET_REG | 0x0000;
-        static constexpr StreamCommandType SET_DEPTH_BUFFER_CLEAR_DEPTH = SET_REG | 0x0001;
-        static constexpr StreamCommandType SET_CONF_REG1                = SET_REG | 0x0002;
-        static constexpr StreamCommandType SET_CONF_REG2                = SET_REG | 0x0003;
-        static constexpr StreamCommandType SET_TEX_ENV_COLOR            = SET_REG | 0x0004;
-
-        static constexpr StreamCommandType FRAMEBUFFER_COMMIT   = FRAMEBUFFER_OP | 0x0001;
-        static constexpr StreamCommandType FRAMEBUFFER_MEMSET   = FRAMEBUFFER_OP | 0x0002;
-        static constexpr StreamCommandType FRAMEBUFFER_COLOR    = FRAMEBUFFER_OP | 0x0010;
-        static constexpr StreamCommandType FRAMEBUFFER_DEPTH    = FRAMEBUFFER_OP | 0x0020;
+        uint32_t total = 0;
+        for (const uint32_t triangles : m_lineTriangles)
+        {
+            total += triangles + 1;
+        }
 
-        static constexpr StreamCommandType TRIANGLE_FULL  = TRIANGLE_STREAM | TRIANGLE_SIZE_ALIGNED;
-    };
-    using SCT = typename StreamCommand::StreamCommandType;
+        uint32_t line = 0;
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < DEVICES; i++)
+        {
+            Device& device = m_devices[i];
+            device.bandStart = line;
+            // Keep at least one display line for every following device
+            const uint32_t lastPossibleEnd = DISPLAY_LINES - (DEVICES - 1 - i);
+            const uint32_t target = (total * (i + 1)) / DEVICES;
+            do
+            {
+                sum += m_lineTriangles[line] + 1;
+                line++;
+                // A display line belongs to the band which contains the bigger part of its weight
+            } while ((line < lastPossibleEnd) && ((i + 1) == DEVICES || ((sum + ((m_lineTriangles[line] + 1) / 2)) < target)));
+            device.bandEnd = line;
+        }
+        m_lineTriangles.fill(0);
+    }
 
-    class TextureStreamArg
+#ifdef RENDERER_DIRTY_WINDOW
+    /// @brief Updates the dirty window with a frame buffer command which was just copied into the upload list.
+    /// A memset of the color buffer changes the whole display line. A commit is removed when the display line has
+    /// not changed, otherwise the commit window is written before it. With several display lines, the whole line is
+    /// always committed (see RENDERER_DIRTY_WINDOW).
+    /// @param device The device which uploads the display line
+    /// @param op The frame buffer command
+    void uploadFramebufferOp(Device& device, const SCT op)
     {
-    public:
-        std::shared_ptr<const uint16_t> pixels;
-        int32_t texSize;
-        int32_t counter;
-    };
+        static constexpr SCT MEMSET_COLOR = (StreamCommand::FRAMEBUFFER_MEMSET | StreamCommand::FRAMEBUFFER_COLOR) & StreamCommand::STREAM_COMMAND_IMM_MASK;
+        static constexpr SCT COMMIT = StreamCommand::FRAMEBUFFER_COMMIT & StreamCommand::STREAM_COMMAND_IMM_MASK;
+        if ((op & MEMSET_COLOR) == MEMSET_COLOR)
+        {
+            device.dirtyWindow.addLine();
+        }
+        if (op & COMMIT)
+        {
+            if (DISPLAY_LINES > 1)
+            {
+                // Without a memset, the frame buffer still contains the previous display line
+                device.dirtyWindow.addLine();
+            }
+            ListUpload& displayListUpload = device.displayListUpload;
+            displayListUpload.template remove<SCT>();
+            if (!device.dirtyWindow.empty())
+            {
+                // The space is reserved by hasEnoughSpace()
+                const IBusConnector::Window& window = device.dirtyWindow.get();
+                appendCommitWindowReg(displayListUpload, StreamCommand::SET_COMMIT_WINDOW_X_START, window.xStart);
+                appendCommitWindowReg(displayListUpload, StreamCommand::SET_COMMIT_WINDOW_X_END, window.xEnd);
+                appendCommitWindowReg(displayListUpload, StreamCommand::SET_COMMIT_WINDOW_Y_START, window.yStart);
+                appendCommitWindowReg(displayListUpload, StreamCommand::SET_COMMIT_WINDOW_Y_END, window.yEnd);
+                // The display lines are uploaded in reverse order, the last one is on the top of the display
+                appendCommitWindowReg(displayListUpload, StreamCommand::SET_COMMIT_WINDOW_LINE_Y, (DISPLAY_LINES - 1 - device.uploadIndexPosition) * LINE_RESOLUTION);
+                *(displayListUpload.template create<SCT>()) = op;
+            }
+        }
+    }
 
-    static uint16_t convertColor(const Vec4i color)
+    /// @brief Writes a register of the commit window into an upload list
+    /// @param displayListUpload The upload list
+    /// @param op The register
+    /// @param value The value of the register
+    static void appendCommitWindowReg(ListUpload& displayListUpload, const SCT op, const uint16_t value)
     {
-        Vec4i colorShift{color};
-        colorShift >>= 4;
-        uint16_t colorInt =   (static_cast<uint16_t>(colorShift[3]) << 0)
-                | (static_cast<uint16_t>(colorShift[2]) << 4)
-                | (static_cast<uint16_t>(colorShift[1]) << 8)
-                | (static_cast<uint16_t>(colorShift[0]) << 12);
-        return colorInt;
+        *(displayListUpload.template create<SCT>()) = op;
+        *(displayListUpload.template create<uint16_t>()) = value;
     }
+#endif
 
-    /// @brief This method will try to send a new display list to the hardware, if the bus is clear.
-    /// @return true if a upload is in progress
-    ///         false no upload is in progress
-    bool uploadDisplayList()
+    /// @brief Looks ahead in the display list, if a triangle which is visible in the current display line is using
+    /// the texture which was bound by the last read texture stream command. The read position of the list is unchanged.
+    /// @param displayList The display list. The read position must point to the command after the texture stream command.
+    /// @param lineStart The first screen line of the display line
+    /// @param lineEnd The first screen line after the display line
+    /// @return true if the texture is used by at least one triangle in the display line
+    static bool isTextureUsedInLine(List& displayList, const uint16_t lineStart, const uint16_t lineEnd)
     {
-        // Check if the bus is clear
-        if (!m_busConnector.clearToSend())
-            return true;
-
-        List& frontList = m_displayList[m_frontList];
-        // Check if the front list is queued. If so, initialize a new transfer
-        if (frontList.state() == List::State::QUEUED)
-        {
-            // Upload the display lists in reverse order because in reality the rendered picture is upside down
-            m_uploadIndexPosition = DISPLAY_LINES - 1;
-            frontList.transfer();
-        }
-
-        if (frontList.state() == List::State::TRANSFERRING)
+        const uint32_t pos = displayList.getGetPos();
+        bool used = false;
+        bool textureReplaced = false;
+        while (!used && !textureReplaced)
         {
-            // First check if an texture upload is pending. If so, finish the upload first
-            if (m_textureStreamArg.counter != m_textureStreamArg.texSize)
+            SCT *op = displayList.template getNext<SCT>();
+            if (op == nullptr)
             {
-                m_busConnector.writeData(reinterpret_cast<const uint8_t*>((m_textureStreamArg.pixels.get()) + m_textureStreamArg.counter), HARDWARE_BUFFER_SIZE);
-                static constexpr uint32_t PIXEL_INC = (HARDWARE_BUFFER_SIZE / sizeof((m_textureStreamArg.pixels.get())[0]));
-                m_textureStreamArg.counter += PIXEL_INC;
-                return true;
+                break;
             }
 
-            // Build new displaylist (which will be uploaded to the device)
-            m_displayListUpload.clear();
-            bool leaveLoop = false;
-            while (!leaveLoop && hasEnoughSpace(m_displayListUpload))
+            switch ((*op) & StreamCommand::STREAM_COMMAND_OP_MASK) {
+            case StreamCommand::TRIANGLE_STREAM:
             {
-                SCT *op = frontList.template getNext<SCT>();
-                if (op == nullptr)
-                {
-                    break;
-                }
+                const Rasterizer::TriangleDescriptor *triangleConf = displayList.template getNext<Rasterizer::TriangleDescriptor>();
+                // Same check as in Rasterizer::calcLineIncrement()
+                used = (triangleConf->bbEndY >= lineStart) && (triangleConf->bbStartY < lineEnd);
+            }
+                break;
+            case StreamCommand::TEXTURE_STREAM:
+                textureReplaced = true;
+                break;
+            case StreamCommand::SET_REG:
+                displayList.template getNext<uint16_t>();
+                break;
+            default:
+                // Has no argument
+                break;
+            }
+        }
+        displayList.setGetPos(pos);
+        return used;
+    }
 
-                *(m_displayListUpload.template create<SCT>()) = *op;
-                switch ((*op) & StreamCommand::STREAM_COMMAND_OP_MASK) {
-                case StreamCommand::TRIANGLE_STREAM:
+#ifdef RENDERER_FRONT_TO_BACK
+    /// @brief Sorts the triangles of a display list by their lower bound of the depth (see Rasterizer::calcMinDepth()).
+    /// Only runs of triangles without any other command in between are sorted, and only when they are drawn with a
+    /// configuration where the order of the triangles does not change the image (apart from triangles with the same depth):
+    /// depth test with LESS or LEQUAL, depth writes and no blending. Because the display lines are built from this list,
+    /// the triangles are also sorted in every display line.
+    /// @param displayList The display list to sort
+    void sortFrontToBack(List& displayList)
+    {
+        uint16_t confReg1 = 0;
+        uint16_t confReg2 = 0;
+        RegMask regsValid = 0;
+        bool sortable = false;
+        SCT *runStart = nullptr;
+        uint32_t runSize = 0;
+
+        displayList.resetGet();
+        while (!displayList.atEnd())
+        {
+            SCT *op = displayList.template getNext<SCT>();
+            if (((*op) & StreamCommand::STREAM_COMMAND_OP_MASK) == StreamCommand::TRIANGLE_STREAM)
+            {
+                const Rasterizer::TriangleDescriptor *triangleConf = displayList.template getNext<Rasterizer::TriangleDescriptor>();
+                if (sortable)
                 {
-                    // Assume, when the op is TRIANGLE_STREAM, then this command must follow a triangle
-                    Rasterizer::RasterizedTriangle *triangleConf = frontList.template getNext<Rasterizer::RasterizedTriangle>();
-                    Rasterizer::RasterizedTriangle *triangleConfDl = m_displayListUpload.template create<Rasterizer::RasterizedTriangle>();
-                    const uint16_t currentScreenPositionStart = m_uploadIndexPosition * LINE_RESOLUTION;
-                    const uint16_t currentScreenPositionEnd = (m_uploadIndexPosition + 1) * LINE_RESOLUTION;
-                    if (!Rasterizer::calcLineIncrement(*triangleConfDl, *triangleConf, currentScreenPositionStart,
-                                                       currentScreenPositionEnd))
+                    if (runSize == 0)
                     {
-                        // Special case in case, the triangle is not visible, just remove it from the display list
-                        // This case can happen when the triangle is not in the current display line
-                        m_displayListUpload.template remove<Rasterizer::RasterizedTriangle>();
-                        m_displayListUpload.template remove<SCT>();
+                        runStart = op;
                     }
+                    // An unknown depth (zero) is sorted to the back
+                    const uint32_t depth = (triangleConf->triangleConfiguration == 0) ? 0xffff : triangleConf->triangleConfiguration;
+                    m_sortKeys[runSize] = (depth << 16) | runSize;
+                    runSize++;
                 }
-                    break;
-                case StreamCommand::FRAMEBUFFER_OP:
-                case StreamCommand::NOP:
-                    // Has no argument
-                    break;
-                case StreamCommand::TEXTURE_STREAM:
-                {
-                    // Read texture stream argument
-                    TextureStreamArg *dlArg = frontList.template getNext<TextureStreamArg>();
-                    // Check if the newly read argument has another texture than the current active one
-                    if (m_textureStreamArg.pixels == dlArg->pixels)
-                    {
-                        // If this is not the case, we can safely discard this command, because the texture is already in the buffer
-                        m_displayListUpload.template remove<SCT>();
-                    }
-                    else
-                    {
-                        // If this is not the case, set the newly read texture as the new stream texture
-                        m_textureStreamArg = *(dlArg);
-
-                        // Upload texture
-                        leaveLoop = true;
-
-                        // TODO: We could check here if the next command is also a texture upload with a different texture. If so, then we can discard
-                        // that command and just upload the comming texture.
-                        // We can also iterate now thru the triangles to check, if a triangle is visible in this line till the next upload command is comming
-                        // if no triangle is visible, then we can also discard this command and just upload the next.
-                    }
-                    // In the last iteration, we don't require the texture anymore. Unfortunately the DisplayList is discarded as a whole,
-                    // and is not calling the destructors of the objects it contains. Therefor we have to do it here manually so the shared_ptr
-                    // knows that this pointer is not required anymore and can delete the texture (if this was the last place, where this pointer was used)
-                    if (m_uploadIndexPosition == 0)
-                    {
-                        (*dlArg).~TextureStreamArg();
-                    }
+                continue;
+            }
 
-                }
-                    break;
-                case StreamCommand::SET_REG:
+            sortRun(reinterpret_cast<uint8_t*>(runStart), runSize);
+            runSize = 0;
+            switch ((*op) & StreamCommand::STREAM_COMMAND_OP_MASK) {
+            case StreamCommand::TEXTURE_STREAM:
+                displayList.template getNext<TextureStreamArg>();
+                break;
+            case StreamCommand::SET_REG:
+            {
+                const uint16_t arg = *(displayList.template getNext<uint16_t>());
+                const uint32_t reg = (*op) & StreamCommand::STREAM_COMMAND_IMM_MASK;
+                if (reg == (StreamCommand::SET_CONF_REG1 & StreamCommand::STREAM_COMMAND_IMM_MASK))
                 {
-                    uint16_t *arg = m_displayListUpload.template create<uint16_t>();
-                    *arg = *(frontList.template getNext<uint16_t>());
+                    confReg1 = arg;
                 }
-                    break;
-                default:
-                    // In case the op was not found
-                    m_displayListUpload.template remove<SCT>();
-                    break;
+                else if (reg == (StreamCommand::SET_CONF_REG2 & StreamCommand::STREAM_COMMAND_IMM_MASK))
+                {
+                    confReg2 = arg;
                 }
+                regsValid |= 1 << reg;
+                sortable = ((regsValid & (REG_MASK_CONF_REG1 | REG_MASK_CONF_REG2)) == (REG_MASK_CONF_REG1 | REG_MASK_CONF_REG2))
+                        && isOrderIndependent(confReg1, confReg2);
+            }
+                break;
+            default:
+                // Has no argument
+                break;
             }
+        }
+        sortRun(reinterpret_cast<uint8_t*>(runStart), runSize);
+        displayList.resetGet();
+    }
 
-            m_busConnector.writeData(m_displayListUpload.getMemPtr(), m_displayListUpload.getSize());
+    /// @brief Sorts a run of triangles in the display list in place. The order is given by m_sortKeys, which contains
+    /// the depth in the upper and the position in the run in the lower 16 bit.
+    /// @param run The first triangle (command and descriptor) of the run
+    /// @param runSize The number of triangles in the run
+    void sortRun(uint8_t* run, const uint32_t runSize)
+    {
+        if (runSize < 2)
+        {
+            return;
+        }
+        // The position makes every key unique, so the sort is stable
+        std::sort(m_sortKeys.begin(), m_sortKeys.begin() + runSize);
 
-            if (frontList.atEnd())
+        // Apply the permutation by following its cycles, so that only one triangle is buffered
+        uint8_t tmp[RECORDED_TRIANGLE_SIZE];
+        for (uint32_t i = 0; i < runSize; i++)
+        {
+            uint32_t src = m_sortKeys[i] & 0xffff;
+            if (src == i)
             {
-                m_busConnector.startColorBufferTransfer(m_uploadIndexPosition);
-                frontList.resetGet();
-                if (m_uploadIndexPosition == 0)
-                {
-                    frontList.clear();
-                    return false;
-                }
-                m_uploadIndexPosition--;
+                continue;
             }
-            return true;
+            memcpy(tmp, &run[i * RECORDED_TRIANGLE_SIZE], RECORDED_TRIANGLE_SIZE);
+            uint32_t dst = i;
+            while (src != i)
+            {
+                memcpy(&run[dst * RECORDED_TRIANGLE_SIZE], &run[src * RECORDED_TRIANGLE_SIZE], RECORDED_TRIANGLE_SIZE);
+                // Mark the triangle as placed
+                m_sortKeys[dst] = dst;
+                dst = src;
+                src = m_sortKeys[dst] & 0xffff;
+            }
+            memcpy(&run[dst * RECORDED_TRIANGLE_SIZE], tmp, RECORDED_TRIANGLE_SIZE);
+            m_sortKeys[dst] = dst;
         }
+    }
 
-        return false;
+    /// @brief Checks if the image is independent of the order of the triangles
+    /// @param confReg1 The value of the conf reg1
+    /// @param confReg2 The value of the conf reg2
+    /// @return true if the triangles can be sorted
+    static bool isOrderIndependent(const uint16_t confReg1, const uint16_t confReg2)
+    {
+        ConfReg1 reg1;
+        ConfReg2 reg2;
+        memcpy(&reg1, &confReg1, sizeof(reg1));
+        memcpy(&reg2, &confReg2, sizeof(reg2));
+        return reg1.enableDepthTest
+                && reg1.depthMask
+                && ((reg1.depthFunc == TestFunc::LESS) || (reg1.depthFunc == TestFunc::LEQUAL))
+                && (reg2.blendFuncSFactor == BlendFunc::ONE)
+                && (reg2.blendFuncDFactor == BlendFunc::ZERO);
+    }
+#endif
+
+    static uint8_t nextList(const uint8_t list)
+    {
+        return (list + 1) % DISPLAY_BUFFERS;
     }
 
-    template <typename TArg, bool CallConstructor = false>
+    template <typename TArg>
     bool appendStreamCommand(const SCT op, const TArg& arg)
     {
         SCT *opDl = m_displayList[m_backList].template create<SCT>();
@@ -549,61 +931,97 @@ private:
                 m_displayList[m_backList].template remove<TArg>();
             }
             // Out of memory error
+            m_statistics.add(&RendererStats::displayListOverflows);
             return false;
         }
 
-        // This is an optimization. Most of the time, a constructor call is not necessary and will just take a 
-        // significant amount of CPU time. So, if it is not required, we omit it.
-        if constexpr (CallConstructor)
+        *opDl = op;
+        *argDl = arg;
+        return true;
+    }
+
+    /// @brief Copies recorded triangles into the display list
+    /// @param triangles The first recorded triangle
+    /// @param size The size of the triangles in bytes, a multiple of RECORDED_TRIANGLE_SIZE
+    /// @return false if the display list is full
+    bool drawRecordedRun(const uint8_t* triangles, const uint32_t size)
+    {
+        if (size == 0)
         {
-            new (argDl) TArg();
+            return true;
         }
 
-        *opDl = op;
-        *argDl = arg;
+        // A texture with mip levels is drawn with level 0 if the recording does not select a level
+        if ((m_boundTextureLevel == LEVEL_NOT_STREAMED) && !streamTextureLevel(0))
+        {
+            return false;
+        }
+
+        // The recorded triangles have the same layout as the display list
+        if (!hasEnoughSpace(m_displayList[m_backList], TRIANGLE_REGS, size))
+        {
+            m_statistics.add(&RendererStats::displayListOverflows);
+            return false;
+        }
+        writeRegs(TRIANGLE_REGS);
+        memcpy(m_displayList[m_backList].createBlock(size), triangles, size);
+        m_statistics.add(&RendererStats::rasterizedTriangles, size / RECORDED_TRIANGLE_SIZE);
+        triggerUpload();
         return true;
     }
 
     template <typename TDisplayList>
     bool hasEnoughSpace(const TDisplayList& displayList)
     {
-        return displayList.getFreeSpace() >= (displayList.template sizeOf<SCT>() + displayList.template sizeOf<Rasterizer::RasterizedTriangle>());
+        uint32_t requiredSize = displayList.template sizeOf<SCT>() + displayList.template sizeOf<Rasterizer::TriangleDescriptor>();
+#ifdef RENDERER_DIRTY_WINDOW
+        // A commit is uploaded together with the five registers of the commit window
+        const uint32_t commitSize = (6 * displayList.template sizeOf<SCT>()) + (5 * displayList.template sizeOf<uint16_t>());
+        if (commitSize > requiredSize)
+        {
+            requiredSize = commitSize;
+        }
+#endif
+        return displayList.getFreeSpace() >= requiredSize;
     }
 
-    std::array<List, DISPLAY_BUFFERS> m_displayList __attribute__ ((aligned (8)));
-    ListUpload m_displayListUpload __attribute__ ((aligned (8)));
-    uint8_t m_frontList = 0;
-    uint8_t m_backList = 1;
-    uint32_t m_uploadIndexPosition = 0;
-    TextureStreamArg m_textureStreamArg{nullptr, 0, 0};
+    /// @brief Checks if the display list has enough space for a triangle or a clear including all registers it potentially requires.
+    /// @param displayList The display list to check
+    /// @param mask The registers which are potentially written together with the command
+    /// @param commandSize The size of the command (by default the size of one triangle)
+    bool hasEnoughSpace(const List& displayList, const RegMask mask, const uint32_t commandSize = RECORDED_TRIANGLE_SIZE)
+    {
+        uint32_t requiredSize = commandSize;
+        for (uint32_t i = 0; i < NUMBER_OF_REGS; i++)
+        {
+            if (mask & (1 << i))
+            {
+                requiredSize += List::template sizeOf<SCT>() + List::template sizeOf<uint16_t>();
+            }
+        }
+        return displayList.getFreeSpace() >= requiredSize;
+    }
 
-    // Texture memory allocator
-    std::array<Texture, MAX_NUMBER_OF_TEXTURES> m_textures;
+    std::array<List, DISPLAY_BUFFERS> m_displayList __attribute__ ((aligned (8)));
+    uint8_t m_frontList = 0; // Tail of the ring: The list which is uploaded next (owned by the upload thread)
+    uint8_t m_backList = 0; // Head of the ring: The list which is currently filled
+    std::array<Device, DEVICES> m_devices; // Owned by the upload thread
+    std::array<uint32_t, DISPLAY_LINES> m_lineTriangles; // Uploaded triangles per display line, used to balance the bands
+#ifdef RENDERER_FRONT_TO_BACK
+    // Sort keys of a run of triangles (see sortRun())
+    static_assert((DISPLAY_LIST_SIZE / RECORDED_TRIANGLE_SIZE) <= 0x10000, "The position of a triangle in a run must fit into 16 bit");
+    std::array<uint32_t, DISPLAY_LIST_SIZE / RECORDED_TRIANGLE_SIZE> m_sortKeys;
+#endif
 
-    IBusConnector& m_busConnector;
+    // The register values which were last written into the back list
+    std::array<uint16_t, NUMBER_OF_REGS> m_listRegs;
+    RegMask m_listRegsValid = 0;
+    uint16_t m_boundTexId = 0; // 0 if no texture is bound
+    uint8_t m_boundTextureLevel = LEVEL_NOT_STREAMED; // The mip level which was last streamed into the display list
 
-    struct __attribute__ ((__packed__)) ConfReg1
-    {
-        bool enableDepthTest : 1;
-        IRenderer::TestFunc depthFunc : 3;
-        IRenderer::TestFunc alphaFunc : 3;
-        uint8_t referenceAlphaValue : 4;
-        bool depthMask : 1;
-        bool colorMaskA : 1;
-        bool colorMaskB : 1;
-        bool colorMaskG : 1;
-        bool colorMaskR : 1;
-    } m_confReg1;
-
-    struct __attribute__ ((__packed__)) ConfReg2
-    {
-        bool perspectiveCorrectedTextures : 1;
-        IRenderer::TexEnvParam texEnvFunc : 3;
-        IRenderer::BlendFunc blendFuncSFactor : 4;
-        IRenderer::BlendFunc blendFuncDFactor : 4;
-        bool texClampS : 1;
-        bool texClampT : 1;
-    } m_confReg2;
+    // Per frame counters of the upload (see Statistics.hpp). They are collected per display list, because they are
+    // written by the upload thread while the list is transferred.
+    std::array<Statistics<UploadStats>, DISPLAY_BUFFERS> m_uploadStatistics;
 };
 
 #endif // RENDERER_HPP
@@ -0,0 +1,504 @@
+// RasteriCEr
+// https://github.com/ToNi3141/RasteriCEr
+// Copyright (c) 2021 ToNi3141
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef RENDERERBASE_HPP
+#define RENDERERBASE_HPP
+
+#include <stdint.h>
+#include <array>
+#include <vector>
+#include <type_traits>
+#include "Vec.hpp"
+#include "IRenderer.hpp"
+#include "IBusConnector.hpp"
+#include "DisplayList.hpp"
+#include "Rasterizer.hpp"
+#include "TextureResidency.hpp"
+#include "TextureStore.hpp"
+#include <string.h>
+
+// Common part of the Renderer and the RendererBuckets. It contains the encoding of the stream commands of the
+// RasteriCEr, the render states with their registers, the texture store and the recording of triangles for the
+// compiled display lists. The renderers only differ in how they collect the commands and how they upload them.
+// The BUS_WIDTH is used to calculate the alignment of the commands. The HARDWARE_BUFFER_SIZE is the size of the
+// uploaded chunks (see Renderer).
+template <uint16_t BUS_WIDTH, uint16_t MAX_NUMBER_OF_TEXTURES, uint32_t HARDWARE_BUFFER_SIZE>
+class RendererBase : public IRenderer
+{
+    static_assert((HARDWARE_BUFFER_SIZE % (BUS_WIDTH / 8)) == 0, "The hardware buffer must be a multiple of the bus width");
+public:
+    RendererBase()
+    {
+        // Unfortunately the Arduino compiler is too old and does not support C++20 default member initializers in bit fields
+#ifndef NO_PERSP_CORRECT
+        m_confReg2.perspectiveCorrectedTextures = true;
+#else
+        m_confReg2.perspectiveCorrectedTextures = false;
+#endif
+
+        setDepthFunc(TestFunc::LESS);
+        setDepthMask(false);
+        setColorMask(true, true, true, true);
+        setAlphaFunc(TestFunc::ALWAYS, 0xf);
+        setTexEnv(TexEnvTarget::TEXTURE_ENV, TexEnvParamName::TEXTURE_ENV_MODE, TexEnvParam::MODULATE);
+        setBlendFunc(BlendFunc::ONE, BlendFunc::ZERO);
+        setLogicOp(LogicOp::COPY);
+        setTexEnvColor({{0, 0, 0, 0}});
+        setClearColor({{0, 0, 0, 0}});
+        setClearDepth(65535);
+        m_eliminatedRegWrites = 0;
+    }
+
+    virtual void recordTriangles(std::vector<uint8_t>* buffer) override
+    {
+        m_recordedTriangles = buffer;
+        m_recordedTextureLevel = NO_MIP_LEVEL;
+    }
+
+    virtual bool setClearColor(const Vec4i& color) override
+    {
+        return setReg(StreamCommand::SET_COLOR_BUFFER_CLEAR_COLOR, convertColor(color));
+    }
+
+    virtual bool setClearDepth(uint16_t depth) override
+    {
+        return setReg(StreamCommand::SET_DEPTH_BUFFER_CLEAR_DEPTH, depth);
+    }
+
+    virtual bool setDepthMask(const bool flag) override
+    {
+        m_confReg1.depthMask = flag;
+        return setReg(StreamCommand::SET_CONF_REG1, m_confReg1);
+    }
+
+    virtual bool enableDepthTest(const bool enable) override
+    {
+        m_confReg1.enableDepthTest = enable;
+        return setReg(StreamCommand::SET_CONF_REG1, m_confReg1);
+    }
+
+    virtual bool setColorMask(const bool r, const bool g, const bool b, const bool a) override
+    {
+        m_confReg1.colorMaskA = a;
+        m_confReg1.colorMaskB = b;
+        m_confReg1.colorMaskG = g;
+        m_confReg1.colorMaskR = r;
+        return setReg(StreamCommand::SET_CONF_REG1, m_confReg1);
+    }
+
+    virtual bool setDepthFunc(const TestFunc func) override
+    {
+        m_confReg1.depthFunc = func;
+        return setReg(StreamCommand::SET_CONF_REG1, m_confReg1);
+    }
+
+    virtual bool setAlphaFunc(const TestFunc func, const uint8_t ref) override
+    {
+        m_confReg1.alphaFunc = func;
+        m_confReg1.referenceAlphaValue = ref;
+        return setReg(StreamCommand::SET_CONF_REG1, m_confReg1);
+    }
+
+    virtual bool setTexEnv(const TexEnvTarget target, const TexEnvParamName pname, const TexEnvParam param) override
+    {
+        (void)target; // Only TEXTURE_ENV is supported
+        (void)pname; // Only GL_TEXTURE_ENV_MODE is supported
+        m_confReg2.texEnvFunc = param;
+        return setReg(StreamCommand::SET_CONF_REG2, m_confReg2);
+    }
+
+    virtual bool setBlendFunc(const BlendFunc sfactor, const BlendFunc dfactor) override
+    {
+        m_confReg2.blendFuncSFactor = sfactor;
+        m_confReg2.blendFuncDFactor = dfactor;
+        return setReg(StreamCommand::SET_CONF_REG2, m_confReg2);
+    }
+
+    virtual bool setLogicOp(const LogicOp opcode) override
+    {
+        (void)opcode;
+        return false;
+    }
+
+    virtual bool setTexEnvColor(const Vec4i& color) override
+    {
+        return setReg(StreamCommand::SET_TEX_ENV_COLOR, convertColor(color));
+    }
+
+    virtual bool setTextureWrapModeS(const TextureWrapMode mode)  override
+    {
+        m_confReg2.texClampS = mode == TextureWrapMode::CLAMP_TO_EDGE;
+        return setReg(StreamCommand::SET_CONF_REG2, m_confReg2);
+    }
+
+    virtual bool setTextureWrapModeT(const TextureWrapMode mode) override
+    {
+        m_confReg2.texClampT = mode == TextureWrapMode::CLAMP_TO_EDGE;
+        return setReg(StreamCommand::SET_CONF_REG2, m_confReg2);
+    }
+
+    virtual bool setViewport(const int16_t x, const int16_t y, const int16_t width, const int16_t height) override
+    {
+        m_viewport = {x, y, width, height};
+        return true;
+    }
+
+    virtual void setFrameCoveredHint(const bool covered) override
+    {
+        m_frameCovered = covered;
+    }
+
+    virtual std::pair<bool, uint16_t>  createTexture() override
+    {
+        return m_textureStore.create();
+    }
+
+    virtual bool updateTexture(const uint16_t texId,
+                               std::shared_ptr<const uint16_t> pixels,
+                               const uint16_t texWidth,
+                               const uint16_t texHeight,
+                               const TextureFormat format) override
+    {
+        if (texWidth != texHeight)
+            return false;
+        return m_textureStore.update(texId, pixels, texWidth, texHeight, format);
+    }
+
+    virtual bool updateTextureLevel(const uint16_t texId,
+                                    const uint8_t level,
+                                    std::shared_ptr<const uint16_t> pixels,
+                                    const uint16_t texWidth,
+                                    const uint16_t texHeight,
+                                    const TextureFormat format) override
+    {
+        return m_textureStore.updateLevel(texId, level, pixels, texWidth, texHeight, format);
+    }
+
+    virtual bool deleteTexture(const uint16_t texId) override
+    {
+        return m_textureStore.destroy(texId);
+    }
+
+    /// @brief Register writes are only added to a display list when a triangle or a clear requires them and when
+    /// the register has changed. This returns the number of writes which were eliminated by this.
+    /// @return Number of register writes which were not added to any display list
+    uint32_t getNumberOfEliminatedRegWrites() const
+    {
+        return m_eliminatedRegWrites;
+    }
+
+    /// @brief Returns the maximum size of a chunk which is sent with IBusConnector::writeData(). The FIFO of the
+    /// hardware must be able to take a whole chunk when IBusConnector::clearToSend() is true (see Serial2AXIS::CHUNK_SIZE).
+    /// @return The size of a chunk in bytes
+    static constexpr uint32_t getHardwareBufferSize()
+    {
+        return HARDWARE_BUFFER_SIZE;
+    }
+
+protected:
+    static constexpr uint32_t MAX_TEXTURE_SIZE = 256 * 256 * 2;
+    static constexpr uint32_t MAX_DESCRIPTORS = 1 + ((MAX_TEXTURE_SIZE + HARDWARE_BUFFER_SIZE - 1) / HARDWARE_BUFFER_SIZE); // Chunk with a texture
+
+    using ListUpload = DisplayList<HARDWARE_BUFFER_SIZE, BUS_WIDTH / 8>;
+    using Texture = typename TextureStore<MAX_NUMBER_OF_TEXTURES>::Texture;
+
+    struct StreamCommand
+    {
+        // Anathomy of a command:
+        // | 4 bit OP | 12 bit IMM |
+
+        using StreamCommandType = uint16_t;
+
+        // This mask will set the command
+        static constexpr StreamCommandType STREAM_COMMAND_OP_MASK = 0xf000;
+
+        // This mask will set the immediate value
+        static constexpr StreamCommandType STREAM_COMMAND_IMM_MASK = 0x0fff;
+
+        // Calculate the triangle size with align overhead.
+        static constexpr StreamCommandType TRIANGLE_SIZE_ALIGNED = ListUpload::template sizeOf<Rasterizer::TriangleDescriptor>();
+
+        // OPs
+        static constexpr StreamCommandType NOP              = 0x0000;
+        static constexpr StreamCommandType TEXTURE_STREAM   = 0x1000;
+        static constexpr StreamCommandType SET_REG          = 0x2000;
+        static constexpr StreamCommandType FRAMEBUFFER_OP   = 0x3000;
+        static constexpr StreamCommandType TRIANGLE_STREAM  = 0x4000;
+        // The paletted texture stream is handled in the display lists like a TEXTURE_STREAM. The op is only
+        // changed when the display list is uploaded.
+        static constexpr StreamCommandType TEXTURE_STREAM_PALETTED = 0x5000;
+
+        // Immediate values
+        static constexpr StreamCommandType TEXTURE_STREAM_32x32     = TEXTURE_STREAM | 0x0011;
+        static constexpr StreamCommandType TEXTURE_STREAM_64x64     = TEXTURE_STREAM | 0x0022;
+        static constexpr StreamCommandType TEXTURE_STREAM_128x128   = TEXTURE_STREAM | 0x0044;
+        static constexpr StreamCommandType TEXTURE_STREAM_256x256   = TEXTURE_STREAM | 0x0088;
+        static constexpr StreamCommandType TEXTURE_STREAM_SIZE_MASK = 0x000f;
+        static constexpr StreamCommandType TEXTURE_STREAM_PAGE_MASK = 0x0f00;
+        static constexpr StreamCommandType TEXTURE_STREAM_PAGE_POS  = 8;
+
+        static constexpr StreamCommandType SET_COLOR_BUFFER_CLEAR_COLOR = SET_REG | 0x0000;
+        static constexpr StreamCommandType SET_DEPTH_BUFFER_CLEAR_DEPTH = SET_REG | 0x0001;
+        static constexpr StreamCommandType SET_CONF_REG1                = SET_REG | 0x0002;
+        static constexpr StreamCommandType SET_CONF_REG2                = SET_REG | 0x0003;
+        static constexpr StreamCommandType SET_TEX_ENV_COLOR            = SET_REG | 0x0004;
+        // The commit window is not part of the render states, it is only written before a commit (see RENDERER_DIRTY_WINDOW)
+        static constexpr StreamCommandType SET_COMMIT_WINDOW_X_START    = SET_REG | 0x0005;
+        static constexpr StreamCommandType SET_COMMIT_WINDOW_X_END      = SET_REG | 0x0006;
+        static constexpr StreamCommandType SET_COMMIT_WINDOW_Y_START    = SET_REG | 0x0007;
+        static constexpr StreamCommandType SET_COMMIT_WINDOW_Y_END      = SET_REG | 0x0008;
+        static constexpr StreamCommandType SET_COMMIT_WINDOW_LINE_Y     = SET_REG | 0x0009;
+
+        static constexpr StreamCommandType FRAMEBUFFER_COMMIT   = FRAMEBUFFER_OP | 0x0001;
+        static constexpr StreamCommandType FRAMEBUFFER_MEMSET   = FRAMEBUFFER_OP | 0x0002;
+        static constexpr StreamCommandType FRAMEBUFFER_COLOR    = FRAMEBUFFER_OP | 0x0010;
+        static constexpr StreamCommandType FRAMEBUFFER_DEPTH    = FRAMEBUFFER_OP | 0x0020;
+
+        // The compact flag selects the triangle setup on the FPGA. Only supported when the RasteriCEr is build with ENABLE_TRIANGLE_SETUP
+        static constexpr StreamCommandType TRIANGLE_STREAM_COMPACT = 0x0800;
+#ifdef HARDWARE_TRIANGLE_SETUP
+        static constexpr StreamCommandType TRIANGLE_DESCRIPTOR = TRIANGLE_STREAM | TRIANGLE_STREAM_COMPACT | TRIANGLE_SIZE_ALIGNED;
+#else
+        static constexpr StreamCommandType TRIANGLE_DESCRIPTOR = TRIANGLE_STREAM | TRIANGLE_SIZE_ALIGNED;
+#endif
+    };
+    using SCT = typename StreamCommand::StreamCommandType;
+    // A recorded triangle has the same layout as in the display lists. All lists are aligned to the bus width.
+    static constexpr uint32_t RECORDED_TRIANGLE_SIZE = ListUpload::template sizeOf<SCT>() + ListUpload::template sizeOf<Rasterizer::TriangleDescriptor>();
+    static constexpr uint8_t NO_MIP_LEVEL = 0xff; // The texture has no mip levels
+
+    // Masks to select registers. The bit position is the register address.
+    using RegMask = uint8_t;
+    static constexpr uint32_t NUMBER_OF_REGS = 5;
+    static constexpr RegMask REG_MASK_CLEAR_COLOR   = 1 << (StreamCommand::SET_COLOR_BUFFER_CLEAR_COLOR & StreamCommand::STREAM_COMMAND_IMM_MASK);
+    static constexpr RegMask REG_MASK_CLEAR_DEPTH   = 1 << (StreamCommand::SET_DEPTH_BUFFER_CLEAR_DEPTH & StreamCommand::STREAM_COMMAND_IMM_MASK);
+    static constexpr RegMask REG_MASK_CONF_REG1     = 1 << (StreamCommand::SET_CONF_REG1 & StreamCommand::STREAM_COMMAND_IMM_MASK);
+    static constexpr RegMask REG_MASK_CONF_REG2     = 1 << (StreamCommand::SET_CONF_REG2 & StreamCommand::STREAM_COMMAND_IMM_MASK);
+    static constexpr RegMask REG_MASK_TEX_ENV_COLOR = 1 << (StreamCommand::SET_TEX_ENV_COLOR & StreamCommand::STREAM_COMMAND_IMM_MASK);
+    // Registers which are used during the rasterization of a triangle
+    static constexpr RegMask TRIANGLE_REGS = REG_MASK_CONF_REG1 | REG_MASK_CONF_REG2 | REG_MASK_TEX_ENV_COLOR;
+    // Registers which are used during a memset of the frame buffer (the conf reg1 contains the masks)
+    static constexpr RegMask CLEAR_REGS = REG_MASK_CLEAR_COLOR | REG_MASK_CLEAR_DEPTH | REG_MASK_CONF_REG1;
+
+    class __attribute__ ((__packed__)) TextureStreamArg
+    {
+    public:
+        const uint16_t* pixels; // Owned by the TextureStore until the display list is uploaded
+        int32_t texSize; // Size of the texture in the texture buffer in 16 bit words (without the palette)
+        TextureFormat format;
+        uint16_t texId;
+        uint16_t generation;
+        uint8_t level; // Mip level of the texels
+    };
+    // The display lists do not call constructors and destructors
+    static_assert(std::is_trivially_copyable<TextureStreamArg>::value, "TextureStreamArg must be trivially copyable");
+
+    static bool isSameTexture(const TextureStreamArg& a, const TextureStreamArg& b)
+    {
+        return (a.texId == b.texId) && (a.generation == b.generation) && (a.level == b.level);
+    }
+
+    /// @brief Creates the texture stream command for a mip level of a texture. Nothing is changed if the size of the
+    /// level is not supported.
+    /// @param op The texture stream command
+    /// @param tsa The argument of the command
+    /// @param tex The texture
+    /// @param texId The id of the texture
+    /// @param level The mip level, must be smaller than tex.levels
+    /// @return false if the size of the level is not supported
+    static bool getTextureStream(SCT& op, TextureStreamArg& tsa, const Texture& tex, const uint16_t texId, const uint8_t level)
+    {
+        const uint16_t size = tex.width >> level;
+        if (size == 256)
+            op = StreamCommand::TEXTURE_STREAM_256x256;
+        else if (size == 128)
+            op = StreamCommand::TEXTURE_STREAM_128x128;
+        else if (size == 64)
+            op = StreamCommand::TEXTURE_STREAM_64x64;
+        else if (size == 32)
+            op = StreamCommand::TEXTURE_STREAM_32x32;
+        else
+            return false;
+
+        tsa.texSize = (tex.format == PALETTE4_RGBA4444) ? ((size * size) / 4) : (size * size);
+        tsa.pixels = tex.getPixels(level);
+        tsa.format = tex.format;
+        tsa.texId = texId;
+        tsa.generation = tex.generation;
+        tsa.level = level;
+        return true;
+    }
+
+    /// @brief Selects the page of a texture and decides which part of the texture has to be streamed after the texture
+    /// stream command. A resident texture is not streamed again, just the palette of a paletted texture.
+    /// @param textureResidency The textures which are resident on the device
+    /// @param op The texture stream command which is uploaded. It is updated with the page, the size and the format.
+    /// @param texture The texture
+    /// @return The number of 16 bit words which have to be streamed after the command
+    static uint32_t bindTexture(TextureResidency<>& textureResidency, SCT& op, const TextureStreamArg& texture)
+    {
+        uint32_t textureUploadSize = 0;
+        const std::pair<bool, uint8_t> page = textureResidency.bind(texture.texId, texture.generation, texture.level, texture.texSize);
+        op = (op & ~StreamCommand::TEXTURE_STREAM_PAGE_MASK) | (page.second << StreamCommand::TEXTURE_STREAM_PAGE_POS);
+        if (page.first)
+        {
+            op &= ~StreamCommand::TEXTURE_STREAM_SIZE_MASK;
+        }
+        else
+        {
+            textureUploadSize = texture.texSize;
+        }
+        if (texture.format == PALETTE4_RGBA4444)
+        {
+            // The hardware can only hold one palette, therefore it is always streamed
+            op = (op & ~StreamCommand::STREAM_COMMAND_OP_MASK) | StreamCommand::TEXTURE_STREAM_PALETTED;
+            textureUploadSize += PALETTE4_SIZE;
+        }
+        return textureUploadSize;
+    }
+
+    /// @brief Splits a texture into descriptors which fit into the hardware buffer
+    /// @param descriptors The first free descriptor of the chain
+    /// @param texture The texture to split
+    /// @param size The number of 16 bit words to stream from the beginning of the texture
+    /// @return The number of used descriptors
+    static uint32_t appendTextureDescriptors(IBusConnector::DataDescriptor* descriptors, const TextureStreamArg& texture, const uint32_t size)
+    {
+        static constexpr uint32_t PIXEL_INC = (HARDWARE_BUFFER_SIZE / sizeof(texture.pixels[0]));
+        uint32_t descriptorCount = 0;
+        for (uint32_t i = 0; i < size; i += PIXEL_INC)
+        {
+            const uint32_t chunkSize = ((size - i) < PIXEL_INC) ? (size - i) : PIXEL_INC;
+            descriptors[descriptorCount++] = { reinterpret_cast<const uint8_t*>(texture.pixels + i), static_cast<uint32_t>(chunkSize * sizeof(texture.pixels[0])) };
+        }
+        return descriptorCount;
+    }
+
+    static uint16_t convertColor(const Vec4i color)
+    {
+        Vec4i colorShift{color};
+        colorShift >>= 4;
+        uint16_t colorInt =   (static_cast<uint16_t>(colorShift[3]) << 0)
+                | (static_cast<uint16_t>(colorShift[2]) << 4)
+                | (static_cast<uint16_t>(colorShift[1]) << 8)
+                | (static_cast<uint16_t>(colorShift[0]) << 12);
+        return colorInt;
+    }
+
+    template <typename TArg>
+    bool setReg(const SCT op, const TArg& arg)
+    {
+        static_assert(sizeof(TArg) == sizeof(uint16_t), "Register must have a size of 16 bit");
+        const uint32_t reg = op & StreamCommand::STREAM_COMMAND_IMM_MASK;
+        if (m_regsPending & (1 << reg))
+        {
+            // The previous value was never used, it is overwritten by this one
+            m_eliminatedRegWrites++;
+        }
+        memcpy(&m_regs[reg], &arg, sizeof(uint16_t));
+        m_regsPending |= 1 << reg;
+        return true;
+    }
+
+    /// @brief Appends a triangle to the recording (see recordTriangles()). It uses the same layout as the display lists.
+    /// When the triangle uses another mip level than the previous one, an entry with the same size is recorded before
+    /// it, which contains a TEXTURE_STREAM op followed by the level. A replay selects this level again.
+    /// @param triangle The rasterized triangle
+    /// @param level The mip level which is used by the triangle, NO_MIP_LEVEL if the texture has no mip levels
+    void recordTriangle(const Rasterizer::TriangleDescriptor& triangle, const uint8_t level)
+    {
+        if (level != m_recordedTextureLevel)
+        {
+            const SCT op = StreamCommand::TEXTURE_STREAM;
+            const uint32_t pos = m_recordedTriangles->size();
+            m_recordedTriangles->resize(pos + RECORDED_TRIANGLE_SIZE, 0);
+            memcpy(&(*m_recordedTriangles)[pos], &op, sizeof(op));
+            (*m_recordedTriangles)[pos + ListUpload::template sizeOf<SCT>()] = level;
+            m_recordedTextureLevel = level;
+        }
+        const SCT op = StreamCommand::TRIANGLE_DESCRIPTOR;
+        const uint32_t pos = m_recordedTriangles->size();
+        m_recordedTriangles->resize(pos + RECORDED_TRIANGLE_SIZE, 0);
+        memcpy(&(*m_recordedTriangles)[pos], &op, sizeof(op));
+        memcpy(&(*m_recordedTriangles)[pos + ListUpload::template sizeOf<SCT>()], &triangle, sizeof(triangle));
+    }
+
+    /// @brief Decodes an entry of a recording (see recordTriangle())
+    /// @param entry The entry, it has the size RECORDED_TRIANGLE_SIZE
+    /// @param level Is set to the recorded mip level, if the entry is not a triangle
+    /// @return true if the entry is a triangle, false if it selects a mip level
+    static bool isRecordedTriangle(const uint8_t* entry, uint8_t& level)
+    {
+        SCT op;
+        memcpy(&op, entry, sizeof(op));
+        if (op == StreamCommand::TRIANGLE_DESCRIPTOR)
+        {
+            return true;
+        }
+        level = entry[ListUpload::template sizeOf<SCT>()];
+        return false;
+    }
+
+    /// @brief Copies the descriptor of a recorded triangle (see recordTriangle())
+    /// @param triangle The descriptor
+    /// @param entry The entry of the triangle, it has the size RECORDED_TRIANGLE_SIZE
+    static void getRecordedTriangle(Rasterizer::TriangleDescriptor& triangle, const uint8_t* entry)
+    {
+        memcpy(reinterpret_cast<uint8_t*>(&triangle), entry + ListUpload::template sizeOf<SCT>(), sizeof(triangle));
+    }
+
+    Rasterizer::Viewport m_viewport{0, 0, INT16_MAX, INT16_MAX}; // Not clamped until a viewport is set
+    std::vector<uint8_t>* m_recordedTriangles = nullptr;
+    uint8_t m_recordedTextureLevel = NO_MIP_LEVEL; // The mip level of the last recorded triangle
+
+    // Current register values
+    std::array<uint16_t, NUMBER_OF_REGS> m_regs;
+    RegMask m_regsPending = 0; // Registers which were set but not yet used by a triangle or a clear
+    uint32_t m_eliminatedRegWrites = 0;
+    bool m_frameCovered = false; // See setFrameCoveredHint()
+
+    // Per frame counters of the renderer (see Statistics.hpp)
+    Statistics<RendererStats> m_statistics;
+
+    // Texture memory allocator
+    TextureStore<MAX_NUMBER_OF_TEXTURES> m_textureStore;
+
+    struct __attribute__ ((__packed__)) ConfReg1
+    {
+        bool enableDepthTest : 1;
+        IRenderer::TestFunc depthFunc : 3;
+        IRenderer::TestFunc alphaFunc : 3;
+        uint8_t referenceAlphaValue : 4;
+        bool depthMask : 1;
+        bool colorMaskA : 1;
+        bool colorMaskB : 1;
+        bool colorMaskG : 1;
+        bool colorMaskR : 1;
+    } m_confReg1;
+
+    struct __attribute__ ((__packed__)) ConfReg2
+    {
+        bool perspectiveCorrectedTextures : 1;
+        IRenderer::TexEnvParam texEnvFunc : 3;
+        IRenderer::BlendFunc blendFuncSFactor : 4;
+        IRenderer::BlendFunc blendFuncDFactor : 4;
+        bool texClampS : 1;
+        bool texClampT : 1;
+    } m_confReg2;
+};
+
+#endif // RENDERERBASE_HPP
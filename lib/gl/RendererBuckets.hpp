@@ -0,0 +1,715 @@
+// RasteriCEr
+// https://github.com/ToNi3141/RasteriCEr
+// Copyright (c) 2021 ToNi3141
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef RENDERERBUCKETS_HPP
+#define RENDERERBUCKETS_HPP
+
+#include <stdint.h>
+#include <array>
+#include <type_traits>
+#include "RendererBase.hpp"
+#include "DirtyWindow.hpp"
+#include <string.h>
+
+// This renderer preallocates one display list (bucket) for every display line (see the screen layout in the Renderer).
+// Every incoming triangle is dispatched in drawTriangle() to all buckets it touches. The triangle is already adjusted
+// to the display line with calcLineIncrement() when it is written into the bucket, so the bucket contains exactly the
+// data which is later streamed to the hardware. During the upload, the buckets are just streamed without reinterpreting
+// them. This makes the upload much faster than the one from the Renderer, but it is less memory efficient, because a
+// triangle is potentially saved several times.
+// The render states (configuration registers and the bound texture) are not written directly into the buckets. They are
+// kept in the renderer and are only written into a bucket when a triangle is added to this bucket which requires a state
+// which is different to the state which was last written into this bucket. Therefore every bucket contains only the states
+// and textures it really needs.
+// The BUS_WIDTH is used to calculate the alignment in the display list.
+// The BUCKET_SIZE is the size of one bucket in bytes. The default will split the DISPLAY_LIST_SIZE equally between all
+// display lines. Bigger buckets allow more geometry per display line but require more memory.
+// The HARDWARE_BUFFER_SIZE is the size of the uploaded chunks, like in the Renderer.
+// The DISPLAY_BUFFERS are the number of bucket sets. Like the display lists of the Renderer, they are used as a ring:
+// one set is filled while the others are uploaded or are waiting for their upload. The upload continues in drawTriangle()
+// and commit() only blocks when all sets are in use. Every set requires DISPLAY_LINES * BUCKET_SIZE bytes.
+// RENDERER_DIRTY_WINDOW is supported like in the Renderer. The changed area is collected per bucket while the triangles
+// are added, commit() then writes the commit window or skips the commit of an unchanged bucket. Like in the Renderer,
+// every bucket is committed completely when there is more than one display line.
+// Unlike the Renderer, this renderer always drives exactly one device and has no DEVICES parameter. It also ignores
+// RENDERER_THREADED: There is no upload() for a second thread, the buckets are uploaded by the thread which calls
+// drawTriangle() and commit(). Use the Renderer for several devices or for a threaded upload.
+template <uint32_t DISPLAY_LIST_SIZE = 2048,
+          uint16_t DISPLAY_LINES = 1,
+          uint16_t LINE_RESOLUTION = 128,
+          uint16_t BUS_WIDTH = 32,
+          uint16_t MAX_NUMBER_OF_TEXTURES = 64,
+          uint32_t BUCKET_SIZE = DISPLAY_LIST_SIZE / DISPLAY_LINES,
+          uint32_t HARDWARE_BUFFER_SIZE = 2048,
+          uint8_t DISPLAY_BUFFERS = 2>
+class RendererBuckets : public RendererBase<BUS_WIDTH, MAX_NUMBER_OF_TEXTURES, HARDWARE_BUFFER_SIZE>
+{
+    static_assert(DISPLAY_BUFFERS >= 2, "At least two bucket sets are required");
+public:
+    RendererBuckets(IBusConnector& busConnector)
+        : m_busConnector(busConnector)
+    {
+        for (auto& buckets : m_buckets)
+        {
+            for (auto& bucket : buckets)
+            {
+                bucket.clear();
+            }
+        }
+        invalidateBucketStates();
+    }
+
+    virtual bool drawTriangle(const IRenderer::Vertex& v0,
+                              const IRenderer::Vertex& v1,
+                              const IRenderer::Vertex& v2,
+                              const IRenderer::TexCoord& st0,
+                              const IRenderer::TexCoord& st1,
+                              const IRenderer::TexCoord& st2,
+                              const Vec4i& color) override
+    {
+        Rasterizer::TriangleDescriptor triangleConf;
+
+        const uint32_t start = m_statistics.start();
+        const bool visible = Rasterizer::rasterize(triangleConf, v0, st0, v1, st1, v2, st2, m_viewport);
+        m_statistics.addTime(&RendererStats::rasterizeTime, start);
+        if (!visible)
+        {
+            // Triangle is not visible
+            m_statistics.add(&RendererStats::invisibleTriangles);
+            return true;
+        }
+
+        triangleConf.triangleStaticColor = convertColor(color);
+
+        uint8_t level = NO_MIP_LEVEL;
+        if (m_boundTexture.pixels)
+        {
+            // Bind the mip level which fits to the size of this triangle. Only this level is streamed.
+            const Texture* tex = m_textureStore.use(m_boundTexture.texId);
+            if (tex && (tex->levels > 1))
+            {
+                level = Rasterizer::calcMipLevel(v0, st0, v1, st1, v2, st2, tex->width, tex->levels);
+                if (level != m_boundTexture.level)
+                {
+                    bindTextureLevel(*tex, m_boundTexture.texId, level);
+                }
+            }
+        }
+
+        if (!addTriangle(triangleConf))
+        {
+            return false;
+        }
+        if (m_recordedTriangles)
+        {
+            recordTriangle(triangleConf, level);
+        }
+        return true;
+    }
+
+    virtual bool drawRecordedTriangles(const std::vector<uint8_t>& buffer) override
+    {
+        // The triangles have to be distributed again into the buckets, the already rasterized values can be reused.
+        for (uint32_t pos = 0; (pos + RECORDED_TRIANGLE_SIZE) <= buffer.size(); pos += RECORDED_TRIANGLE_SIZE)
+        {
+            uint8_t level;
+            if (!isRecordedTriangle(&buffer[pos], level))
+            {
+                // Bind the mip level which was selected when the triangles were recorded (see recordTriangle())
+                const Texture* tex = m_boundTexture.pixels ? m_textureStore.use(m_boundTexture.texId) : nullptr;
+                if (tex && (level < tex->levels) && (level != m_boundTexture.level))
+                {
+                    bindTextureLevel(*tex, m_boundTexture.texId, level);
+                }
+                continue;
+            }
+            Rasterizer::TriangleDescriptor triangleConf;
+            getRecordedTriangle(triangleConf, &buffer[pos]);
+            if (!addTriangle(triangleConf))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    virtual void commit() override
+    {
+        // Add frame buffer flush command
+        // Every bucket has always reserved space for this command (see hasEnoughSpace()), so this can't fail
+        for (uint32_t i = 0; i < DISPLAY_LINES; i++)
+        {
+            List& bucket = m_buckets[m_backList][i];
+#ifdef RENDERER_DIRTY_WINDOW
+            // Only changed display lines are committed, together with their commit window
+            DirtyWindow<LINE_RESOLUTION>& dirtyWindow = m_dirtyWindows[m_backList][i];
+            if (DISPLAY_LINES > 1)
+            {
+                // Without a memset, the frame buffer still contains the previous display line
+                dirtyWindow.addLine();
+            }
+            if (dirtyWindow.empty())
+            {
+                continue;
+            }
+            const IBusConnector::Window& window = dirtyWindow.get();
+            appendCommitWindowReg(bucket, StreamCommand::SET_COMMIT_WINDOW_X_START, window.xStart);
+            appendCommitWindowReg(bucket, StreamCommand::SET_COMMIT_WINDOW_X_END, window.xEnd);
+            appendCommitWindowReg(bucket, StreamCommand::SET_COMMIT_WINDOW_Y_START, window.yStart);
+            appendCommitWindowReg(bucket, StreamCommand::SET_COMMIT_WINDOW_Y_END, window.yEnd);
+            // The display lines are uploaded in reverse order, the last one is on the top of the display
+            appendCommitWindowReg(bucket, StreamCommand::SET_COMMIT_WINDOW_LINE_Y, (DISPLAY_LINES - 1 - i) * LINE_RESOLUTION);
+#endif
+            *(bucket.template create<SCT>()) = StreamCommand::FRAMEBUFFER_COMMIT | StreamCommand::FRAMEBUFFER_COLOR;
+        }
+
+        // Enqueue all buckets of the back set and continue with the next set of the ring
+        uint32_t displayListBytes = 0;
+        for (auto& bucket : m_buckets[m_backList])
+        {
+            displayListBytes += bucket.getSize();
+            bucket.enqueue();
+        }
+        m_statistics.set(&RendererStats::displayListBytes, displayListBytes);
+        m_backList = nextList(m_backList);
+        m_textureStore.frameCommitted();
+
+        // If the ring is full, block as long as the next set is transferred
+        const uint32_t start = m_statistics.start();
+        while (!isIdle(m_backList))
+        {
+            uploadDisplayList();
+        }
+        m_statistics.addTime(&RendererStats::commitTime, start);
+        m_statistics.commit();
+        // The set is idle, so its upload counters are complete
+        m_uploadStatistics[m_backList].commit();
+
+        // The hardware state at the beginning of a display line is unknown, because it depends on what was uploaded before.
+        // Therefore force that the states are written again into the new buckets.
+        invalidateBucketStates();
+
+        // Triggers an upload
+        uploadDisplayList();
+    }
+
+    virtual bool tryCommit() override
+    {
+        // The commit only blocks, when the next set of the ring is still in use
+        if (!isIdle(nextList(m_backList)))
+        {
+            uploadDisplayList();
+            return false;
+        }
+        commit();
+        return true;
+    }
+
+    virtual void getFrameStats(FrameStats& stats) const override
+    {
+        stats.renderer = m_statistics.get();
+        stats.upload = m_uploadStatistics[m_backList].get();
+    }
+
+    virtual bool clear(bool colorBuffer, bool depthBuffer) override
+    {
+        if (m_frameCovered && colorBuffer)
+        {
+            // The application overwrites every pixel, the clear of the color buffer is not required
+            colorBuffer = false;
+            m_statistics.add(&RendererStats::elidedClears);
+        }
+        const SCT opColorBuffer = StreamCommand::FRAMEBUFFER_MEMSET | StreamCommand::FRAMEBUFFER_COLOR;
+        const SCT opDepthBuffer = StreamCommand::FRAMEBUFFER_MEMSET | StreamCommand::FRAMEBUFFER_DEPTH;
+
+        SCT op = StreamCommand::NOP;
+        if (colorBuffer && depthBuffer)
+        {
+            op = opColorBuffer | opDepthBuffer;
+        }
+        else if (colorBuffer)
+        {
+            op = opColorBuffer;
+        }
+        else if (depthBuffer)
+        {
+            op = opDepthBuffer;
+        }
+        else
+        {
+            // Nothing to clear
+            return true;
+        }
+
+        for (auto& bucket : m_buckets[m_backList])
+        {
+            if (!hasEnoughSpace(bucket, CLEAR_REGS))
+            {
+                m_statistics.add(&RendererStats::displayListOverflows);
+                return false;
+            }
+        }
+
+        // The clear is executed on every display line. The memset uses the clear values and the masks from the conf reg1
+        RegMask regsWritten = 0;
+        for (uint32_t i = 0; i < DISPLAY_LINES; i++)
+        {
+            regsWritten |= writeRegsIntoBucket(i, CLEAR_REGS);
+            *(m_buckets[m_backList][i].template create<SCT>()) = op;
+#ifdef RENDERER_DIRTY_WINDOW
+            if (colorBuffer)
+            {
+                m_dirtyWindows[m_backList][i].addLine();
+            }
+#endif
+        }
+        consumePendingRegs(CLEAR_REGS, regsWritten);
+        return true;
+    }
+
+    virtual bool useTexture(const uint16_t texId) override
+    {
+        const Texture* tex = m_textureStore.use(texId);
+        if (!tex || texId == 0)
+        {
+            return false;
+        }
+        // The texture is just bound here. It is written into the buckets when a triangle requires this texture
+        return bindTextureLevel(*tex, texId, 0);
+    }
+
+private:
+    using Base = RendererBase<BUS_WIDTH, MAX_NUMBER_OF_TEXTURES, HARDWARE_BUFFER_SIZE>;
+    using typename Base::StreamCommand;
+    using typename Base::SCT;
+    using typename Base::RegMask;
+    using typename Base::TextureStreamArg;
+    using typename Base::Texture;
+    using typename Base::ListUpload;
+    using Base::MAX_DESCRIPTORS;
+    using Base::RECORDED_TRIANGLE_SIZE;
+    using Base::NO_MIP_LEVEL;
+    using Base::NUMBER_OF_REGS;
+    using Base::TRIANGLE_REGS;
+    using Base::CLEAR_REGS;
+    using Base::isSameTexture;
+    using Base::getTextureStream;
+    using Base::appendTextureDescriptors;
+    using Base::convertColor;
+    using Base::recordTriangle;
+    using Base::isRecordedTriangle;
+    using Base::getRecordedTriangle;
+    using Base::m_viewport;
+    using Base::m_recordedTriangles;
+    using Base::m_regs;
+    using Base::m_regsPending;
+    using Base::m_eliminatedRegWrites;
+    using Base::m_frameCovered;
+    using Base::m_statistics;
+    using Base::m_textureStore;
+
+    using List = DisplayList<BUCKET_SIZE, BUS_WIDTH / 8>;
+
+    // Contains the states which were last written into a bucket
+    struct BucketState
+    {
+        std::array<uint16_t, NUMBER_OF_REGS> regs;
+        RegMask regsValid;
+        TextureStreamArg texture;
+    };
+
+    void invalidateBucketStates()
+    {
+        for (auto& bucketState : m_bucketStates)
+        {
+            bucketState.regsValid = 0;
+            bucketState.texture = TextureStreamArg{nullptr, 0, IRenderer::RGBA4444, 0, 0, 0};
+        }
+    }
+
+    /// @brief Adds a rasterized triangle to all buckets which are touched by it
+    /// @param triangleConf The rasterized triangle
+    /// @return true if succeeded, false if a bucket is full
+    bool addTriangle(const Rasterizer::TriangleDescriptor& triangleConf)
+    {
+        // Calculate the buckets which are touched by this triangle. Use the same conditions as calcLineIncrement()
+        const uint32_t firstBucket = triangleConf.bbStartY / LINE_RESOLUTION;
+        uint32_t lastBucket = triangleConf.bbEndY / LINE_RESOLUTION;
+        if (firstBucket >= DISPLAY_LINES)
+        {
+            // Triangle is not visible
+            m_statistics.add(&RendererStats::invisibleTriangles);
+            return true;
+        }
+        if (lastBucket >= DISPLAY_LINES)
+        {
+            lastBucket = DISPLAY_LINES - 1;
+        }
+
+        // Check first if all buckets have enough memory. A triangle which is only partially written into the buckets
+        // would result in a triangle which is only visible in some display lines.
+        for (uint32_t i = firstBucket; i <= lastBucket; i++)
+        {
+            if (!hasEnoughSpace(m_buckets[m_backList][i], TRIANGLE_REGS))
+            {
+                m_statistics.add(&RendererStats::displayListOverflows);
+                return false;
+            }
+        }
+
+        RegMask regsWritten = 0;
+        for (uint32_t i = firstBucket; i <= lastBucket; i++)
+        {
+            List& bucket = m_buckets[m_backList][i];
+            regsWritten |= writeRegsIntoBucket(i, TRIANGLE_REGS);
+            writeTextureIntoBucket(i);
+
+            SCT *op = bucket.template create<SCT>();
+            Rasterizer::TriangleDescriptor *triangleConfDl = bucket.template create<Rasterizer::TriangleDescriptor>();
+            *op = StreamCommand::TRIANGLE_DESCRIPTOR;
+            if (!Rasterizer::calcLineIncrement(*triangleConfDl, triangleConf, i * LINE_RESOLUTION, (i + 1) * LINE_RESOLUTION))
+            {
+                // Should not happen because the buckets are selected by the bounding box. Just remove it to be safe
+                bucket.template remove<Rasterizer::TriangleDescriptor>();
+                bucket.template remove<SCT>();
+            }
+#ifdef RENDERER_DIRTY_WINDOW
+            else
+            {
+                m_dirtyWindows[m_backList][i].addTriangle(*triangleConfDl);
+            }
+#endif
+        }
+        consumePendingRegs(TRIANGLE_REGS, regsWritten);
+        m_statistics.add(&RendererStats::rasterizedTriangles);
+
+        // Should have a really low performance impact to trigger a upload after each triangle...
+        uploadDisplayList();
+        return true;
+    }
+
+    /// @brief Writes all registers selected by the mask into the bucket, if they differ from the ones which were last
+    /// written into this bucket. The bucket must have enough space (see hasEnoughSpace())
+    /// @param bucketIndex The index of the bucket in the back list
+    /// @param mask The registers to write
+    /// @return The registers which were written
+    RegMask writeRegsIntoBucket(const uint32_t bucketIndex, const RegMask mask)
+    {
+        RegMask written = 0;
+        List& bucket = m_buckets[m_backList][bucketIndex];
+        BucketState& bucketState = m_bucketStates[bucketIndex];
+        for (uint32_t i = 0; i < NUMBER_OF_REGS; i++)
+        {
+            const RegMask regMask = 1 << i;
+            if ((mask & regMask) && (!(bucketState.regsValid & regMask) || (bucketState.regs[i] != m_regs[i])))
+            {
+                *(bucket.template create<SCT>()) = StreamCommand::SET_REG | i;
+                *(bucket.template create<uint16_t>()) = m_regs[i];
+                bucketState.regs[i] = m_regs[i];
+                bucketState.regsValid |= regMask;
+                written |= regMask;
+            }
+        }
+        return written;
+    }
+
+    /// @brief Marks the registers as used. Registers which were set but not written into any bucket are counted as eliminated.
+    /// @param mask The registers which were used
+    /// @param written The registers which were written into at least one bucket
+    void consumePendingRegs(const RegMask mask, const RegMask written)
+    {
+        for (uint32_t i = 0; i < NUMBER_OF_REGS; i++)
+        {
+            const RegMask regMask = 1 << i;
+            if ((mask & m_regsPending & regMask) && !(written & regMask))
+            {
+                m_eliminatedRegWrites++;
+            }
+        }
+        m_regsPending &= ~mask;
+    }
+
+    /// @brief Binds a mip level of a texture. The binding is kept if the size of the level is not supported.
+    /// @param tex The texture
+    /// @param texId The id of the texture
+    /// @param level The mip level, must be smaller than tex.levels
+    /// @return false if the size of the level is not supported
+    bool bindTextureLevel(const Texture& tex, const uint16_t texId, const uint8_t level)
+    {
+        return getTextureStream(m_boundTextureOp, m_boundTexture, tex, texId, level);
+    }
+
+    /// @brief Writes the bound texture into the bucket if the bucket uses a different one.
+    /// The bucket must have enough space (see hasEnoughSpace())
+    /// @param bucketIndex The index of the bucket in the back list
+    void writeTextureIntoBucket(const uint32_t bucketIndex)
+    {
+        BucketState& bucketState = m_bucketStates[bucketIndex];
+        if (m_boundTexture.pixels && !isSameTexture(bucketState.texture, m_boundTexture))
+        {
+            // The texture can be bound since the last frame or it can be replaced since it was bound. Mark it
+            // as used in this frame and refresh the binding if the texels have changed.
+            const Texture* tex = m_textureStore.use(m_boundTexture.texId);
+            if (!tex || (tex->generation != m_boundTexture.generation))
+            {
+                // Keep the mip level if the new texels still have it
+                if (!tex || !bindTextureLevel(*tex, m_boundTexture.texId, (m_boundTexture.level < tex->levels) ? m_boundTexture.level : 0))
+                {
+                    m_boundTexture.pixels = nullptr;
+                    return;
+                }
+                if (isSameTexture(bucketState.texture, m_boundTexture))
+                {
+                    return;
+                }
+            }
+            List& bucket = m_buckets[m_backList][bucketIndex];
+            *(bucket.template create<SCT>()) = m_boundTextureOp;
+            *(bucket.template create<TextureStreamArg>()) = m_boundTexture;
+            bucketState.texture = m_boundTexture;
+        }
+    }
+
+    /// @brief This method will try to send the next chunk of a bucket to the hardware, if the last transfer is complete.
+    /// @return true if a upload is in progress
+    ///         false no upload is in progress
+    bool uploadDisplayList()
+    {
+        // Check if the last chain is transferred. The chain points into the bucket and to the texture,
+        // therefore nothing can be changed until the transfer is complete
+        if (!m_busConnector.transferComplete())
+            return true;
+
+        // Check if the front list is queued. If so, initialize a new transfer
+        if (m_buckets[m_frontList][DISPLAY_LINES - 1].state() == List::State::QUEUED)
+        {
+            // Upload the display lists in reverse order because in reality the rendered picture is upside down
+            m_uploadIndexPosition = DISPLAY_LINES - 1;
+            for (auto& bucket : m_buckets[m_frontList])
+            {
+                bucket.transfer();
+            }
+        }
+
+        List& bucket = m_buckets[m_frontList][m_uploadIndexPosition];
+        if (bucket.state() == List::State::TRANSFERRING)
+        {
+            // Check if the whole bucket is transferred. If so, start the transfer of the color buffer
+            if (bucket.atEnd())
+            {
+#ifdef RENDERER_DIRTY_WINDOW
+                // A bucket without changes was not committed (see commit())
+                DirtyWindow<LINE_RESOLUTION>& dirtyWindow = m_dirtyWindows[m_frontList][m_uploadIndexPosition];
+                if (dirtyWindow.empty())
+                {
+                    m_uploadStatistics[m_frontList].add(&UploadStats::skippedLines);
+                }
+                else
+                {
+                    m_busConnector.startColorBufferTransfer(m_uploadIndexPosition, dirtyWindow.get());
+                }
+                dirtyWindow.clear();
+#else
+                m_busConnector.startColorBufferTransfer(m_uploadIndexPosition, DirtyWindow<LINE_RESOLUTION>::FULL_LINE);
+#endif
+                bucket.resetGet();
+                bucket.clear();
+                if (m_uploadIndexPosition == 0)
+                {
+                    // The textures of this frame are not used anymore by the upload
+                    m_textureStore.frameUploaded();
+                    m_frontList = nextList(m_frontList);
+                    return false;
+                }
+                m_uploadIndexPosition--;
+                return true;
+            }
+
+            // The bucket already has the format which is expected from the hardware. Just search for the next
+            // chunk which can be directly streamed from the bucket. A chunk ends when the hardware buffer is full
+            // or when a texture has to be streamed.
+            Statistics<UploadStats>& uploadStatistics = m_uploadStatistics[m_frontList];
+            const uint32_t start = uploadStatistics.start();
+            const uint8_t* chunkStart = nullptr;
+            uint32_t chunkSize = 0;
+            uint32_t textureUploadSize = 0;
+            bool leaveLoop = false;
+            while (!leaveLoop && hasEnoughSpace(chunkSize))
+            {
+                SCT *op = bucket.template getNext<SCT>();
+                if (op == nullptr)
+                {
+                    break;
+                }
+
+                if (chunkStart == nullptr)
+                {
+                    chunkStart = reinterpret_cast<const uint8_t*>(op);
+                }
+                chunkSize += bucket.template sizeOf<SCT>();
+
+                switch ((*op) & StreamCommand::STREAM_COMMAND_OP_MASK) {
+                case StreamCommand::TRIANGLE_STREAM:
+                    bucket.template getNext<Rasterizer::TriangleDescriptor>();
+                    chunkSize += bucket.template sizeOf<Rasterizer::TriangleDescriptor>();
+                    uploadStatistics.add(&UploadStats::uploadedTriangles);
+                    break;
+                case StreamCommand::SET_REG:
+                    bucket.template getNext<uint16_t>();
+                    chunkSize += bucket.template sizeOf<uint16_t>();
+                    break;
+                case StreamCommand::FRAMEBUFFER_OP:
+                case StreamCommand::NOP:
+                    // Has no argument
+                    break;
+                case StreamCommand::TEXTURE_STREAM:
+                {
+                    // Read texture stream argument
+                    TextureStreamArg *dlArg = bucket.template getNext<TextureStreamArg>();
+                    // Check if the newly read argument has another texture than the current active one
+                    if (isSameTexture(m_textureStreamArg, *dlArg))
+                    {
+                        // If this is not the case, we can safely discard this command, because the texture is already in the buffer
+                        chunkSize -= bucket.template sizeOf<SCT>();
+                        if (chunkSize == 0)
+                        {
+                            // Nothing was collected till now, so just start a new chunk after this command
+                            chunkStart = nullptr;
+                        }
+                        else
+                        {
+                            // The chunk must be contiguous, therefore end the chunk here
+                            leaveLoop = true;
+                        }
+                    }
+                    else
+                    {
+                        // If this is not the case, set the newly read texture as the new stream texture
+                        m_textureStreamArg = *(dlArg);
+
+                        // Select the page of the texture. Only upload the texture if it is not already resident,
+                        // otherwise just select the page
+                        textureUploadSize = Base::bindTexture(m_textureResidency, *op, *dlArg);
+                        // The argument is not streamed, therefore the chunk must end here to be contiguous
+                        leaveLoop = true;
+                    }
+                }
+                    break;
+                default:
+                    // In case the op was not found
+                    chunkSize -= bucket.template sizeOf<SCT>();
+                    leaveLoop = true;
+                    break;
+                }
+            }
+
+            // Queue the chunk and, if required, the texture directly from the texture memory
+            uint32_t descriptorCount = 0;
+            if (chunkSize > 0)
+            {
+                m_descriptors[descriptorCount++] = { chunkStart, chunkSize };
+            }
+            if (textureUploadSize)
+            {
+                descriptorCount += appendTextureDescriptors(&m_descriptors[descriptorCount], m_textureStreamArg, textureUploadSize);
+            }
+            uploadStatistics.add(&UploadStats::uploadedBytes, chunkSize);
+            uploadStatistics.add(&UploadStats::textureBytes, textureUploadSize * sizeof(uint16_t));
+            uploadStatistics.addTime(&UploadStats::time, start);
+            m_busConnector.submitData(m_descriptors.data(), descriptorCount);
+            return true;
+        }
+
+        return false;
+    }
+
+    static uint8_t nextList(const uint8_t list)
+    {
+        return (list + 1) % DISPLAY_BUFFERS;
+    }
+
+    /// @brief Checks if a bucket set is neither queued nor transferred. The buckets are uploaded in reverse order,
+    /// therefore the first bucket is the last one which gets idle.
+    bool isIdle(const uint8_t list) const
+    {
+        return m_buckets[list][0].state() == List::State::IDLE;
+    }
+
+    /// @brief Checks if a bucket has enough space for a triangle or a clear including all states it potentially requires.
+    /// It will always keep enough space for the commit command, so that commit() can't fail.
+    /// @param bucket The bucket to check
+    /// @param mask The registers which are potentially written together with the command
+    bool hasEnoughSpace(const List& bucket, const RegMask mask)
+    {
+        uint32_t requiredSize = List::template sizeOf<SCT>() // Commit
+#ifdef RENDERER_DIRTY_WINDOW
+            + (5 * (List::template sizeOf<SCT>() + List::template sizeOf<uint16_t>())) // Commit window
+#endif
+            + List::template sizeOf<SCT>() + List::template sizeOf<TextureStreamArg>()
+            + List::template sizeOf<SCT>() + List::template sizeOf<Rasterizer::TriangleDescriptor>();
+        for (uint32_t i = 0; i < NUMBER_OF_REGS; i++)
+        {
+            if (mask & (1 << i))
+            {
+                requiredSize += List::template sizeOf<SCT>() + List::template sizeOf<uint16_t>();
+            }
+        }
+        return bucket.getFreeSpace() >= requiredSize;
+    }
+
+#ifdef RENDERER_DIRTY_WINDOW
+    /// @brief Writes a register of the commit window into a bucket. The space is reserved by hasEnoughSpace()
+    /// @param bucket The bucket
+    /// @param op The register
+    /// @param value The value of the register
+    static void appendCommitWindowReg(List& bucket, const SCT op, const uint16_t value)
+    {
+        *(bucket.template create<SCT>()) = op;
+        *(bucket.template create<uint16_t>()) = value;
+    }
+#endif
+
+    /// @brief Checks if the chunk which is streamed to the hardware has enough space for the next command
+    /// @param chunkSize The current size of the chunk
+    bool hasEnoughSpace(const uint32_t chunkSize)
+    {
+        return (HARDWARE_BUFFER_SIZE - chunkSize) >= (ListUpload::template sizeOf<SCT>() + ListUpload::template sizeOf<Rasterizer::TriangleDescriptor>());
+    }
+
+    std::array<std::array<List, DISPLAY_LINES>, DISPLAY_BUFFERS> m_buckets __attribute__ ((aligned (8)));
+#ifdef RENDERER_DIRTY_WINDOW
+    std::array<std::array<DirtyWindow<LINE_RESOLUTION>, DISPLAY_LINES>, DISPLAY_BUFFERS> m_dirtyWindows; // Changed area of every bucket
+#endif
+    std::array<BucketState, DISPLAY_LINES> m_bucketStates;
+    uint8_t m_frontList = 0; // Tail of the ring: The set which is uploaded next
+    uint8_t m_backList = 0; // Head of the ring: The set which is currently filled
+    uint32_t m_uploadIndexPosition = 0;
+    TextureStreamArg m_textureStreamArg{nullptr, 0, IRenderer::RGBA4444, 0, 0, 0};
+    TextureResidency<> m_textureResidency;
+    std::array<IBusConnector::DataDescriptor, MAX_DESCRIPTORS> m_descriptors;
+
+    // The bound texture
+    TextureStreamArg m_boundTexture{nullptr, 0, IRenderer::RGBA4444, 0, 0, 0};
+    SCT m_boundTextureOp = StreamCommand::NOP;
+
+    // Per frame counters of the upload (see Statistics.hpp)
+    std::array<Statistics<UploadStats>, DISPLAY_BUFFERS> m_uploadStatistics; // Upload counters of every set
+
+    IBusConnector& m_busConnector;
+};
+
+#endif // RENDERERBUCKETS_HPP
@@ -0,0 +1,62 @@
+// RasteriCEr
+// https://github.com/ToNi3141/RasteriCEr
+// Copyright (c) 2021 ToNi3141
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef RENDERERUPLOADTHREAD_HPP
+#define RENDERERUPLOADTHREAD_HPP
+
+#include <atomic>
+#include <thread>
+
+// Runs the upload of a renderer which is build with RENDERER_THREADED in a std::thread (for instance for the simulation).
+// On a MCU, Renderer::upload() can be called in the same way from the second core.
+// The thread is started with the construction and stops with the destruction of this object, therefore it must be
+// destroyed before the renderer.
+template <typename TRenderer>
+class RendererUploadThread
+{
+public:
+    RendererUploadThread(TRenderer& renderer)
+        : m_renderer(renderer)
+        , m_thread(&RendererUploadThread::run, this)
+    {
+    }
+
+    ~RendererUploadThread()
+    {
+        m_running.store(false);
+        m_thread.join();
+    }
+
+private:
+    void run()
+    {
+        while (m_running.load())
+        {
+            if (!m_renderer.upload())
+            {
+                // Nothing to upload
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    TRenderer& m_renderer;
+    std::atomic<bool> m_running{true};
+    std::thread m_thread; // Must be the last member, so that the thread is started after everything is initialized
+};
+
+#endif // RENDERERUPLOADTHREAD_HPP
@@ -0,0 +1,874 @@
+// RasteriCEr
+// https://github.com/ToNi3141/RasteriCEr
+// Copyright (c) 2021 ToNi3141
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SOFTWARERENDERER_HPP
+#define SOFTWARERENDERER_HPP
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include "IRenderer.hpp"
+#include "Rasterizer.hpp"
+#include "TextureStore.hpp"
+#include "ThreadPool.hpp"
+
+// Renders the triangles on the host instead of the RasteriCEr, for instance for the simulation, for tests or for
+// targets with an operating system but without FPGA. It uses the same triangles as the Renderer (Rasterizer::RasterizedTriangle)
+// and calculates the fragments exactly like the Rasterizer.v and the FragmentPipeline.v. Therefore the color buffer
+// (RGBA4444) and the depth buffer (16 bit W buffer) contain the same values as the frame buffers of the hardware
+// and it can be used as reference for the RTL.
+// The screen is divided into the same DISPLAY_LINES with the LINE_RESOLUTION as in the Renderer. Every display line is
+// again divided into tiles of TILE_WIDTH pixels. During commit(), the tiles are rendered in parallel on a work stealing
+// thread pool. A tile is rasterized with LANES pixels at a time. The edge functions and the attributes of the lanes are
+// evaluated with vector instructions (GCC vector extension, SSE/AVX on x86, NEON on ARM).
+// Differences to the hardware:
+//  - The hardware uses the same memory for every display line, so every display line starts with the content of the
+//    previous one. Here every pixel has its own memory. It makes no difference, when the frame starts with a clear.
+//  - The edge walker of the Rasterizer.v is not simulated, instead all pixels in the bounding box which are in the triangle
+//    are rendered. The edge walker visits the same pixels, just in another order.
+// The color buffer has the same layout as the stream of the color buffer from the hardware: The first pixel is the upper left corner.
+template <uint16_t DISPLAY_LINES = 1, uint16_t LINE_RESOLUTION = 128, uint16_t MAX_NUMBER_OF_TEXTURES = 64>
+class SoftwareRenderer : public IRenderer
+{
+public:
+    static constexpr uint16_t TILE_WIDTH = 64;
+    static constexpr uint32_t LANES = 8;
+
+    /// @brief Creates the renderer
+    /// @param colorBuffer The color buffer with resolutionW * DISPLAY_LINES * LINE_RESOLUTION pixels
+    /// @param depthBuffer The depth buffer with the same size as the color buffer
+    /// @param resolutionW The horizontal resolution
+    /// @param numberOfThreads The number of threads which are rendering the tiles (including the thread which calls commit()).
+    ///     0 uses one thread per core.
+    SoftwareRenderer(uint16_t* colorBuffer, uint16_t* depthBuffer, const uint16_t resolutionW, const uint32_t numberOfThreads = 0)
+        : m_colorBuffer(colorBuffer)
+        , m_depthBuffer(depthBuffer)
+        , m_resolutionW(resolutionW)
+        , m_tilesPerLine((resolutionW + TILE_WIDTH - 1) / TILE_WIDTH)
+        , m_threadPool(numberOfThreads)
+    {
+        initRecip();
+
+        // Same defaults as the Renderer has
+#ifndef NO_PERSP_CORRECT
+        m_state.confReg2.perspectiveCorrectedTextures = true;
+#else
+        m_state.confReg2.perspectiveCorrectedTextures = false;
+#endif
+        m_state.confReg2.texClampS = false;
+        m_state.confReg2.texClampT = false;
+        m_state.confReg1.enableDepthTest = false;
+        m_state.texture = nullptr;
+        m_state.textureSize = 0;
+        m_state.textureFormat = RGBA4444;
+
+        setDepthFunc(TestFunc::LESS);
+        setDepthMask(false);
+        setColorMask(true, true, true, true);
+        setAlphaFunc(TestFunc::ALWAYS, 0xf);
+        setTexEnv(TexEnvTarget::TEXTURE_ENV, TexEnvParamName::TEXTURE_ENV_MODE, TexEnvParam::MODULATE);
+        setBlendFunc(BlendFunc::ONE, BlendFunc::ZERO);
+        setTexEnvColor({{0, 0, 0, 0}});
+        setClearColor({{0, 0, 0, 0}});
+        setClearDepth(65535);
+    }
+
+    virtual bool drawTriangle(const Vertex& v0,
+                              const Vertex& v1,
+                              const Vertex& v2,
+                              const TexCoord& st0,
+                              const TexCoord& st1,
+                              const TexCoord& st2,
+                              const Vec4i& color) override
+    {
+        Rasterizer::RasterizedTriangle triangle;
+        const uint32_t start = m_statistics.start();
+        const bool visible = Rasterizer::rasterize(triangle, v0, st0, v1, st1, v2, st2, m_viewport);
+        m_statistics.addTime(&RendererStats::rasterizeTime, start);
+        if (!visible)
+        {
+            m_statistics.add(&RendererStats::invisibleTriangles);
+            return true;
+        }
+        triangle.triangleStaticColor = convertColor(color);
+
+        const typename TextureStore<MAX_NUMBER_OF_TEXTURES>::Texture* tex = m_boundTexId ? m_textureStore.use(m_boundTexId) : nullptr;
+        uint8_t level = NO_MIP_LEVEL;
+        if (tex && (tex->levels > 1))
+        {
+            // Same mip level selection as in the Renderer
+            level = Rasterizer::calcMipLevel(v0, st0, v1, st1, v2, st2, tex->width, tex->levels);
+            bindTextureLevel(*tex, level);
+        }
+
+        if (m_recordedTriangles)
+        {
+            // The triangle is recorded together with its mip level
+            const uint32_t pos = m_recordedTriangles->size();
+            m_recordedTriangles->resize(pos + RECORDED_TRIANGLE_SIZE);
+            memcpy(&(*m_recordedTriangles)[pos], &triangle, sizeof(Rasterizer::RasterizedTriangle));
+            (*m_recordedTriangles)[pos + sizeof(Rasterizer::RasterizedTriangle)] = level;
+        }
+        appendTriangle(triangle);
+        m_statistics.add(&RendererStats::rasterizedTriangles);
+        return true;
+    }
+
+    virtual void recordTriangles(std::vector<uint8_t>* buffer) override
+    {
+        m_recordedTriangles = buffer;
+    }
+
+    virtual bool drawRecordedTriangles(const std::vector<uint8_t>& buffer) override
+    {
+        Rasterizer::RasterizedTriangle triangle;
+        const typename TextureStore<MAX_NUMBER_OF_TEXTURES>::Texture* tex = m_boundTexId ? m_textureStore.use(m_boundTexId) : nullptr;
+        for (uint32_t pos = 0; (pos + RECORDED_TRIANGLE_SIZE) <= buffer.size(); pos += RECORDED_TRIANGLE_SIZE)
+        {
+            memcpy(reinterpret_cast<uint8_t*>(&triangle), &buffer[pos], sizeof(Rasterizer::RasterizedTriangle));
+            const uint8_t level = buffer[pos + sizeof(Rasterizer::RasterizedTriangle)];
+            if (tex && (level < tex->levels))
+            {
+                bindTextureLevel(*tex, level);
+            }
+            appendTriangle(triangle);
+            m_statistics.add(&RendererStats::rasterizedTriangles);
+        }
+        return true;
+    }
+
+    virtual void commit() override
+    {
+        m_statistics.set(&RendererStats::displayListBytes, (m_commands.size() * sizeof(Command))
+            + (m_triangles.size() * sizeof(Rasterizer::RasterizedTriangle)));
+
+        const uint32_t start = m_statistics.start();
+        m_textureStore.frameCommitted();
+        m_threadPool.run(DISPLAY_LINES * m_tilesPerLine, [this](const uint32_t tile) { renderTile(tile); });
+        // The textures of this frame are not used anymore
+        m_textureStore.frameUploaded();
+        m_statistics.addTime(&RendererStats::commitTime, start);
+        m_statistics.commit();
+
+        m_commands.clear();
+        m_triangles.clear();
+        m_states.clear();
+        m_stateChanged = true;
+    }
+
+    virtual bool tryCommit() override
+    {
+        // The frame is rendered during the commit, there are no previous frames which can be in progress
+        commit();
+        return true;
+    }
+
+    virtual void getFrameStats(FrameStats& stats) const override
+    {
+        stats.renderer = m_statistics.get();
+        stats.upload = {};
+    }
+
+    virtual bool clear(bool colorBuffer, bool depthBuffer) override
+    {
+        if (m_frameCovered && colorBuffer)
+        {
+            // The application overwrites every pixel, the clear of the color buffer is not required
+            colorBuffer = false;
+            m_statistics.add(&RendererStats::elidedClears);
+        }
+        Command command{};
+        command.op = Command::CLEAR;
+        command.clearColor = colorBuffer;
+        command.clearDepth = depthBuffer;
+        appendCommand(command);
+        return true;
+    }
+
+    virtual bool setClearColor(const Vec4i& color) override
+    {
+        return setState(m_state.clearColor, convertColor(color));
+    }
+
+    virtual bool setClearDepth(uint16_t depth) override
+    {
+        return setState(m_state.clearDepth, depth);
+    }
+
+    virtual bool setDepthMask(const bool flag) override
+    {
+        ConfReg1 confReg1 = m_state.confReg1;
+        confReg1.depthMask = flag;
+        return setState(m_state.confReg1, confReg1);
+    }
+
+    virtual bool enableDepthTest(const bool enable) override
+    {
+        ConfReg1 confReg1 = m_state.confReg1;
+        confReg1.enableDepthTest = enable;
+        return setState(m_state.confReg1, confReg1);
+    }
+
+    virtual bool setColorMask(const bool r, const bool g, const bool b, const bool a) override
+    {
+        ConfReg1 confReg1 = m_state.confReg1;
+        confReg1.colorMaskA = a;
+        confReg1.colorMaskB = b;
+        confReg1.colorMaskG = g;
+        confReg1.colorMaskR = r;
+        return setState(m_state.confReg1, confReg1);
+    }
+
+    virtual bool setDepthFunc(const TestFunc func) override
+    {
+        ConfReg1 confReg1 = m_state.confReg1;
+        confReg1.depthFunc = func;
+        return setState(m_state.confReg1, confReg1);
+    }
+
+    virtual bool setAlphaFunc(const TestFunc func, const uint8_t ref) override
+    {
+        ConfReg1 confReg1 = m_state.confReg1;
+        confReg1.alphaFunc = func;
+        confReg1.referenceAlphaValue = ref;
+        return setState(m_state.confReg1, confReg1);
+    }
+
+    virtual bool setTexEnv(const TexEnvTarget target, const TexEnvParamName pname, const TexEnvParam param) override
+    {
+        (void)target; // Only TEXTURE_ENV is supported
+        (void)pname; // Only GL_TEXTURE_ENV_MODE is supported
+        ConfReg2 confReg2 = m_state.confReg2;
+        confReg2.texEnvFunc = param;
+        return setState(m_state.confReg2, confReg2);
+    }
+
+    virtual bool setBlendFunc(const BlendFunc sfactor, const BlendFunc dfactor) override
+    {
+        ConfReg2 confReg2 = m_state.confReg2;
+        confReg2.blendFuncSFactor = sfactor;
+        confReg2.blendFuncDFactor = dfactor;
+        return setState(m_state.confReg2, confReg2);
+    }
+
+    virtual bool setLogicOp(const LogicOp opcode) override
+    {
+        // Like the hardware, logic ops are not supported
+        (void)opcode;
+        return false;
+    }
+
+    virtual bool setTexEnvColor(const Vec4i& color) override
+    {
+        return setState(m_state.texEnvColor, convertColor(color));
+    }
+
+    virtual bool setTextureWrapModeS(const TextureWrapMode mode) override
+    {
+        ConfReg2 confReg2 = m_state.confReg2;
+        confReg2.texClampS = mode == TextureWrapMode::CLAMP_TO_EDGE;
+        return setState(m_state.confReg2, confReg2);
+    }
+
+    virtual bool setTextureWrapModeT(const TextureWrapMode mode) override
+    {
+        ConfReg2 confReg2 = m_state.confReg2;
+        confReg2.texClampT = mode == TextureWrapMode::CLAMP_TO_EDGE;
+        return setState(m_state.confReg2, confReg2);
+    }
+
+    virtual bool setViewport(const int16_t x, const int16_t y, const int16_t width, const int16_t height) override
+    {
+        m_viewport = {x, y, width, height};
+        return true;
+    }
+
+    virtual void setFrameCoveredHint(const bool covered) override
+    {
+        m_frameCovered = covered;
+    }
+
+    virtual std::pair<bool, uint16_t> createTexture() override
+    {
+        return m_textureStore.create();
+    }
+
+    virtual bool updateTexture(const uint16_t texId,
+                               std::shared_ptr<const uint16_t> pixels,
+                               const uint16_t texWidth,
+                               const uint16_t texHeight,
+                               const TextureFormat format) override
+    {
+        if (texWidth != texHeight)
+            return false;
+        return m_textureStore.update(texId, pixels, texWidth, texHeight, format);
+    }
+
+    virtual bool updateTextureLevel(const uint16_t texId,
+                                    const uint8_t level,
+                                    std::shared_ptr<const uint16_t> pixels,
+                                    const uint16_t texWidth,
+                                    const uint16_t texHeight,
+                                    const TextureFormat format) override
+    {
+        return m_textureStore.updateLevel(texId, level, pixels, texWidth, texHeight, format);
+    }
+
+    virtual bool useTexture(const uint16_t texId) override
+    {
+        const typename TextureStore<MAX_NUMBER_OF_TEXTURES>::Texture* tex = m_textureStore.use(texId);
+        if (!tex || texId == 0)
+        {
+            return false;
+        }
+        if ((tex->width != 32) && (tex->width != 64) && (tex->width != 128) && (tex->width != 256))
+        {
+            return false; // Not supported texture format
+        }
+        m_state.texture = tex->pixels.get();
+        m_state.textureSize = tex->width;
+        m_state.textureFormat = tex->format;
+        m_stateChanged = true;
+        m_boundTexId = texId;
+        return true;
+    }
+
+    virtual bool deleteTexture(const uint16_t texId) override
+    {
+        return m_textureStore.destroy(texId);
+    }
+
+private:
+    static constexpr uint8_t NO_MIP_LEVEL = 0xff; // The texture has no mip levels
+    static constexpr uint32_t RECORDED_TRIANGLE_SIZE = sizeof(Rasterizer::RasterizedTriangle) + 1; // The triangle and its mip level
+
+    // Same layout as the registers of the Renderer
+    struct __attribute__ ((__packed__)) ConfReg1
+    {
+        bool enableDepthTest : 1;
+        IRenderer::TestFunc depthFunc : 3;
+        IRenderer::TestFunc alphaFunc : 3;
+        uint8_t referenceAlphaValue : 4;
+        bool depthMask : 1;
+        bool colorMaskA : 1;
+        bool colorMaskB : 1;
+        bool colorMaskG : 1;
+        bool colorMaskR : 1;
+    };
+
+    struct __attribute__ ((__packed__)) ConfReg2
+    {
+        bool perspectiveCorrectedTextures : 1;
+        IRenderer::TexEnvParam texEnvFunc : 3;
+        IRenderer::BlendFunc blendFuncSFactor : 4;
+        IRenderer::BlendFunc blendFuncDFactor : 4;
+        bool texClampS : 1;
+        bool texClampT : 1;
+    };
+
+    // Everything which configures the fragment pipeline (the registers and the bound texture of the hardware)
+    struct State
+    {
+        ConfReg1 confReg1;
+        ConfReg2 confReg2;
+        uint16_t texEnvColor;
+        uint16_t clearColor;
+        uint16_t clearDepth;
+        const uint16_t* texture; // Owned by the TextureStore until the frame is rendered
+        uint16_t textureSize;
+        TextureFormat textureFormat;
+    };
+
+    // The triangles are kept in m_triangles, so that a clear doesn't carry an (uninitialized) triangle
+    struct Command
+    {
+        enum Op : uint8_t
+        {
+            TRIANGLE,
+            CLEAR
+        };
+        Op op;
+        bool clearColor;
+        bool clearDepth;
+        uint32_t state; // Index into m_states
+        uint32_t triangle; // Index into m_triangles (TRIANGLE only)
+    };
+
+    // Lanes of the vector unit
+    typedef uint32_t LaneVec __attribute__ ((vector_size (LANES * sizeof(uint32_t))));
+    typedef int32_t LaneMask __attribute__ ((vector_size (LANES * sizeof(int32_t))));
+
+    // Recip.v with the parameters of the FragmentPipeline
+    static constexpr uint32_t RECIP_NUMERATOR = 0xffffff;
+    static constexpr uint32_t RECIP_NUMBER_WIDTH = 16;
+    static constexpr uint32_t RECIP_LOOKUP_PRECISION = 11;
+    static constexpr uint32_t RECIP_INTERPOLATION_WIDTH = RECIP_NUMBER_WIDTH - RECIP_LOOKUP_PRECISION;
+    static constexpr uint32_t RECIP_LOOKUP_SIZE = 1 << RECIP_LOOKUP_PRECISION;
+
+    static uint16_t convertColor(const Vec4i color)
+    {
+        Vec4i colorShift{color};
+        colorShift >>= 4;
+        uint16_t colorInt =   (static_cast<uint16_t>(colorShift[3]) << 0)
+                | (static_cast<uint16_t>(colorShift[2]) << 4)
+                | (static_cast<uint16_t>(colorShift[1]) << 8)
+                | (static_cast<uint16_t>(colorShift[0]) << 12);
+        return colorInt;
+    }
+
+    template <typename TArg>
+    bool setState(TArg& reg, const TArg& value)
+    {
+        if (memcmp(&reg, &value, sizeof(TArg)) != 0)
+        {
+            reg = value;
+            m_stateChanged = true;
+        }
+        return true;
+    }
+
+    /// @brief Selects the texels of a mip level of the bound texture for the next triangles
+    /// @param tex The bound texture
+    /// @param level The mip level, must be smaller than tex.levels
+    void bindTextureLevel(const typename TextureStore<MAX_NUMBER_OF_TEXTURES>::Texture& tex, const uint8_t level)
+    {
+        setState(m_state.texture, tex.getPixels(level));
+        setState(m_state.textureSize, static_cast<uint16_t>(tex.width >> level));
+    }
+
+    void appendCommand(Command& command)
+    {
+        if (m_stateChanged)
+        {
+            m_states.push_back(m_state);
+            m_stateChanged = false;
+        }
+        command.state = m_states.size() - 1;
+        m_commands.push_back(command);
+    }
+
+    void appendTriangle(const Rasterizer::RasterizedTriangle& triangle)
+    {
+        Command command{};
+        command.op = Command::TRIANGLE;
+        command.triangle = m_triangles.size();
+        m_triangles.push_back(triangle);
+        appendCommand(command);
+    }
+
+    /// @brief Builds the lookup tables of the Recip.v
+    void initRecip()
+    {
+        for (uint32_t j = 0; j < RECIP_LOOKUP_SIZE; j++)
+        {
+            // Integer arithmetic of the initial block of the Recip.v
+            const int32_t currentB = (j == 0) ? -1 : (((RECIP_NUMERATOR / j) + (1 << (RECIP_INTERPOLATION_WIDTH - 1))) >> RECIP_INTERPOLATION_WIDTH);
+            const int32_t nextB = ((RECIP_NUMERATOR / (j + 1)) + (1 << (RECIP_INTERPOLATION_WIDTH - 1))) >> RECIP_INTERPOLATION_WIDTH;
+            m_recipB[j] = static_cast<uint16_t>(currentB);
+            m_recipM[j] = static_cast<uint16_t>(currentB - nextB);
+        }
+    }
+
+    /// @brief Calculates 0xffffff / x like the Recip.v
+    /// @param x U1.15 number
+    /// @return U7.9 number
+    uint16_t recip(const uint16_t x) const
+    {
+        const uint32_t lut = x >> RECIP_INTERPOLATION_WIDTH;
+        const uint32_t prod = static_cast<uint32_t>(x & ((1 << RECIP_INTERPOLATION_WIDTH) - 1)) * m_recipM[lut];
+        const uint16_t mx = -static_cast<uint16_t>(prod >> RECIP_INTERPOLATION_WIDTH);
+        return mx + m_recipB[lut];
+    }
+
+    static uint16_t clampTexture(const uint32_t texCoord, const bool clampToEdge)
+    {
+        // texCoord is a 24 bit number
+        if (clampToEdge)
+        {
+            if (texCoord & 0x800000)
+            {
+                return 0;
+            }
+            if ((texCoord >> 15) != 0)
+            {
+                return 0x7fff;
+            }
+        }
+        return static_cast<uint16_t>(texCoord);
+    }
+
+    static bool test(const TestFunc func, const uint16_t val, const uint16_t ref)
+    {
+        switch (func)
+        {
+        case ALWAYS: return true;
+        case NEVER: return false;
+        case LESS: return val < ref;
+        case EQUAL: return val == ref;
+        case LEQUAL: return val <= ref;
+        case GREATER: return val > ref;
+        case NOTEQUAL: return val != ref;
+        case GEQUAL: return val >= ref;
+        default: return true;
+        }
+    }
+
+    /// @brief Calculates (a * b) + (c * d) of 4 bit colors like the hardware, including the rounding and the saturation
+    static uint8_t mac(const uint8_t a, const uint8_t b, const uint8_t c, const uint8_t d)
+    {
+        const uint32_t val = (a * b) + (c * d) + 0xf;
+        return (val & 0x100) ? 0xf : ((val >> 4) & 0xf);
+    }
+
+    static std::array<uint8_t, 4> unpack(const uint16_t color)
+    {
+        return {{ static_cast<uint8_t>((color >> 12) & 0xf),
+                  static_cast<uint8_t>((color >> 8) & 0xf),
+                  static_cast<uint8_t>((color >> 4) & 0xf),
+                  static_cast<uint8_t>(color & 0xf) }};
+    }
+
+    static uint16_t pack(const std::array<uint8_t, 4>& color)
+    {
+        return (color[0] << 12) | (color[1] << 8) | (color[2] << 4) | color[3];
+    }
+
+    /// @brief Reads a texel like the TextureBuffer.v
+    static uint16_t fetchTexel(const State& state, const uint16_t texS, const uint16_t texT)
+    {
+        if (!state.texture)
+        {
+            return 0;
+        }
+        uint32_t index;
+        switch (state.textureSize)
+        {
+        case 32:
+            index = (((texT >> 10) & 0x1f) << 5) | ((texS >> 10) & 0x1f);
+            break;
+        case 64:
+            index = (((texT >> 9) & 0x3f) << 6) | ((texS >> 9) & 0x3f);
+            break;
+        case 128:
+            index = (((texT >> 8) & 0x7f) << 7) | ((texS >> 8) & 0x7f);
+            break;
+        default:
+            // 256x256 is not supported by the TextureBuffer, it always reads the first texel
+            index = 0;
+            break;
+        }
+        if (state.textureFormat == PALETTE4_RGBA4444)
+        {
+            // The palette is in front of the indices, a word contains four indices
+            const uint16_t indices = state.texture[PALETTE4_SIZE + (index >> 2)];
+            return state.texture[(indices >> ((index & 0x3) * 4)) & 0xf];
+        }
+        return state.texture[index];
+    }
+
+    /// @brief Calculates a fragment like the FragmentPipeline.v and writes it into the buffers
+    /// @param state The configuration of the pipeline
+    /// @param triangleColor The static color of the triangle
+    /// @param texS The interpolated texture coordinate S from the rasterizer (S1.30)
+    /// @param texT The interpolated texture coordinate T from the rasterizer (S1.30)
+    /// @param depthW The interpolated reciprocal of W from the rasterizer (S1.30)
+    /// @param color The pixel in the color buffer
+    /// @param depth The pixel in the depth buffer
+    void shadeFragment(const State& state,
+                       const uint16_t triangleColor,
+                       const uint32_t texS,
+                       const uint32_t texT,
+                       const uint32_t depthW,
+                       uint16_t& color,
+                       uint16_t& depth) const
+    {
+        // Perspective correction. Recip: (Un.24 / U1.15 = U7.9)
+        const uint16_t wValue = recip(static_cast<uint16_t>(depthW >> 15));
+        const int16_t texSTmp = static_cast<int16_t>(static_cast<int32_t>(texS) >> 16); // S1.14
+        const int16_t texTTmp = static_cast<int16_t>(static_cast<int32_t>(texT) >> 16);
+        uint16_t textureS;
+        uint16_t textureT;
+        if (state.confReg2.perspectiveCorrectedTextures)
+        {
+            // (U7.9 * S1.14 = S8.23) >> 8 = S8.15, truncated to 24 bit
+            textureS = clampTexture(static_cast<uint32_t>((static_cast<int32_t>(wValue) * texSTmp) >> 8) & 0xffffff, state.confReg2.texClampS);
+            textureT = clampTexture(static_cast<uint32_t>((static_cast<int32_t>(wValue) * texTTmp) >> 8) & 0xffffff, state.confReg2.texClampT);
+        }
+        else
+        {
+            textureS = clampTexture(static_cast<uint16_t>(static_cast<uint16_t>(texSTmp) << 1), state.confReg2.texClampS);
+            textureT = clampTexture(static_cast<uint16_t>(static_cast<uint16_t>(texTTmp) << 1), state.confReg2.texClampT);
+        }
+
+        // Tex env
+        const std::array<uint8_t, 4> s = unpack(fetchTexel(state, textureS, textureT));
+        const std::array<uint8_t, 4> p = unpack(triangleColor);
+        const std::array<uint8_t, 4> c = unpack(state.texEnvColor);
+        std::array<uint8_t, 4> tex;
+        switch (state.confReg2.texEnvFunc)
+        {
+        case REPLACE:
+            for (uint32_t i = 0; i < 4; i++)
+                tex[i] = mac(s[i], 0xf, 0, 0);
+            break;
+        case MODULATE:
+            for (uint32_t i = 0; i < 4; i++)
+                tex[i] = mac(p[i], s[i], 0, 0);
+            break;
+        case DECAL:
+            for (uint32_t i = 0; i < 3; i++)
+                tex[i] = mac(p[i], 0xf - s[3], s[i], s[3]);
+            tex[3] = mac(p[3], 0xf, 0, 0);
+            break;
+        case BLEND:
+            for (uint32_t i = 0; i < 3; i++)
+                tex[i] = mac(p[i], 0xf - s[i], c[i], s[i]);
+            tex[3] = mac(p[3], s[3], 0, 0);
+            break;
+        case ADD:
+            for (uint32_t i = 0; i < 3; i++)
+                tex[i] = mac(p[i], 0xf, s[i], 0xf);
+            tex[3] = mac(p[3], s[3], 0, 0);
+            break;
+        case DISABLE:
+        default:
+            for (uint32_t i = 0; i < 4; i++)
+                tex[i] = mac(p[i], 0xf, 0, 0);
+            break;
+        }
+
+        // Depth and alpha test
+        const bool depthTestPassed = test(state.confReg1.depthFunc, wValue, depth) || !state.confReg1.enableDepthTest;
+        const bool alphaTestPassed = test(state.confReg1.alphaFunc, tex[3], state.confReg1.referenceAlphaValue);
+        if (!(depthTestPassed && alphaTestPassed))
+        {
+            return;
+        }
+
+        // Blend. Factors which are not supported by the hardware are zero (the hardware keeps the last factor).
+        const std::array<uint8_t, 4> d = unpack(color);
+        std::array<uint8_t, 4> sFactor{};
+        std::array<uint8_t, 4> dFactor{};
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            switch (state.confReg2.blendFuncSFactor)
+            {
+            case ONE: sFactor[i] = 0xf; break;
+            case DST_COLOR: sFactor[i] = d[i]; break;
+            case ONE_MINUS_DST_COLOR: sFactor[i] = 0xf - d[i]; break;
+            case SRC_ALPHA: sFactor[i] = tex[3]; break;
+            case ONE_MINUS_SRC_ALPHA: sFactor[i] = 0xf - tex[3]; break;
+            case DST_ALPHA: sFactor[i] = d[3]; break;
+            case ONE_MINUS_DST_ALPHA: sFactor[i] = 0xf - d[3]; break;
+            case SRC_ALPHA_SATURATE: sFactor[i] = (i == 3) ? 0xf : std::min<uint8_t>(tex[3], 0xf - d[3]); break;
+            default: break;
+            }
+            switch (state.confReg2.blendFuncDFactor)
+            {
+            case ONE: dFactor[i] = 0xf; break;
+            case SRC_COLOR: dFactor[i] = tex[i]; break;
+            case ONE_MINUS_SRC_COLOR: dFactor[i] = 0xf - tex[i]; break;
+            case SRC_ALPHA: dFactor[i] = tex[3]; break;
+            case ONE_MINUS_SRC_ALPHA: dFactor[i] = 0xf - tex[3]; break;
+            case DST_ALPHA: dFactor[i] = d[3]; break;
+            case ONE_MINUS_DST_ALPHA: dFactor[i] = 0xf - d[3]; break;
+            default: break;
+            }
+        }
+        std::array<uint8_t, 4> frag;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            frag[i] = mac(sFactor[i], tex[i], dFactor[i], d[i]);
+        }
+
+        // Write back
+        const uint16_t colorMask = colorWriteMask(state.confReg1);
+        color = (color & ~colorMask) | (pack(frag) & colorMask);
+        if (state.confReg1.enableDepthTest && state.confReg1.depthMask)
+        {
+            depth = wValue;
+        }
+    }
+
+    static uint16_t colorWriteMask(const ConfReg1& confReg1)
+    {
+        return (confReg1.colorMaskR ? 0xf000 : 0) | (confReg1.colorMaskG ? 0x0f00 : 0)
+            | (confReg1.colorMaskB ? 0x00f0 : 0) | (confReg1.colorMaskA ? 0x000f : 0);
+    }
+
+    /// @brief Returns the index of the first pixel of a line in the buffers
+    /// @param displayLine The display line
+    /// @param y The line in the display line (0 is the bottom)
+    uint32_t lineIndex(const uint32_t displayLine, const uint32_t y) const
+    {
+        // Like the hardware: The display lines and the lines in a display line are upside down
+        return ((((DISPLAY_LINES - 1) - displayLine) * LINE_RESOLUTION) + ((LINE_RESOLUTION - 1) - y)) * m_resolutionW;
+    }
+
+    void renderTile(const uint32_t tile)
+    {
+        const uint32_t displayLine = tile / m_tilesPerLine;
+        const uint16_t lineStart = displayLine * LINE_RESOLUTION;
+        const uint16_t lineEnd = lineStart + LINE_RESOLUTION;
+        const uint16_t tileStart = (tile % m_tilesPerLine) * TILE_WIDTH;
+        const uint16_t tileEnd = std::min<uint16_t>(tileStart + TILE_WIDTH, m_resolutionW);
+
+        Rasterizer::RasterizedTriangle triangle;
+        for (const Command& command : m_commands)
+        {
+            const State& state = m_states[command.state];
+            if (command.op == Command::CLEAR)
+            {
+                clearTile(state, command, displayLine, tileStart, tileEnd);
+            }
+            else
+            {
+                const Rasterizer::RasterizedTriangle& commandTriangle = m_triangles[command.triangle];
+                if ((commandTriangle.bbEndX > tileStart) && (commandTriangle.bbStartX < tileEnd)
+                    && Rasterizer::calcLineIncrement(triangle, commandTriangle, lineStart, lineEnd))
+                {
+                    rasterizeTriangle(state, triangle, displayLine, tileStart, tileEnd);
+                }
+            }
+        }
+    }
+
+    void clearTile(const State& state, const Command& command, const uint32_t displayLine, const uint16_t tileStart, const uint16_t tileEnd)
+    {
+        // The memset of the hardware uses the same masks as the fragments
+        const uint16_t colorMask = command.clearColor ? colorWriteMask(state.confReg1) : 0;
+        const bool clearDepth = command.clearDepth && state.confReg1.depthMask;
+        for (uint32_t y = 0; y < LINE_RESOLUTION; y++)
+        {
+            const uint32_t index = lineIndex(displayLine, y);
+            for (uint32_t x = tileStart; x < tileEnd; x++)
+            {
+                m_colorBuffer[index + x] = (m_colorBuffer[index + x] & ~colorMask) | (state.clearColor & colorMask);
+                if (clearDepth)
+                {
+                    m_depthBuffer[index + x] = state.clearDepth;
+                }
+            }
+        }
+    }
+
+    /// @brief Rasterizes a triangle like the Rasterizer.v, LANES pixels at a time
+    /// @param state The configuration of the fragment pipeline
+    /// @param triangle The triangle, already moved into the display line with Rasterizer::calcLineIncrement()
+    /// @param displayLine The display line
+    /// @param tileStart The first column of the tile
+    /// @param tileEnd The first column after the tile
+    void rasterizeTriangle(const State& state,
+                           const Rasterizer::RasterizedTriangle& triangle,
+                           const uint32_t displayLine,
+                           const uint16_t tileStart,
+                           const uint16_t tileEnd)
+    {
+        const uint32_t xStart = std::max<uint32_t>(triangle.bbStartX, tileStart);
+        const uint32_t xEnd = std::min<uint32_t>(triangle.bbEndX, tileEnd);
+        const uint32_t yEnd = std::min<uint32_t>(triangle.bbEndY, LINE_RESOLUTION);
+
+        // The hardware accumulates the increments. The values are calculated here directly from the position,
+        // the result is the same, because both are calculated modulo 2^32
+        LaneVec laneOffset;
+        for (uint32_t i = 0; i < LANES; i++)
+        {
+            laneOffset[i] = xStart - triangle.bbStartX + i;
+        }
+        const LaneVec w0X = laneOffset * static_cast<uint32_t>(triangle.wXInc[0]);
+        const LaneVec w1X = laneOffset * static_cast<uint32_t>(triangle.wXInc[1]);
+        const LaneVec w2X = laneOffset * static_cast<uint32_t>(triangle.wXInc[2]);
+        const LaneVec sX = laneOffset * static_cast<uint32_t>(triangle.texStXInc[0]);
+        const LaneVec tX = laneOffset * static_cast<uint32_t>(triangle.texStXInc[1]);
+        const LaneVec depthWX = laneOffset * static_cast<uint32_t>(triangle.depthWXInc);
+        const uint32_t w0Step = LANES * static_cast<uint32_t>(triangle.wXInc[0]);
+        const uint32_t w1Step = LANES * static_cast<uint32_t>(triangle.wXInc[1]);
+        const uint32_t w2Step = LANES * static_cast<uint32_t>(triangle.wXInc[2]);
+        const uint32_t sStep = LANES * static_cast<uint32_t>(triangle.texStXInc[0]);
+        const uint32_t tStep = LANES * static_cast<uint32_t>(triangle.texStXInc[1]);
+        const uint32_t depthWStep = LANES * static_cast<uint32_t>(triangle.depthWXInc);
+        const LaneMask zero{};
+
+        for (uint32_t y = triangle.bbStartY; y < yEnd; y++)
+        {
+            const uint32_t dy = y - triangle.bbStartY;
+            LaneVec w0 = w0X + (static_cast<uint32_t>(triangle.wInit[0]) + (dy * static_cast<uint32_t>(triangle.wYInc[0])));
+            LaneVec w1 = w1X + (static_cast<uint32_t>(triangle.wInit[1]) + (dy * static_cast<uint32_t>(triangle.wYInc[1])));
+            LaneVec w2 = w2X + (static_cast<uint32_t>(triangle.wInit[2]) + (dy * static_cast<uint32_t>(triangle.wYInc[2])));
+            LaneVec s = sX + (static_cast<uint32_t>(triangle.texStInit[0]) + (dy * static_cast<uint32_t>(triangle.texStYInc[0])));
+            LaneVec t = tX + (static_cast<uint32_t>(triangle.texStInit[1]) + (dy * static_cast<uint32_t>(triangle.texStYInc[1])));
+            LaneVec depthW = depthWX + (static_cast<uint32_t>(triangle.depthWInit) + (dy * static_cast<uint32_t>(triangle.depthWYInc)));
+
+            const uint32_t index = lineIndex(displayLine, y);
+            for (uint32_t x = xStart; x < xEnd; x += LANES)
+            {
+                // A pixel is in the triangle, when no edge function is negative
+                const LaneMask inTriangle = reinterpret_cast<LaneMask>(w0 | w1 | w2) >= zero;
+                uint32_t mask = 0;
+                for (uint32_t i = 0; i < LANES; i++)
+                {
+                    mask |= (inTriangle[i] & 0x1) << i;
+                }
+                // Remove the lanes after the end of the bounding box
+                if ((xEnd - x) < LANES)
+                {
+                    mask &= (1 << (xEnd - x)) - 1;
+                }
+
+                while (mask)
+                {
+                    const uint32_t i = __builtin_ctz(mask);
+                    mask &= mask - 1;
+                    shadeFragment(state, triangle.triangleStaticColor, s[i], t[i], depthW[i], m_colorBuffer[index + x + i], m_depthBuffer[index + x + i]);
+                }
+
+                w0 += w0Step;
+                w1 += w1Step;
+                w2 += w2Step;
+                s += sStep;
+                t += tStep;
+                depthW += depthWStep;
+            }
+        }
+    }
+
+    uint16_t* m_colorBuffer;
+    uint16_t* m_depthBuffer;
+    const uint16_t m_resolutionW;
+    const uint32_t m_tilesPerLine;
+
+    State m_state;
+    bool m_stateChanged = true;
+    bool m_frameCovered = false; // See setFrameCoveredHint()
+    uint16_t m_boundTexId = 0; // 0 if no texture is bound
+    std::vector<State> m_states;
+    std::vector<Command> m_commands;
+    std::vector<Rasterizer::RasterizedTriangle> m_triangles;
+    std::vector<uint8_t>* m_recordedTriangles = nullptr;
+    Rasterizer::Viewport m_viewport{0, 0, INT16_MAX, INT16_MAX}; // Not clamped until a viewport is set
+
+    std::array<uint16_t, RECIP_LOOKUP_SIZE> m_recipB;
+    std::array<uint16_t, RECIP_LOOKUP_SIZE> m_recipM;
+
+    Statistics<RendererStats> m_statistics;
+    TextureStore<MAX_NUMBER_OF_TEXTURES> m_textureStore;
+    ThreadPool m_threadPool;
+};
+
+#endif // SOFTWARERENDERER_HPP
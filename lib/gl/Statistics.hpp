@@ -0,0 +1,152 @@
+// RasteriCEr
+// https://github.com/ToNi3141/RasteriCEr
+// Copyright (c) 2021 ToNi3141
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef STATISTICS_HPP
+#define STATISTICS_HPP
+
+#include <stdint.h>
+
+// Define ICEGL_STATISTICS to collect the per frame counters of the TnL and the renderers (see IceGL::getFrameStats()).
+// Without ICEGL_STATISTICS, all counting functions are empty and the counters do not use any memory.
+// The times are measured in the ticks of the clock which is set with StatisticsClock::setClock(), for instance
+//     StatisticsClock::setClock([]() -> uint32_t { return DWT->CYCCNT; }); // Cortex-M cycle counter
+//     StatisticsClock::setClock([]() -> uint32_t { return std::chrono::duration_cast<std::chrono::microseconds>(
+//         std::chrono::steady_clock::now().time_since_epoch()).count(); }); // Host
+// Without a clock, all times are zero.
+
+struct TnLStats
+{
+    uint32_t submittedTriangles = 0; // Triangles which were sent to the TnL
+    uint32_t culledTriangles = 0; // Triangles discarded by the face culling
+    uint32_t outsideTriangles = 0; // Triangles which are completely outside of the view volume
+    uint32_t clippedTriangles = 0; // Triangles which are crossing a plane of the view volume and were clipped
+    uint32_t time = 0; // Time in the TnL. Includes RendererStats::rasterizeTime and, if the upload is not threaded, the upload.
+};
+
+struct RendererStats
+{
+    uint32_t rasterizedTriangles = 0; // Triangles which were added to the display list
+    uint32_t invisibleTriangles = 0; // Triangles which were discarded by the rasterizer because they cover no pixel
+    uint32_t displayListBytes = 0; // Used bytes of the display list(s) at the commit
+    uint32_t displayListOverflows = 0; // Commands which were rejected because the display list was full
+    uint32_t elidedClears = 0; // Color buffer clears which were skipped because of IRenderer::setFrameCoveredHint()
+    uint32_t rasterizeTime = 0; // Time in Rasterizer::rasterize()
+    uint32_t commitTime = 0; // Time commit() was blocked, because the previous frames were not uploaded yet
+};
+
+// The upload is pipelined, therefore these counters are from the last frame which was completely uploaded,
+// not from the frame which was just committed (see Renderer::DISPLAY_BUFFERS).
+struct UploadStats
+{
+    uint32_t uploadedTriangles = 0; // Triangles which were sent to the hardware, summed over all display lines
+    uint32_t rejectedTriangles = 0; // Triangles which were skipped in a display line because they are not in the line (only Renderer)
+    uint32_t uploadedBytes = 0; // Bytes of the commands and triangles which were sent to the hardware
+    uint32_t textureBytes = 0; // Bytes of the textures and palettes which were streamed to the hardware
+    uint32_t skippedLines = 0; // Display lines which were not sent to the display because they have not changed (only with RENDERER_DIRTY_WINDOW)
+    uint32_t time = 0; // Time which was required to build the upload lists
+};
+
+struct FrameStats
+{
+    TnLStats tnl;
+    RendererStats renderer;
+    UploadStats upload;
+};
+
+class StatisticsClock
+{
+public:
+    using Clock = uint32_t (*)();
+
+    /// @brief Sets the clock which is used for the time measurements
+    /// @param clock Function which returns the current time in ticks. The ticks can wrap around. nullptr disables the measurements.
+    static void setClock(const Clock clock)
+    {
+        s_clock = clock;
+    }
+
+    /// @brief Returns the current time
+    /// @return The current time in ticks, or zero without a clock
+    static uint32_t now()
+    {
+        return s_clock ? s_clock() : 0;
+    }
+
+private:
+    static inline Clock s_clock = nullptr;
+};
+
+/// @brief Counters of one stage of the pipeline. The counters are collected until commit() is called. Then they
+/// are available with get() until the next commit().
+/// @tparam TStats The struct with the counters
+template <typename TStats>
+class Statistics
+{
+public:
+    using Counter = uint32_t TStats::*;
+
+#ifdef ICEGL_STATISTICS
+    void add(const Counter counter, const uint32_t value = 1)
+    {
+        m_current.*counter += value;
+    }
+
+    void set(const Counter counter, const uint32_t value)
+    {
+        m_current.*counter = value;
+    }
+
+    /// @brief Returns a time stamp for addTime()
+    uint32_t start() const
+    {
+        return StatisticsClock::now();
+    }
+
+    /// @brief Adds the time since start to a counter
+    /// @param counter The counter
+    /// @param start The time stamp from start()
+    void addTime(const Counter counter, const uint32_t start)
+    {
+        m_current.*counter += StatisticsClock::now() - start;
+    }
+
+    /// @brief Makes the collected counters available with get() and starts a new collection
+    void commit()
+    {
+        m_committed = m_current;
+        m_current = {};
+    }
+
+    TStats get() const
+    {
+        return m_committed;
+    }
+
+private:
+    TStats m_current{};
+    TStats m_committed{};
+#else
+    void add(const Counter, const uint32_t = 1) {}
+    void set(const Counter, const uint32_t) {}
+    uint32_t start() const { return 0; }
+    void addTime(const Counter, const uint32_t) {}
+    void commit() {}
+    TStats get() const { return {}; }
+#endif
+};
+
+#endif // STATISTICS_HPP
@@ -0,0 +1,131 @@
+// RasteriCEr
+// https://github.com/ToNi3141/RasteriCEr
+// Copyright (c) 2021 ToNi3141
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef TEXTURERESIDENCY_HPP
+#define TEXTURERESIDENCY_HPP
+
+#include <stdint.h>
+#include <array>
+
+// Keeps track of the textures which are resident in the texture buffer of the RasteriCEr.
+// The texture buffer is divided into pages. A page has the size of the smallest texture (32x32px). A texture occupies
+// one or more pages and is always aligned to its own size (a 64x64px texture can start at page 0, 4, 8 ...).
+// When a new texture does not fit anymore into the buffer, the least recently used textures are evicted.
+// A texture is identified by its id, its generation and its mip level (see TextureStore). When a texture gets new
+// texels, the pages of the old texels are reused first. The other levels of the same generation are still in use.
+// The TEXTURE_PAGES has to match the TEXTURE_BUFFER_SIZE of the RasteriCEr (32kB -> 16 pages).
+template <uint8_t TEXTURE_PAGES = 16>
+class TextureResidency
+{
+public:
+    static constexpr uint32_t PAGE_SIZE = 32 * 32; // In texels
+
+    /// @brief Selects the page for a texture. If the texture is not resident, pages are allocated for the new texture.
+    /// Every call counts as usage of the texture.
+    /// @param texId The id of the texture
+    /// @param generation The generation of the texels of the texture
+    /// @param level The mip level of the texels
+    /// @param texSize The size of the texture in texels
+    /// @return pair with the first value to indicate if the texture is already resident (true) and the second value with the page
+    std::pair<bool, uint8_t> bind(const uint16_t texId, const uint16_t generation, const uint8_t level, const uint32_t texSize)
+    {
+        m_useCounter++;
+        const uint32_t pagesRequired = (texSize + PAGE_SIZE - 1) / PAGE_SIZE;
+
+        // Check if the texture is resident
+        for (uint32_t i = 0; i < TEXTURE_PAGES; i++)
+        {
+            Page& page = m_pages[i];
+            if ((page.pages == pagesRequired) && (page.texId == texId) && (page.generation == generation) && (page.level == level))
+            {
+                page.lastUse = m_useCounter;
+                return {true, i};
+            }
+        }
+
+        if (pagesRequired > TEXTURE_PAGES)
+        {
+            // The texture is bigger than the buffer. It can't be resident.
+            invalidate();
+            return {false, 0};
+        }
+
+        // Search the aligned area with the least recently used textures in it.
+        uint32_t bestPage = 0;
+        uint32_t bestLastUse = UINT32_MAX;
+        for (uint32_t i = 0; i < TEXTURE_PAGES; i += pagesRequired)
+        {
+            uint32_t lastUse = 0;
+            for (uint32_t j = 0; j < TEXTURE_PAGES; j++)
+            {
+                const Page& page = m_pages[j];
+                // Old texels of the same texture are not used anymore
+                const bool used = (page.texId != texId) || (page.generation == generation);
+                if (page.pages && used && (j < (i + pagesRequired)) && ((j + page.pages) > i))
+                {
+                    lastUse = (page.lastUse > lastUse) ? page.lastUse : lastUse;
+                }
+            }
+            if (lastUse < bestLastUse)
+            {
+                bestLastUse = lastUse;
+                bestPage = i;
+            }
+        }
+
+        // Evict all textures which are overlapping with the new one
+        for (uint32_t j = 0; j < TEXTURE_PAGES; j++)
+        {
+            Page& page = m_pages[j];
+            if (page.pages && (j < (bestPage + pagesRequired)) && ((j + page.pages) > bestPage))
+            {
+                page.pages = 0;
+            }
+        }
+
+        m_pages[bestPage].texId = texId;
+        m_pages[bestPage].generation = generation;
+        m_pages[bestPage].level = level;
+        m_pages[bestPage].pages = pagesRequired;
+        m_pages[bestPage].lastUse = m_useCounter;
+        return {false, bestPage};
+    }
+
+    /// @brief Marks all textures as not resident
+    void invalidate()
+    {
+        for (Page& page : m_pages)
+        {
+            page.pages = 0;
+        }
+    }
+
+private:
+    struct Page
+    {
+        uint16_t texId = 0; // The texture which starts at this page
+        uint16_t generation = 0;
+        uint8_t level = 0;
+        uint32_t pages = 0; // Number of pages which are used by the texture. 0 if no texture starts at this page
+        uint32_t lastUse = 0;
+    };
+
+    std::array<Page, TEXTURE_PAGES> m_pages;
+    uint32_t m_useCounter = 0;
+};
+
+#endif // TEXTURERESIDENCY_HPP
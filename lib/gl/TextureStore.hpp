@@ -0,0 +1,281 @@
+// RasteriCEr
+// https://github.com/ToNi3141/RasteriCEr
+// Copyright (c) 2021 ToNi3141
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef TEXTURESTORE_HPP
+#define TEXTURESTORE_HPP
+
+#include <stdint.h>
+#include <array>
+#include <memory>
+#include "IRenderer.hpp"
+#ifdef RENDERER_THREADED
+#include <atomic>
+#endif
+
+// Owns the textures of a renderer. The textures are stored in a fixed pool which is indexed by the texture id.
+// The display lists are not holding references to the textures, they only contain the id, the generation and a plain
+// pointer to the texels. The generation is incremented every time the texels of a texture are replaced or the texture
+// is deleted, so the id and the generation together identify the texels.
+// Texels which are replaced or deleted can still be used by display lists which are not uploaded yet. Therefore they
+// are only released, when the last frame which used them is uploaded (frameCommitted() and frameUploaded() are the
+// fences). With RENDERER_THREADED, frameUploaded() is called from the upload thread, everything else from the
+// thread which uses the renderer.
+// The retired texels are kept in a fixed pool, which can hold all levels of all textures once. When it is full, a
+// texture which is still used by a display list can't be replaced or deleted until the next frame is uploaded.
+// A texture can have a chain of mip levels. Every level has half the size of the previous one, the smallest level
+// is 32x32px (the smallest texture of the texture buffer). The levels are stored with the same layout as level 0.
+template <uint16_t MAX_NUMBER_OF_TEXTURES>
+class TextureStore
+{
+public:
+    static constexpr uint8_t MAX_LEVELS = 3; // 128x128px down to 32x32px (see GL_TEXTURE_SUPPORTED_SIZES)
+    static constexpr uint16_t MIN_LEVEL_SIZE = 32;
+
+    struct Texture
+    {
+        bool inUse = false;
+        std::shared_ptr<const uint16_t> pixels;
+        std::array<std::shared_ptr<const uint16_t>, MAX_LEVELS - 1> mipmaps; // Texels of the levels 1 to MAX_LEVELS - 1
+        uint8_t levels = 1; // Number of consecutive levels which have texels, starting at level 0
+        uint16_t width = 0;
+        uint16_t height = 0;
+        IRenderer::TextureFormat format = IRenderer::RGBA4444;
+        uint16_t generation = 0; // Incremented when the texels are replaced or the texture is deleted
+        uint32_t lastUse = 0; // The last frame which has used the texels
+
+        /// @brief Returns the texels of a level
+        /// @param level The level, must be smaller than levels
+        const uint16_t* getPixels(const uint8_t level) const
+        {
+            return (level == 0) ? pixels.get() : mipmaps[level - 1].get();
+        }
+    };
+
+    /// @brief Allocates a new texture id
+    /// @return pair with the first value to indicate if the operation succeeded (true) and the second value with the id
+    std::pair<bool, uint16_t> create()
+    {
+        for (uint32_t i = 0; i < m_textures.size(); i++)
+        {
+            if (m_textures[i].inUse == false)
+            {
+                m_textures[i].inUse = true;
+                return {true, i};
+            }
+        }
+        return {false, 0};
+    }
+
+    /// @brief Replaces the texels of a texture
+    /// @param texId The id of the texture
+    /// @param pixels The new texels
+    /// @param width The width of the texture
+    /// @param height The height of the texture
+    /// @param format The format of the texels
+    /// @return true if succeeded, false if the texture does not exist or the retired texels can't be stored
+    bool update(const uint16_t texId, std::shared_ptr<const uint16_t> pixels, const uint16_t width, const uint16_t height, const IRenderer::TextureFormat format)
+    {
+        if (texId >= m_textures.size())
+        {
+            return false;
+        }
+        Texture& tex = m_textures[texId];
+        if (!tex.inUse || !retire(tex))
+        {
+            return false;
+        }
+        tex.pixels = pixels;
+        tex.width = width;
+        tex.height = height;
+        tex.format = format;
+        return true;
+    }
+
+    /// @brief Replaces the texels of a mip level of a texture. The texture gets a new generation, like with update().
+    /// @param texId The id of the texture
+    /// @param level The level, between 1 and MAX_LEVELS - 1
+    /// @param pixels The new texels
+    /// @param width The width of the level, must be the width of level 0 >> level
+    /// @param height The height of the level, must be the height of level 0 >> level
+    /// @param format The format of the texels, must be the format of level 0
+    /// @return true if succeeded, false if the texture does not exist, the level does not match level 0 or is smaller
+    /// than MIN_LEVEL_SIZE or the retired texels can't be stored
+    bool updateLevel(const uint16_t texId, const uint8_t level, std::shared_ptr<const uint16_t> pixels, const uint16_t width,
+                     const uint16_t height, const IRenderer::TextureFormat format)
+    {
+        if ((texId >= m_textures.size()) || (level == 0) || (level >= MAX_LEVELS))
+        {
+            return false;
+        }
+        Texture& tex = m_textures[texId];
+        if (!tex.inUse
+                || !tex.pixels
+                || (width != (tex.width >> level))
+                || (height != (tex.height >> level))
+                || (format != tex.format)
+                || (width < MIN_LEVEL_SIZE))
+        {
+            return false;
+        }
+        releaseRetired();
+        if (!hasRetiredSpace(tex.mipmaps[level - 1] ? 1 : 0, tex.lastUse))
+        {
+            return false;
+        }
+        // The old level can still be used by a display list, the new generation makes the pages of it invalid
+        tex.generation++;
+        retirePixels(tex.mipmaps[level - 1], tex.lastUse);
+        tex.mipmaps[level - 1] = pixels;
+        tex.levels = 1;
+        while ((tex.levels < MAX_LEVELS) && tex.mipmaps[tex.levels - 1])
+        {
+            tex.levels++;
+        }
+        return true;
+    }
+
+    /// @brief Returns a texture which is used in the current frame
+    /// @param texId The id of the texture
+    /// @return The texture or nullptr if the texture has no texels
+    const Texture* use(const uint16_t texId)
+    {
+        if (texId >= m_textures.size())
+        {
+            return nullptr;
+        }
+        Texture& tex = m_textures[texId];
+        if (!tex.inUse || !tex.pixels)
+        {
+            return nullptr;
+        }
+        tex.lastUse = m_committedFrames;
+        return &tex;
+    }
+
+    /// @brief Deletes a texture. The id can be allocated again with create().
+    /// @param texId The id of the texture
+    /// @return false if the retired texels can't be stored, the texture is then not deleted
+    bool destroy(const uint16_t texId)
+    {
+        if (texId >= m_textures.size())
+        {
+            return true;
+        }
+        Texture& tex = m_textures[texId];
+        if (!retire(tex))
+        {
+            return false;
+        }
+        tex.inUse = false;
+        return true;
+    }
+
+    /// @brief Signals that a frame was handed over to the upload. All textures which are used from now on, belong to the next frame.
+    void frameCommitted()
+    {
+        m_committedFrames++;
+        releaseRetired();
+    }
+
+    /// @brief Signals that the upload of the oldest committed frame is complete
+    void frameUploaded()
+    {
+        m_uploadedFrames++;
+    }
+
+private:
+    struct Retired
+    {
+        std::shared_ptr<const uint16_t> pixels;
+        uint32_t lastUse;
+    };
+
+    bool retire(Texture& tex)
+    {
+        releaseRetired();
+        uint32_t count = tex.pixels ? 1 : 0;
+        for (const std::shared_ptr<const uint16_t>& mipmap : tex.mipmaps)
+        {
+            count += mipmap ? 1 : 0;
+        }
+        if (!hasRetiredSpace(count, tex.lastUse))
+        {
+            return false;
+        }
+        tex.generation++;
+        retirePixels(tex.pixels, tex.lastUse);
+        for (std::shared_ptr<const uint16_t>& mipmap : tex.mipmaps)
+        {
+            retirePixels(mipmap, tex.lastUse);
+        }
+        tex.levels = 1;
+        // The texture has no texels anymore, the next ones are not used by any frame yet
+        tex.lastUse = m_uploadedFrames - 1;
+        return true;
+    }
+
+    bool hasRetiredSpace(const uint32_t count, const uint32_t lastUse) const
+    {
+        return !isInFlight(lastUse) || ((m_retiredCount + count) <= m_retired.size());
+    }
+
+    void retirePixels(std::shared_ptr<const uint16_t>& pixels, const uint32_t lastUse)
+    {
+        if (pixels && isInFlight(lastUse))
+        {
+            // A display list which is not uploaded yet can still point to the texels. The space is checked with
+            // hasRetiredSpace().
+            m_retired[m_retiredCount++] = {pixels, lastUse};
+        }
+        pixels.reset();
+    }
+
+    void releaseRetired()
+    {
+        for (uint32_t i = 0; i < m_retiredCount;)
+        {
+            if (!isInFlight(m_retired[i].lastUse))
+            {
+                m_retiredCount--;
+                m_retired[i] = std::move(m_retired[m_retiredCount]);
+                m_retired[m_retiredCount].pixels.reset();
+            }
+            else
+            {
+                i++;
+            }
+        }
+    }
+
+    bool isInFlight(const uint32_t frame) const
+    {
+        // Wrap around safe version of frame >= m_uploadedFrames
+        return static_cast<int32_t>(frame - m_uploadedFrames) >= 0;
+    }
+
+    std::array<Texture, MAX_NUMBER_OF_TEXTURES> m_textures;
+    std::array<Retired, MAX_NUMBER_OF_TEXTURES * MAX_LEVELS> m_retired;
+    uint32_t m_retiredCount = 0;
+    uint32_t m_committedFrames = 0;
+#ifdef RENDERER_THREADED
+    std::atomic<uint32_t> m_uploadedFrames{0};
+#else
+    uint32_t m_uploadedFrames = 0;
+#endif
+};
+
+#endif // TEXTURESTORE_HPP
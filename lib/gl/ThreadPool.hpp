@@ -0,0 +1,192 @@
+// RasteriCEr
+// https://github.com/ToNi3141/RasteriCEr
+// Copyright (c) 2021 ToNi3141
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work stealing thread pool for hosts with an operating system (see SoftwareRenderer). run() distributes the tasks
+// in contiguous chunks over the queues of the threads. Every thread executes the tasks of its own queue, and when it
+// is empty, it steals the tasks from the other queues. The thread which calls run() works as the first thread of the pool.
+class ThreadPool
+{
+public:
+    using Task = std::function<void(const uint32_t index)>;
+
+    /// @brief Creates the pool
+    /// @param numberOfThreads The number of threads including the thread which calls run(). 0 uses one thread per core.
+    ThreadPool(uint32_t numberOfThreads = 0)
+    {
+        if (numberOfThreads == 0)
+        {
+            numberOfThreads = std::thread::hardware_concurrency();
+        }
+        m_numberOfThreads = (numberOfThreads > 0) ? numberOfThreads : 1;
+        m_queues = std::make_unique<Queue[]>(m_numberOfThreads);
+        for (uint32_t i = 1; i < m_numberOfThreads; i++)
+        {
+            m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wakeUp.notify_all();
+        for (std::thread& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    /// @brief Executes task(0) to task(numberOfTasks - 1) on the threads of the pool and returns when all tasks are
+    /// executed. The tasks can be executed in any order and in parallel.
+    /// @param numberOfTasks The number of tasks
+    /// @param task The function which executes a task
+    void run(const uint32_t numberOfTasks, const Task& task)
+    {
+        if (numberOfTasks == 0)
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_task = &task;
+            // Set the counter before the tasks are queued, a thread which is still searching for work might already take them
+            m_pendingTasks.store(numberOfTasks);
+            for (uint32_t i = 0; i < m_numberOfThreads; i++)
+            {
+                std::lock_guard<std::mutex> queueLock(m_queues[i].mutex);
+                for (uint32_t t = (i * numberOfTasks) / m_numberOfThreads; t < (((i + 1) * numberOfTasks) / m_numberOfThreads); t++)
+                {
+                    m_queues[i].tasks.push_back(t);
+                }
+            }
+            m_generation++;
+        }
+        m_wakeUp.notify_all();
+
+        work(0);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_pendingTasks.load() == 0; });
+    }
+
+    /// @brief Returns the number of threads including the thread which calls run()
+    uint32_t getNumberOfThreads() const
+    {
+        return m_numberOfThreads;
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<uint32_t> tasks;
+    };
+
+    void workerLoop(const uint32_t thread)
+    {
+        uint32_t generation = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wakeUp.wait(lock, [&]() { return m_stop || (m_generation != generation); });
+                if (m_stop)
+                {
+                    return;
+                }
+                generation = m_generation;
+            }
+            work(thread);
+        }
+    }
+
+    void work(const uint32_t thread)
+    {
+        uint32_t index;
+        while (pop(thread, index))
+        {
+            // m_task was set before the task was queued, the queue mutex makes it visible
+            (*m_task)(index);
+            if (m_pendingTasks.fetch_sub(1) == 1)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_done.notify_all();
+            }
+        }
+    }
+
+    /// @brief Takes the next task. The own queue is used from the back, the queues of others from the front, so that
+    /// a stolen task is far away from the tasks the other thread is currently working on.
+    /// @param thread The thread which searches a task
+    /// @param index The index of the task
+    /// @return false if all queues are empty
+    bool pop(const uint32_t thread, uint32_t& index)
+    {
+        {
+            Queue& queue = m_queues[thread];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty())
+            {
+                index = queue.tasks.back();
+                queue.tasks.pop_back();
+                return true;
+            }
+        }
+        for (uint32_t i = 1; i < m_numberOfThreads; i++)
+        {
+            Queue& queue = m_queues[(thread + i) % m_numberOfThreads];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty())
+            {
+                index = queue.tasks.front();
+                queue.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint32_t m_numberOfThreads = 1;
+    std::unique_ptr<Queue[]> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::condition_variable m_done;
+    uint32_t m_generation = 0;
+    bool m_stop = false;
+    const Task* m_task = nullptr;
+    std::atomic<uint32_t> m_pendingTasks{0};
+};
+
+#endif // THREADPOOL_HPP
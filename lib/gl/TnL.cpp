@@ -20,19 +20,34 @@
 #include "Veci.hpp"
 #include <string.h>
 #include <stdlib.h>
+#ifdef TNL_FIX_POINT
 #include "Rasterizer.hpp"
+#endif
 
 // The Arduino IDE will produce compile errors when using std::min and std::max
 #include <algorithm>    // std::max
+#include <type_traits>
 #define max std::max
 #define min std::min
 
+#ifdef TNL_FIX_POINT
+#ifdef CLIP_UNITCUBE
+#error "CLIP_UNITCUBE is not supported with TNL_FIX_POINT"
+#endif
+static_assert((TNL_FIX_POINT_DECIMALS >= 9) && (TNL_FIX_POINT_DECIMALS <= Rasterizer::TEX_COORD_DECIMALS),
+              "TNL_FIX_POINT_DECIMALS must be between 9 and Rasterizer::TEX_COORD_DECIMALS");
+#endif
 
 TnL::TnL()
 {
     m_t.identity();
     m_m.identity();
     m_n.identity();
+#ifdef TNL_FIX_POINT
+    m_tFix.fromMat<FIX_POINT_DECIMALS>(m_t);
+    m_mFix.fromMat<FIX_POINT_DECIMALS>(m_m);
+    m_nFix.fromMat<FIX_POINT_DECIMALS>(m_n);
+#endif
 
     setEmissiveColorMaterial({{0.0f, 0.0f, 0.0f, 1.0f}});
     setAmbientColorMaterial({{0.2f, 0.2f, 0.2f, 1.0}});
@@ -58,11 +73,56 @@ TnL::TnL()
 
 bool TnL::drawObj(IRenderer &renderer, const TnL::RenderObj &obj)
 {
-    // TODO: It is possible to precompute all transformations and lights here and save it in an temporary array.
-    // That avoids that we have to transform and light every vertex three times.
-    // Then one can call drawTriangle() which then applies the clipping and sends it to the rasterizer.
+    // The matrices, lights and arrays might have changed since the last call
+    invalidateVertexCache();
+#if TNL_VERTEX_BATCH_SIZE > 0
+    m_vertexBatch.count = 0;
+#endif
+
+    if (m_enableCulling && (m_cullMode == CullMode::FRONT_AND_BACK))
+    {
+        // Every triangle is culled, there is nothing to draw
+        if (obj.count >= 3)
+        {
+            const uint32_t triangles = (obj.drawMode == RenderObj::DrawMode::TRIANGLES) ? (obj.count / 3) : (obj.count - 2);
+            m_culledTriangles += triangles;
+            m_statistics.add(&TnLStats::submittedTriangles, triangles);
+            m_statistics.add(&TnLStats::culledTriangles, triangles);
+        }
+        return true;
+    }
 
-    Triangle triangle;
+    const uint32_t start = m_statistics.start();
+    // Resolve the formats of the arrays and the indices once for the whole draw call
+    m_arrays = obj.prepareArrays();
+    // Float indices are not supported, they are drawn like disabled indices (default case)
+    const RenderObj::Type indicesType = obj.indicesEnabled ? obj.indicesType : RenderObj::Type::FLOAT;
+    bool ret;
+    switch (indicesType)
+    {
+    case RenderObj::Type::BYTE:
+        ret = drawTriangles(renderer, obj, static_cast<const uint8_t*>(obj.indicesPointer));
+        break;
+    case RenderObj::Type::SHORT:
+        ret = drawTriangles(renderer, obj, static_cast<const uint16_t*>(obj.indicesPointer));
+        break;
+    case RenderObj::Type::UNSIGNED_INT:
+        ret = drawTriangles(renderer, obj, static_cast<const uint32_t*>(obj.indicesPointer));
+        break;
+    default:
+        ret = drawTriangles(renderer, obj, LinearIndices{});
+        break;
+    }
+    m_statistics.addTime(&TnLStats::time, start);
+    return ret;
+}
+
+template <typename TIndices>
+bool TnL::drawTriangles(IRenderer& renderer, const RenderObj& obj, const TIndices& indices)
+{
+    ClipVertList vertList;
+    ClipStList stList;
+    Vec4i color;
     uint32_t index0 = 0;
     uint32_t index1 = 0;
     uint32_t index2 = 0;
@@ -70,29 +130,29 @@ bool TnL::drawObj(IRenderer &renderer, const TnL::RenderObj &obj)
     {
         switch (obj.drawMode) {
         case RenderObj::DrawMode::TRIANGLES:
-            index0 = obj.getIndex(i);
-            index1 = obj.getIndex(i + 1);
-            index2 = obj.getIndex(i + 2);
+            index0 = indices[i];
+            index1 = indices[i + 1];
+            index2 = indices[i + 2];
             i += 3;
             break;
         case RenderObj::DrawMode::TRIANGLE_FAN:
-            index0 = obj.getIndex(0);
-            index1 = obj.getIndex(i + 1);
-            index2 = obj.getIndex(i + 2);
+            index0 = indices[0];
+            index1 = indices[i + 1];
+            index2 = indices[i + 2];
             i += 1;
             break;
         case RenderObj::DrawMode::TRIANGLE_STRIP:
             if (i & 0x1)
             {
-                index0 = obj.getIndex(i + 1);
-                index1 = obj.getIndex(i);
-                index2 = obj.getIndex(i + 2);
+                index0 = indices[i + 1];
+                index1 = indices[i];
+                index2 = indices[i + 2];
             }
             else
             {
-                index0 = obj.getIndex(i);
-                index1 = obj.getIndex(i + 1);
-                index2 = obj.getIndex(i + 2);
+                index0 = indices[i];
+                index1 = indices[i + 1];
+                index2 = indices[i + 2];
             }
             i += 1;
             break;
@@ -100,50 +160,32 @@ bool TnL::drawObj(IRenderer &renderer, const TnL::RenderObj &obj)
             break;
         }
 
-        if (obj.vertexArrayEnabled)
-        {
-            obj.getVertex(triangle.v0, index0);
-            obj.getVertex(triangle.v1, index1);
-            obj.getVertex(triangle.v2, index2);
-        }
-
-        if (obj.texCoordArrayEnabled)
+#if TNL_VERTEX_BATCH_SIZE > 0
+        // Without indices, the vertices are consumed in ascending order and index2 is always the highest index.
+        // Transform the next vertices in one batch when it leaves the current batch.
+        if constexpr (std::is_same<TIndices, LinearIndices>::value)
         {
-            obj.getTexCoord(triangle.st0, index0);
-            obj.getTexCoord(triangle.st1, index1);
-            obj.getTexCoord(triangle.st2, index2);
-        }
-
-        if (obj.colorArrayEnabled)
-        {
-            Vec4 color0;
-            Vec4 color1;
-            Vec4 color2;
-
-            obj.getColor(color0, index0);
-            obj.getColor(color1, index1);
-            obj.getColor(color2, index2);
-
-            triangle.color0.fromVec<8>(color0.vec);
-            triangle.color1.fromVec<8>(color1.vec);
-            triangle.color2.fromVec<8>(color2.vec);
-        }
-        else
-        {
-            // If no color is defined, use the globally setted color
-            triangle.color0 = obj.vertexColor;
-            triangle.color1 = obj.vertexColor;
-            triangle.color2 = obj.vertexColor;
+            if (index2 >= (m_vertexBatch.first + m_vertexBatch.count))
+            {
+                // The center of a fan (index0) stays in the vertex cache
+                const uint32_t first = (obj.drawMode == RenderObj::DrawMode::TRIANGLE_FAN) ? index1 : min(index0, index1);
+                transformVertexBatch(first, min(static_cast<uint32_t>(VERTEX_BATCH_SIZE), obj.count - first));
+            }
         }
+#endif
 
-        if (obj.normalArrayEnabled)
+        m_statistics.add(&TnLStats::submittedTriangles);
+        fetchAndTransformVertex(vertList[0], stList[0], index0);
+        fetchAndTransformVertex(vertList[1], stList[1], index1);
+        fetchAndTransformVertex(vertList[2], stList[2], index2);
+        if (cullTriangle(vertList[0], vertList[1], vertList[2]))
         {
-            obj.getNormal(triangle.n0, index0);
-            obj.getNormal(triangle.n1, index1);
-            obj.getNormal(triangle.n2, index2);
+            continue;
         }
+        // Flat shading: The color of the last vertex is used for the whole triangle
+        fetchAndCalculateColor(color, obj, index2);
 
-        if (!drawTriangle(renderer, triangle))
+        if (!drawTransformedTriangle(renderer, vertList, stList, color))
         {
             return false;
         }
@@ -153,65 +195,131 @@ bool TnL::drawObj(IRenderer &renderer, const TnL::RenderObj &obj)
 
 bool TnL::drawTriangle(IRenderer &renderer, const Triangle& triangle)
 {
-    Vec4i color = triangle.color2;
-    if (m_enableLighting)
-    {
-        Vec4 v2;
-        Vec3 n2;
+    const uint32_t start = m_statistics.start();
+    m_statistics.add(&TnLStats::submittedTriangles);
+    ClipVertList vertList;
+    ClipStList stList;
 
-        m_n.transform(n2, triangle.n2);
-        n2.normalize(); // In OpenGL this step can be turned on and off with GL_NORMALIZE, also there is GL_RESCALE_NORMAL which offers a faster way
-        // which only works with uniform scales. For now this is constantly enabled because it is usually what someone want.
-        m_m.transform(v2, triangle.v2);
+    stList[0] = toTnLVec(triangle.st0);
+    stList[1] = toTnLVec(triangle.st1);
+    stList[2] = toTnLVec(triangle.st2);
 
-        Vec4 colorLight{m_material.preCalcSceneLight};
-        for (auto& light : m_lights)
-        {
-            calculateLight(colorLight, light, m_material, v2, n2);
-        }
+    transformVertex(vertList[0], stList[0], toTnLVec(triangle.v0));
+    transformVertex(vertList[1], stList[1], toTnLVec(triangle.v1));
+    transformVertex(vertList[2], stList[2], toTnLVec(triangle.v2));
 
+    if (cullTriangle(vertList[0], vertList[1], vertList[2]))
+    {
+        m_statistics.addTime(&TnLStats::time, start);
+        return true;
+    }
 
-        color.fromVec<8>(colorLight.vec);
-        // Clamp colors.
-        static constexpr int32_t MAX_VAL = 255;
-        color = {min(color[0], MAX_VAL),
-                 min(color[1], MAX_VAL),
-                 min(color[2], MAX_VAL),
-                 min(color[3], MAX_VAL)};
+    Vec4i color = triangle.color2;
+    if (m_enableLighting)
+    {
+        calculateColor(color, toTnLVec(triangle.v2), toTnLVec(triangle.n2));
     }
 
-    ClipVertList vertList;
-    ClipStList stList;
-    ClipVertList vertListBuffer;
-    ClipStList stListBuffer;
+    const bool ret = drawTransformedTriangle(renderer, vertList, stList, color);
+    m_statistics.addTime(&TnLStats::time, start);
+    return ret;
+}
 
-    m_t.transform(vertList[0], triangle.v0);
-    m_t.transform(vertList[1], triangle.v1);
-    m_t.transform(vertList[2], triangle.v2);
+bool TnL::cullTriangle(const TnLVec4& v0, const TnLVec4& v1, const TnLVec4& v2)
+{
+    if (!m_enableCulling)
+    {
+        return false;
+    }
 
-    stList[0] = triangle.st0;
-    stList[1] = triangle.st1;
-    stList[2] = triangle.st2;
+    // The determinant of the x, y and w components of the clip space coordinates has the same sign as the area of
+    // the triangle in screen space (when all w are positive). Unlike the area, it also gives the right orientation
+    // for triangles which are crossing the near plane, therefore the triangle can be culled before it is clipped.
+#ifdef TNL_FIX_POINT
+    // The products of three components would overflow even 64 bit. Only the sign is required, so the components
+    // are shifted to 20 bit, which is precise enough for the orientation.
+    const uint32_t maxVal = abs(v0[0]) | abs(v0[1]) | abs(v0[3])
+        | abs(v1[0]) | abs(v1[1]) | abs(v1[3])
+        | abs(v2[0]) | abs(v2[1]) | abs(v2[3]);
+    const uint8_t shift = max(0, 32 - __builtin_clz(maxVal | 1) - 20);
+    const int64_t v0x = v0[0] >> shift;
+    const int64_t v0y = v0[1] >> shift;
+    const int64_t v0w = v0[3] >> shift;
+    const int64_t v1x = v1[0] >> shift;
+    const int64_t v1y = v1[1] >> shift;
+    const int64_t v1w = v1[3] >> shift;
+    const int64_t v2x = v2[0] >> shift;
+    const int64_t v2y = v2[1] >> shift;
+    const int64_t v2w = v2[3] >> shift;
+    const int64_t det = (v0x * ((v1y * v2w) - (v2y * v1w)))
+        - (v1x * ((v0y * v2w) - (v2y * v0w)))
+        + (v2x * ((v0y * v1w) - (v1y * v0w)));
+    const CullMode currentOrientation = (det >= 0) ? CullMode::BACK : CullMode::FRONT;
+#else
+    const float det = (v0[0] * ((v1[1] * v2[3]) - (v2[1] * v1[3])))
+        - (v1[0] * ((v0[1] * v2[3]) - (v2[1] * v0[3])))
+        + (v2[0] * ((v0[1] * v1[3]) - (v1[1] * v0[3])));
+    const CullMode currentOrientation = (det >= 0.0f) ? CullMode::BACK : CullMode::FRONT;
+#endif
+    if (currentOrientation != m_cullMode)
+    {
+        m_culledTriangles++;
+        m_statistics.add(&TnLStats::culledTriangles);
+        return true;
+    }
+    return false;
+}
 
-    calculateTexGenCoords(stList, triangle.v0, triangle.v1, triangle.v2);
+bool TnL::drawTransformedTriangle(IRenderer &renderer, ClipVertList& vertList, ClipStList& stList, const Vec4i& color)
+{
+    clampTexGenCoords(stList);
 
-    // Because if flat shading, the color doesn't have to be interpolated during clipping, so it can be ignored for now...
-    auto [vertListSize, vertListClipped, stListClipped] = clip(vertList, vertListBuffer, stList, stListBuffer);
+    const OutCode oc0 = outCode(vertList[0]);
+    const OutCode oc1 = outCode(vertList[1]);
+    const OutCode oc2 = outCode(vertList[2]);
 
-    // Calculate for every vertex the perspective division and also apply the viewport transformation
-    for (uint8_t i = 0; i < vertListSize; i++)
+    // Check if the triangle is completely outside by checking if all vertices have the same outcode
+    if (oc0 & oc1 & oc2)
     {
-        perspectiveDivide(vertListClipped[i]);
-        viewportTransform(vertListClipped[i]);
+        m_statistics.add(&TnLStats::outsideTriangles);
+        return true;
     }
 
-    // Cull triangle
-    if (m_enableCulling)
+    // Checking if the triangle is completely inside by checking, if no vertex has an outcode. This is the common case
+    // (especially with a guard band), then the triangle is rendered directly without using the clipping buffers.
+    uint32_t vertListSize = 3;
+    ClipVertList* vertListClipped = &vertList;
+    ClipStList* stListClipped = &stList;
+    ClipVertList vertListBuffer;
+    ClipStList stListBuffer;
+    OutCode ocTriangle = oc0;
+    ocTriangle |= oc1;
+    ocTriangle |= oc2;
+    if (ocTriangle != OutCode::NONE)
     {
-        const float edgeVal = Rasterizer::edgeFunctionFloat(vertList[0], vertList[1], vertList[2]);
-        const CullMode currentOrientation = (edgeVal <= 0.0f) ? CullMode::BACK : CullMode::FRONT;
-        if (currentOrientation != m_cullMode)
+        // Because if flat shading, the color doesn't have to be interpolated during clipping, so it can be ignored for now...
+        auto [size, vertListOut, stListOut] = clip(vertList, vertListBuffer, stList, stListBuffer, ocTriangle);
+        if (size == 0)
+        {
+            m_statistics.add(&TnLStats::outsideTriangles);
             return true;
+        }
+        m_statistics.add(&TnLStats::clippedTriangles);
+        vertListSize = size;
+        vertListClipped = &vertListOut;
+        stListClipped = &stListOut;
+    }
+
+    // Calculate for every vertex the perspective division and also apply the viewport transformation
+    for (uint8_t i = 0; i < vertListSize; i++)
+    {
+        perspectiveDivide((*vertListClipped)[i]);
+        viewportTransform((*vertListClipped)[i]);
+#ifdef TNL_FIX_POINT
+        // Convert the texture coordinates into the format of the rasterizer. They can be negative, therefore they
+        // are multiplied, a left shift of a negative value is undefined.
+        (*stListClipped)[i] *= (1 << (Rasterizer::TEX_COORD_DECIMALS - FIX_POINT_DECIMALS));
+#endif
     }
 
     // Render the triangle
@@ -219,12 +327,12 @@ bool TnL::drawTriangle(IRenderer &renderer, const Triangle& triangle)
     {
         // For a triangle we need atleast 3 vertices. Also treat the clipped list from the clipping as a
         // triangle fan where vert zero is always the center of this fan
-        const bool success = renderer.drawTriangle(vertListClipped[0],
-                vertListClipped[i-2],
-                vertListClipped[i-1],
-                stListClipped[0],
-                stListClipped[i-2],
-                stListClipped[i-1],
+        const bool success = renderer.drawTriangle((*vertListClipped)[0],
+                (*vertListClipped)[i-2],
+                (*vertListClipped)[i-1],
+                (*stListClipped)[0],
+                (*stListClipped)[i-2],
+                (*stListClipped)[i-1],
                 color);
         if (!success)
         {
@@ -234,33 +342,299 @@ bool TnL::drawTriangle(IRenderer &renderer, const Triangle& triangle)
     return true;
 }
 
-void TnL::calculateTexGenCoords(TnL::ClipStList &stList, const Vec4& v0, const Vec4& v1, const Vec4& v2) const
+void TnL::fetchAndTransformVertex(TnLVec4& vertex, TnLVec2& st, const uint32_t index)
 {
+#if TNL_VERTEX_BATCH_SIZE > 0
+    if ((index >= m_vertexBatch.first) && (index < (m_vertexBatch.first + m_vertexBatch.count)))
+    {
+        const uint32_t i = index - m_vertexBatch.first;
+        const uint32_t count = m_vertexBatch.count;
+        vertex = Vec4{{m_vertexBatch.vertexTransformed[i],
+                       m_vertexBatch.vertexTransformed[i + count],
+                       m_vertexBatch.vertexTransformed[i + (count * 2)],
+                       m_vertexBatch.vertexTransformed[i + (count * 3)]}};
+        st = m_vertexBatch.st[i];
+        return;
+    }
+#endif
+
+#if TNL_VERTEX_CACHE_SIZE > 0
+    // Direct mapped cache. Strips, fans and most of the indexed meshes are referencing vertices which
+    // are close to each other, therefore this is usually as good as a FIFO or LRU
+    VertexCacheEntry& entry = m_vertexCache[index % VERTEX_CACHE_SIZE];
+    if (entry.valid && (entry.index == index))
+    {
+        vertex = entry.vertex;
+        st = entry.st;
+        return;
+    }
+#endif
+
+    Vec4 v;
+    v.initHomogeneous();
+    m_arrays.vertex.read(v, index);
+
+    Vec2 stObj{{0.0f, 0.0f}};
+    m_arrays.texCoord.read(stObj, index);
+    st = toTnLVec(stObj);
+
+    transformVertex(vertex, st, toTnLVec(v));
+
+#if TNL_VERTEX_CACHE_SIZE > 0
+    entry.index = index;
+    entry.valid = true;
+    entry.colorValid = false;
+    entry.vertex = vertex;
+    entry.st = st;
+#endif
+}
+
+void TnL::fetchAndCalculateColor(Vec4i& color, const RenderObj& obj, const uint32_t index)
+{
+#if TNL_VERTEX_CACHE_SIZE > 0
+    VertexCacheEntry& entry = m_vertexCache[index % VERTEX_CACHE_SIZE];
+    const bool cached = entry.valid && (entry.index == index);
+    if (cached && entry.colorValid)
+    {
+        color = entry.color;
+        return;
+    }
+#endif
+
+#if TNL_VERTEX_BATCH_SIZE > 0
+    const bool batched = (index >= m_vertexBatch.first) && (index < (m_vertexBatch.first + m_vertexBatch.count));
+#else
+    const bool batched = false;
+#endif
+
+    if (m_enableLighting && batched)
+    {
+#if TNL_VERTEX_BATCH_SIZE > 0
+        const uint32_t i = index - m_vertexBatch.first;
+        const uint32_t count = m_vertexBatch.count;
+        const Vec4 vEye{{m_vertexBatch.vertexEye[i],
+                         m_vertexBatch.vertexEye[i + count],
+                         m_vertexBatch.vertexEye[i + (count * 2)],
+                         m_vertexBatch.vertexEye[i + (count * 3)]}};
+        const Vec3 nEye{{m_vertexBatch.normalTransformed[i],
+                         m_vertexBatch.normalTransformed[i + count],
+                         m_vertexBatch.normalTransformed[i + (count * 2)]}};
+        calculateColorEye(color, vEye, nEye);
+#endif
+    }
+    else if (m_enableLighting)
+    {
+        // Lighting requires the vertex in object space and the normal. They are not cached, because they are only
+        // required for the provoking vertex and fetching them again is cheap compared to the light calculation.
+        Vec4 v;
+        v.initHomogeneous();
+        Vec3 n{{0.0f, 0.0f, 1.0f}};
+        m_arrays.vertex.read(v, index);
+        m_arrays.normal.read(n, index);
+        calculateColor(color, toTnLVec(v), toTnLVec(n));
+    }
+    else if (obj.colorArrayEnabled)
+    {
+        Vec4 c;
+        m_arrays.color.read(c, index);
+        color.fromVec<8>(c.vec);
+    }
+    else
+    {
+        // If no color is defined, use the globally setted color
+        color = obj.vertexColor;
+    }
+
+#if TNL_VERTEX_CACHE_SIZE > 0
+    if (cached)
+    {
+        entry.color = color;
+        entry.colorValid = true;
+    }
+#endif
+}
+
+void TnL::invalidateVertexCache()
+{
+#if TNL_VERTEX_CACHE_SIZE > 0
+    for (VertexCacheEntry& entry : m_vertexCache)
+    {
+        entry.valid = false;
+        entry.colorValid = false;
+    }
+#endif
+}
+
+void TnL::transformVertexBatch(const uint32_t first, const uint16_t count)
+{
+#if TNL_VERTEX_BATCH_SIZE > 0
+    VertexBatch& b = m_vertexBatch;
+    b.first = first;
+    b.count = count;
+
+    const bool lighting = m_enableLighting;
+    const bool eye = eyeCoordinatesRequired();
+
+    // Fetch the vertices from the arrays
+    for (uint16_t i = 0; i < count; i++)
+    {
+        Vec4 v;
+        v.initHomogeneous();
+        m_arrays.vertex.read(v, first + i);
+        b.vertex[i] = v[0];
+        b.vertex[i + count] = v[1];
+        b.vertex[i + (count * 2)] = v[2];
+        b.vertex[i + (count * 3)] = v[3];
+
+        b.st[i] = Vec2{{0.0f, 0.0f}};
+        m_arrays.texCoord.read(b.st[i], first + i);
+
+        if (lighting)
+        {
+            Vec3 n{{0.0f, 0.0f, 1.0f}};
+            m_arrays.normal.read(n, first + i);
+            b.normal[i] = n[0];
+            b.normal[i + count] = n[1];
+            b.normal[i + (count * 2)] = n[2];
+        }
+    }
+
+    // Transform the whole batch
+    m_t.transform<4>(b.vertexTransformed.data(), b.vertex.data(), count);
+    if (eye)
+    {
+        m_m.transform<4>(b.vertexEye.data(), b.vertex.data(), count);
+    }
+    if (lighting)
+    {
+        m_n.transform<3>(b.normalTransformed.data(), b.normal.data(), count);
+    }
+
+    // Generate the texture coordinates
     if (m_texGenEnableS || m_texGenEnableT)
     {
-        Vec4 v0Transformed;
-        Vec4 v1Transformed;
-        Vec4 v2Transformed;
+        for (uint16_t i = 0; i < count; i++)
+        {
+            const Vec4 v{{b.vertex[i], b.vertex[i + count], b.vertex[i + (count * 2)], b.vertex[i + (count * 3)]}};
+            Vec4 vEye;
+            if (eye)
+            {
+                vEye = Vec4{{b.vertexEye[i], b.vertexEye[i + count], b.vertexEye[i + (count * 2)], b.vertexEye[i + (count * 3)]}};
+            }
+            calculateTexGenCoords(b.st[i], v, vEye);
+        }
+    }
+#else
+    (void)first;
+    (void)count;
+#endif
+}
+
+bool TnL::eyeCoordinatesRequired() const
+{
+    return m_enableLighting
+            || (m_texGenEnableS && (m_texGenModeS == TexGenMode::EYE_LINEAR))
+            || (m_texGenEnableT && (m_texGenModeT == TexGenMode::EYE_LINEAR));
+}
+
+void TnL::transformVertex(TnLVec4& vertex, TnLVec2& st, const TnLVec4& v) const
+{
+#ifdef TNL_FIX_POINT
+    m_tFix.transform<FIX_POINT_DECIMALS>(vertex, v);
+#else
+    m_t.transform(vertex, v);
+#endif
+    calculateTexGenCoords(st, v);
+}
+
+void TnL::calculateColor(Vec4i& color, const TnLVec4& v, const TnLVec3& n) const
+{
+    TnLVec4 vTransformed;
+    TnLVec3 nTransformed;
+
+#ifdef TNL_FIX_POINT
+    m_nFix.transform<FIX_POINT_DECIMALS>(nTransformed, n);
+    m_mFix.transform<FIX_POINT_DECIMALS>(vTransformed, v);
+#else
+    m_n.transform(nTransformed, n);
+    m_m.transform(vTransformed, v);
+#endif
+    calculateColorEye(color, vTransformed, nTransformed);
+}
+
+void TnL::calculateColorEye(Vec4i& color, const TnLVec4& vEye, TnLVec3 nEye) const
+{
+#ifdef TNL_FIX_POINT
+    nEye.normalize<FIX_POINT_DECIMALS>();
+#else
+    nEye.normalize();
+#endif // In OpenGL this step can be turned on and off with GL_NORMALIZE, also there is GL_RESCALE_NORMAL which offers a faster way
+    // which only works with uniform scales. For now this is constantly enabled because it is usually what someone want.
+
+#ifdef TNL_FIX_POINT
+    Vec4i colorLight{m_material.fix.sceneLight};
+#else
+    Vec4 colorLight{m_material.preCalcSceneLight};
+#endif
+    for (auto& light : m_lights)
+    {
+        calculateLight(colorLight, light, m_material, vEye, nEye);
+    }
+
+#ifdef TNL_FIX_POINT
+    static constexpr uint8_t COLOR_SHIFT = FIX_POINT_DECIMALS - 8;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        color[i] = (colorLight[i] + (1 << (COLOR_SHIFT - 1))) >> COLOR_SHIFT;
+    }
+#else
+    color.fromVec<8>(colorLight.vec);
+#endif
+    // Clamp colors.
+    static constexpr int32_t MAX_VAL = 255;
+    color = {min(color[0], MAX_VAL),
+             min(color[1], MAX_VAL),
+             min(color[2], MAX_VAL),
+             min(color[3], MAX_VAL)};
+}
+
+void TnL::calculateTexGenCoords(TnLVec2& st, const TnLVec4& v) const
+{
+    if (m_texGenEnableS || m_texGenEnableT)
+    {
+        TnLVec4 vTransformed;
         if ((m_texGenModeS == TexGenMode::EYE_LINEAR) || (m_texGenModeT == TexGenMode::EYE_LINEAR))
         {
-            // TODO: We are transforming the vertexes twice, one time for the light and again here for the texture generation.
-            // It would be convenient if we would do this only one.
-            m_m.transform(v0Transformed, v0);
-            m_m.transform(v1Transformed, v1);
-            m_m.transform(v2Transformed, v2);
+#ifdef TNL_FIX_POINT
+            m_mFix.transform<FIX_POINT_DECIMALS>(vTransformed, v);
+#else
+            m_m.transform(vTransformed, v);
+#endif
         }
+        calculateTexGenCoords(st, v, vTransformed);
+    }
+}
+
+void TnL::calculateTexGenCoords(TnLVec2& st, const TnLVec4& v, const TnLVec4& vTransformed) const
+{
+    if (m_texGenEnableS || m_texGenEnableT)
+    {
         if (m_texGenEnableS)
         {
             switch (m_texGenModeS) {
             case TexGenMode::OBJECT_LINEAR:
-                stList[0][0] = m_texGenVecObjS.dot(v0);
-                stList[1][0] = m_texGenVecObjS.dot(v1);
-                stList[2][0] = m_texGenVecObjS.dot(v2);
+#ifdef TNL_FIX_POINT
+                st[0] = m_texGenVecObjS.dot<FIX_POINT_DECIMALS>(v);
+#else
+                st[0] = m_texGenVecObjS.dot(v);
+#endif
                 break;
             case TexGenMode::EYE_LINEAR:
-                stList[0][0] = m_texGenVecEyeS.dot(v0Transformed);
-                stList[1][0] = m_texGenVecEyeS.dot(v1Transformed);
-                stList[2][0] = m_texGenVecEyeS.dot(v2Transformed);
+#ifdef TNL_FIX_POINT
+                st[0] = m_texGenVecEyeS.dot<FIX_POINT_DECIMALS>(vTransformed);
+#else
+                st[0] = m_texGenVecEyeS.dot(vTransformed);
+#endif
                 break;
             case TexGenMode::SPHERE_MAP:
                 // TODO: Implement
@@ -273,14 +647,18 @@ void TnL::calculateTexGenCoords(TnL::ClipStList &stList, const Vec4& v0, const V
         {
             switch (m_texGenModeT) {
             case TexGenMode::OBJECT_LINEAR:
-                stList[0][1] = m_texGenVecObjT.dot(v0);
-                stList[1][1] = m_texGenVecObjT.dot(v1);
-                stList[2][1] = m_texGenVecObjT.dot(v2);
+#ifdef TNL_FIX_POINT
+                st[1] = m_texGenVecObjT.dot<FIX_POINT_DECIMALS>(v);
+#else
+                st[1] = m_texGenVecObjT.dot(v);
+#endif
                 break;
             case TexGenMode::EYE_LINEAR:
-                stList[0][1] = m_texGenVecEyeT.dot(v0Transformed);
-                stList[1][1] = m_texGenVecEyeT.dot(v1Transformed);
-                stList[2][1] = m_texGenVecEyeT.dot(v2Transformed);
+#ifdef TNL_FIX_POINT
+                st[1] = m_texGenVecEyeT.dot<FIX_POINT_DECIMALS>(vTransformed);
+#else
+                st[1] = m_texGenVecEyeT.dot(vTransformed);
+#endif
                 break;
             case TexGenMode::SPHERE_MAP:
                 // TODO: Implement
@@ -289,9 +667,31 @@ void TnL::calculateTexGenCoords(TnL::ClipStList &stList, const Vec4& v0, const V
                 break;
             }
         }
+    }
+}
 
+void TnL::clampTexGenCoords(TnL::ClipStList &stList) const
+{
+    if (m_texGenEnableS || m_texGenEnableT)
+    {
         // Clamp generated texture coordinates so that they are
         // between -1.0 .. 1.0
+#ifdef TNL_FIX_POINT
+        for (uint8_t i = 0; i < 2; i++)
+        {
+            for (uint8_t j = 0; j < 3; j++)
+            {
+                const VecInt val = stList[j][i];
+                if (val > FIX_POINT_ONE || val < -FIX_POINT_ONE)
+                {
+                    const VecInt intPart = (val / FIX_POINT_ONE) * FIX_POINT_ONE;
+                    stList[0][i] -= intPart;
+                    stList[1][i] -= intPart;
+                    stList[2][i] -= intPart;
+                }
+            }
+        }
+#else
         Vec3 stx{{stList[0][0], stList[1][0], stList[2][0]}};
         Vec3 sty{{stList[0][1], stList[1][1], stList[2][1]}};
 
@@ -332,11 +732,93 @@ void TnL::calculateTexGenCoords(TnL::ClipStList &stList, const Vec4& v0, const V
         stList[0][1] = sty[0];
         stList[1][1] = sty[1];
         stList[2][1] = sty[2];
+#endif
     }
 }
 
-void TnL::calculateLight(Vec4 &color, const LightConfig& lightConfig, const MaterialConfig& materialConfig, Vec4 v0, Vec3 n0) const
+void TnL::calculateLight(TnLVec4 &color, const LightConfig& lightConfig, const MaterialConfig& materialConfig, TnLVec4 v0, TnLVec3 n0) const
 {
+#ifdef TNL_FIX_POINT
+    // Same calculation as the floating point version below
+    Vec4i n{{n0[0], n0[1], n0[2], 0}};
+
+    if (lightConfig.enable)
+    {
+        Vec4i dir;
+        VecInt att = FIX_POINT_ONE;
+
+        if (lightConfig.fix.position[3] != 0)
+        {
+            // Point light
+            dir = lightConfig.fix.position;
+            dir -= v0;
+            const int64_t dist = dir.length();
+            dir.normalize<FIX_POINT_DECIMALS>();
+
+            const int64_t attDiv = lightConfig.fix.constantAttenuation
+                + ((lightConfig.fix.linearAttenuation * dist) >> FIX_POINT_DECIMALS)
+                + ((((lightConfig.fix.quadraticAttenuation * dist) >> FIX_POINT_DECIMALS) * dist) >> FIX_POINT_DECIMALS);
+            att = (1ll << (FIX_POINT_DECIMALS * 2)) / max(attDiv, static_cast<int64_t>(1));
+        }
+        else
+        {
+            // Directional light
+            dir = lightConfig.fix.directionalLightDir;
+        }
+        static constexpr VecInt DIFFUSE_THRESHOLD = 0.01f * FIX_POINT_ONE;
+        VecInt dotDirDiffuse = n.dot<FIX_POINT_DECIMALS>(dir);
+        dotDirDiffuse = (dotDirDiffuse < DIFFUSE_THRESHOLD) ? 0 : dotDirDiffuse;
+
+        // Convert now the direction in dir to the half way vector
+        if (lightConfig.localViewer)
+        {
+            Vec4i dirEye{{0, 0, 0, FIX_POINT_ONE}};
+            dirEye -= v0;
+            dirEye.normalize<FIX_POINT_DECIMALS>();
+            dir += dirEye;
+            dir.normalize<FIX_POINT_DECIMALS>();
+        }
+        else
+        {
+            if (lightConfig.fix.position[3] != 0)
+            {
+                const Vec4i pointEye{{0, 0, FIX_POINT_ONE, FIX_POINT_ONE}};
+                dir += pointEye;
+                dir.normalize<FIX_POINT_DECIMALS>();
+            }
+            else
+            {
+                dir = lightConfig.fix.halfWayVectorInfinite;
+            }
+        }
+
+        VecInt dotDirSpecular = n.dot<FIX_POINT_DECIMALS>(dir);
+
+        if (materialConfig.specularExponent == 0.0f) // x^0 == 1.0
+        {
+            dotDirSpecular = FIX_POINT_ONE;
+        }
+        else if (materialConfig.specularExponent != 1.0f) // x^1 == x
+        {
+            dotDirSpecular = materialConfig.specularPow(dotDirSpecular);
+        }
+
+        Vec4i colorLight = lightConfig.fix.diffuseColor;
+        colorLight.mul<FIX_POINT_DECIMALS>(dotDirDiffuse);
+        colorLight += lightConfig.fix.ambientColor;
+        if (dotDirDiffuse != 0)
+        {
+            Vec4i colorLightSpecular = lightConfig.fix.specularColor;
+            colorLightSpecular.mul<FIX_POINT_DECIMALS>(dotDirSpecular);
+            colorLight += colorLightSpecular;
+        }
+
+        colorLight.mul<FIX_POINT_DECIMALS>(att);
+
+        // Add light sums to final color
+        color += colorLight;
+    }
+#else
     Vec4 n{{n0[0], n0[1], n0[2], 0}};
 
     if (lightConfig.enable)
@@ -431,11 +913,18 @@ void TnL::calculateLight(Vec4 &color, const LightConfig& lightConfig, const Mate
         // Add light sums to final color
         color += colorLight;
     }
+#endif
 }
 
-void TnL::lerpVert(Vec4& vOut, const Vec4& v0, const Vec4& v1, const float amt)
+void TnL::lerpVert(TnLVec4& vOut, const TnLVec4& v0, const TnLVec4& v1, const TnLScalar amt)
 {
-#ifdef CLIP_UNITCUBE
+#if defined(TNL_FIX_POINT)
+    const VecInt a1 = FIX_POINT_ONE - amt;
+    vOut[3] = mulFix(v0[3] - v1[3], a1) + v1[3];
+    vOut[2] = mulFix(v0[2] - v1[2], a1) + v1[2];
+    vOut[1] = mulFix(v0[1] - v1[1], a1) + v1[1];
+    vOut[0] = mulFix(v0[0] - v1[0], a1) + v1[0];
+#elif defined(CLIP_UNITCUBE)
     vOut[3] = ((v0[3] - v1[3]) * amt) + v1[3];
     vOut[2] = ((v0[2] - v1[2]) * amt) + v1[2];
     vOut[1] = ((v0[1] - v1[1]) * amt) + v1[1];
@@ -453,9 +942,13 @@ void TnL::lerpVert(Vec4& vOut, const Vec4& v0, const Vec4& v1, const float amt)
 #endif
 }
 
-void TnL::lerpSt(Vec2& vOut, const Vec2& v0, const Vec2& v1, const float amt)
+void TnL::lerpSt(TnLVec2& vOut, const TnLVec2& v0, const TnLVec2& v1, const TnLScalar amt)
 {
-#ifdef CLIP_UNITCUBE
+#if defined(TNL_FIX_POINT)
+    const VecInt a1 = FIX_POINT_ONE - amt;
+    vOut[1] = mulFix(v0[1] - v1[1], a1) + v1[1];
+    vOut[0] = mulFix(v0[0] - v1[0], a1) + v1[0];
+#elif defined(CLIP_UNITCUBE)
     vOut[1] = ((v0[1] - v1[1]) * amt) + v1[1];
     vOut[0] = ((v0[0] - v1[0]) * amt) + v1[0];
 #else
@@ -469,19 +962,30 @@ void TnL::lerpSt(Vec2& vOut, const Vec2& v0, const Vec2& v1, const float amt)
 
 
 
-TnL::OutCode TnL::outCode(const Vec4& v)
+TnL::OutCode TnL::outCode(const TnLVec4& v)
 {
     OutCode c = OutCode::NONE;
-    const float w = v[3];
+    const TnLScalar w = v[3];
 
-    if (v[0] < -w)
+#ifdef TNL_FIX_POINT
+    if (v[0] < mulFix(m_guardBandLeft, w))
+        c |= OutCode::LEFT;
+    if (v[0] > mulFix(m_guardBandRight, w))
+        c |= OutCode::RIGHT;
+    if (v[1] < mulFix(m_guardBandBottom, w))
+        c |= OutCode::BOTTOM;
+    if (v[1] > mulFix(m_guardBandTop, w))
+        c |= OutCode::TOP;
+#else
+    if (v[0] < (m_guardBandLeft * w))
         c |= OutCode::LEFT;
-    if (v[0] > w)
+    if (v[0] > (m_guardBandRight * w))
         c |= OutCode::RIGHT;
-    if (v[1] < -w)
+    if (v[1] < (m_guardBandBottom * w))
         c |= OutCode::BOTTOM;
-    if (v[1] > w)
+    if (v[1] > (m_guardBandTop * w))
         c |= OutCode::TOP;
+#endif
     if (v[2] < -w)
         c |= OutCode::NEAR;
     if (v[2] > w)
@@ -490,7 +994,7 @@ TnL::OutCode TnL::outCode(const Vec4& v)
     return c;
 }
 
-float TnL::lerpAmt(OutCode plane, const Vec4& v0, const Vec4& v1)
+TnL::TnLScalar TnL::lerpAmt(OutCode plane, const TnLVec4& v0, const TnLVec4& v1)
 {
 #ifdef CLIP_UNITCUBE
     // The clipping with a unit cube is easier to imagine, because it uses normal coordinates instead of homogeneous.
@@ -507,26 +1011,63 @@ float TnL::lerpAmt(OutCode plane, const Vec4& v0, const Vec4& v1)
 #else
     // For a better explanation see https://chaosinmotion.com/2016/05/22/3d-clipping-in-homogeneous-coordinates/
     // and https://github.com/w3woody/arduboy/blob/master/Demo3D/pipeline.cpp
+#ifdef TNL_FIX_POINT
+    int64_t zDot0 = 0;
+    int64_t zDot1 = 0;
+
+    switch (plane)
+    {
+    case OutCode::RIGHT:
+        zDot0 = v0[0] - mulFix(m_guardBandRight, v0[3]);
+        zDot1 = v1[0] - mulFix(m_guardBandRight, v1[3]);
+        break;
+    case OutCode::LEFT:
+        zDot0 = v0[0] - mulFix(m_guardBandLeft, v0[3]);
+        zDot1 = v1[0] - mulFix(m_guardBandLeft, v1[3]);
+        break;
+    case OutCode::TOP:
+        zDot0 = v0[1] - mulFix(m_guardBandTop, v0[3]);
+        zDot1 = v1[1] - mulFix(m_guardBandTop, v1[3]);
+        break;
+    case OutCode::BOTTOM:
+        zDot0 = v0[1] - mulFix(m_guardBandBottom, v0[3]);
+        zDot1 = v1[1] - mulFix(m_guardBandBottom, v1[3]);
+        break;
+    case OutCode::NEAR:
+        zDot0 = static_cast<int64_t>(v0[2]) + v0[3];
+        zDot1 = static_cast<int64_t>(v1[2]) + v1[3];
+        break;
+    case OutCode::FAR:
+    default:
+        zDot0 = static_cast<int64_t>(v0[2]) - v0[3];
+        zDot1 = static_cast<int64_t>(v1[2]) - v1[3];
+        break;
+    }
+    const int64_t diff = zDot0 - zDot1;
+    return (diff != 0) ? ((zDot0 * FIX_POINT_ONE) / diff) : 0;
+#else
     float zDot0 = 0.0f;
     float zDot1 = 0.0f;
 
     switch (plane)
     {
-    case OutCode::RIGHT: // v.dot(1,0,0,-1)
-        zDot0 = v0[0] - v0[3];
-        zDot1 = v1[0] - v1[3];
+    // The left, right, top and bottom planes are the planes of the guard band. Without a guard band, they are
+    // the same planes as if the guard band values are set to 1 and -1.
+    case OutCode::RIGHT: // v.dot(1,0,0,-guardBandRight)
+        zDot0 = v0[0] - (m_guardBandRight * v0[3]);
+        zDot1 = v1[0] - (m_guardBandRight * v1[3]);
         break;
-    case OutCode::LEFT: // v.dot(1,0,0,1)
-        zDot0 = v0[0] + v0[3];
-        zDot1 = v1[0] + v1[3];
+    case OutCode::LEFT: // v.dot(1,0,0,-guardBandLeft)
+        zDot0 = v0[0] - (m_guardBandLeft * v0[3]);
+        zDot1 = v1[0] - (m_guardBandLeft * v1[3]);
         break;
-    case OutCode::TOP: // v.dot(0,1,0,-1)
-        zDot0 = v0[1] - v0[3];
-        zDot1 = v1[1] - v1[3];
+    case OutCode::TOP: // v.dot(0,1,0,-guardBandTop)
+        zDot0 = v0[1] - (m_guardBandTop * v0[3]);
+        zDot1 = v1[1] - (m_guardBandTop * v1[3]);
         break;
-    case OutCode::BOTTOM: // v.dot(0,1,0,1)
-        zDot0 = v0[1] + v0[3];
-        zDot1 = v1[1] + v1[3];
+    case OutCode::BOTTOM: // v.dot(0,1,0,-guardBandBottom)
+        zDot0 = v0[1] - (m_guardBandBottom * v0[3]);
+        zDot1 = v1[1] - (m_guardBandBottom * v1[3]);
         break;
     case OutCode::NEAR: // v.dot(0,0,1,1)
         zDot0 = v0[2] + v0[3];
@@ -539,29 +1080,16 @@ float TnL::lerpAmt(OutCode plane, const Vec4& v0, const Vec4& v1)
         break;
     }
     return zDot0 / (zDot0 - zDot1);
+#endif // TNL_FIX_POINT
 #endif
 }
 
 std::tuple<const uint32_t, TnL::ClipVertList&, TnL::ClipStList&> TnL::clip(ClipVertList& vertList,
                                                                            ClipVertList& vertListBuffer,
                                                                            ClipStList& stList,
-                                                                           ClipStList& stListBuffer)
+                                                                           ClipStList& stListBuffer,
+                                                                           const OutCode outCodes)
 {
-    // Check if the triangle is completely outside by checking if all vertices have the same outcode
-    OutCode oc0 = outCode(vertList[0]);
-    OutCode oc1 = outCode(vertList[1]);
-    OutCode oc2 = outCode(vertList[2]);
-    if (oc0 & oc1 & oc2)
-    {
-        return {0u, vertList, stList};
-    }
-
-    // Checking if the triangle is completely inside by checking, if no vertex has an outcode
-    if ((oc0 | oc1 | oc2) == OutCode::NONE)
-    {
-        return {3u, vertList, stList};
-    }
-
     ClipVertList* currentVertListBufferIn = &vertList;
     ClipVertList* currentVertListBufferOut = &vertListBuffer;
     ClipStList* currentStListBufferIn = &stList;
@@ -572,9 +1100,12 @@ std::tuple<const uint32_t, TnL::ClipVertList&, TnL::ClipStList&> TnL::clip(ClipV
 
     for (auto oc : {OutCode::NEAR, OutCode::FAR, OutCode::LEFT, OutCode::RIGHT, OutCode::TOP, OutCode::BOTTOM})
     {
-        // Optimization hint: If no vertex has an outcode given from oc, then it can just be
-        // ignored. We just have to avoid that the swapping of the buffers is executed.
-        // Then we can skip the unneeded copying of data.
+        // If no vertex of the triangle is outside of this plane, then also no clipped vertex can be outside of it.
+        // Skip then the plane to avoid the unneeded copying of data.
+        if (!(outCodes & oc))
+        {
+            continue;
+        }
         numberOfVertsCurrentPlane = clipAgainstPlane(*currentVertListBufferOut,
                                                      *currentStListBufferOut,
                                                      oc,
@@ -623,7 +1154,7 @@ uint32_t TnL::clipAgainstPlane(ClipVertList& vertListOut,
             uint8_t vertMod = (vert - 1) < 0 ? listInSize-1 : vert - 1;
             if (!(outCode(vertListIn[vertMod]) & clipPlane))
             {
-                float lerpw = lerpAmt(clipPlane, vertListIn[vert], vertListIn[vertMod]);
+                const TnLScalar lerpw = lerpAmt(clipPlane, vertListIn[vert], vertListIn[vertMod]);
                 lerpVert(vertListOut[i], vertListIn[vert], vertListIn[vertMod], lerpw);
                 lerpSt(stListOut[i], stListIn[vert], stListIn[vertMod], lerpw);
                 i++;
@@ -632,7 +1163,7 @@ uint32_t TnL::clipAgainstPlane(ClipVertList& vertListOut,
             vertMod = (vert + 1) % listInSize;
             if (!(outCode(vertListIn[vertMod]) & clipPlane))
             {
-                float lerpw = lerpAmt(clipPlane, vertListIn[vert], vertListIn[vertMod]);
+                const TnLScalar lerpw = lerpAmt(clipPlane, vertListIn[vert], vertListIn[vertMod]);
                 lerpVert(vertListOut[i], vertListIn[vert], vertListIn[vertMod], lerpw);
                 lerpSt(stListOut[i], stListIn[vert], stListIn[vertMod], lerpw);
                 i++;
@@ -675,8 +1206,14 @@ void TnL::viewportTransform(Vec4 &v0, Vec4 &v1, Vec4 &v2)
 
 }
 
-void TnL::viewportTransform(Vec4 &v)
+void TnL::viewportTransform(TnLVec4 &v)
 {
+#ifdef TNL_FIX_POINT
+    // Same as below, but the result is directly converted into the screen coordinate format of the rasterizer
+    static constexpr uint8_t SCREEN_SHIFT = FIX_POINT_DECIMALS - Rasterizer::SCREEN_COORD_DECIMALS;
+    v[0] = (mulFix(v[0], m_viewportWidthHalf) + m_viewportXShift + (1 << (SCREEN_SHIFT - 1))) >> SCREEN_SHIFT;
+    v[1] = (mulFix(v[1], m_viewportHeightHalf) + m_viewportYShift + (1 << (SCREEN_SHIFT - 1))) >> SCREEN_SHIFT;
+#else
     // v has the range from -1 to 1. When we multiply it, it has a range from -viewPortWidth/2 to viewPortWidth/2
     // With the addition we shift it from -viewPortWidth/2 to 0 + viewPortX
     v[0] = (((v[0] * m_viewportWidthHalf)) + m_viewportXShift);
@@ -686,15 +1223,26 @@ void TnL::viewportTransform(Vec4 &v)
     // v[1] = (((v[1] + 1.0f) * m_viewportHeight * 0.5f) + m_viewportY);
     // Disabeling z because since we using a w buffer, this computation just wastes cpu cycles
     //v[2] = (1.0f - ((v[2]+1.0f)*0.5f)) * (m_depthRangeZFar - m_depthRangeZNear);
+#endif
 }
 
-void TnL::perspectiveDivide(Vec4 &v)
+void TnL::perspectiveDivide(TnLVec4 &v)
 {
+#ifdef TNL_FIX_POINT
+    // The reciprocal of w is directly calculated in the depth format of the rasterizer
+    static constexpr uint8_t DEPTH_W_DECIMALS = Rasterizer::DEPTH_W_DECIMALS;
+    const int64_t w = (v[3] > 0) ? v[3] : 1;
+    const int64_t wRecip = (1ll << (FIX_POINT_DECIMALS + DEPTH_W_DECIMALS)) / w;
+    v[3] = wRecip;
+    v[0] = (v[0] * wRecip) >> DEPTH_W_DECIMALS;
+    v[1] = (v[1] * wRecip) >> DEPTH_W_DECIMALS;
+#else
     v[3] = 1.0f / v[3];
     v[0] = v[0] * v[3];
     v[1] = v[1] * v[3];
     // Disabeling z because since we using a w buffer, this computation just wastes cpu cycles
     //v[2] = v[2] * v[3];
+#endif
 }
 
 void TnL::setViewport(const int16_t x, const int16_t y, const int16_t width, const int16_t height)
@@ -703,27 +1251,57 @@ void TnL::setViewport(const int16_t x, const int16_t y, const int16_t width, con
     // 0 and height which means a effective screen resolution of height + 1. For instance, we have a resolution of
     // 480 x 272. The view port transformation would go from 0 to 480 which are then 481px. Thats the reason why we
     // decrement here the resolution by one.
-    m_viewportHeight = height - 1;
-    m_viewportWidth = width - 1;
+    const int16_t viewportHeight = height - 1;
+    const int16_t viewportWidth = width - 1;
+    if ((viewportHeight == m_viewportHeight) && (viewportWidth == m_viewportWidth) && (x == m_viewportX) && (y == m_viewportY))
+    {
+        return;
+    }
+    m_stateVersion++;
+    m_viewportHeight = viewportHeight;
+    m_viewportWidth = viewportWidth;
     m_viewportX = x;
     m_viewportY = y;
 
-    m_viewportHeightHalf = m_viewportHeight / 2.0f;
-    m_viewportWidthHalf = m_viewportWidth / 2.0f;
-    m_viewportXShift = m_viewportX + m_viewportWidthHalf;
-    m_viewportYShift = m_viewportY + m_viewportHeightHalf;
-
+    const float viewportHeightHalf = m_viewportHeight / 2.0f;
+    const float viewportWidthHalf = m_viewportWidth / 2.0f;
+    const float viewportXShift = m_viewportX + viewportWidthHalf;
+    const float viewportYShift = m_viewportY + viewportHeightHalf;
+    m_viewportHeightHalf = toTnLScalar(viewportHeightHalf);
+    m_viewportWidthHalf = toTnLScalar(viewportWidthHalf);
+    m_viewportXShift = toTnLScalar(viewportXShift);
+    m_viewportYShift = toTnLScalar(viewportYShift);
+
+    // Calculate the guard band planes in normalized device coordinates. Limit them, so that the viewport
+    // transformation can't produce screen coordinates which the rasterizer is not able to handle.
+    if ((viewportWidthHalf > 0.0f) && (viewportHeightHalf > 0.0f))
+    {
+        m_guardBandLeft = toTnLScalar(max(-GUARD_BAND, (-GUARD_BAND_LIMIT - viewportXShift) / viewportWidthHalf));
+        m_guardBandRight = toTnLScalar(min(GUARD_BAND, (GUARD_BAND_LIMIT - viewportXShift) / viewportWidthHalf));
+        m_guardBandBottom = toTnLScalar(max(-GUARD_BAND, (-GUARD_BAND_LIMIT - viewportYShift) / viewportHeightHalf));
+        m_guardBandTop = toTnLScalar(min(GUARD_BAND, (GUARD_BAND_LIMIT - viewportYShift) / viewportHeightHalf));
+    }
+    else
+    {
+        m_guardBandLeft = toTnLScalar(-1.0f);
+        m_guardBandRight = toTnLScalar(1.0f);
+        m_guardBandBottom = toTnLScalar(-1.0f);
+        m_guardBandTop = toTnLScalar(1.0f);
+    }
 }
 
 void TnL::setDepthRange(const float zNear, const float zFar)
 {
-    m_depthRangeZFar = zFar;
-    m_depthRangeZNear = zNear;
+    updateState(m_depthRangeZFar, zFar);
+    updateState(m_depthRangeZNear, zNear);
 }
 
 void TnL::setModelProjectionMatrix(const Mat44 &m)
 {
     m_t = m;
+#ifdef TNL_FIX_POINT
+    m_tFix.fromMat<FIX_POINT_DECIMALS>(m);
+#endif
 }
 
 
@@ -735,153 +1313,215 @@ TnL::OutCode operator|=(TnL::OutCode& lhs, TnL::OutCode rhs)
 void TnL::setModelMatrix(const Mat44 &m)
 {
     m_m = m;
+#ifdef TNL_FIX_POINT
+    m_mFix.fromMat<FIX_POINT_DECIMALS>(m);
+#endif
 }
 
 void TnL::setNormalMatrix(const Mat44& m)
 {
     m_n = m;
+#ifdef TNL_FIX_POINT
+    m_nFix.fromMat<FIX_POINT_DECIMALS>(m);
+#endif
+}
+
+bool TnL::normalMatrixRequired() const
+{
+    return m_enableLighting
+            || (m_texGenEnableS && (m_texGenModeS == TexGenMode::SPHERE_MAP))
+            || (m_texGenEnableT && (m_texGenModeT == TexGenMode::SPHERE_MAP));
 }
 
 void TnL::enableLighting(bool enable)
 {
-    m_enableLighting = enable;
+    updateState(m_enableLighting, enable);
 }
 
 void TnL::enableLight(const uint8_t light, const bool enable)
 {
-    m_lights[light].enable = enable;
+    updateState(m_lights[light].enable, enable);
 }
 
 void TnL::setAmbientColorLight(const uint8_t light, const Vec4 &color)
 {
-    m_lights[light].ambientColor = color;
-    m_lights[light].preCalcAmbient(m_material.ambientColor);
+    if (updateState(m_lights[light].ambientColor, color))
+    {
+        m_lights[light].preCalcAmbient(m_material.ambientColor);
+    }
 }
 
 void TnL::setDiffuseColorLight(const uint8_t light, const Vec4 &color)
 {
-    m_lights[light].diffuseColor = color;
-    m_lights[light].preCalcDiffuse(m_material.diffuseColor);
+    if (updateState(m_lights[light].diffuseColor, color))
+    {
+        m_lights[light].preCalcDiffuse(m_material.diffuseColor);
+    }
 }
 
 void TnL::setSpecularColorLight(const uint8_t light, const Vec4 &color)
 {
-    m_lights[light].specularColor = color;
-    m_lights[light].preCalcSpecular(m_material.specularColor);
+    if (updateState(m_lights[light].specularColor, color))
+    {
+        m_lights[light].preCalcSpecular(m_material.specularColor);
+    }
 }
 
 void TnL::setPosLight(const uint8_t light, const Vec4 &pos)
 {
-    m_m.transform(m_lights[light].position, pos);
-    m_lights[light].preCalcVectors();
+    Vec4 position;
+    m_m.transform(position, pos);
+    if (updateState(m_lights[light].position, position))
+    {
+        m_lights[light].preCalcVectors();
+    }
 }
 
 void TnL::setConstantAttenuationLight(const uint8_t light, const float val)
 {
-    m_lights[light].constantAttenuation = val;
+    if (updateState(m_lights[light].constantAttenuation, val))
+    {
+        m_lights[light].preCalcFixPoint();
+    }
 }
 
 void TnL::setLinearAttenuationLight(const uint8_t light, const float val)
 {
-    m_lights[light].linearAttenuation = val;
+    if (updateState(m_lights[light].linearAttenuation, val))
+    {
+        m_lights[light].preCalcFixPoint();
+    }
 }
 
 void TnL::setQuadraticAttenuationLight(const uint8_t light, const float val)
 {
-    m_lights[light].quadraticAttenuation = val;
+    if (updateState(m_lights[light].quadraticAttenuation, val))
+    {
+        m_lights[light].preCalcFixPoint();
+    }
 }
 
 void TnL::setEmissiveColorMaterial(const Vec4 &color)
 {
-    m_material.emissiveColor = color;
-    m_material.preCalcColors();
+    if (updateState(m_material.emissiveColor, color))
+    {
+        m_material.preCalcColors();
+    }
 }
 
 void TnL::setAmbientColorMaterial(const Vec4 &color)
 {
-    m_material.ambientColor = color;
-    m_material.preCalcColors();
-    for (auto& light : m_lights)
+    if (updateState(m_material.ambientColor, color))
     {
-        light.preCalcAmbient(color);
+        m_material.preCalcColors();
+        for (auto& light : m_lights)
+        {
+            light.preCalcAmbient(color);
+        }
     }
 }
 
 void TnL::setAmbientColorScene(const Vec4 &color)
 {
-    m_material.ambientColorScene = color;
-    m_material.preCalcColors();
+    if (updateState(m_material.ambientColorScene, color))
+    {
+        m_material.preCalcColors();
+    }
 }
 
 void TnL::setDiffuseColorMaterial(const Vec4 &color)
 {
-    m_material.diffuseColor = color;
-    for (auto& light : m_lights)
+    if (updateState(m_material.diffuseColor, color))
     {
-        light.preCalcDiffuse(color);
+        for (auto& light : m_lights)
+        {
+            light.preCalcDiffuse(color);
+        }
     }
 }
 
 void TnL::setSpecularColorMaterial(const Vec4 &color)
 {
-    m_material.specularColor = color;
-    for (auto& light : m_lights)
+    if (updateState(m_material.specularColor, color))
     {
-        light.preCalcSpecular(color);
+        for (auto& light : m_lights)
+        {
+            light.preCalcSpecular(color);
+        }
     }
 }
 
 void TnL::setSpecularExponentMaterial(const float val)
 {
-    m_material.specularExponent = val;
+    if (updateState(m_material.specularExponent, val))
+    {
+#ifdef TNL_FIX_POINT
+        m_material.preCalcSpecularLut();
+#endif
+    }
 }
 
 void TnL::enableTexGenS(bool enable)
 {
-    m_texGenEnableS = enable;
+    updateState(m_texGenEnableS, enable);
 }
 
 void TnL::enableTexGenT(bool enable)
 {
-    m_texGenEnableT = enable;
+    updateState(m_texGenEnableT, enable);
 }
 
 void TnL::setTexGenModeS(TexGenMode mode)
 {
-    m_texGenModeS = mode;
+    updateState(m_texGenModeS, mode);
 }
 
 void TnL::setTexGenModeT(TexGenMode mode)
 {
-    m_texGenModeT = mode;
+    updateState(m_texGenModeT, mode);
 }
 
 void TnL::setTexGenVecObjS(const Vec4 &val)
 {
-    m_texGenVecObjS = val;
+    updateState(m_texGenVecObjS, TnLVec4{toTnLVec(val)});
 }
 
 void TnL::setTexGenVecObjT(const Vec4 &val)
 {
-    m_texGenVecObjT = val;
+    updateState(m_texGenVecObjT, TnLVec4{toTnLVec(val)});
 }
 
 void TnL::setTexGenVecEyeS(const Vec4 &val)
 {
-    m_texGenVecEyeS = val;
+    updateState(m_texGenVecEyeS, TnLVec4{toTnLVec(val)});
 }
 
 void TnL::setTexGenVecEyeT(const Vec4 &val)
 {
-    m_texGenVecEyeT = val;
+    updateState(m_texGenVecEyeT, TnLVec4{toTnLVec(val)});
 }
 
 void TnL::setCullMode(TnL::CullMode mode)
 {
-    m_cullMode = mode;
+    updateState(m_cullMode, mode);
 }
 
 void TnL::enableCulling(bool enable)
 {
-    m_enableCulling = enable;
+    updateState(m_enableCulling, enable);
+}
+
+uint32_t TnL::getNumberOfCulledTriangles() const
+{
+    return m_culledTriangles;
+}
+
+void TnL::commitStatistics()
+{
+    m_statistics.commit();
+}
+
+TnLStats TnL::getStatistics() const
+{
+    return m_statistics.get();
 }
@@ -19,15 +19,73 @@
 #define TNL_HPP
 
 #include "Vec.hpp"
+#include "Veci.hpp"
 #include "IRenderer.hpp"
+#include "Statistics.hpp"
 #include <tuple>
 #include <array>
 #include "Mat44.hpp"
+#ifdef TNL_FIX_POINT
+#include "Mat44i.hpp"
+#endif
+
+// Define TNL_FIX_POINT to use fixed point arithmetic instead of floats for the transformation, clipping,
+// perspective division, lighting and texture coordinate generation. This is much faster on MCUs without FPU.
+// The vertices are then directly delivered in the fixed point formats of the rasterizer (see IRenderer::Vertex).
+// TNL_FIX_POINT_DECIMALS is the number of fractional bits (Q15.16 by default). All object, eye and clip space
+// coordinates must fit into the integer part.
+#ifndef TNL_FIX_POINT_DECIMALS
+#define TNL_FIX_POINT_DECIMALS 16
+#endif
+
+// Number of entries of the lookup table which replaces the pow() of the specular light in the fixed point TnL.
+// The values between the entries are linearly interpolated.
+#ifndef TNL_SPECULAR_LUT_SIZE
+#define TNL_SPECULAR_LUT_SIZE 64
+#endif
+
+// Number of entries of the post-transform vertex cache. The cache stores the transformed vertices of a
+// drawObj() call, so that vertices which are shared between several triangles are only fetched, transformed
+// and lit once. Every entry requires around 50 bytes. Set it to 0 to disable the cache on MCUs with less memory.
+#ifndef TNL_VERTEX_CACHE_SIZE
+#define TNL_VERTEX_CACHE_SIZE 16
+#endif
+
+// Number of vertices which are transformed at once when drawObj() draws a non indexed array (glDrawArrays).
+// The vertices are transformed with one call into a structure of arrays scratch buffer, which can be vectorized
+// (see Mat44::transform()). Every vertex in this buffer requires 80 bytes. Set it to 0 to disable the batch transformation.
+// The batch transformation is made for FPUs and vector extensions and is not available with TNL_FIX_POINT.
+#ifndef TNL_VERTEX_BATCH_SIZE
+#ifdef TNL_FIX_POINT
+#define TNL_VERTEX_BATCH_SIZE 0
+#else
+#define TNL_VERTEX_BATCH_SIZE 16
+#endif
+#endif
+#if defined(TNL_FIX_POINT) && (TNL_VERTEX_BATCH_SIZE > 0)
+#error "TNL_VERTEX_BATCH_SIZE is not supported with TNL_FIX_POINT"
+#endif
+
+// Size of the guard band in normalized device coordinates. Triangles are only clipped against the left, right, top and
+// bottom planes when they are leaving the guard band, the parts between the viewport and the guard band are discarded
+// by the rasterizer, which clamps the bounding box of the triangle to the viewport. That saves the expensive clipping
+// of most triangles which are crossing the edges of the viewport. Bigger triangles are reducing the precision of the
+// interpolation of the vertex attributes, a value around 2.0 is a good compromise and is the default. 1.0 disables
+// the guard band. Triangles are always clipped against the near and far planes.
+#ifndef TNL_GUARD_BAND
+#define TNL_GUARD_BAND 2.0f
+#endif
 
 class TnL
 {
 public:
     static constexpr uint8_t MAX_LIGHTS = 8;
+    static constexpr float GUARD_BAND = TNL_GUARD_BAND;
+    // Max distance in pixels of a vertex to the origin of the screen. It keeps the edge functions of the
+    // rasterizer (S.2 vertex coordinates) in the range of an int32_t.
+    static constexpr float GUARD_BAND_LIMIT = 2047.0f;
+    static constexpr uint32_t VERTEX_CACHE_SIZE = TNL_VERTEX_CACHE_SIZE;
+    static constexpr uint16_t VERTEX_BATCH_SIZE = TNL_VERTEX_BATCH_SIZE;
 
     enum TexGenMode
     {
@@ -93,92 +151,120 @@ public:
 
         uint32_t arrayOffset;
 
-        template <typename T>
-        bool getFromArray(T& vec, const Type type, const void* arr, const uint32_t stride, uint8_t size, const uint32_t index) const
+        // Reads the elements of an attribute array. The type, size and stride of the array are resolved once per
+        // draw call (see prepareArrays()), so that the fetch of a vertex doesn't have to switch on them.
+        template <uint8_t VecSize>
+        struct ArrayReader
         {
-            if (arr)
+            using Fetch = void (*)(Vec<VecSize>& vec, const uint8_t* element, const uint8_t size);
+            Fetch fetch = nullptr; // nullptr if the array is disabled
+            const uint8_t* arr = nullptr;
+            uint32_t stride = 0; // Distance between two elements in bytes
+            uint8_t size = 0;
+
+            bool read(Vec<VecSize>& vec, const uint32_t index) const
             {
-                const uint32_t indexWithStride = (stride == 0) ? index * size : index * stride;
-                const int8_t* a = reinterpret_cast<const int8_t*>(arr);
-                if (stride == 0) {
-                    switch (type)
-                    {
-                    case Type::BYTE:
-                        vec.fromArray(a + (indexWithStride * 1), size);
-                        break;
-                    case Type::SHORT:
-                        vec.fromArray(reinterpret_cast<const int16_t*>(a + (indexWithStride * 2)), size);
-                        break;
-                    case Type::UNSIGNED_INT:
-                        vec.fromArray(reinterpret_cast<const int32_t*>(a + (indexWithStride * 4)), size);
-                        break;
-                    default:
-                        vec.fromArray(reinterpret_cast<const float*>(a + (indexWithStride * 4)), size);
-                        break;
-                    }
-                }
-                else
+                if (fetch)
                 {
-                    switch (type)
-                    {
-                    case Type::BYTE:
-                        vec.fromArray(a + indexWithStride, size);
-                        break;
-                    case Type::SHORT:
-                        vec.fromArray(reinterpret_cast<const int16_t*>(a + indexWithStride), size);
-                        break;
-                    case Type::UNSIGNED_INT:
-                        vec.fromArray(reinterpret_cast<const int32_t*>(a + indexWithStride), size);
-                        break;
-                    default:
-                        vec.fromArray(reinterpret_cast<const float*>(a + indexWithStride), size);
-                        break;
-                    }
+                    fetch(vec, arr + (index * stride), size);
+                    return true;
                 }
-
-                return true;
+                return false;
             }
-            return false;
-        }
+        };
 
-        bool getVertex(Vec4& vec, const uint32_t index) const
+        struct ArrayReaders
         {
-            vec.initHomogeneous();
-            return getFromArray(vec, vertexType, vertexPointer, vertexStride, vertexSize, index);
-        }
+            ArrayReader<4> vertex;
+            ArrayReader<2> texCoord;
+            ArrayReader<3> normal;
+            ArrayReader<4> color;
+        };
 
-        bool getTexCoord(Vec2& vec, const uint32_t index) const
+        /// @brief Selects the readers for the enabled arrays
+        /// @return The readers. Every reader of a disabled array returns false.
+        ArrayReaders prepareArrays() const
         {
-            return getFromArray(vec, texCoordType, texCoordPointer, texCoordStride, texCoordSize, index);
+            ArrayReaders readers;
+            if (vertexArrayEnabled)
+            {
+                prepareArray(readers.vertex, vertexType, vertexPointer, vertexStride, vertexSize);
+            }
+            if (texCoordArrayEnabled)
+            {
+                prepareArray(readers.texCoord, texCoordType, texCoordPointer, texCoordStride, texCoordSize);
+            }
+            if (normalArrayEnabled)
+            {
+                prepareArray(readers.normal, normalType, normalPointer, normalStride, 3);
+            }
+            if (colorArrayEnabled)
+            {
+                prepareArray(readers.color, colorType, colorPointer, colorStride, colorSize);
+            }
+            return readers;
         }
 
-        bool getColor(Vec4& vec, const uint32_t index) const
+    private:
+        template <uint8_t VecSize>
+        static void prepareArray(ArrayReader<VecSize>& reader, const Type type, const void* arr, const uint32_t stride, const uint8_t size)
         {
-            return getFromArray(vec, colorType, colorPointer, colorStride, colorSize, index);
+            if (!arr)
+            {
+                return;
+            }
+            reader.arr = static_cast<const uint8_t*>(arr);
+            reader.size = size;
+            switch (type)
+            {
+            case Type::BYTE:
+                reader.fetch = &fetchElement<int8_t, VecSize>;
+                reader.stride = (stride == 0) ? (size * sizeof(int8_t)) : stride;
+                break;
+            case Type::SHORT:
+                reader.fetch = &fetchElement<int16_t, VecSize>;
+                reader.stride = (stride == 0) ? (size * sizeof(int16_t)) : stride;
+                break;
+            case Type::UNSIGNED_INT:
+                reader.fetch = &fetchElement<int32_t, VecSize>;
+                reader.stride = (stride == 0) ? (size * sizeof(int32_t)) : stride;
+                break;
+            default:
+                // Floats are the common case, the usual sizes get an unrolled fetch
+                switch (size)
+                {
+                case 2:
+                    reader.fetch = &fetchElementUnrolled<float, 2, VecSize>;
+                    break;
+                case 3:
+                    reader.fetch = &fetchElementUnrolled<float, 3, VecSize>;
+                    break;
+                case 4:
+                    reader.fetch = &fetchElementUnrolled<float, 4, VecSize>;
+                    break;
+                default:
+                    reader.fetch = &fetchElement<float, VecSize>;
+                    break;
+                }
+                reader.stride = (stride == 0) ? (size * sizeof(float)) : stride;
+                break;
+            }
         }
 
-        bool getNormal(Vec3& vec, const uint32_t index) const
+        template <typename T, uint8_t VecSize>
+        static void fetchElement(Vec<VecSize>& vec, const uint8_t* element, const uint8_t size)
         {
-            return getFromArray(vec, normalType, normalPointer, normalStride, 3, index);
+            vec.fromArray(reinterpret_cast<const T*>(element), size);
         }
 
-        uint32_t getIndex(const uint32_t index) const
+        template <typename T, uint8_t Size, uint8_t VecSize>
+        static void fetchElementUnrolled(Vec<VecSize>& vec, const uint8_t* element, const uint8_t)
         {
-            if (indicesEnabled)
+            const T* e = reinterpret_cast<const T*>(element);
+            for (uint8_t i = 0; i < std::min(Size, VecSize); i++)
             {
-                switch (indicesType)
-                {
-                case Type::BYTE:
-                    return static_cast<const uint8_t*>(indicesPointer)[index];
-                case Type::SHORT:
-                    return static_cast<const uint16_t*>(indicesPointer)[index];
-                case Type::UNSIGNED_INT:
-                    return static_cast<const uint32_t*>(indicesPointer)[index];
-                default:
-                    return index;
-                }
+                vec[i] = e[i];
             }
-            return index;
         }
     };
 
@@ -208,6 +294,10 @@ public:
     void setModelMatrix(const Mat44& m);
     void setNormalMatrix(const Mat44& m);
 
+    /// @brief Signals if the normal matrix is used with the current configuration (lighting or sphere map texture generation)
+    /// @return true if the normal matrix has to be set
+    bool normalMatrixRequired() const;
+
     void enableLighting(bool enable);
     void setEmissiveColorMaterial(const Vec4& color);
     void setAmbientColorMaterial(const Vec4& color);
@@ -235,10 +325,42 @@ public:
 
     void enableCulling(bool enable);
     void setCullMode(CullMode mode);
+
+    /// @brief Triangles are culled right after the transformation of their vertices, before they are lit and clipped.
+    /// @return Number of triangles which were culled since the TnL was created
+    uint32_t getNumberOfCulledTriangles() const;
+
+    /// @brief Finishes the collection of the per frame counters (only collected with ICEGL_STATISTICS, see Statistics.hpp)
+    void commitStatistics();
+
+    /// @return The counters of the frame which was finished with the last commitStatistics()
+    TnLStats getStatistics() const;
+
+    /// @brief The version is incremented every time a setter changes the state which is used to transform, light,
+    /// cull and clip the vertices (not the matrices). Setting a value which is already set does not change it.
+    /// @return The version of the TnL state
+    uint32_t getStateVersion() const { return m_stateVersion; }
 private:
+    // Number format of the vertices, normals, texture coordinates and colors within the TnL. The inputs are
+    // converted into this format when they are fetched.
+#ifdef TNL_FIX_POINT
+    static constexpr uint8_t FIX_POINT_DECIMALS = TNL_FIX_POINT_DECIMALS;
+    static constexpr VecInt FIX_POINT_ONE = 1 << FIX_POINT_DECIMALS;
+    static constexpr uint32_t SPECULAR_LUT_SIZE = TNL_SPECULAR_LUT_SIZE;
+    using TnLScalar = VecInt;
+    using TnLVec2 = Vec2i;
+    using TnLVec3 = Vec3i;
+    using TnLVec4 = Vec4i;
+#else
+    using TnLScalar = float;
+    using TnLVec2 = Vec2;
+    using TnLVec3 = Vec3;
+    using TnLVec4 = Vec4;
+#endif
+
     // Each clipping plane can potentally introduce one more vertex, so, we have 3 vertexes, plus 6 possible planes, results in 9 vertexes
-    using ClipVertList = std::array<Vec4, 9>;
-    using ClipStList = std::array<Vec2, 9>;
+    using ClipVertList = std::array<TnLVec4, 9>;
+    using ClipStList = std::array<TnLVec2, 9>;
 
     enum OutCode
     {
@@ -262,13 +384,54 @@ private:
 
         Vec4 preCalcSceneLight;
 
+#ifdef TNL_FIX_POINT
+        // Fixed point values which are used by calculateColorEye() and calculateLight()
+        struct
+        {
+            Vec4i sceneLight;
+            std::array<VecInt, SPECULAR_LUT_SIZE + 1> specularLut; // x^specularExponent for x = 0 .. 1.0
+        } fix;
+#endif
+
         void preCalcColors()
         {
             // Emission color of material
             preCalcSceneLight = emissiveColor;
             // Ambient Color Material and ambient scene color
             preCalcSceneLight += ambientColor * ambientColorScene;
+#ifdef TNL_FIX_POINT
+            fix.sceneLight.fromVec<FIX_POINT_DECIMALS>(preCalcSceneLight.vec);
+#endif
         }
+
+#ifdef TNL_FIX_POINT
+        void preCalcSpecularLut()
+        {
+            for (uint32_t i = 0; i <= SPECULAR_LUT_SIZE; i++)
+            {
+                const float x = static_cast<float>(i) / SPECULAR_LUT_SIZE;
+                fix.specularLut[i] = (powf(x, specularExponent) * FIX_POINT_ONE) + 0.5f;
+            }
+        }
+
+        VecInt specularPow(const VecInt x) const
+        {
+            if (x <= 0)
+            {
+                return fix.specularLut[0];
+            }
+            if (x >= FIX_POINT_ONE)
+            {
+                return fix.specularLut[SPECULAR_LUT_SIZE];
+            }
+            const uint32_t pos = static_cast<uint32_t>(x) * SPECULAR_LUT_SIZE;
+            const uint32_t index = pos >> FIX_POINT_DECIMALS;
+            const int64_t frac = pos & (FIX_POINT_ONE - 1);
+            const VecInt a = fix.specularLut[index];
+            const VecInt b = fix.specularLut[index + 1];
+            return a + (((b - a) * frac) >> FIX_POINT_DECIMALS);
+        }
+#endif
     };
 
     struct LightConfig
@@ -293,22 +456,56 @@ private:
         Vec4 preCalcDirectionalLightDir;
         Vec4 preCalcHalfWayVectorInfinite;
 
+#ifdef TNL_FIX_POINT
+        // Fixed point values which are used by calculateLight()
+        struct
+        {
+            Vec4i position;
+            Vec4i ambientColor;
+            Vec4i diffuseColor;
+            Vec4i specularColor;
+            Vec4i directionalLightDir;
+            Vec4i halfWayVectorInfinite;
+            VecInt constantAttenuation;
+            VecInt linearAttenuation;
+            VecInt quadraticAttenuation;
+        } fix;
+#endif
+
         void preCalcAmbient(const Vec4& colorMat)
         {
             // Static ambient color
             preCalcAmbientColor = ambientColor * colorMat;
+            preCalcFixPoint();
         }
 
         void preCalcDiffuse(const Vec4& colorMat)
         {
             // Static Diffuse Color
             preCalcDiffuseColor = diffuseColor * colorMat;
+            preCalcFixPoint();
         }
 
         void preCalcSpecular(const Vec4& colorMat)
         {
             // Static Specular Color
             preCalcSpecularColor = specularColor * colorMat;
+            preCalcFixPoint();
+        }
+
+        void preCalcFixPoint()
+        {
+#ifdef TNL_FIX_POINT
+            fix.position.fromVec<FIX_POINT_DECIMALS>(position.vec);
+            fix.ambientColor.fromVec<FIX_POINT_DECIMALS>(preCalcAmbientColor.vec);
+            fix.diffuseColor.fromVec<FIX_POINT_DECIMALS>(preCalcDiffuseColor.vec);
+            fix.specularColor.fromVec<FIX_POINT_DECIMALS>(preCalcSpecularColor.vec);
+            fix.directionalLightDir.fromVec<FIX_POINT_DECIMALS>(preCalcDirectionalLightDir.vec);
+            fix.halfWayVectorInfinite.fromVec<FIX_POINT_DECIMALS>(preCalcHalfWayVectorInfinite.vec);
+            fix.constantAttenuation = (constantAttenuation * FIX_POINT_ONE) + 0.5f;
+            fix.linearAttenuation = (linearAttenuation * FIX_POINT_ONE) + 0.5f;
+            fix.quadraticAttenuation = (quadraticAttenuation * FIX_POINT_ONE) + 0.5f;
+#endif
         }
 
         void preCalcVectors()
@@ -321,17 +518,65 @@ private:
             const Vec4 pointEye{{0.0f, 0.0f, 1.0f, 1.0f}};
             preCalcHalfWayVectorInfinite = preCalcDirectionalLightDir + pointEye;
             preCalcHalfWayVectorInfinite.unit();
+            preCalcFixPoint();
         }
     };
 
-    float lerpAmt(OutCode plane, const Vec4 &v0, const Vec4 &v1);
-    void lerpVert(Vec4& vOut, const Vec4& v0, const Vec4& v1, const float amt);
-    void lerpSt(Vec2& vOut, const Vec2& v0, const Vec2& v1, const float amt);
-    OutCode outCode(const Vec4 &v);
+#if TNL_VERTEX_CACHE_SIZE > 0
+    struct VertexCacheEntry
+    {
+        uint32_t index{0};
+        bool valid{false};
+        bool colorValid{false}; // The color is only calculated when the vertex is used as provoking vertex
+        TnLVec4 vertex; // Clip space
+        TnLVec2 st; // Including the generated texture coordinates
+        Vec4i color; // Lit color
+    };
+#endif
+
+#if TNL_VERTEX_BATCH_SIZE > 0
+    // All arrays are structure of arrays with count as stride (x0, x1, .. xcount, y0, y1, ...)
+    struct VertexBatch
+    {
+        uint32_t first{0}; // Index of the first vertex in the batch
+        uint16_t count{0}; // Number of vertices in the batch, 0 if the batch is empty
+        std::array<float, 4 * VERTEX_BATCH_SIZE> vertex; // Object space
+        std::array<float, 4 * VERTEX_BATCH_SIZE> vertexTransformed; // Clip space
+        std::array<float, 4 * VERTEX_BATCH_SIZE> vertexEye; // Eye space; only when lighting or eye linear tex gen is used
+        std::array<float, 3 * VERTEX_BATCH_SIZE> normal; // Object space; only when lighting is used
+        std::array<float, 3 * VERTEX_BATCH_SIZE> normalTransformed; // Eye space; only when lighting is used
+        std::array<Vec2, VERTEX_BATCH_SIZE> st; // Including the generated texture coordinates
+    };
+#endif
+
+    bool drawTransformedTriangle(IRenderer& renderer, ClipVertList& vertList, ClipStList& stList, const Vec4i& color);
+    bool cullTriangle(const TnLVec4& v0, const TnLVec4& v1, const TnLVec4& v2);
+    // Index array of a non indexed draw call
+    struct LinearIndices
+    {
+        uint32_t operator[](const uint32_t index) const { return index; }
+    };
+
+    template <typename TIndices>
+    bool drawTriangles(IRenderer& renderer, const RenderObj& obj, const TIndices& indices);
+    void fetchAndTransformVertex(TnLVec4& vertex, TnLVec2& st, const uint32_t index);
+    void fetchAndCalculateColor(Vec4i& color, const RenderObj& obj, const uint32_t index);
+    void transformVertex(TnLVec4& vertex, TnLVec2& st, const TnLVec4& v) const;
+    void calculateColor(Vec4i& color, const TnLVec4& v, const TnLVec3& n) const;
+    void calculateColorEye(Vec4i& color, const TnLVec4& vEye, TnLVec3 nEye) const;
+    void invalidateVertexCache();
+    void transformVertexBatch(const uint32_t first, const uint16_t count);
+    bool eyeCoordinatesRequired() const;
+
+    TnLScalar lerpAmt(OutCode plane, const TnLVec4 &v0, const TnLVec4 &v1);
+    void lerpVert(TnLVec4& vOut, const TnLVec4& v0, const TnLVec4& v1, const TnLScalar amt);
+    void lerpSt(TnLVec2& vOut, const TnLVec2& v0, const TnLVec2& v1, const TnLScalar amt);
+    OutCode outCode(const TnLVec4 &v);
     std::tuple<const uint32_t, ClipVertList&, ClipStList&> clip(ClipVertList& vertList,
                                                                 ClipVertList& vertListBuffer,
                                                                 ClipStList& stList,
-                                                                ClipStList& stListBuffer);
+                                                                ClipStList& stListBuffer,
+                                                                const OutCode outCodes);
     uint32_t clipAgainstPlane(ClipVertList& vertListOut,
                               ClipStList& stListOut,
                               const OutCode clipPlane,
@@ -340,15 +585,69 @@ private:
                               const uint32_t listInSize);
 
     inline void viewportTransform(Vec4 &v0, Vec4 &v1, Vec4 &v2);
-    inline void viewportTransform(Vec4 &v);
-    inline void perspectiveDivide(Vec4& v);
+    inline void viewportTransform(TnLVec4 &v);
+    inline void perspectiveDivide(TnLVec4& v);
+
+    void calculateLight(TnLVec4 &color, const LightConfig& lightConfig, const MaterialConfig& materialConfig, TnLVec4 v0, TnLVec3 n0) const;
+    void calculateTexGenCoords(TnLVec2& st, const TnLVec4& v) const;
+    void calculateTexGenCoords(TnLVec2& st, const TnLVec4& v, const TnLVec4& vEye) const;
+    void clampTexGenCoords(ClipStList& stList) const;
+
+    // Converts the inputs of the TnL (floats) into the number format of the TnL
+#ifdef TNL_FIX_POINT
+    template <uint8_t VecSize>
+    static Veci<VecInt, VecSize> toTnLVec(const Vec<VecSize>& v)
+    {
+        Veci<VecInt, VecSize> tmp;
+        tmp.template fromVec<FIX_POINT_DECIMALS>(v.vec);
+        return tmp;
+    }
+
+    static TnLScalar toTnLScalar(const float val)
+    {
+        return (val * FIX_POINT_ONE) + ((val < 0.0f) ? -0.5f : 0.5f);
+    }
 
-    void calculateLight(Vec4 &color, const LightConfig& lightConfig, const MaterialConfig& materialConfig, Vec4 v0, Vec3 n0) const;
-    void calculateTexGenCoords(ClipStList& stList, const Vec4& v0, const Vec4& v1, const Vec4& v2) const;
+    static VecInt mulFix(const VecInt a, const VecInt b)
+    {
+        return (static_cast<int64_t>(a) * b) >> FIX_POINT_DECIMALS;
+    }
+#else
+    template <uint8_t VecSize>
+    static const Vec<VecSize>& toTnLVec(const Vec<VecSize>& v)
+    {
+        return v;
+    }
+
+    static TnLScalar toTnLScalar(const float val)
+    {
+        return val;
+    }
+#endif
+
+    /// @brief Sets a value of the TnL state and increments the state version if the value has changed
+    /// @return true if the value has changed
+    template <typename T>
+    bool updateState(T& state, const T& value)
+    {
+        if (state == value)
+        {
+            return false;
+        }
+        state = value;
+        m_stateVersion++;
+        return true;
+    }
 
     Mat44 m_t; // ModelViewProjection
     Mat44 m_m; // ModelView
     Mat44 m_n; // Normal
+#ifdef TNL_FIX_POINT
+    // Fixed point versions of the matrices which are used per vertex
+    Mat44i m_tFix;
+    Mat44i m_mFix;
+    Mat44i m_nFix;
+#endif
 
     float m_depthRangeZNear = 0.0f;
     float m_depthRangeZFar = 1.0f;
@@ -356,10 +655,14 @@ private:
     int16_t m_viewportY = 0;
     int16_t m_viewportHeight = 0;
     int16_t m_viewportWidth = 0;
-    float m_viewportXShift = 0.0f;
-    float m_viewportYShift = 0.0f;
-    float m_viewportHeightHalf = 0.0f;
-    float m_viewportWidthHalf = 0.0f;
+    TnLScalar m_viewportXShift = toTnLScalar(0.0f);
+    TnLScalar m_viewportYShift = toTnLScalar(0.0f);
+    TnLScalar m_viewportHeightHalf = toTnLScalar(0.0f);
+    TnLScalar m_viewportWidthHalf = toTnLScalar(0.0f);
+    TnLScalar m_guardBandLeft = toTnLScalar(-1.0f);
+    TnLScalar m_guardBandRight = toTnLScalar(1.0f);
+    TnLScalar m_guardBandBottom = toTnLScalar(-1.0f);
+    TnLScalar m_guardBandTop = toTnLScalar(1.0f);
 
     std::array<LightConfig, MAX_LIGHTS> m_lights;
     MaterialConfig m_material{};
@@ -369,13 +672,24 @@ private:
     bool m_texGenEnableT{false};
     TexGenMode m_texGenModeS{TexGenMode::EYE_LINEAR};
     TexGenMode m_texGenModeT{TexGenMode::EYE_LINEAR};
-    Vec4 m_texGenVecObjS{{1.0f, 0.0f, 0.0f, 0.0f}};
-    Vec4 m_texGenVecObjT{{0.0f, 1.0f, 0.0f, 0.0f}};
-    Vec4 m_texGenVecEyeS{{1.0f, 0.0f, 0.0f, 0.0f}};
-    Vec4 m_texGenVecEyeT{{0.0f, 1.0f, 0.0f, 0.0f}};
+    TnLVec4 m_texGenVecObjS{toTnLVec(Vec4{{1.0f, 0.0f, 0.0f, 0.0f}})};
+    TnLVec4 m_texGenVecObjT{toTnLVec(Vec4{{0.0f, 1.0f, 0.0f, 0.0f}})};
+    TnLVec4 m_texGenVecEyeS{toTnLVec(Vec4{{1.0f, 0.0f, 0.0f, 0.0f}})};
+    TnLVec4 m_texGenVecEyeT{toTnLVec(Vec4{{0.0f, 1.0f, 0.0f, 0.0f}})};
 
     bool m_enableCulling{false};
     CullMode m_cullMode{CullMode::BACK};
+    uint32_t m_stateVersion{0}; // See getStateVersion()
+    uint32_t m_culledTriangles{0};
+    Statistics<TnLStats> m_statistics;
+
+    RenderObj::ArrayReaders m_arrays; // The arrays of the current drawObj() call
+#if TNL_VERTEX_CACHE_SIZE > 0
+    std::array<VertexCacheEntry, VERTEX_CACHE_SIZE> m_vertexCache;
+#endif
+#if TNL_VERTEX_BATCH_SIZE > 0
+    VertexBatch m_vertexBatch;
+#endif
 
     friend TnL::OutCode operator|=(TnL::OutCode& lhs, TnL::OutCode rhs);
 };
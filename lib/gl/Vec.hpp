@@ -17,6 +17,7 @@
 
 #ifndef VEC_HPP
 #define VEC_HPP
+#include <stdint.h>
 #include <array>
 #include <math.h>
 
@@ -99,6 +100,7 @@ public:
     float& operator[] (int index) { return vec[index]; }
     float operator[] (int index) const { return vec[index]; }
     void operator= (const std::array<float, VecSize>& val) { vec = val; }
+    bool operator== (const Vec<VecSize>& rhs) const { return vec == rhs.vec; }
     void operator= (const float* val)
     {
         for (uint32_t i = 0; i < VecSize; i++)
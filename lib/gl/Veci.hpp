@@ -102,6 +102,7 @@ public:
     T& operator[] (int index) { return vec[index]; }
     T operator[] (int index) const { return vec[index]; }
     void operator= (const std::array<T, VecSize>& val) { vec = val; }
+    bool operator== (const Veci<T, VecSize>& rhs) const { return vec == rhs.vec; }
 
     template <uint8_t shift = 0>
     int64_t dot(const Veci<T, VecSize>& val) const
@@ -112,7 +113,50 @@ public:
         return retVal >> shift;
     }
 
+    /// @brief Calculates the length of the vector
+    /// @return The length with the same number of fractional bits as the vector
+    T length() const
+    {
+        return isqrt(dot(*this));
+    }
+
+    /// @brief Normalizes the vector. Does nothing if the vector has a length of zero.
+    /// @tparam shift Number of fractional bits of the vector
+    template <uint8_t shift>
+    void normalize()
+    {
+        const T len = length();
+        if (len == 0)
+            return;
+        div<shift>(len);
+    }
+
     std::array<T, VecSize> vec;
+
+private:
+    static T isqrt(const int64_t val)
+    {
+        // Bitwise square root, which only requires shifts and additions
+        uint64_t op = (val < 0) ? 0 : val;
+        uint64_t res = 0;
+        uint64_t one = 1ull << 62;
+        while (one > op)
+            one >>= 2;
+        while (one != 0)
+        {
+            if (op >= (res + one))
+            {
+                op -= res + one;
+                res = (res >> 1) + one;
+            }
+            else
+            {
+                res >>= 1;
+            }
+            one >>= 2;
+        }
+        return res;
+    }
 };
 
 using VecInt = int32_t;
@@ -18,7 +18,17 @@
 `timescale 1ns / 1ps
 module DisplayControllerSpi #(
     parameter PIXEL = (128*128),
-    parameter CLOCK_DIV = 2 // Divides clk to slowdown sck. 0 means nohting, 1 means half the clock, 2 only one quarter and so on.
+    parameter CLOCK_DIV = 2, // Divides clk to slowdown sck. 0 means nohting, 1 means half the clock, 2 only one quarter and so on.
+
+    // Updates only the commit window of the frame buffer (see OP_RENDER_CONFIG_COMMIT_WINDOW_* in RegisterAndDescriptorDefines.vh).
+    // The pixels outside of the window are discarded and before the pixels of the window are sent, the controller
+    // sets the address window of the display with the CASET, RASET and RAMWR commands (MIPI DCS, like the ILI9341 or ST7735).
+    // When disabled, the display must be configured with an address window which covers the whole display and the
+    // frame buffer lines are sent in the order of the display.
+    parameter ENABLE_COMMIT_WINDOW = 0,
+    parameter X_RESOLUTION = 128, // Width of the frame buffer. Only required for the commit window
+    parameter COLUMN_OFFSET = 0, // Offset of the first column of the display controller. Only used for the commit window
+    parameter ROW_OFFSET = 0 // Offset of the first row of the display controller. Only used for the commit window
 ) (
     input  wire         resetn,
     input  wire         clk,
@@ -41,6 +51,13 @@ module DisplayControllerSpi #(
     input  wire         s_axis_tlast,
     input  wire [15:0]  s_axis_tdata,
 
+    // Commit window. It must be valid during the AXI stream transfer
+    input  wire [15:0]  windowXStart,
+    input  wire [15:0]  windowXEnd,
+    input  wire [15:0]  windowYStart,
+    input  wire [15:0]  windowYEnd,
+    input  wire [15:0]  windowLineY,
+
     // External enable or disable of the serializer
     output reg          transferRunning
     );
@@ -77,6 +94,14 @@ module DisplayControllerSpi #(
     localparam WAIT_FOR_DATA = 1;
     localparam SERIALIZE_DATA = 2;
 
+    // Display commands to set the address window
+    localparam DISPLAY_CMD_CASET = 8'h2a;
+    localparam DISPLAY_CMD_RASET = 8'h2b;
+    localparam DISPLAY_CMD_RAMWR = 8'h2c;
+    // Number of words (commands and arguments) which are sent before the pixels of a commit window
+    localparam WINDOW_HEADER_SIZE = 7;
+    localparam CACHE_WIDTH = 16;
+
     ///////////////////////////
     // SPI Bypass
     ///////////////////////////
@@ -88,22 +113,43 @@ module DisplayControllerSpi #(
     assign mosi = (display_mux_reg) ? tft_mosi : regMosi;
     assign sck = (display_mux_reg) ? tft_sck : sckDiv;
     assign cs = (display_mux_reg) ? tft_cs : 1'b0;
-    assign dc = (display_mux_reg) ? tft_dc : 1'b1;
+    assign dc = (display_mux_reg) ? tft_dc : regDc;
     assign tft_reset = resetn;
     wire startTransfer = !display_mux_reg;
 
     reg [3:0] stateBufferReq;
     reg [3:0] stateAxis;
 
-    reg [SERIALIZER_WORDWIDH - 1:0] serializerCache; // While the data is scanned out, this buffer is used to fetch new data
-    reg [SERIALIZER_WORDWIDH - 1:0] serializerCacheWorking; // This is the buffer where the data is scanned out
+    // The words in the caches are MSB aligned, the width contains the number of bits to send and dc the data/command signal.
+    reg [CACHE_WIDTH - 1:0] serializerCache; // While the data is scanned out, this buffer is used to fetch new data
+    reg [6:0] serializerCacheWidth;
+    reg serializerCacheDc;
+    reg [CACHE_WIDTH - 1:0] serializerCacheWorking; // This is the buffer where the data is scanned out
+    reg [6:0] serializerCacheWidthWorking;
     reg serializerCacheEmpty; // Signal that data is copied from the fbCache to serializerCacheWorking so that a new memory request can be started
+    reg regDc;
     
     reg [3:0] stateSerializer;
     reg [6:0] serCount;
     reg [$clog2(PIXEL * 2):0] pixelCount;
+    reg [$clog2(PIXEL * 2):0] pixelEnd; // Number of pixels in the buffer
     reg [$clog2(PIXEL * 2):0] streamAddr;
 
+    // Commit window
+    reg [15:0] streamX; // Position of the current pixel of the stream in the frame buffer
+    reg [15:0] streamY;
+    reg [15:0] headerXStart; // Address window of the pixels in the buffer
+    reg [15:0] headerXEnd;
+    reg [15:0] headerYStart;
+    reg [15:0] headerYEnd;
+    reg [ 2:0] headerIndex; // Next word of the header. The header is sent when it is smaller than WINDOW_HEADER_SIZE
+    wire headerSent = headerIndex == WINDOW_HEADER_SIZE;
+    wire inWindow = (ENABLE_COMMIT_WINDOW == 0) 
+        || ((streamX >= windowXStart) && (streamX <= windowXEnd) && (streamY >= windowYStart) && (streamY <= windowYEnd));
+    /* verilator lint_off WIDTH */
+    wire [15:0] windowXEndClamped = (windowXEnd > (X_RESOLUTION - 1)) ? (X_RESOLUTION - 1) : windowXEnd;
+    /* verilator lint_on WIDTH */
+
     reg regSck;
     reg [CLOCK_DIV - 1 : 0] serClockDiv;
     reg enableSck;
@@ -132,7 +178,7 @@ module DisplayControllerSpi #(
     defparam mem.MEM_SIZE_BYTES = $clog2(PIXEL * 2); // Round size to the next bigger number of two size
     defparam mem.MEM_WIDTH = 16;
 
-    wire bufferClean = pixelCount == PIXEL;
+    wire bufferClean = pixelCount == pixelEnd;
 
     if (CLOCK_DIV == 0)
     begin
@@ -153,7 +199,10 @@ module DisplayControllerSpi #(
             stateSerializer <= WAIT_FOR_START;
             stateAxis <= AXIS_WAIT_FOR_START;
             pixelCount <= PIXEL;
+            pixelEnd <= PIXEL;
+            headerIndex <= WINDOW_HEADER_SIZE;
             regMosi <= 0;
+            regDc <= 1;
             enableSck <= 0;
             regSck <= 0;
             s_axis_tready <= 0; 
@@ -177,6 +226,8 @@ module DisplayControllerSpi #(
                     begin
                         s_axis_tready <= 1;
                         streamAddr <= 0; 
+                        streamX <= 0;
+                        streamY <= 0;
                         memWr <= 1;
                         stateAxis <= AXIS_TRANSFER;
                     end
@@ -185,10 +236,38 @@ module DisplayControllerSpi #(
                 begin
                     if (s_axis_tvalid)
                     begin
-                        streamAddr <= streamAddr + 1;
+                        // Only the pixels in the window are written. The other ones are overwritten by the next pixel in the window
+                        if (inWindow)
+                        begin
+                            streamAddr <= streamAddr + 1;
+                        end
+                        /* verilator lint_off WIDTH */
+                        if (streamX == (X_RESOLUTION - 1))
+                        /* verilator lint_on WIDTH */
+                        begin
+                            streamX <= 0;
+                            streamY <= streamY + 1;
+                        end
+                        else
+                        begin
+                            streamX <= streamX + 1;
+                        end
+
                         if (s_axis_tlast)
                         begin
                             pixelCount <= 0; // Reset pixelCount to signal, that the serializer can continue with serializing
+                            if (ENABLE_COMMIT_WINDOW)
+                            begin
+                                // While the serializer sends the pixels, the window can already be changed for the next commit
+                                pixelEnd <= streamAddr + {{$clog2(PIXEL * 2){1'b0}}, inWindow};
+                                headerIndex <= 0;
+                                /* verilator lint_off WIDTH */
+                                headerXStart <= windowXStart + COLUMN_OFFSET;
+                                headerXEnd <= windowXEndClamped + COLUMN_OFFSET;
+                                headerYStart <= windowLineY + windowYStart + ROW_OFFSET;
+                                headerYEnd <= windowLineY + windowYEnd + ROW_OFFSET;
+                                /* verilator lint_on WIDTH */
+                            end
                             memWr <= 0;
                             s_axis_tready <= 0;
                             stateAxis <= AXIS_WAIT_FOR_START;
@@ -201,7 +280,24 @@ module DisplayControllerSpi #(
             case (stateBufferReq)
                 WAIT_FOR_MEM_REQ: // Wait for mem req
                 begin
-                    if (serializerCacheEmpty && !bufferClean)
+                    if (serializerCacheEmpty && !headerSent)
+                    begin
+                        // Set the address window of the display before the pixels are sent
+                        case (headerIndex)
+                        0: serializerCache <= {DISPLAY_CMD_CASET, 8'h0};
+                        1: serializerCache <= headerXStart;
+                        2: serializerCache <= headerXEnd;
+                        3: serializerCache <= {DISPLAY_CMD_RASET, 8'h0};
+                        4: serializerCache <= headerYStart;
+                        5: serializerCache <= headerYEnd;
+                        default: serializerCache <= {DISPLAY_CMD_RAMWR, 8'h0};
+                        endcase
+                        serializerCacheDc <= !((headerIndex == 0) || (headerIndex == 3) || (headerIndex == 6));
+                        serializerCacheWidth <= ((headerIndex == 0) || (headerIndex == 3) || (headerIndex == 6)) ? 7'd8 : 7'd16;
+                        headerIndex <= headerIndex + 1;
+                        serializerCacheEmpty <= 0;
+                    end
+                    else if (serializerCacheEmpty && !bufferClean)
                     begin
                         stateBufferReq <= WAIT_FOR_FIRST_BYTE;
                     end
@@ -215,12 +311,16 @@ module DisplayControllerSpi #(
 `ifdef STREAM_COLORMODE_12BIT
                     serializerCache <= {memOut[COLOR_R_POS +: COLOR_SUB_PIXEL_WIDTH], 
                                         memOut[COLOR_G_POS +: COLOR_SUB_PIXEL_WIDTH], 
-                                        memOut[COLOR_B_POS +: COLOR_SUB_PIXEL_WIDTH]};
+                                        memOut[COLOR_B_POS +: COLOR_SUB_PIXEL_WIDTH], 4'h0};
 `else
                     serializerCache <= {memOut[COLOR_R_POS +: COLOR_SUB_PIXEL_WIDTH], 1'b0, 
                                         memOut[COLOR_G_POS +: COLOR_SUB_PIXEL_WIDTH], 2'b00, 
                                         memOut[COLOR_B_POS +: COLOR_SUB_PIXEL_WIDTH], 1'b0};
 `endif
+                    /* verilator lint_off WIDTH */
+                    serializerCacheWidth <= SERIALIZER_WORDWIDH;
+                    /* verilator lint_on WIDTH */
+                    serializerCacheDc <= 1;
                     pixelCount <= pixelCount + 1;
                     serializerCacheEmpty <= 0;
                     stateBufferReq <= WAIT_FOR_MEM_REQ;
@@ -251,8 +351,10 @@ module DisplayControllerSpi #(
                         begin
                             enableSck <= 1;
                             serializerCacheWorking <= serializerCache;
+                            serializerCacheWidthWorking <= serializerCacheWidth;
                             serCount <= 1; // It is one because it is pushing now also one bit out
-                            regMosi <= serializerCache[SERIALIZER_WORDWIDH - 1];
+                            regMosi <= serializerCache[CACHE_WIDTH - 1];
+                            regDc <= serializerCacheDc;
                             
                             serializerCacheEmpty <= 1; // Start the next request
                             stateSerializer <= SERIALIZE_DATA;
@@ -263,10 +365,10 @@ module DisplayControllerSpi #(
                 begin
                     if (CLOCK_DIV == 0)
                     begin
-                        regMosi <= serializerCacheWorking[(SERIALIZER_WORDWIDH - 1) - serCount];
+                        regMosi <= serializerCacheWorking[(CACHE_WIDTH - 1) - serCount];
                         serCount <= serCount + 1;
 
-                        if (serCount == SERIALIZER_WORDWIDH)
+                        if (serCount == serializerCacheWidthWorking)
                         begin
                             enableSck <= 0;
                             stateSerializer <= WAIT_FOR_DATA;
@@ -277,14 +379,14 @@ module DisplayControllerSpi #(
                         if (serClockDiv == 0)
                         begin
                             regSck <= 0;
-                            regMosi <= serializerCacheWorking[(SERIALIZER_WORDWIDH - 1) - serCount];
+                            regMosi <= serializerCacheWorking[(CACHE_WIDTH - 1) - serCount];
                             serCount <= serCount + 1;
                         end
                         else if (serClockDiv[CLOCK_DIV - 1])
                         begin
                             regSck <= 1;
                             
-                            if (serCount == SERIALIZER_WORDWIDH)
+                            if (serCount == serializerCacheWidthWorking)
                             begin
                                 stateSerializer <= WAIT_FOR_DATA;
                             end
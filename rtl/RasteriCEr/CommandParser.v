@@ -31,6 +31,8 @@ module CommandParser #(
     // Rasterizer
     // Configs
     output reg  [ 3:0]  confTextureMode,
+    output reg  [ 3:0]  confTexturePage,
+    output reg          confTexturePaletted,
     output wire [15:0]  confReg1,
     output wire [15:0]  confReg2,
     output wire [15:0]  confTextureEnvColor,
@@ -40,6 +42,7 @@ module CommandParser #(
     output reg          m_rasterizer_axis_tvalid,
     input  wire         m_rasterizer_axis_tready,
     output reg          m_rasterizer_axis_tlast,
+    output reg          m_rasterizer_axis_tuser, // Signals that the triangle uses the compact triangle descriptor
     output reg  [CMD_STREAM_WIDTH - 1 : 0]  m_rasterizer_axis_tdata,
 
     // Color/Depth buffer control
@@ -53,6 +56,11 @@ module CommandParser #(
     output reg          depthBufferCmdCommit,
     output reg          depthBufferCmdMemset,
     output wire [15:0]  confDepthBufferClearDepth,
+    output wire [15:0]  confCommitWindowXStart,
+    output wire [15:0]  confCommitWindowXEnd,
+    output wire [15:0]  confCommitWindowYStart,
+    output wire [15:0]  confCommitWindowYEnd,
+    output wire [15:0]  confCommitWindowLineY,
 
     // Texture stream interface
     output reg          m_texture_axis_tvalid,
@@ -61,7 +69,12 @@ module CommandParser #(
     output reg  [TEXTURE_STREAM_WIDTH - 1 : 0]  m_texture_axis_tdata,
 
     // Debug
-    output wire [ 3 : 0]  dbgStreamState
+    output wire [ 3 : 0]  dbgStreamState,
+
+    // Performance counter events
+    output wire         perfWaitForHost, // The parser is ready, but the command stream has no data
+    output wire         perfWaitForIdle, // The parser waits until the rasterizer, the fragment pipeline and the frame buffers are idle
+    output wire         perfStreamStall // A triangle or texture stream is stalled by its receiver
 );
 `include "RegisterAndDescriptorDefines.vh"
     localparam DATABUS_SCALE_FACTOR = (CMD_STREAM_WIDTH / 8);
@@ -84,7 +97,7 @@ module CommandParser #(
     localparam FB_CONTROL_WAITFOREND = 1;
 
     // Command Unit Variables
-    reg  [15 : 0]   configReg[0 : 4];
+    reg  [15 : 0]   configReg[0 : OP_RENDER_CONFIG_NUMBER_OF_REGS - 1];
     reg             apply;
     wire            applied;
     reg  [13 : 0]   streamCounter;
@@ -102,9 +115,19 @@ module CommandParser #(
     assign confReg1 = configReg[OP_RENDER_CONFIG_REG1];
     assign confReg2 = configReg[OP_RENDER_CONFIG_REG2];
     assign confTextureEnvColor = configReg[OP_RENDER_CONFIG_TEX_ENV_COLOR];
+    assign confCommitWindowXStart = configReg[OP_RENDER_CONFIG_COMMIT_WINDOW_X_START];
+    assign confCommitWindowXEnd = configReg[OP_RENDER_CONFIG_COMMIT_WINDOW_X_END];
+    assign confCommitWindowYStart = configReg[OP_RENDER_CONFIG_COMMIT_WINDOW_Y_START];
+    assign confCommitWindowYEnd = configReg[OP_RENDER_CONFIG_COMMIT_WINDOW_Y_END];
+    assign confCommitWindowLineY = configReg[OP_RENDER_CONFIG_COMMIT_WINDOW_LINE_Y];
 
     assign dbgStreamState = state[3:0];
 
+    assign perfWaitForHost = s_cmd_axis_tready && !s_cmd_axis_tvalid;
+    assign perfWaitForIdle = (state == WAIT_FOR_IDLE);
+    assign perfStreamStall = ((state == EXEC_TRIANGLE_STREAM) && !m_rasterizer_axis_tready)
+                            || (((state == EXEC_TEXTURE_STREAM) || (state == EXEC_TEXTURE_STREAM_16)) && !m_texture_axis_tready);
+
     always @(posedge aclk)
     begin
         if (!resetn)
@@ -119,9 +142,11 @@ module CommandParser #(
 
             m_texture_axis_tvalid <= 0;
             m_texture_axis_tlast <= 0;
+            confTexturePaletted <= 0;
             
             m_rasterizer_axis_tvalid <= 0;
             m_rasterizer_axis_tlast <= 0;
+            m_rasterizer_axis_tuser <= 0;
         end
         else 
         begin
@@ -147,28 +172,53 @@ module CommandParser #(
                     OP_TRIANGLE_STREAM:
                     begin
                         /* verilator lint_off WIDTH */
-                        streamCounter <= s_cmd_axis_tdata[DATABUS_SCALE_FACTOR_LOG2 +: OP_IMM_SIZE - DATABUS_SCALE_FACTOR_LOG2];
+                        streamCounter <= s_cmd_axis_tdata[DATABUS_SCALE_FACTOR_LOG2 +: OP_TRIANGLE_STREAM_SIZE_SIZE - DATABUS_SCALE_FACTOR_LOG2];
                         /* verilator lint_off WIDTH */
+                        m_rasterizer_axis_tuser <= s_cmd_axis_tdata[OP_TRIANGLE_STREAM_COMPACT_POS];
                         state <= EXEC_TRIANGLE_STREAM;
                     end
-                    OP_TEXTURE_STREAM:
+                    OP_TEXTURE_STREAM,
+                    OP_TEXTURE_STREAM_PALETTED:
                     begin
                         confTextureMode <= s_cmd_axis_tdata[TEXTURE_STREAM_MODE_POS +: TEXTURE_STREAM_IMM_SIZE];
-                        case (s_cmd_axis_tdata[TEXTURE_STREAM_SIZE_POS +: TEXTURE_STREAM_IMM_SIZE])
-                            `OP_TEXTURE_STREAM_MODE_32x32: 
-                                streamCounter <= (32 * 32 * 2) / DATABUS_SCALE_FACTOR;
-                            `OP_TEXTURE_STREAM_MODE_64x64: 
-                                streamCounter <= (64 * 64 * 2) / DATABUS_SCALE_FACTOR;
-                            `OP_TEXTURE_STREAM_MODE_128x128:
-                                streamCounter <= (128 * 128 * 2) / DATABUS_SCALE_FACTOR;
-                            `OP_TEXTURE_STREAM_MODE_256x256:
-                                streamCounter <= (256 * 256 * 2) / DATABUS_SCALE_FACTOR; 
-                            default:
-                            begin
-                            end
-                        endcase
+                        confTexturePage <= s_cmd_axis_tdata[TEXTURE_STREAM_PAGE_POS +: TEXTURE_STREAM_IMM_SIZE];
+                        confTexturePaletted <= (s_cmd_axis_tdata[OP_POS +: OP_SIZE] == OP_TEXTURE_STREAM_PALETTED);
+                        if (s_cmd_axis_tdata[OP_POS +: OP_SIZE] == OP_TEXTURE_STREAM_PALETTED)
+                        begin
+                            // The palette is followed by 4 bit indices
+                            case (s_cmd_axis_tdata[TEXTURE_STREAM_SIZE_POS +: TEXTURE_STREAM_IMM_SIZE])
+                                `OP_TEXTURE_STREAM_MODE_32x32: 
+                                    streamCounter <= ((TEXTURE_PALETTE_SIZE * 2) + ((32 * 32) / 2)) / DATABUS_SCALE_FACTOR;
+                                `OP_TEXTURE_STREAM_MODE_64x64: 
+                                    streamCounter <= ((TEXTURE_PALETTE_SIZE * 2) + ((64 * 64) / 2)) / DATABUS_SCALE_FACTOR;
+                                `OP_TEXTURE_STREAM_MODE_128x128:
+                                    streamCounter <= ((TEXTURE_PALETTE_SIZE * 2) + ((128 * 128) / 2)) / DATABUS_SCALE_FACTOR;
+                                `OP_TEXTURE_STREAM_MODE_256x256:
+                                    streamCounter <= ((TEXTURE_PALETTE_SIZE * 2) + ((256 * 256) / 2)) / DATABUS_SCALE_FACTOR;
+                                default:
+                                    streamCounter <= (TEXTURE_PALETTE_SIZE * 2) / DATABUS_SCALE_FACTOR;
+                            endcase
+                        end
+                        else
+                        begin
+                            case (s_cmd_axis_tdata[TEXTURE_STREAM_SIZE_POS +: TEXTURE_STREAM_IMM_SIZE])
+                                `OP_TEXTURE_STREAM_MODE_32x32: 
+                                    streamCounter <= (32 * 32 * 2) / DATABUS_SCALE_FACTOR;
+                                `OP_TEXTURE_STREAM_MODE_64x64: 
+                                    streamCounter <= (64 * 64 * 2) / DATABUS_SCALE_FACTOR;
+                                `OP_TEXTURE_STREAM_MODE_128x128:
+                                    streamCounter <= (128 * 128 * 2) / DATABUS_SCALE_FACTOR;
+                                `OP_TEXTURE_STREAM_MODE_256x256:
+                                    streamCounter <= (256 * 256 * 2) / DATABUS_SCALE_FACTOR; 
+                                default:
+                                begin
+                                end
+                            endcase
+                        end
 
-                        if (|s_cmd_axis_tdata[TEXTURE_STREAM_SIZE_POS +: TEXTURE_STREAM_IMM_SIZE])
+                        // A paletted texture always streams at least the palette
+                        if ((|s_cmd_axis_tdata[TEXTURE_STREAM_SIZE_POS +: TEXTURE_STREAM_IMM_SIZE])
+                            || (s_cmd_axis_tdata[OP_POS +: OP_SIZE] == OP_TEXTURE_STREAM_PALETTED))
                         begin
                             if (TEXTURE_STREAM_WIDTH == 16)
                             begin
@@ -288,7 +338,7 @@ module CommandParser #(
             begin
                 if (s_cmd_axis_tvalid)
                 begin
-                    configReg[streamCounter[0 +: 3]] <= s_cmd_axis_tdata[0 +: 16];
+                    configReg[streamCounter[0 +: 4]] <= s_cmd_axis_tdata[0 +: 16];
                     s_cmd_axis_tready <= 0;
                     state <= WAIT_FOR_IDLE;
                 end
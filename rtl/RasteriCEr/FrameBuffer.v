@@ -15,10 +15,17 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
+// Fast clear (ENABLE_FAST_CLEAR): Every beat of the memory has a tag which marks if the beat contains the pixels
+// or if it is cleared. A memset only resets the tags, which are packed into words of 64 tags, therefore it
+// takes only FRAME_SIZE / (64 * PIXEL_PER_BEAT) clock cycles. The cleared beats are resolved lazily: A read of a cleared
+// beat returns the clear color, and the first write into a cleared beat writes the clear color into the other pixels of
+// the beat. The fast clear is only used when the memset writes all sub pixels (fragMask is set), otherwise the
+// memset writes the memory. It requires FRAME_SIZE / PIXEL_PER_BEAT bits of distributed memory.
 module FrameBuffer
 #(
     parameter FRAME_SIZE = 128 * 128, // 128px * 128px. Used for abort the memset and commit phase when all pixels are transferred without processing the padding pixel
     parameter STREAM_WIDTH = 16,
+    parameter ENABLE_FAST_CLEAR = 0,
     localparam SIZE = $clog2(FRAME_SIZE * 2), // The size of the frame buffer as bytes in power of two
     localparam ADDR_WIDTH = SIZE - 1 // Convert SIZE from 8 bit bytes to 16 bit pixels
 )
@@ -66,6 +73,11 @@ module FrameBuffer
     localparam TILECONTROL_MEMCPY = 1;
     localparam TILECONTROL_MEMSET = 2;
     localparam TILECONTROL_MEMCPY_INIT = 3;
+    localparam TILECONTROL_FAST_MEMSET = 4;
+    localparam TAG_WIDTH_LOG2 = 6;
+    localparam TAG_WIDTH = 1 << TAG_WIDTH_LOG2;
+    localparam TAG_ADDR_WIDTH = MEM_ADDR_WIDTH - TAG_WIDTH_LOG2;
+    localparam FRAMEBUFFER_FRAME_SIZE_IN_TAG_WORDS = (FRAMEBUFFER_FRAME_SIZE_IN_BEATS + TAG_WIDTH - 1) / TAG_WIDTH;
 
     // Tile Control
     reg [5:0] stateTileControl;
@@ -76,6 +88,14 @@ module FrameBuffer
     wire [MEM_ADDR_WIDTH - 1 : 0]   fragAddrRead;
     wire [STREAM_WIDTH - 1 : 0]     fragValOut;
     reg  [ADDR_WIDTH - 1 : 0]       fragAddrReadDelay;
+
+    // Fast clear
+    reg  [15:0]                     fastClearColor;
+    wire [STREAM_WIDTH - 1 : 0]     fastClearBeat = {PIXEL_PER_BEAT{fastClearColor}};
+    wire                            fastClear = ENABLE_FAST_CLEAR && (fragMask == 4'hf);
+    wire                            readBeatValid; // Tag of the beat which was read in the last clock cycle
+    wire                            writeBeatValid; // Tag of the beat which is written
+    wire [STREAM_WIDTH - 1 : 0]     fbDataOut = (readBeatValid) ? fragValOut : fastClearBeat;
     
     reg                             commandRunning;
     reg  [MEM_ADDR_WIDTH - 1 : 0]   counter;
@@ -86,11 +106,57 @@ module FrameBuffer
     reg                             fbWr;
     wire [MEM_ADDR_WIDTH - 1 : 0]   fbAddrBusWrite  = (commandRunning) ? commitAddr : fragAddrWrite;
     wire [MEM_ADDR_WIDTH - 1 : 0]   fbAddrBusRead   = (commandRunning) ? memsetWriteAddr : fragAddrRead;
-    wire [STREAM_WIDTH - 1 : 0]     fbDataInBus     = (commandRunning) ? {PIXEL_PER_BEAT{clearColor}} : fragValIn;
+    wire [STREAM_WIDTH - 1 : 0]     fbDataInLanes   = (commandRunning) ? {PIXEL_PER_BEAT{clearColor}} : fragValIn;
     wire                            fbWrBus         = (commandRunning) ? fbWr : fragWriteEnable;
-    wire [STROBES_PER_BEAT - 1 : 0] fbWrMaskBus     = (commandRunning) ? {PIXEL_PER_BEAT{fragMask}} : writeStrobe;
+    wire [STROBES_PER_BEAT - 1 : 0] fbWrMaskLanes   = (commandRunning) ? {PIXEL_PER_BEAT{fragMask}} : writeStrobe;
+    // A write into a cleared beat writes the whole beat. The sub pixels which are not written are filled with the clear color.
+    wire [STREAM_WIDTH - 1 : 0]     fbDataInBus;
+    wire [STROBES_PER_BEAT - 1 : 0] fbWrMaskBus     = (writeBeatValid) ? fbWrMaskLanes : {STROBES_PER_BEAT{1'b1}};
 
     genvar i;
+    generate
+        for (i = 0; i < STROBES_PER_BEAT; i = i + 1)
+        begin
+            assign fbDataInBus[i * SUB_PIXEL_WIDTH +: SUB_PIXEL_WIDTH] = (writeBeatValid || fbWrMaskLanes[i]) 
+                ? fbDataInLanes[i * SUB_PIXEL_WIDTH +: SUB_PIXEL_WIDTH] 
+                : fastClearBeat[i * SUB_PIXEL_WIDTH +: SUB_PIXEL_WIDTH];
+        end
+    endgenerate
+
+    generate
+        if (ENABLE_FAST_CLEAR)
+        begin
+            reg  [TAG_WIDTH - 1 : 0]      tags [0 : (1 << TAG_ADDR_WIDTH) - 1];
+            reg                           readTag;
+            wire [TAG_ADDR_WIDTH - 1 : 0] tagAddrWrite = fbAddrBusWrite[TAG_WIDTH_LOG2 +: TAG_ADDR_WIDTH];
+            wire [TAG_WIDTH - 1 : 0]      tagWordWrite = tags[tagAddrWrite];
+            wire [TAG_WIDTH - 1 : 0]      tagWordRead = tags[fbAddrBusRead[TAG_WIDTH_LOG2 +: TAG_ADDR_WIDTH]];
+
+            assign writeBeatValid = tagWordWrite[fbAddrBusWrite[0 +: TAG_WIDTH_LOG2]];
+            assign readBeatValid = readTag;
+
+            always @(posedge clk)
+            begin
+                // Same latency as the memory
+                readTag <= tagWordRead[fbAddrBusRead[0 +: TAG_WIDTH_LOG2]];
+
+                if (stateTileControl == TILECONTROL_FAST_MEMSET)
+                begin
+                    tags[counter[0 +: TAG_ADDR_WIDTH]] <= 0;
+                end
+                else if (fbWrBus)
+                begin
+                    tags[tagAddrWrite] <= tagWordWrite | ({{(TAG_WIDTH - 1){1'b0}}, 1'b1} << fbAddrBusWrite[0 +: TAG_WIDTH_LOG2]);
+                end
+            end
+        end
+        else
+        begin
+            assign writeBeatValid = 1;
+            assign readBeatValid = 1;
+        end
+    endgenerate
+
     generate
         if (PIXEL_PER_BEAT == 1)
         begin
@@ -98,7 +164,7 @@ module FrameBuffer
             assign fragValIn = fragIn;
             assign writeStrobe = fragMask;
             assign fragAddrRead = fragIndexRead;
-            assign fragOut = fragValOut;
+            assign fragOut = fbDataOut;
         end
         else
         begin
@@ -113,10 +179,10 @@ module FrameBuffer
             assign fragValIn = {PIXEL_PER_BEAT{fragIn}};
             assign fragAddrRead = fragIndexRead[PIXEL_PER_BEAT_LOG2 +: MEM_ADDR_WIDTH];
 
-            assign fragOut = fragValOut[fragAddrReadDelay[0 +: PIXEL_PER_BEAT_LOG2] * PIXEL_WIDTH +: PIXEL_WIDTH];
+            assign fragOut = fbDataOut[fragAddrReadDelay[0 +: PIXEL_PER_BEAT_LOG2] * PIXEL_WIDTH +: PIXEL_WIDTH];
         end
     endgenerate
-    assign m_axis_tdata = fragValOut;
+    assign m_axis_tdata = fbDataOut;
 
     `RAM_MODULE ramTile (
         .clk(clk),
@@ -160,8 +226,16 @@ module FrameBuffer
                     commandRunning <= 1;
                     if (cmdMemset) 
                     begin
-                        fbWr <= 1;
-                        stateTileControl <= TILECONTROL_MEMSET;
+                        if (fastClear)
+                        begin
+                            fbWr <= 0;
+                            stateTileControl <= TILECONTROL_FAST_MEMSET;
+                        end
+                        else
+                        begin
+                            fbWr <= 1;
+                            stateTileControl <= TILECONTROL_MEMSET;
+                        end
                     end
 
                     // Commits have priority over a clear.
@@ -204,8 +278,15 @@ module FrameBuffer
                         if (cmdMemset) 
                         begin
                             counter <= 0;
-                            fbWr <= 1;
-                            stateTileControl <= TILECONTROL_MEMSET;
+                            if (fastClear)
+                            begin
+                                stateTileControl <= TILECONTROL_FAST_MEMSET;
+                            end
+                            else
+                            begin
+                                fbWr <= 1;
+                                stateTileControl <= TILECONTROL_MEMSET;
+                            end
                         end
                         else
                         begin
@@ -223,6 +304,17 @@ module FrameBuffer
                 end
                 counter <= counterNext;
             end
+            TILECONTROL_FAST_MEMSET:
+            begin
+                // The tags are reset in the always block of the tags. The clear color is latched here and not at
+                // the start of the command, because a commit before the memset still requires the old clear color.
+                fastClearColor <= clearColor;
+                if (counterNext == FRAMEBUFFER_FRAME_SIZE_IN_TAG_WORDS[0 +: MEM_ADDR_WIDTH])
+                begin
+                    stateTileControl <= TILECONTROL_WAIT_FOR_COMMAND;
+                end
+                counter <= counterNext;
+            end
             endcase
         end
     end
@@ -0,0 +1,139 @@
+// RasteriCEr
+// https://github.com/ToNi3141/RasteriCEr
+// Copyright (c) 2021 ToNi3141
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Coarse depth buffer which stores for every block of 8x1 pixels an upper bound of the values in the depth buffer.
+// The rasterizer uses it to skip blocks, where the whole triangle would fail the depth test (see Rasterizer).
+// A block is addressed with the frame buffer index divided by eight, therefore X_RESOLUTION must be a multiple of eight.
+//
+// The buffer snoops the write port of the depth buffer. A write can only increase the bound of a block. To lower the
+// bound again, every block collects a layer: The maximum of all values written since the layer started and a mask of
+// the written pixels. When all pixels of a block are written, the maximum of the layer replaces the bound of the block
+// and a new layer starts. With that, the bound is valid for all depth functions.
+// The memset is executed together with the memset of the depth buffer and uses the same handshake as the FrameBuffer.
+module HierarchicalDepthBuffer
+#(
+    parameter X_RESOLUTION = 128,
+    parameter Y_LINE_RESOLUTION = 128,
+    parameter FRAMEBUFFER_INDEX_WIDTH = 14,
+    localparam NUMBER_OF_BLOCKS = (X_RESOLUTION * Y_LINE_RESOLUTION) / 8,
+    localparam BLOCK_INDEX_WIDTH = FRAMEBUFFER_INDEX_WIDTH - 3
+)
+(
+    input  wire         clk,
+    input  wire         reset,
+
+    // Query interface (combinatorial)
+    input  wire [FRAMEBUFFER_INDEX_WIDTH - 1 : 0] fragIndexRead,
+    output wire [15:0]  maxDepth,
+
+    // Write port of the depth buffer
+    input  wire [FRAMEBUFFER_INDEX_WIDTH - 1 : 0] fragIndexWrite,
+    input  wire [15:0]  fragIn,
+    input  wire         fragWriteEnable,
+    input  wire         fragMask,
+
+    // Control
+    input  wire         apply,
+    output reg          applied,
+    input  wire         cmdMemset,
+
+    // Clear depth
+    input  wire [15:0]  clearDepth
+);
+    localparam HIZ_WAIT_FOR_COMMAND = 0;
+    localparam HIZ_MEMSET = 1;
+
+    reg [15:0] blockMaxDepth [0 : NUMBER_OF_BLOCKS - 1];
+    reg [15:0] layerMaxDepth [0 : NUMBER_OF_BLOCKS - 1];
+    reg [ 7:0] layerMask [0 : NUMBER_OF_BLOCKS - 1];
+
+    reg [ 1:0] state;
+    reg [BLOCK_INDEX_WIDTH - 1 : 0] counter;
+
+    assign maxDepth = blockMaxDepth[fragIndexRead[3 +: BLOCK_INDEX_WIDTH]];
+
+    // Update of the block which is written
+    wire [BLOCK_INDEX_WIDTH - 1 : 0] writeBlock = fragIndexWrite[3 +: BLOCK_INDEX_WIDTH];
+    wire [15:0] writeBlockMaxDepth = blockMaxDepth[writeBlock];
+    wire [15:0] writeLayerMaxDepth = layerMaxDepth[writeBlock];
+    wire [ 7:0] writeLayerMask = layerMask[writeBlock];
+    wire [ 7:0] newLayerMask = writeLayerMask | (8'h1 << fragIndexWrite[0 +: 3]);
+    wire [15:0] newLayerMaxDepth = ((writeLayerMask == 0) || (fragIn > writeLayerMaxDepth)) ? fragIn : writeLayerMaxDepth;
+
+    always @(posedge clk)
+    begin
+        if (reset)
+        begin
+            state <= HIZ_WAIT_FOR_COMMAND;
+            applied <= 1;
+        end
+        else
+        begin
+            case (state)
+            HIZ_WAIT_FOR_COMMAND:
+            begin
+                counter <= 0;
+                if (apply)
+                begin
+                    applied <= 0;
+                    if (cmdMemset & fragMask)
+                    begin
+                        state <= HIZ_MEMSET;
+                    end
+                end
+                else
+                begin
+                    applied <= 1;
+                end
+
+                if (fragWriteEnable & fragMask)
+                begin
+                    if (newLayerMask == 8'hff)
+                    begin
+                        // The layer covers the whole block, the bound can be lowered to the maximum of the layer
+                        blockMaxDepth[writeBlock] <= newLayerMaxDepth;
+                        layerMaxDepth[writeBlock] <= 0;
+                        layerMask[writeBlock] <= 0;
+                    end
+                    else
+                    begin
+                        if (fragIn > writeBlockMaxDepth)
+                        begin
+                            blockMaxDepth[writeBlock] <= fragIn;
+                        end
+                        layerMaxDepth[writeBlock] <= newLayerMaxDepth;
+                        layerMask[writeBlock] <= newLayerMask;
+                    end
+                end
+            end
+            HIZ_MEMSET:
+            begin
+                blockMaxDepth[counter] <= clearDepth;
+                layerMaxDepth[counter] <= 0;
+                layerMask[counter] <= 0;
+                counter <= counter + 1;
+                /* verilator lint_off WIDTH */
+                if (counter == (NUMBER_OF_BLOCKS - 1))
+                /* verilator lint_on WIDTH */
+                begin
+                    state <= HIZ_WAIT_FOR_COMMAND;
+                end
+            end
+            endcase
+        end
+    end
+endmodule
@@ -0,0 +1,63 @@
+// RasteriCEr
+// https://github.com/ToNi3141/RasteriCEr
+// Copyright (c) 2021 ToNi3141
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Register block with free running counters. Every counter counts the clock cycles in which its event is asserted.
+// The counters are read through counterSelect: The value of the selected counter is available on counterValue one clock
+// cycle later. The counters wrap around on overflow, so the host should only use the difference of two reads.
+// clear resets all counters.
+module PerformanceCounters #(
+    parameter NUMBER_OF_COUNTERS = 8,
+    parameter COUNTER_WIDTH = 32,
+    localparam SELECT_WIDTH = $clog2(NUMBER_OF_COUNTERS)
+) (
+    input  wire                             aclk,
+    input  wire                             resetn,
+
+    // Events
+    input  wire [NUMBER_OF_COUNTERS - 1 : 0] events,
+
+    // Register interface
+    input  wire                             clear,
+    input  wire [SELECT_WIDTH - 1 : 0]      counterSelect,
+    output reg  [COUNTER_WIDTH - 1 : 0]     counterValue
+);
+    reg [COUNTER_WIDTH - 1 : 0] counters [0 : NUMBER_OF_COUNTERS - 1];
+
+    integer i;
+    always @(posedge aclk)
+    begin
+        if (!resetn || clear)
+        begin
+            for (i = 0; i < NUMBER_OF_COUNTERS; i = i + 1)
+            begin
+                counters[i] <= 0;
+            end
+            counterValue <= 0;
+        end
+        else
+        begin
+            for (i = 0; i < NUMBER_OF_COUNTERS; i = i + 1)
+            begin
+                if (events[i])
+                begin
+                    counters[i] <= counters[i] + 1;
+                end
+            end
+            counterValue <= counters[counterSelect];
+        end
+    end
+endmodule
@@ -30,7 +30,29 @@ module RasteriCEr #(
     parameter FRAMEBUFFER_STREAM_WIDTH = 16,
 
     // The size of the texture in bytes in power of two
-    parameter TEXTURE_BUFFER_SIZE = 15
+    parameter TEXTURE_BUFFER_SIZE = 15,
+
+    // Enables the triangle setup which accepts the compact triangle descriptor. It requires additionally a 32x32 bit multiplier.
+    // The triangle descriptor is always accepted.
+    parameter ENABLE_TRIANGLE_SETUP = 0,
+
+    // Enables the performance counters (see PerformanceCounters and the PERF_COUNTER_* defines). Without them,
+    // perfCounterValue is always zero.
+    parameter ENABLE_PERFORMANCE_COUNTERS = 0,
+
+    // Enables the hierarchical depth buffer. The rasterizer skips blocks of 8x1 pixels, where the triangle would fail
+    // the depth test. It requires a X_RESOLUTION which is a multiple of eight and additionally
+    // (X_RESOLUTION * Y_LINE_RESOLUTION / 8) * 40 bits of distributed memory.
+    parameter ENABLE_HIERARCHICAL_DEPTH = 0,
+
+    // Enables the shading of pixels while the rasterizer walks out of the triangle after a line increment.
+    // It saves clock cycles at the edges of the triangle but requires additional FFs and LUTs in the rasterizer.
+    parameter ENABLE_SHADED_WALK_OUT = 0,
+
+    // Enables the fast clear of the color and depth buffer. A memset only resets the tags of the buffers instead of
+    // writing the clear value into every pixel (see FrameBuffer). It requires additionally
+    // 2 * (X_RESOLUTION * Y_LINE_RESOLUTION) / (FRAMEBUFFER_STREAM_WIDTH / 16) bits of distributed memory.
+    parameter ENABLE_FAST_CLEAR = 0
 )
 (
     input  wire         aclk,
@@ -48,10 +70,23 @@ module RasteriCEr #(
     input  wire         m_framebuffer_axis_tready,
     output wire         m_framebuffer_axis_tlast,
     output wire [FRAMEBUFFER_STREAM_WIDTH - 1 : 0]  m_framebuffer_axis_tdata,
+
+    // Commit window of the framebuffer stream (see OP_RENDER_CONFIG_COMMIT_WINDOW_*).
+    // The values are valid during the stream
+    output wire [15:0]  commitWindowXStart,
+    output wire [15:0]  commitWindowXEnd,
+    output wire [15:0]  commitWindowYStart,
+    output wire [15:0]  commitWindowYEnd,
+    output wire [15:0]  commitWindowLineY,
     
     // Debug
     output wire [ 3:0]  dbgStreamState,
-    output wire         dbgRasterizerRunning
+    output wire         dbgRasterizerRunning,
+
+    // Performance counters
+    input  wire         perfCounterClear,
+    input  wire [ 2:0]  perfCounterSelect,
+    output wire [31:0]  perfCounterValue
 );
 `include "RasterizerDefines.vh"
 `include "RegisterAndDescriptorDefines.vh"
@@ -73,6 +108,8 @@ module RasteriCEr #(
     wire [31:0] texelIndex;
     wire [15:0] texel;
     wire [ 3:0] textureMode;
+    wire [ 3:0] texturePage;
+    wire        texturePaletted;
 
     // Color buffer access
     wire [FRAMEBUFFER_INDEX_WIDTH - 1 : 0] colorIndexRead;
@@ -96,6 +133,11 @@ module RasteriCEr #(
     wire        s_rasterizer_axis_tready;
     wire        s_rasterizer_axis_tlast;
     wire [CMD_STREAM_WIDTH - 1 : 0] s_rasterizer_axis_tdata;
+    wire        s_setup_axis_tvalid;
+    wire        s_setup_axis_tready;
+    wire        s_setup_axis_tlast;
+    wire        s_setup_axis_tuser;
+    wire [CMD_STREAM_WIDTH - 1 : 0] s_setup_axis_tdata;
 
     // Memory
     wire        colorBufferApply;
@@ -105,6 +147,8 @@ module RasteriCEr #(
     wire [15:0] confColorBufferClearColor;
     wire        depthBufferApply;
     wire        depthBufferApplied;
+    wire        depthBufferFbApplied;
+    wire        hiZApplied;
     wire        depthBufferCmdCommit;
     wire        depthBufferCmdMemset;
     wire [15:0] confDepthBufferClearDepth;
@@ -124,6 +168,15 @@ module RasteriCEr #(
     wire [15:0] confReg2;
     wire [15:0] confTextureEnvColor;
 
+    // Hierarchical depth buffer
+    wire [FRAMEBUFFER_INDEX_WIDTH - 1 : 0] hiZIndex;
+    wire [15:0] hiZMaxDepth;
+
+    // Performance counter events
+    wire        perfWaitForHost;
+    wire        perfWaitForIdle;
+    wire        perfStreamStall;
+
     assign dbgRasterizerRunning = rasterizerRunning;
 
     CommandParser commandParser(
@@ -139,16 +192,19 @@ module RasteriCEr #(
         // Rasterizer
         // Configs
         .confTextureMode(textureMode),
+        .confTexturePage(texturePage),
+        .confTexturePaletted(texturePaletted),
         .confReg1(confReg1),
         .confReg2(confReg2),
         .confTextureEnvColor(confTextureEnvColor),
         // Control
         .rasterizerRunning(rasterizerRunning),
         .pixelInPipeline(pixelInPipeline),
-        .m_rasterizer_axis_tvalid(s_rasterizer_axis_tvalid),
-        .m_rasterizer_axis_tready(s_rasterizer_axis_tready),
-        .m_rasterizer_axis_tlast(s_rasterizer_axis_tlast),
-        .m_rasterizer_axis_tdata(s_rasterizer_axis_tdata),
+        .m_rasterizer_axis_tvalid(s_setup_axis_tvalid),
+        .m_rasterizer_axis_tready(s_setup_axis_tready),
+        .m_rasterizer_axis_tlast(s_setup_axis_tlast),
+        .m_rasterizer_axis_tuser(s_setup_axis_tuser),
+        .m_rasterizer_axis_tdata(s_setup_axis_tdata),
 
         // applied
         .colorBufferApply(colorBufferApply),
@@ -161,6 +217,11 @@ module RasteriCEr #(
         .depthBufferCmdCommit(depthBufferCmdCommit),
         .depthBufferCmdMemset(depthBufferCmdMemset),
         .confDepthBufferClearDepth(confDepthBufferClearDepth),
+        .confCommitWindowXStart(commitWindowXStart),
+        .confCommitWindowXEnd(commitWindowXEnd),
+        .confCommitWindowYStart(commitWindowYStart),
+        .confCommitWindowYEnd(commitWindowYEnd),
+        .confCommitWindowLineY(commitWindowLineY),
 
         // Texture AXIS interface
         .m_texture_axis_tvalid(s_texture_axis_tvalid),
@@ -169,7 +230,12 @@ module RasteriCEr #(
         .m_texture_axis_tdata(s_texture_axis_tdata),
 
         // Debug
-        .dbgStreamState(dbgStreamState)
+        .dbgStreamState(dbgStreamState),
+
+        // Performance counter events
+        .perfWaitForHost(perfWaitForHost),
+        .perfWaitForIdle(perfWaitForIdle),
+        .perfStreamStall(perfStreamStall)
     );
     defparam commandParser.CMD_STREAM_WIDTH = CMD_STREAM_WIDTH;
     defparam commandParser.TEXTURE_STREAM_WIDTH = TEXTURE_STREAM_WIDTH;
@@ -181,6 +247,8 @@ module RasteriCEr #(
         .clk(aclk),
         .reset(!resetn),
         .mode(textureMode),
+        .page(texturePage),
+        .paletted(texturePaletted),
 
         .s_axis_tvalid(s_texture_axis_tvalid),
         .s_axis_tready(s_texture_axis_tready),
@@ -205,7 +273,7 @@ module RasteriCEr #(
         .fragMask({4{confReg1[REG1_DEPTH_MASK_POS +: REG1_DEPTH_MASK_SIZE]}}),
         
         .apply(depthBufferApply),
-        .applied(depthBufferApplied),
+        .applied(depthBufferFbApplied),
         .cmdCommit(depthBufferCmdCommit),
         .cmdMemset(depthBufferCmdMemset),
 
@@ -218,6 +286,41 @@ module RasteriCEr #(
     );
     defparam depthBuffer.FRAME_SIZE = X_RESOLUTION * Y_LINE_RESOLUTION;
     defparam depthBuffer.STREAM_WIDTH = FRAMEBUFFER_STREAM_WIDTH;
+    defparam depthBuffer.ENABLE_FAST_CLEAR = ENABLE_FAST_CLEAR;
+
+    generate
+        if (ENABLE_HIERARCHICAL_DEPTH)
+        begin
+            HierarchicalDepthBuffer hierarchicalDepthBuffer (
+                .clk(aclk),
+                .reset(!resetn),
+
+                .fragIndexRead(hiZIndex),
+                .maxDepth(hiZMaxDepth),
+
+                .fragIndexWrite(depthIndexWrite),
+                .fragIn(depthOut),
+                .fragWriteEnable(depthWriteEnable),
+                .fragMask(confReg1[REG1_DEPTH_MASK_POS +: REG1_DEPTH_MASK_SIZE]),
+
+                .apply(depthBufferApply),
+                .applied(hiZApplied),
+                .cmdMemset(depthBufferCmdMemset),
+
+                .clearDepth(confDepthBufferClearDepth)
+            );
+            defparam hierarchicalDepthBuffer.X_RESOLUTION = X_RESOLUTION;
+            defparam hierarchicalDepthBuffer.Y_LINE_RESOLUTION = Y_LINE_RESOLUTION;
+            defparam hierarchicalDepthBuffer.FRAMEBUFFER_INDEX_WIDTH = FRAMEBUFFER_INDEX_WIDTH;
+        end
+        else
+        begin
+            assign hiZMaxDepth = 16'hffff;
+            assign hiZApplied = 1;
+        end
+    endgenerate
+    // The memset of the hierarchical depth buffer runs together with the one of the depth buffer
+    assign depthBufferApplied = depthBufferFbApplied & hiZApplied;
 
     FrameBuffer colorBuffer (  
         .clk(aclk),
@@ -247,12 +350,47 @@ module RasteriCEr #(
     );
     defparam colorBuffer.FRAME_SIZE = X_RESOLUTION * Y_LINE_RESOLUTION;
     defparam colorBuffer.STREAM_WIDTH = FRAMEBUFFER_STREAM_WIDTH;
+    defparam colorBuffer.ENABLE_FAST_CLEAR = ENABLE_FAST_CLEAR;
+
+    generate
+        if (ENABLE_TRIANGLE_SETUP)
+        begin
+            TriangleSetup triangleSetup (
+                .clk(aclk),
+                .reset(!resetn),
+
+                .s_axis_tvalid(s_setup_axis_tvalid),
+                .s_axis_tready(s_setup_axis_tready),
+                .s_axis_tlast(s_setup_axis_tlast),
+                .s_axis_tuser(s_setup_axis_tuser),
+                .s_axis_tdata(s_setup_axis_tdata),
+
+                .m_axis_tvalid(s_rasterizer_axis_tvalid),
+                .m_axis_tready(s_rasterizer_axis_tready),
+                .m_axis_tlast(s_rasterizer_axis_tlast),
+                .m_axis_tdata(s_rasterizer_axis_tdata)
+            );
+            defparam triangleSetup.CMD_STREAM_WIDTH = CMD_STREAM_WIDTH;
+        end
+        else
+        begin
+            // Without triangle setup, the compact triangles are not supported and the stream goes directly into the rasterizer
+            assign s_rasterizer_axis_tvalid = s_setup_axis_tvalid;
+            assign s_setup_axis_tready = s_rasterizer_axis_tready;
+            assign s_rasterizer_axis_tlast = s_setup_axis_tlast;
+            assign s_rasterizer_axis_tdata = s_setup_axis_tdata;
+        end
+    endgenerate
 
     Rasterizer rop (
         .clk(aclk), 
         .reset(!resetn), 
 
         .rasterizerRunning(rasterizerRunning),
+        .confReg1(confReg1),
+
+        .hiZIndex(hiZIndex),
+        .hiZMaxDepth(hiZMaxDepth),
 
         .s_axis_tvalid(s_rasterizer_axis_tvalid),
         .s_axis_tready(s_rasterizer_axis_tready),
@@ -269,6 +407,8 @@ module RasteriCEr #(
     defparam rop.Y_LINE_RESOLUTION = Y_LINE_RESOLUTION;
     defparam rop.FRAMEBUFFER_INDEX_WIDTH = FRAMEBUFFER_INDEX_WIDTH;
     defparam rop.CMD_STREAM_WIDTH = CMD_STREAM_WIDTH;
+    defparam rop.ENABLE_HIERARCHICAL_DEPTH = ENABLE_HIERARCHICAL_DEPTH;
+    defparam rop.ENABLE_SHADED_WALK_OUT = ENABLE_SHADED_WALK_OUT;
 
 `ifdef UP5K
     FragmentPipelineIce40Wrapper fragmentPipeline (    
@@ -305,4 +445,35 @@ module RasteriCEr #(
     );
     defparam fragmentPipeline.FRAMEBUFFER_INDEX_WIDTH = FRAMEBUFFER_INDEX_WIDTH;
 
+    generate
+        if (ENABLE_PERFORMANCE_COUNTERS)
+        begin
+            wire [PERF_COUNTER_NUMBER_OF_COUNTERS - 1 : 0] perfEvents;
+            assign perfEvents[PERF_COUNTER_CYCLES] = 1;
+            assign perfEvents[PERF_COUNTER_CMD_WAIT_FOR_HOST] = perfWaitForHost;
+            assign perfEvents[PERF_COUNTER_CMD_WAIT_FOR_IDLE] = perfWaitForIdle;
+            assign perfEvents[PERF_COUNTER_CMD_STREAM_STALL] = perfStreamStall;
+            assign perfEvents[PERF_COUNTER_RASTERIZER_BUSY] = rasterizerRunning;
+            assign perfEvents[PERF_COUNTER_FRAGMENT_BUSY] = pixelInPipeline;
+            assign perfEvents[PERF_COUNTER_FRAGMENT_STALL] = m_fragment_axis_tvalid && !m_fragment_axis_tready;
+            assign perfEvents[PERF_COUNTER_FRAGMENTS] = m_fragment_axis_tvalid && m_fragment_axis_tready;
+
+            PerformanceCounters performanceCounters (
+                .aclk(aclk),
+                .resetn(resetn),
+
+                .events(perfEvents),
+
+                .clear(perfCounterClear),
+                .counterSelect(perfCounterSelect),
+                .counterValue(perfCounterValue)
+            );
+            defparam performanceCounters.NUMBER_OF_COUNTERS = PERF_COUNTER_NUMBER_OF_COUNTERS;
+        end
+        else
+        begin
+            assign perfCounterValue = 0;
+        end
+    endgenerate
+
 endmodule
\ No newline at end of file
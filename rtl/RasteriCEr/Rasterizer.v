@@ -27,7 +27,15 @@ module Rasterizer
     parameter FRAMEBUFFER_INDEX_WIDTH = 14,
 
     // The bit width of the command interface. Allowed values: 16, 32, 64, 128, 256
-    parameter CMD_STREAM_WIDTH = 16
+    parameter CMD_STREAM_WIDTH = 16,
+
+    // Skips fragments which fail the depth test with the help of the HierarchicalDepthBuffer
+    parameter ENABLE_HIERARCHICAL_DEPTH = 0,
+
+    // Shades the pixels while the edge walker walks out of the triangle after a line increment. The walker saves the
+    // position where it entered the line and returns to it, instead of walking the same pixels twice. It requires
+    // additionally around 200 FFs to save the position.
+    parameter ENABLE_SHADED_WALK_OUT = 0
 )
 (
     input wire                              clk,
@@ -35,6 +43,11 @@ module Rasterizer
     
     // Rasterizer Control
     output reg                              rasterizerRunning,
+    input  wire [15:0]                      confReg1,
+
+    // Hierarchical depth buffer
+    output wire [FRAMEBUFFER_INDEX_WIDTH - 1 : 0] hiZIndex,
+    input  wire [15:0]                      hiZMaxDepth,
 
     // Triangle Stream
     input  wire                             s_axis_tvalid,
@@ -95,6 +108,46 @@ module Rasterizer
     localparam EDGE_WALKING_DIRECTION_LEFT = 1'b0;
     localparam EDGE_WALKING_DIRECTION_RIGHT = 1'b1;
 
+    // Hierarchical depth test. The triangle contains a lower bound of its depth values, the hierarchical depth buffer an
+    // upper bound of the depth values of the block of 8x1 pixels which contains fbIndex. If the bound of the triangle is
+    // behind the block, the whole triangle fails the depth test in this block, which is only valid for LESS and LEQUAL.
+    // The lower bits of x and fbIndex are the same, because X_RESOLUTION is a multiple of eight.
+    wire [2 : 0] depthFunc = confReg1[REG1_DEPTH_TEST_FUNC_POS +: REG1_DEPTH_TEST_FUNC_SIZE];
+    wire [15 : 0] triangleMinDepth = paramMem[TRIANGLE_CONFIGURATION][TRIANGLE_MIN_DEPTH_POS +: TRIANGLE_MIN_DEPTH_SIZE];
+    wire hiZReject = (ENABLE_HIERARCHICAL_DEPTH != 0)
+        & confReg1[REG1_ENABLE_DEPTH_TEST_POS +: REG1_ENABLE_DEPTH_TEST_SIZE]
+        & (((depthFunc == LESS) & (triangleMinDepth >= hiZMaxDepth)) | ((depthFunc == LEQUAL) & (triangleMinDepth > hiZMaxDepth)));
+    // When the walker enters a rejected block at its first pixel (in walking direction), then it jumps over the block
+    /* verilator lint_off WIDTH */
+    wire hiZSkipRight = (x[2 : 0] == 3'h0) & ((x + 8) <= paramMem[BB_END][BB_X_POS +: X_BIT_WIDTH]);
+    wire hiZSkipLeft = (x[2 : 0] == 3'h7) & (x >= (paramMem[BB_START][BB_X_POS +: X_BIT_WIDTH] + 7));
+    wire hiZSkip = hiZReject & (edgeWalkingState == RASTERIZER_EDGEWALKER_WALK) & isInTriangleAndInBounds
+        & ((edgeWalkingDirection == EDGE_WALKING_DIRECTION_RIGHT) ? hiZSkipRight : hiZSkipLeft);
+    // Pixel step of the walker: One pixel or a whole block
+    wire [X_BIT_WIDTH - 1 : 0] xStep = (hiZSkip) ? 8 : 1;
+    /* verilator lint_on WIDTH */
+    wire [1 : 0] incShift = (hiZSkip) ? 2'd3 : 2'd0;
+    assign hiZIndex = fbIndex;
+
+    // Saved position of the shaded walk out. When the walker leaves the triangle, it continues from the saved position
+    // into the other direction. The position is restored in the same cycle, when the walker steps to the next pixel.
+    reg [X_BIT_WIDTH - 1 : 0] savedX;
+    reg signed [PARAMETER_WIDTH - 1 : 0] savedW0;
+    reg signed [PARAMETER_WIDTH - 1 : 0] savedW1;
+    reg signed [PARAMETER_WIDTH - 1 : 0] savedW2;
+    reg signed [PARAMETER_WIDTH - 1 : 0] savedTexS;
+    reg signed [PARAMETER_WIDTH - 1 : 0] savedTexT;
+    reg signed [PARAMETER_WIDTH - 1 : 0] savedDepthW;
+    wire restoreWalkOut = (ENABLE_SHADED_WALK_OUT != 0) & (edgeWalkingState == RASTERIZER_EDGEWALKER_WALK_OUT) & !isInTriangleAndInBounds;
+    wire [X_BIT_WIDTH - 1 : 0] walkX = (restoreWalkOut) ? savedX : x;
+    wire signed [PARAMETER_WIDTH - 1 : 0] walkW0 = (restoreWalkOut) ? savedW0 : paramMem[INC_W0];
+    wire signed [PARAMETER_WIDTH - 1 : 0] walkW1 = (restoreWalkOut) ? savedW1 : paramMem[INC_W1];
+    wire signed [PARAMETER_WIDTH - 1 : 0] walkW2 = (restoreWalkOut) ? savedW2 : paramMem[INC_W2];
+    wire signed [PARAMETER_WIDTH - 1 : 0] walkTexS = (restoreWalkOut) ? savedTexS : paramMem[INC_TEX_S];
+    wire signed [PARAMETER_WIDTH - 1 : 0] walkTexT = (restoreWalkOut) ? savedTexT : paramMem[INC_TEX_T];
+    wire signed [PARAMETER_WIDTH - 1 : 0] walkDepthW = (restoreWalkOut) ? savedDepthW : paramMem[INC_DEPTH_W];
+    wire walkDirection = (restoreWalkOut) ? !edgeWalkingDirection : edgeWalkingDirection;
+
     always @(posedge clk)
     begin
         if (reset)
@@ -238,31 +291,31 @@ module Rasterizer
                     end
                     else 
                     begin
-                        if (edgeWalkingDirection == EDGE_WALKING_DIRECTION_RIGHT)
+                        if (walkDirection == EDGE_WALKING_DIRECTION_RIGHT)
                         begin
                             // Pixel Increment
-                            x <= x + 1;
+                            x <= walkX + xStep;
 
-                            paramMem[INC_W0] <= paramMem[INC_W0] + $signed(paramMem[INC_W0_X]);
-                            paramMem[INC_W1] <= paramMem[INC_W1] + $signed(paramMem[INC_W1_X]);
-                            paramMem[INC_W2] <= paramMem[INC_W2] + $signed(paramMem[INC_W2_X]);
+                            paramMem[INC_W0] <= walkW0 + ($signed(paramMem[INC_W0_X]) <<< incShift);
+                            paramMem[INC_W1] <= walkW1 + ($signed(paramMem[INC_W1_X]) <<< incShift);
+                            paramMem[INC_W2] <= walkW2 + ($signed(paramMem[INC_W2_X]) <<< incShift);
 
-                            paramMem[INC_TEX_S] <= paramMem[INC_TEX_S] + $signed(paramMem[INC_TEX_S_X]);
-                            paramMem[INC_TEX_T] <= paramMem[INC_TEX_T] + $signed(paramMem[INC_TEX_T_X]);
-                            paramMem[INC_DEPTH_W] <= paramMem[INC_DEPTH_W] + $signed(paramMem[INC_DEPTH_W_X]);
+                            paramMem[INC_TEX_S] <= walkTexS + ($signed(paramMem[INC_TEX_S_X]) <<< incShift);
+                            paramMem[INC_TEX_T] <= walkTexT + ($signed(paramMem[INC_TEX_T_X]) <<< incShift);
+                            paramMem[INC_DEPTH_W] <= walkDepthW + ($signed(paramMem[INC_DEPTH_W_X]) <<< incShift);
                         end
                         else
                         begin
                             // Pixel Decrement
-                            x <= x - 1;
+                            x <= walkX - xStep;
 
-                            paramMem[INC_W0] <= paramMem[INC_W0] - $signed(paramMem[INC_W0_X]);
-                            paramMem[INC_W1] <= paramMem[INC_W1] - $signed(paramMem[INC_W1_X]);
-                            paramMem[INC_W2] <= paramMem[INC_W2] - $signed(paramMem[INC_W2_X]);
+                            paramMem[INC_W0] <= walkW0 - ($signed(paramMem[INC_W0_X]) <<< incShift);
+                            paramMem[INC_W1] <= walkW1 - ($signed(paramMem[INC_W1_X]) <<< incShift);
+                            paramMem[INC_W2] <= walkW2 - ($signed(paramMem[INC_W2_X]) <<< incShift);
 
-                            paramMem[INC_TEX_S] <= paramMem[INC_TEX_S] - $signed(paramMem[INC_TEX_S_X]);
-                            paramMem[INC_TEX_T] <= paramMem[INC_TEX_T] - $signed(paramMem[INC_TEX_T_X]);
-                            paramMem[INC_DEPTH_W] <= paramMem[INC_DEPTH_W] - $signed(paramMem[INC_DEPTH_W_X]);
+                            paramMem[INC_TEX_S] <= walkTexS - ($signed(paramMem[INC_TEX_S_X]) <<< incShift);
+                            paramMem[INC_TEX_T] <= walkTexT - ($signed(paramMem[INC_TEX_T_X]) <<< incShift);
+                            paramMem[INC_DEPTH_W] <= walkDepthW - ($signed(paramMem[INC_DEPTH_W_X]) <<< incShift);
                         end
                     end
 
@@ -275,7 +328,7 @@ module Rasterizer
                             if (isInTriangle)
                             begin
                                 // If yes, then there is nothing to do. We are already at position (0, 0)
-                                m_axis_tvalid <= 1;
+                                m_axis_tvalid <= !hiZReject;
                                 edgeWalkingState <= RASTERIZER_EDGEWALKER_WALK;
                             end
                             else
@@ -288,7 +341,19 @@ module Rasterizer
                         RASTERIZER_EDGEWALKER_CHECK_WALKING_DIR:
                         begin
                             // Check if after a line increment the pixel is inside the triangle
-                            if (isInTriangle)
+                            if ((ENABLE_SHADED_WALK_OUT != 0) & isInTriangleAndInBounds)
+                            begin
+                                // Walk out and shade. Save the position to continue from here into the other direction
+                                savedX <= x;
+                                savedW0 <= paramMem[INC_W0];
+                                savedW1 <= paramMem[INC_W1];
+                                savedW2 <= paramMem[INC_W2];
+                                savedTexS <= paramMem[INC_TEX_S];
+                                savedTexT <= paramMem[INC_TEX_T];
+                                savedDepthW <= paramMem[INC_DEPTH_W];
+                                edgeWalkingState <= RASTERIZER_EDGEWALKER_WALK_OUT;
+                            end
+                            else if ((ENABLE_SHADED_WALK_OUT == 0) & isInTriangle)
                             begin
                                 // If yes, walk out. It will continue walking in the old direction, this should be closest to the edge
                                 // Improvement: Save this position inside in the triangle. Also during walk out it is possible to render this pixel.
@@ -310,7 +375,7 @@ module Rasterizer
                             begin
                                 // The triangle is withing it bounds and everything is fine. So, just shade the pixel
                                 edgeWalkTryOtherside <= 0;
-                                m_axis_tvalid <= 1; // To prevent, that the first pixel of the triangle is skipped
+                                m_axis_tvalid <= !hiZReject; // To prevent, that the first pixel of the triangle is skipped
                                 edgeWalkingState <= RASTERIZER_EDGEWALKER_WALK;
                             end
                             else if (x == paramMem[BB_END][BB_X_POS +: X_BIT_WIDTH])
@@ -366,14 +431,33 @@ module Rasterizer
                         end
                         RASTERIZER_EDGEWALKER_WALK_OUT:
                         begin
-                            // Walk out of the triangle. To improve the performance: If the rasterizer could save the starting point,
-                            // it could also shade pixel while walking out, and if it is out reset to this point, switch direction
-                            // and shade the left pixels. But this would again occupy arround 400 luts.
-                            if (!isInTriangle | (x == paramMem[BB_START][BB_X_POS +: X_BIT_WIDTH]) | (x >= paramMem[BB_END][BB_X_POS +: X_BIT_WIDTH]))
-                            begin                             
-                                // Change the walking direction and shade
-                                edgeWalkingDirection <= !edgeWalkingDirection;
-                                edgeWalkingState <= RASTERIZER_EDGEWALKER_SEARCH_EDGE;
+                            if (ENABLE_SHADED_WALK_OUT != 0)
+                            begin
+                                // Walk out of the triangle and shade the pixels on the way
+                                if (isInTriangleAndInBounds)
+                                begin
+                                    m_axis_tvalid <= !hiZReject;
+                                end
+                                else
+                                begin
+                                    // The walker is outside. The increment logic restores the saved position and steps
+                                    // from there into the other direction, the rest of the line is then shaded in the walk state
+                                    m_axis_tvalid <= 0;
+                                    edgeWalkingDirection <= !edgeWalkingDirection;
+                                    edgeWalkingState <= RASTERIZER_EDGEWALKER_WALK;
+                                end
+                            end
+                            else
+                            begin
+                                // Walk out of the triangle. To improve the performance: If the rasterizer could save the starting point,
+                                // it could also shade pixel while walking out, and if it is out reset to this point, switch direction
+                                // and shade the left pixels (see ENABLE_SHADED_WALK_OUT). But this would again occupy arround 400 luts.
+                                if (!isInTriangle | (x == paramMem[BB_START][BB_X_POS +: X_BIT_WIDTH]) | (x >= paramMem[BB_END][BB_X_POS +: X_BIT_WIDTH]))
+                                begin                             
+                                    // Change the walking direction and shade
+                                    edgeWalkingDirection <= !edgeWalkingDirection;
+                                    edgeWalkingState <= RASTERIZER_EDGEWALKER_SEARCH_EDGE;
+                                end
                             end
                         end
                         RASTERIZER_EDGEWALKER_WALK:
@@ -381,7 +465,8 @@ module Rasterizer
                             // Render pixels
                                 if (isInTriangleAndInBounds)
                                 begin
-                                    m_axis_tvalid <= 1;
+                                    // Fragments which fail the hierarchical depth test are not shaded
+                                    m_axis_tvalid <= !hiZReject;
                                 end
                                 else
                                 begin
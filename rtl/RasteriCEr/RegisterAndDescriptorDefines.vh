@@ -38,6 +38,7 @@ localparam OP_TEXTURE_STREAM = 1;
 localparam OP_RENDER_CONFIG = 2;
 localparam OP_FRAMEBUFFER = 3;
 localparam OP_TRIANGLE_STREAM = 4;
+localparam OP_TEXTURE_STREAM_PALETTED = 5;
 
 localparam OP_POS = 12;
 localparam OP_SIZE = 4;
@@ -49,23 +50,38 @@ localparam OP_IMM_SIZE = 12;
 ////////////////////////////
 // OP_TRIANGLE_STREAM
 // Immediate value contains size of triangle in bytes (inclusive the additional bytes which are required for CMD_AXIS bus alignment).
-//  +--------------------------------+
-//  | 4 bit OP | 12 bit size in bytes|
-//  +--------------------------------+
+// The compact bit selects the compact triangle descriptor which is converted by the TriangleSetup into a triangle descriptor.
+// The compact triangle descriptor is only supported when the RasteriCEr is build with ENABLE_TRIANGLE_SETUP.
+//  +------------------------------------------------+
+//  | 4 bit OP | 1 bit compact | 11 bit size in bytes |
+//  +------------------------------------------------+
+localparam OP_TRIANGLE_STREAM_SIZE_SIZE = 11;
+localparam OP_TRIANGLE_STREAM_COMPACT_POS = 11;
 
 // OP_TEXTURE_STREAM
-//  +-----------------------------------------------------+
-//  | 4 bit OP | 4 bit reserved | 4 bit mode | 4 bit size |
-//  +-----------------------------------------------------+
+//  +-------------------------------------------------+
+//  | 4 bit OP | 4 bit page | 4 bit mode | 4 bit size |
+//  +-------------------------------------------------+
 // The size uses also the OP_TEXTURE_STREAM_MODE defines.
+// The page selects where the texture starts in the texture buffer. One page has the size of a 32x32 texture, bigger
+// textures are occupying several pages. The texture buffer can hold several textures. If the size is zero, then
+// no texture data is streamed and the command just selects the texture (which was streamed before) in the page.
 localparam TEXTURE_STREAM_SIZE_POS = 0;
 localparam TEXTURE_STREAM_MODE_POS = 4;
+localparam TEXTURE_STREAM_PAGE_POS = 8;
 localparam TEXTURE_STREAM_IMM_SIZE = 4;
 `define OP_TEXTURE_STREAM_MODE_32x32   4'b0001 // When used for size: expects after the command 32x32x2 bytes of texture data
 `define OP_TEXTURE_STREAM_MODE_64x64   4'b0010 // When used for size: expects after the command 64x64x2 bytes of texture data
 `define OP_TEXTURE_STREAM_MODE_128x128 4'b0100 // When used for size: expects after the command 128x128x2 bytes of texture data
 `define OP_TEXTURE_STREAM_MODE_256x256 4'b1000 // When used for size: expects after the command 256x256x2 bytes of texture data
 
+// OP_TEXTURE_STREAM_PALETTED
+// Same immediate value as OP_TEXTURE_STREAM. The texture contains 4 bit indices into a palette with 16 RGBA4444 colors.
+// After the command, always the palette (16x2 bytes) is streamed, also when the size is zero, because the texture buffer
+// can only hold the palette of one texture. When the size is not zero, the indices are streamed after the palette
+// (a fourth of the size of a OP_TEXTURE_STREAM texture). Four indices are packed in 16 bit, the first index is in the lowest nibble.
+localparam TEXTURE_PALETTE_SIZE = 16;
+
 // OP_RENDER_CONFIG
 //  +-----------------------------+
 //  | 4 bit OP | 12 register addr |
@@ -75,6 +91,12 @@ localparam OP_RENDER_CONFIG_DEPTH_BUFFER_CLEAR_DEPTH = 1;
 localparam OP_RENDER_CONFIG_REG1 = 2;
 localparam OP_RENDER_CONFIG_REG2 = 3;
 localparam OP_RENDER_CONFIG_TEX_ENV_COLOR = 4;
+localparam OP_RENDER_CONFIG_COMMIT_WINDOW_X_START = 5;
+localparam OP_RENDER_CONFIG_COMMIT_WINDOW_X_END = 6;
+localparam OP_RENDER_CONFIG_COMMIT_WINDOW_Y_START = 7;
+localparam OP_RENDER_CONFIG_COMMIT_WINDOW_Y_END = 8;
+localparam OP_RENDER_CONFIG_COMMIT_WINDOW_LINE_Y = 9;
+localparam OP_RENDER_CONFIG_NUMBER_OF_REGS = 10;
 
 // OP_FRAMEBUFFER
 //  +----------------------------------------------------------------------------------------------------------------------------------+
@@ -125,13 +147,43 @@ localparam TRIANGLE_DATA_SET_SIZE_256 = PADDING_3 + 1; // Max command port width
                                             x <= 256 ? TRIANGLE_DATA_SET_SIZE_256 : \
                                             0)
 
+// OP_TRIANGLE_STREAM (compact)
+// Compact Triangle Descriptor, each value containts 4 bytes. The bounding box is already moved into the current
+// display line (BB_START clamped to zero), the vertices are moved by the same offset.
+localparam COMPACT_TRIANGLE_CONFIGURATION = 0;
+localparam COMPACT_BB_START = 1; // S15.0, S15.0
+localparam COMPACT_BB_END = 2; // S15.0, S15.0
+localparam COMPACT_V0 = 3; // S13.2, S13.2 (x, y)
+localparam COMPACT_V1 = 4; // S13.2, S13.2 (x, y)
+localparam COMPACT_V2 = 5; // S13.2, S13.2 (x, y)
+localparam COMPACT_DEPTH_W0 = 6; // S1.30
+localparam COMPACT_DEPTH_W1 = 7; // S1.30
+localparam COMPACT_DEPTH_W2 = 8; // S1.30
+localparam COMPACT_TEX_S0 = 9; // S4.27 (perspective corrected)
+localparam COMPACT_TEX_S1 = 10; // S4.27 (perspective corrected)
+localparam COMPACT_TEX_S2 = 11; // S4.27 (perspective corrected)
+localparam COMPACT_TEX_T0 = 12; // S4.27 (perspective corrected)
+localparam COMPACT_TEX_T1 = 13; // S4.27 (perspective corrected)
+localparam COMPACT_TEX_T2 = 14; // S4.27 (perspective corrected)
+localparam COMPACT_PADDING_1 = 15;
+localparam COMPACT_TRIANGLE_DATA_SET_SIZE_32 = COMPACT_TEX_T2 + 1; // Max command port width: 32 bit
+localparam COMPACT_TRIANGLE_DATA_SET_SIZE_512 = COMPACT_PADDING_1 + 1; // Max command port width: 512 bit
+`define GET_COMPACT_TRIANGLE_SIZE_FOR_BUS_WIDTH(x) (x <= 32 ? COMPACT_TRIANGLE_DATA_SET_SIZE_32 : \
+                                                    x <= 512 ? COMPACT_TRIANGLE_DATA_SET_SIZE_512 : \
+                                                    0)
+
 // BB_START and BB_END defines
 localparam BB_X_POS = 0;
 localparam BB_Y_POS = 16;
 // TRIANGLE_CONFIGURATION defines
+//  +-----------------------------------------------------+
+//  | 16 bit static color (RGBA4444) | 16 bit min depth   |
+//  +-----------------------------------------------------+
+// The min depth is a lower bound of the depth values of all fragments of the triangle. It is used by the hierarchical
+// depth test (see HierarchicalDepthBuffer). Zero disables the test for this triangle.
 localparam TRIANGLE_STATIC_COLOR_POS = 16;
-localparam ENABLE_W_INTERPOLATION_POS = 0;
-localparam ENABLE_TEXTURE_INTERPOLATION_POS = 1;
+localparam TRIANGLE_MIN_DEPTH_POS = 0;
+localparam TRIANGLE_MIN_DEPTH_SIZE = 16;
 
 // OP_TEXTURE_STREAM
 // Texture data, size is dependet on the immediate value, for instance,
@@ -252,6 +304,22 @@ localparam CLAMP_TO_EDGE = 1;
 //  | 4 bit R | 4 bit G | 4 bit B | 4 bit A |
 //  +---------------------------------------+
 
+// OP_RENDER_CONFIG_COMMIT_WINDOW_X_START, OP_RENDER_CONFIG_COMMIT_WINDOW_X_END,
+// OP_RENDER_CONFIG_COMMIT_WINDOW_Y_START, OP_RENDER_CONFIG_COMMIT_WINDOW_Y_END
+//  +---------------------------------------+
+//  | 16 bit position                       |
+//  +---------------------------------------+
+// Area of the frame buffer which was changed and which is sent to the display by the display controller (see
+// DisplayControllerSpi::ENABLE_COMMIT_WINDOW). The positions are in pixels in the order of the frame buffer stream,
+// the origin is the first pixel of the stream. The end positions are inclusive.
+// The frame buffer itself always streams all pixels, the registers are only passed to the display controller.
+
+// OP_RENDER_CONFIG_COMMIT_WINDOW_LINE_Y
+//  +---------------------------------------+
+//  | 16 bit row                            |
+//  +---------------------------------------+
+// Row of the display where the first row of the frame buffer is shown.
+
 // Color defines
 localparam COLOR_R_POS = 12;
 localparam COLOR_G_POS = 8;
@@ -261,3 +329,18 @@ localparam COLOR_SUB_PIXEL_WIDTH = 4;
 
 // OP_FRAMEBUFFER
 // Does not contain any arguments, just starts the framebuffer commit and clear processes
+
+////////////////////////////
+// Performance Counters
+////////////////////////////
+// Addresses of the counters of the PerformanceCounters register block (see RasteriCEr::ENABLE_PERFORMANCE_COUNTERS).
+// Every counter counts the clock cycles (aclk) in which its event was active.
+localparam PERF_COUNTER_CYCLES = 0; // All cycles
+localparam PERF_COUNTER_CMD_WAIT_FOR_HOST = 1; // The command parser is ready, but the command stream has no data
+localparam PERF_COUNTER_CMD_WAIT_FOR_IDLE = 2; // The command parser waits until the rasterizer, the fragment pipeline and the frame buffers are idle
+localparam PERF_COUNTER_CMD_STREAM_STALL = 3; // A triangle or texture stream is stalled by the triangle setup, the rasterizer or the texture buffer
+localparam PERF_COUNTER_RASTERIZER_BUSY = 4; // The rasterizer is running
+localparam PERF_COUNTER_FRAGMENT_BUSY = 5; // The fragment pipeline contains fragments
+localparam PERF_COUNTER_FRAGMENT_STALL = 6; // The rasterizer has a fragment but the fragment pipeline is not ready
+localparam PERF_COUNTER_FRAGMENTS = 7; // Fragments which were sent from the rasterizer to the fragment pipeline
+localparam PERF_COUNTER_NUMBER_OF_COUNTERS = 8;
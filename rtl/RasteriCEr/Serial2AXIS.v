@@ -16,17 +16,26 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 // Simple bridge to connect a AXIS device to an serial port like SPI
+// SERIAL_LANES selects the number of data lines:
+//  1: SPI (mode 0) with serial_mosi[0] and serial_miso
+//  4: Quad SPI (mode 0, receive only). The MSB nibble of a byte comes first, serial_miso is not used.
+// In both modes, the serial data is sampled in the clock domain of serial_sck and handed over to aclk. Therefore aclk
+// must be faster than serial_sck.
+// CHUNK_SIZE is the maximum number of bytes the host sends after serial_cts was set (the HARDWARE_BUFFER_SIZE of the
+// driver, see Renderer::getHardwareBufferSize()). The FIFO must be able to take a whole chunk above the FIFO_TRESHOLD.
 
 module Serial2AXIS 
 #(
-    parameter FIFO_SIZE = 4096,
+    parameter SERIAL_LANES = 1,
+    parameter CHUNK_SIZE = 2048,
+    parameter FIFO_SIZE = CHUNK_SIZE * 2,
     parameter FIFO_TRESHOLD = FIFO_SIZE / 4
 )
 (
     input  wire         aclk,
     input  wire         resetn, 
 
-    input  wire         serial_mosi,
+    input  wire [SERIAL_LANES - 1 : 0] serial_mosi,
     output wire         serial_miso,
     input  wire         serial_sck,
     input  wire         serial_cs,
@@ -50,8 +59,60 @@ module Serial2AXIS
 
     wire        readFromFifo = fifoReadEnable;
 
-    SPI_Slave #(.SPI_MODE(0)) spiSlave (resetn, aclk, rxDone, mosi, 0, 0, serial_sck, serial_miso, serial_mosi, !serial_cs);
-    //uart_rx #(.CLKS_PER_BIT(16)) rxUart(aclk, rx, rxDone, mosi);
+    generate
+        if (SERIAL_LANES == 4)
+        begin
+            reg         nibbleCount;
+            reg  [3:0]  highNibble;
+            reg  [7:0]  rxByte;
+            reg         rxByteDone;
+            reg  [2:0]  rxByteDoneSync;
+
+            always @(posedge serial_sck or negedge serial_cs)
+            begin
+                if (!serial_cs)
+                begin
+                    nibbleCount <= 0;
+                    rxByteDone <= 0;
+                end
+                else
+                begin
+                    nibbleCount <= !nibbleCount;
+                    if (!nibbleCount)
+                    begin
+                        highNibble <= serial_mosi;
+                        rxByteDone <= 0;
+                    end
+                    else
+                    begin
+                        rxByte <= {highNibble, serial_mosi};
+                        rxByteDone <= 1;
+                    end
+                end
+            end
+
+            // Clock domain crossing like in the SPI_Slave: rxByte is stable for one nibble after rxByteDone was set
+            always @(posedge aclk)
+            begin
+                if (!resetn)
+                begin
+                    rxByteDoneSync <= 0;
+                end
+                else
+                begin
+                    rxByteDoneSync <= {rxByteDoneSync[1 : 0], rxByteDone};
+                end
+            end
+            assign rxDone = rxByteDoneSync[1] & !rxByteDoneSync[2];
+            assign mosi = rxByte;
+            assign serial_miso = 0;
+        end
+        else
+        begin
+            SPI_Slave #(.SPI_MODE(0)) spiSlave (resetn, aclk, rxDone, mosi, 0, 0, serial_sck, serial_miso, serial_mosi[0], !serial_cs);
+            //uart_rx #(.CLKS_PER_BIT(16)) rxUart(aclk, rx, rxDone, mosi);
+        end
+    endgenerate
 
     sfifo #(.BW(BW), .LGFLEN(LGFLEN), .OPT_ASYNC_READ(0))
         sfifoInst
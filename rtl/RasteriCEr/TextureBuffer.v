@@ -26,7 +26,17 @@ module TextureBuffer #(
     localparam PIXEL_WIDTH = SUB_PIXEL_WIDTH * 4,
     localparam SIZE_IN_WORDS = SIZE - $clog2(PIXEL_WIDTH / 8),
     localparam ADDR_WIDTH = SIZE_IN_WORDS - $clog2(STREAM_WIDTH / PIXEL_WIDTH),
-    localparam ADDR_WIDTH_DIFF = SIZE_IN_WORDS - ADDR_WIDTH
+    localparam ADDR_WIDTH_DIFF = SIZE_IN_WORDS - ADDR_WIDTH,
+
+    // The texture memory is divided into pages. A page has the size of the smallest texture (32x32px).
+    // A texture always starts at the beginning of a page. Bigger textures are occupying several pages.
+    localparam PAGE_SIZE_IN_WORDS = 10, // 32px * 32px in power of two
+    localparam PAGE_SIZE_IN_STREAM_WORDS = PAGE_SIZE_IN_WORDS - ADDR_WIDTH_DIFF,
+
+    // Paletted textures are using 4 bit indices into a palette of 16 colors. The palette is streamed in front of the indices.
+    localparam PALETTE_SIZE = 16,
+    localparam PALETTE_INDEX_WIDTH = $clog2(PALETTE_SIZE),
+    localparam PALETTE_COLORS_PER_STREAM_WORD = STREAM_WIDTH / PIXEL_WIDTH
 )
 (
     input  wire                         clk,
@@ -39,6 +49,15 @@ module TextureBuffer #(
     // 4'b1000 256x256 (right now not supported)
     input  wire [ 3 : 0]                mode,
 
+    // Texture page
+    // The page where the texture starts. Used for reading and writing the texture
+    input  wire [ 3 : 0]                page,
+
+    // Texture format
+    // 0 RGBA4444
+    // 1 4 bit palette indices. Every stream starts with the palette, the indices are following.
+    input  wire                         paletted,
+
     // Texture Read
     output wire [PIXEL_WIDTH - 1 : 0]   texel,
     input  wire [31 : 0]                texelIndex,
@@ -60,7 +79,21 @@ module TextureBuffer #(
     wire [STREAM_WIDTH - 1 : 0]     memReadData;
     wire [ADDR_WIDTH - 1 : 0]       memReadAddr;
     reg  [SIZE_IN_WORDS - 1 : 0]    texelIndexConf;
-    reg  [SIZE_IN_WORDS - 1 : 0]    texelIndexConfDelay;
+    reg  [SIZE_IN_WORDS - 1 : 0]    texelIndexWord;
+    reg  [SIZE_IN_WORDS - 1 : 0]    texelIndexWordDelay;
+    reg  [ 1 : 0]                   texelIndexNibbleDelay;
+    reg  [SIZE_IN_WORDS - 1 : 0]    texelIndexPage;
+    wire [PIXEL_WIDTH - 1 : 0]      memTexel;
+
+    reg  [PIXEL_WIDTH - 1 : 0]      palette [0 : PALETTE_SIZE - 1];
+    reg  [PALETTE_INDEX_WIDTH : 0]  paletteWriteIndex = 0;
+    wire                            paletteWrite = paletted && (paletteWriteIndex != PALETTE_SIZE);
+
+    // Offset of the page in the memory. Pages which are outside of the memory are wrapping around.
+    /* verilator lint_off WIDTH */
+    wire [ADDR_WIDTH - 1 : 0]       pageWriteOffset = page << PAGE_SIZE_IN_STREAM_WORDS;
+    wire [SIZE_IN_WORDS - 1 : 0]    pageReadOffset = page << PAGE_SIZE_IN_WORDS;
+    /* verilator lint_on WIDTH */
 
 
     `RAM_MODULE #(
@@ -74,8 +107,8 @@ module TextureBuffer #(
 
         .writeData(s_axis_tdata),
         .writeCs(1),
-        .write(s_axis_tvalid),
-        .writeAddr(memWriteAddr),
+        .write(s_axis_tvalid && !paletteWrite),
+        .writeAddr(memWriteAddr + pageWriteOffset),
         .writeMask({(STREAM_WIDTH / SUB_PIXEL_WIDTH){1'b1}}),
 
         .readData(memReadData),
@@ -86,18 +119,21 @@ module TextureBuffer #(
     generate
         if (STREAM_WIDTH == 16)
         begin
-            assign memReadAddr = texelIndexConf;
-            assign texel = memReadData;
+            assign memReadAddr = texelIndexPage;
+            assign memTexel = memReadData;
         end
         else
         begin
-            assign memReadAddr = texelIndexConf[ADDR_WIDTH_DIFF +: ADDR_WIDTH];
+            assign memReadAddr = texelIndexPage[ADDR_WIDTH_DIFF +: ADDR_WIDTH];
 
             // Note: The memReadData is one clock cycle delayed, therefore we have to use the delayed texel index
-            assign texel = memReadData[texelIndexConfDelay[0 +: ADDR_WIDTH_DIFF] * PIXEL_WIDTH +: PIXEL_WIDTH];
+            assign memTexel = memReadData[texelIndexWordDelay[0 +: ADDR_WIDTH_DIFF] * PIXEL_WIDTH +: PIXEL_WIDTH];
         end
     endgenerate
 
+    // A word of a paletted texture contains four indices
+    assign texel = (paletted) ? palette[memTexel[texelIndexNibbleDelay * PALETTE_INDEX_WIDTH +: PALETTE_INDEX_WIDTH]] : memTexel;
+
 
     always @*
     begin
@@ -113,28 +149,48 @@ module TextureBuffer #(
             default:
                 texelIndexConf = 0;
         endcase
+        texelIndexWord = (paletted) ? {2'b0, texelIndexConf[2 +: SIZE_IN_WORDS - 2]} : texelIndexConf;
+        // The page offset does not change the lower bits, because a page is always bigger than a memory word
+        texelIndexPage = texelIndexWord + pageReadOffset;
     end
 
     always @(posedge clk)
-    begin
-        texelIndexConfDelay <= texelIndexConf;
+    begin : TexWrite
+        integer i;
+
+        texelIndexWordDelay <= texelIndexWord;
+        texelIndexNibbleDelay <= texelIndexConf[0 +: 2];
         if (reset)
         begin
             memWriteAddr <= 0;
+            paletteWriteIndex <= 0;
             s_axis_tready <= 1;
         end
         else
         begin
             if (s_axis_tvalid)
             begin
-                if (s_axis_tlast)
+                if (paletteWrite)
                 begin
-                    memWriteAddr <= 0;
+                    // The palette is at the beginning of the stream and is written into registers instead of the memory
+                    for (i = 0; i < PALETTE_COLORS_PER_STREAM_WORD; i = i + 1)
+                    begin
+                        /* verilator lint_off WIDTH */
+                        palette[paletteWriteIndex[0 +: PALETTE_INDEX_WIDTH] + i] <= s_axis_tdata[i * PIXEL_WIDTH +: PIXEL_WIDTH];
+                        /* verilator lint_on WIDTH */
+                    end
+                    paletteWriteIndex <= paletteWriteIndex + PALETTE_COLORS_PER_STREAM_WORD;
                 end
                 else
                 begin
                     memWriteAddr <= memWriteAddr + 1;
                 end
+
+                if (s_axis_tlast)
+                begin
+                    memWriteAddr <= 0;
+                    paletteWriteIndex <= 0;
+                end
             end
         end
     end
@@ -0,0 +1,402 @@
+// RasteriCEr
+// https://github.com/ToNi3141/RasteriCEr
+// Copyright (c) 2021 ToNi3141
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Converts a compact triangle descriptor (vertices, W and texture coordinates) into the triangle descriptor
+// which is expected by the Rasterizer (edge functions and increments). This is the same calculation as
+// in Rasterizer::setup() in the driver.
+// When s_axis_tuser is not set, the stream is directly passed through to the Rasterizer.
+// The calculation uses only one multiplier which is shared by all steps. A triangle needs roughly 200 clock cycles.
+module TriangleSetup
+#(
+    // The bit width of the command interface. Allowed values: 16, 32, 64, 128, 256
+    parameter CMD_STREAM_WIDTH = 16
+)
+(
+    input  wire                             clk,
+    input  wire                             reset,
+
+    // Triangle Stream from the CommandParser
+    input  wire                             s_axis_tvalid,
+    output wire                             s_axis_tready,
+    input  wire                             s_axis_tlast,
+    input  wire                             s_axis_tuser, // 1: compact triangle descriptor, 0: triangle descriptor
+    input  wire [CMD_STREAM_WIDTH - 1 : 0]  s_axis_tdata,
+
+    // Triangle Stream to the Rasterizer
+    output wire                             m_axis_tvalid,
+    input  wire                             m_axis_tready,
+    output wire                             m_axis_tlast,
+    output wire [CMD_STREAM_WIDTH - 1 : 0]  m_axis_tdata
+);
+`include "RegisterAndDescriptorDefines.vh"
+
+    localparam PARAMETER_WIDTH = 32;
+    localparam PARAMETERS_PER_STREAM_BEAT = CMD_STREAM_WIDTH / PARAMETER_WIDTH;
+    localparam COMPACT_TRIANGLE_SIZE = `GET_COMPACT_TRIANGLE_SIZE_FOR_BUS_WIDTH(CMD_STREAM_WIDTH);
+    localparam TRIANGLE_SIZE = `GET_TRIANGLE_SIZE_FOR_BUS_WIDTH(CMD_STREAM_WIDTH);
+    localparam TRIANGLE_BEATS = (TRIANGLE_SIZE * PARAMETER_WIDTH) / CMD_STREAM_WIDTH;
+
+    // Setup state machine
+    localparam SETUP_IDLE = 0;
+    localparam SETUP_COPY = 1;
+    localparam SETUP_EDGE = 2;
+    localparam SETUP_SIGN = 3;
+    localparam SETUP_DIV = 4;
+    localparam SETUP_NORM = 5;
+    localparam SETUP_INTERPOLATE = 6;
+    localparam SETUP_OUT = 7;
+    localparam SETUP_FLUSH = 8;
+
+    // Triangle data
+    reg  [PARAMETER_WIDTH - 1 : 0]          inMem [0 : COMPACT_TRIANGLE_SIZE - 1];
+    reg  [PARAMETER_WIDTH - 1 : 0]          outMem [0 : TRIANGLE_SIZE - 1];
+    reg  signed [PARAMETER_WIDTH - 1 : 0]   norm [0 : 8]; // Normalized edge functions and increments, Sn.22
+    reg  signed [PARAMETER_WIDTH - 1 : 0]   area; // Sn.4
+    reg  [PARAMETER_WIDTH - 1 : 0]          areaInv; // Sn.24
+    reg  [PARAMETER_WIDTH : 0]              divRemainder;
+    reg  [4 : 0]                            paramIndex;
+    reg                                     parameterComplete;
+    reg  [15 : 0]                           parameterLow;
+
+    // Setup variables
+    reg  [3 : 0]                            state;
+    reg  [3 : 0]                            cnt;
+    reg  [1 : 0]                            term;
+    reg  [1 : 0]                            phase;
+    reg  [5 : 0]                            outBeat;
+
+    // Shared multiplier
+    reg  signed [31 : 0]                    mulA;
+    reg  signed [31 : 0]                    mulB;
+    reg  signed [63 : 0]                    prod;
+    reg  signed [63 : 0]                    acc;
+
+    // Output stream
+    reg                                     outValid;
+    reg                                     outLast;
+    reg  [CMD_STREAM_WIDTH - 1 : 0]         outData;
+
+    // The stream is passed through when no compact triangle is received
+    wire passthrough = (state == SETUP_IDLE) && !s_axis_tuser;
+    assign s_axis_tready = (state == SETUP_IDLE) ? m_axis_tready : (state == SETUP_COPY);
+    assign m_axis_tvalid = passthrough ? s_axis_tvalid : outValid;
+    assign m_axis_tlast = passthrough ? s_axis_tlast : outLast;
+    assign m_axis_tdata = passthrough ? s_axis_tdata : outData;
+
+    // Vertices and the start of the bounding box (S13.2)
+    wire signed [31 : 0] v0x = {{16{inMem[COMPACT_V0][15]}}, inMem[COMPACT_V0][0 +: 16]};
+    wire signed [31 : 0] v0y = {{16{inMem[COMPACT_V0][31]}}, inMem[COMPACT_V0][16 +: 16]};
+    wire signed [31 : 0] v1x = {{16{inMem[COMPACT_V1][15]}}, inMem[COMPACT_V1][0 +: 16]};
+    wire signed [31 : 0] v1y = {{16{inMem[COMPACT_V1][31]}}, inMem[COMPACT_V1][16 +: 16]};
+    wire signed [31 : 0] v2x = {{16{inMem[COMPACT_V2][15]}}, inMem[COMPACT_V2][0 +: 16]};
+    wire signed [31 : 0] v2y = {{16{inMem[COMPACT_V2][31]}}, inMem[COMPACT_V2][16 +: 16]};
+    wire signed [31 : 0] px = {{14{inMem[COMPACT_BB_START][BB_X_POS + 15]}}, inMem[COMPACT_BB_START][BB_X_POS +: 16], 2'b0};
+    wire signed [31 : 0] py = {{14{inMem[COMPACT_BB_START][BB_Y_POS + 15]}}, inMem[COMPACT_BB_START][BB_Y_POS +: 16], 2'b0};
+
+    // Edge function edge(a, b, c) = (c.x - a.x) * (b.y - a.y) - (c.y - a.y) * (b.x - a.x)
+    // cnt 0: edge(v1, v2, p), cnt 1: edge(v2, v0, p), cnt 2: edge(v0, v1, p), cnt 3: edge(v0, v1, v2) (area)
+    reg  signed [31 : 0] edgeAX;
+    reg  signed [31 : 0] edgeAY;
+    reg  signed [31 : 0] edgeBX;
+    reg  signed [31 : 0] edgeBY;
+    always @(*)
+    begin
+        case (cnt[1 : 0])
+        2'd0:
+        begin
+            edgeAX = v1x; edgeAY = v1y; edgeBX = v2x; edgeBY = v2y;
+        end
+        2'd1:
+        begin
+            edgeAX = v2x; edgeAY = v2y; edgeBX = v0x; edgeBY = v0y;
+        end
+        default:
+        begin
+            edgeAX = v0x; edgeAY = v0y; edgeBX = v1x; edgeBY = v1y;
+        end
+        endcase
+    end
+    wire signed [31 : 0] edgeCX = (cnt == 3) ? v2x : px;
+    wire signed [31 : 0] edgeCY = (cnt == 3) ? v2y : py;
+
+    // Attributes for the dot products
+    // cnt 0 - 5: S, T with the normalized edge functions, x increments and y increments. cnt 6 - 8: W with the same.
+    wire [4 : 0] attrIndex = ((cnt < 6) ? (cnt[0] ? COMPACT_TEX_T0 : COMPACT_TEX_S0) : COMPACT_DEPTH_W0) + term;
+    wire [3 : 0] normIndex = ((cnt < 6) ? (cnt[2 : 1] * 3) : ((cnt - 6) * 3)) + term;
+    wire [5 : 0] attrShift = (cnt < 6) ? 19 : 22;
+
+    always @(posedge clk)
+    begin
+        if (reset)
+        begin
+            state <= SETUP_IDLE;
+            paramIndex <= 0;
+            parameterComplete <= 0;
+            outValid <= 0;
+            outLast <= 0;
+        end
+        else
+        begin
+            case (state)
+            SETUP_IDLE, SETUP_COPY:
+            begin : SetupCopy
+                integer i;
+                if (s_axis_tvalid && s_axis_tuser)
+                begin
+                    state <= SETUP_COPY;
+                    if (CMD_STREAM_WIDTH == 16)
+                    begin
+                        // Build 32 bit parameter from 16 bit axi stream
+                        parameterComplete <= !parameterComplete;
+                        if (parameterComplete)
+                        begin
+                            inMem[paramIndex] <= {s_axis_tdata[0 +: 16], parameterLow};
+                            paramIndex <= paramIndex + 1;
+                        end
+                        else
+                        begin
+                            parameterLow <= s_axis_tdata[0 +: 16];
+                        end
+                    end
+                    else
+                    begin
+                        for (i = 0; i < PARAMETERS_PER_STREAM_BEAT; i = i + 1)
+                        begin
+                            inMem[paramIndex + i[0 +: 5]] <= s_axis_tdata[PARAMETER_WIDTH * i +: PARAMETER_WIDTH];
+                        end
+                        paramIndex <= paramIndex + PARAMETERS_PER_STREAM_BEAT[0 +: 5];
+                    end
+
+                    if (s_axis_tlast)
+                    begin
+                        paramIndex <= 0;
+                        parameterComplete <= 0;
+                        cnt <= 0;
+                        term <= 0;
+                        phase <= 0;
+                        state <= SETUP_EDGE;
+                    end
+                end
+            end
+            SETUP_EDGE:
+            begin
+                // Calculates the edge functions at the start of the bounding box and the area. Each edge function requires two products.
+                case (phase)
+                0:
+                begin
+                    mulA <= (term == 0) ? (edgeCX - edgeAX) : (edgeCY - edgeAY);
+                    mulB <= (term == 0) ? (edgeBY - edgeAY) : (edgeBX - edgeAX);
+                    phase <= 1;
+                end
+                1:
+                begin
+                    prod <= mulA * mulB;
+                    phase <= 2;
+                end
+                default:
+                begin
+                    phase <= 0;
+                    if (term == 0)
+                    begin
+                        acc <= prod;
+                        term <= 1;
+                    end
+                    else
+                    begin
+                        // The driver calculates the edge functions with 32 bit, so just use the lower 32 bits
+                        if (cnt == 3)
+                        begin
+                            area <= acc[0 +: 32] - prod[0 +: 32];
+                            state <= SETUP_SIGN;
+                        end
+                        else
+                        begin
+                            outMem[INC_W0 + cnt] <= acc[0 +: 32] - prod[0 +: 32];
+                        end
+                        term <= 0;
+                        cnt <= cnt + 1;
+                    end
+                end
+                endcase
+            end
+            SETUP_SIGN:
+            begin : SetupSign
+                integer k;
+                // The increments are the derivations of the edge functions. A step of one pixel is a step of 4 in S13.2.
+                if (area <= 0)
+                begin
+                    area <= -area;
+                    for (k = 0; k < 3; k = k + 1)
+                    begin
+                        outMem[INC_W0 + k] <= -outMem[INC_W0 + k];
+                    end
+                    outMem[INC_W0_X] <= -((v2y - v1y) <<< 2);
+                    outMem[INC_W1_X] <= -((v0y - v2y) <<< 2);
+                    outMem[INC_W2_X] <= -((v1y - v0y) <<< 2);
+                    outMem[INC_W0_Y] <= (v2x - v1x) <<< 2;
+                    outMem[INC_W1_Y] <= (v0x - v2x) <<< 2;
+                    outMem[INC_W2_Y] <= (v1x - v0x) <<< 2;
+                end
+                else
+                begin
+                    outMem[INC_W0_X] <= (v2y - v1y) <<< 2;
+                    outMem[INC_W1_X] <= (v0y - v2y) <<< 2;
+                    outMem[INC_W2_X] <= (v1y - v0y) <<< 2;
+                    outMem[INC_W0_Y] <= -((v2x - v1x) <<< 2);
+                    outMem[INC_W1_Y] <= -((v0x - v2x) <<< 2);
+                    outMem[INC_W2_Y] <= -((v1x - v0x) <<< 2);
+                end
+                outMem[TRIANGLE_CONFIGURATION] <= inMem[COMPACT_TRIANGLE_CONFIGURATION];
+                outMem[BB_START] <= inMem[COMPACT_BB_START];
+                outMem[BB_END] <= inMem[COMPACT_BB_END];
+                divRemainder <= 0;
+                areaInv <= 0;
+                cnt <= 0;
+                state <= SETUP_DIV;
+            end
+            SETUP_DIV:
+            begin : SetupDiv
+                reg [PARAMETER_WIDTH : 0] remainder;
+                // Restoring division: areaInv = (1 << 48) / area >> 20 = (1 << 28) / area (Sn.24)
+                remainder = {divRemainder[0 +: PARAMETER_WIDTH], ({term, cnt} == 0)};
+                if (remainder >= {1'b0, area})
+                begin
+                    divRemainder <= remainder - {1'b0, area};
+                    areaInv <= {areaInv[0 +: PARAMETER_WIDTH - 1], 1'b1};
+                end
+                else
+                begin
+                    divRemainder <= remainder;
+                    areaInv <= {areaInv[0 +: PARAMETER_WIDTH - 1], 1'b0};
+                end
+                // 29 bits are required for the quotient. cnt is 4 bits wide, use the term as additional bit.
+                {term, cnt} <= {term, cnt} + 1;
+                if ({term, cnt} == 28)
+                begin
+                    cnt <= 0;
+                    term <= 0;
+                    phase <= 0;
+                    state <= SETUP_NORM;
+                end
+            end
+            SETUP_NORM:
+            begin
+                // Normalize the edge functions and the increments with the area (Sn.4 * Sn.24 >> 6 = Sn.22)
+                case (phase)
+                0:
+                begin
+                    mulA <= outMem[INC_W0 + cnt];
+                    mulB <= areaInv;
+                    phase <= 1;
+                end
+                1:
+                begin
+                    prod <= mulA * mulB;
+                    phase <= 2;
+                end
+                default:
+                begin
+                    phase <= 0;
+                    norm[cnt] <= prod[6 +: 32];
+                    cnt <= cnt + 1;
+                    if (cnt == 8)
+                    begin
+                        cnt <= 0;
+                        state <= SETUP_INTERPOLATE;
+                    end
+                end
+                endcase
+            end
+            SETUP_INTERPOLATE:
+            begin
+                // Interpolate the texture coordinates (Sn.27 * Sn.22 = Sn.49 >> 19 = Sn.30) and W (Sn.30 * Sn.22 = Sn.52 >> 22 = Sn.30)
+                case (phase)
+                0:
+                begin
+                    mulA <= inMem[attrIndex];
+                    mulB <= norm[normIndex];
+                    phase <= 1;
+                end
+                1:
+                begin
+                    prod <= mulA * mulB;
+                    phase <= 2;
+                end
+                default:
+                begin : Accumulate
+                    reg signed [63 : 0] sum;
+                    sum = (term == 0) ? prod : acc + prod;
+                    acc <= sum;
+                    phase <= 0;
+                    term <= term + 1;
+                    if (term == 2)
+                    begin
+                        term <= 0;
+                        outMem[INC_TEX_S + cnt] <= sum[attrShift +: 32];
+                        cnt <= cnt + 1;
+                        if (cnt == 8)
+                        begin
+                            outBeat <= 0;
+                            state <= SETUP_OUT;
+                        end
+                    end
+                end
+                endcase
+            end
+            SETUP_OUT:
+            begin : SetupOut
+                integer i;
+                if (m_axis_tready)
+                begin
+                    outValid <= 1;
+                    if (CMD_STREAM_WIDTH == 16)
+                    begin
+                        outData <= outMem[outBeat[1 +: 5]][outBeat[0] * 16 +: 16];
+                    end
+                    else
+                    begin
+                        for (i = 0; i < PARAMETERS_PER_STREAM_BEAT; i = i + 1)
+                        begin
+                            outData[PARAMETER_WIDTH * i +: PARAMETER_WIDTH] <= outMem[(outBeat * PARAMETERS_PER_STREAM_BEAT) + i];
+                        end
+                    end
+                    outBeat <= outBeat + 1;
+                    if (outBeat == (TRIANGLE_BEATS - 1))
+                    begin
+                        outLast <= 1;
+                        state <= SETUP_FLUSH;
+                    end
+                end
+            end
+            SETUP_FLUSH:
+            begin
+                // Wait till the last beat is received by the Rasterizer
+                if (m_axis_tready)
+                begin
+                    outValid <= 0;
+                    outLast <= 0;
+                    state <= SETUP_IDLE;
+                end
+            end
+            default:
+            begin
+                state <= SETUP_IDLE;
+            end
+            endcase
+        end
+    end
+endmodule
@@ -33,7 +33,12 @@ module top #(
     output wire         m_framebuffer_axis_tvalid,
     input  wire         m_framebuffer_axis_tready,
     output wire         m_framebuffer_axis_tlast,
-    output wire [FRAMEBUFFER_STREAM_WIDTH - 1 : 0]  m_framebuffer_axis_tdata
+    output wire [FRAMEBUFFER_STREAM_WIDTH - 1 : 0]  m_framebuffer_axis_tdata,
+
+    // Performance counters
+    input  wire         perfCounterClear,
+    input  wire [ 2:0]  perfCounterSelect,
+    output wire [31:0]  perfCounterValue
 );
     parameter X_RESOLUTION = `X_RESOLUTION;
     parameter Y_RESOLUTION = `Y_RESOLUTION;
@@ -45,7 +50,12 @@ module top #(
                  .Y_LINE_RESOLUTION(Y_LINE_RESOLUTION),
                  .CMD_STREAM_WIDTH(CMD_STREAM_WIDTH),
                  .FRAMEBUFFER_STREAM_WIDTH(FRAMEBUFFER_STREAM_WIDTH),
-                 .TEXTURE_BUFFER_SIZE(TEXTURE_BUFFER_SIZE)) rasteriCEr(
+                 .TEXTURE_BUFFER_SIZE(TEXTURE_BUFFER_SIZE),
+                 .ENABLE_TRIANGLE_SETUP(1),
+                 .ENABLE_PERFORMANCE_COUNTERS(1),
+                 .ENABLE_HIERARCHICAL_DEPTH(1),
+                 .ENABLE_SHADED_WALK_OUT(1),
+                 .ENABLE_FAST_CLEAR(1)) rasteriCEr(
         .aclk(aclk),
         .resetn(resetn),
         
@@ -58,9 +68,18 @@ module top #(
         .m_framebuffer_axis_tready(m_framebuffer_axis_tready),
         .m_framebuffer_axis_tlast(m_framebuffer_axis_tlast),
         .m_framebuffer_axis_tdata(m_framebuffer_axis_tdata),
+        .commitWindowXStart(),
+        .commitWindowXEnd(),
+        .commitWindowYStart(),
+        .commitWindowYEnd(),
+        .commitWindowLineY(),
 
         // Debug
         .dbgStreamState(),
-        .dbgRasterizerRunning()
+        .dbgRasterizerRunning(),
+
+        .perfCounterClear(perfCounterClear),
+        .perfCounterSelect(perfCounterSelect),
+        .perfCounterValue(perfCounterValue)
     );
 endmodule
\ No newline at end of file
@@ -17,10 +17,13 @@ read_verilog ./top.v
 read_verilog ./../../RasteriCEr/DualPortRam.v
 read_verilog ./../../RasteriCEr/FrameBuffer.v
 read_verilog ./../../RasteriCEr/Rasterizer.v
+read_verilog ./../../RasteriCEr/TriangleSetup.v
 read_verilog ./../../RasteriCEr/RasteriCEr.v
 read_verilog ./../../RasteriCEr/FragmentPipeline.v
 read_verilog ./../../RasteriCEr/FragmentPipelineIce40Wrapper.v
 read_verilog ./../../RasteriCEr/CommandParser.v
+read_verilog ./../../RasteriCEr/PerformanceCounters.v
+read_verilog ./../../RasteriCEr/HierarchicalDepthBuffer.v
 read_verilog ./../../RasteriCEr/Serial2AXIS.v
 read_verilog ./../../RasteriCEr/Recip.v
 read_verilog ./../../RasteriCEr/TextureBuffer.v
@@ -74,6 +74,11 @@ module top
     wire        m_framebuffer_axis_tready;
     wire        m_framebuffer_axis_tlast;
     wire [15:0] m_framebuffer_axis_tdata;
+    wire [15:0] commitWindowXStart;
+    wire [15:0] commitWindowXEnd;
+    wire [15:0] commitWindowYStart;
+    wire [15:0] commitWindowYEnd;
+    wire [15:0] commitWindowLineY;
 
     // AXI Stream command interface
     wire        s_cmd_axis_tvalid;
@@ -102,9 +107,17 @@ module top
         .s_axis_tlast(m_framebuffer_axis_tlast),
         .s_axis_tdata(m_framebuffer_axis_tdata),
 
+        .windowXStart(commitWindowXStart),
+        .windowXEnd(commitWindowXEnd),
+        .windowYStart(commitWindowYStart),
+        .windowYEnd(commitWindowYEnd),
+        .windowLineY(commitWindowLineY),
+
         .transferRunning(transferRunning)
     );
     defparam lcd.PIXEL = X_RESOLUTION * Y_LINE_RESOLUTION;
+    defparam lcd.X_RESOLUTION = X_RESOLUTION;
+    defparam lcd.ENABLE_COMMIT_WINDOW = 0; // Requires a driver which is build with RENDERER_DIRTY_WINDOW
     defparam lcd.CLOCK_DIV = 2; // Caution, normally the SPI displays work with a maximum frequency of 15.5 MHz. 
                                 // A CLOCK_DIV of 2 means that the 90MHz clock is divided by four which results in a frequency of 22.5 MHz.
 
@@ -112,7 +125,11 @@ module top
                  .Y_RESOLUTION(Y_RESOLUTION),
                  .Y_LINE_RESOLUTION(Y_LINE_RESOLUTION),
                  .CMD_STREAM_WIDTH(CMD_STREAM_WIDTH),
-                 .TEXTURE_BUFFER_SIZE(TEXTURE_BUFFER_SIZE)) rasteriCEr(
+                 .TEXTURE_BUFFER_SIZE(TEXTURE_BUFFER_SIZE),
+                 .ENABLE_TRIANGLE_SETUP(1),
+                 .ENABLE_HIERARCHICAL_DEPTH(1),
+                 .ENABLE_SHADED_WALK_OUT(1),
+                 .ENABLE_FAST_CLEAR(1)) rasteriCEr(
 
         .aclk(clk),
         .resetn(resetn),
@@ -128,11 +145,20 @@ module top
         .m_framebuffer_axis_tready(m_framebuffer_axis_tready),
         .m_framebuffer_axis_tlast(m_framebuffer_axis_tlast),
         .m_framebuffer_axis_tdata(m_framebuffer_axis_tdata),
+        .commitWindowXStart(commitWindowXStart),
+        .commitWindowXEnd(commitWindowXEnd),
+        .commitWindowYStart(commitWindowYStart),
+        .commitWindowYEnd(commitWindowYEnd),
+        .commitWindowLineY(commitWindowLineY),
 
         // Debug
         .dbgStreamState(),
         // .dbgStreamState({dbgStreamingState3, dbgStreamingState2, dbgStreamingState1, dbgStreamingState0}),
-        .dbgRasterizerRunning()
+        .dbgRasterizerRunning(),
+
+        .perfCounterClear(1'b0),
+        .perfCounterSelect(3'b0),
+        .perfCounterValue()
     );
 
     Serial2AXIS serial2axis(
@@ -151,6 +177,8 @@ module top
         .m_axis_tlast(s_cmd_axis_tlast),
         .m_axis_tdata(s_cmd_axis_tdata)
     );
+    defparam serial2axis.CHUNK_SIZE = 2048; // Must match the HARDWARE_BUFFER_SIZE of the driver
+    defparam serial2axis.SERIAL_LANES = 1; // 4 for a quad SPI host, serial_mosi then has to be extended to four pins
 
     always @(posedge clk)
     begin
@@ -71,6 +71,11 @@ module top
     wire        m_framebuffer_axis_tready;
     wire        m_framebuffer_axis_tlast;
     wire [15:0] m_framebuffer_axis_tdata;
+    wire [15:0] commitWindowXStart;
+    wire [15:0] commitWindowXEnd;
+    wire [15:0] commitWindowYStart;
+    wire [15:0] commitWindowYEnd;
+    wire [15:0] commitWindowLineY;
 
     // AXI Stream command interface
     wire        s_cmd_axis_tvalid;
@@ -99,11 +104,19 @@ module top
         .s_axis_tlast(m_framebuffer_axis_tlast),
         .s_axis_tdata(m_framebuffer_axis_tdata),
 
+        .windowXStart(commitWindowXStart),
+        .windowXEnd(commitWindowXEnd),
+        .windowYStart(commitWindowYStart),
+        .windowYEnd(commitWindowYEnd),
+        .windowLineY(commitWindowLineY),
+
         .transferRunning(transferRunning)
     );
     defparam lcd.CLOCK_DIV = 0; // Caution, normally the SPI displays work with a maximum frequency of 15.5 MHz. 
                                 // A CLOCK_DIV of 0 means, that we increase the clock to 24MHz.
     defparam lcd.PIXEL = X_RESOLUTION * Y_LINE_RESOLUTION;
+    defparam lcd.X_RESOLUTION = X_RESOLUTION;
+    defparam lcd.ENABLE_COMMIT_WINDOW = 0; // Requires a driver which is build with RENDERER_DIRTY_WINDOW
 
     RasteriCEr #(.X_RESOLUTION(X_RESOLUTION),
                  .Y_RESOLUTION(Y_RESOLUTION),
@@ -125,11 +138,20 @@ module top
         .m_framebuffer_axis_tready(m_framebuffer_axis_tready),
         .m_framebuffer_axis_tlast(m_framebuffer_axis_tlast),
         .m_framebuffer_axis_tdata(m_framebuffer_axis_tdata),
+        .commitWindowXStart(commitWindowXStart),
+        .commitWindowXEnd(commitWindowXEnd),
+        .commitWindowYStart(commitWindowYStart),
+        .commitWindowYEnd(commitWindowYEnd),
+        .commitWindowLineY(commitWindowLineY),
 
         // Debug
         .dbgStreamState(),
         // .dbgStreamState({dbgStreamingState3, dbgStreamingState2, dbgStreamingState1, dbgStreamingState0}),
-        .dbgRasterizerRunning()
+        .dbgRasterizerRunning(),
+
+        .perfCounterClear(1'b0),
+        .perfCounterSelect(3'b0),
+        .perfCounterValue()
     );
 
     Serial2AXIS serial2axis(
@@ -148,6 +170,8 @@ module top
         .m_axis_tlast(s_cmd_axis_tlast),
         .m_axis_tdata(s_cmd_axis_tdata)
     );
+    defparam serial2axis.CHUNK_SIZE = 2048; // Must match the HARDWARE_BUFFER_SIZE of the driver
+    defparam serial2axis.SERIAL_LANES = 1; // 4 for a quad SPI host, serial_mosi then has to be extended to four pins
 
     always @(posedge clk)
     begin
@@ -0,0 +1,580 @@
+// RasteriCEr
+// https://github.com/ToNi3141/RasteriCEr
+// Copyright (c) 2021 ToNi3141
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Headless benchmark of the driver and the RTL (Verilator model). It renders a set of scenes through
+// IceGL / Renderer and the Verilator model and prints one JSON object per scene to stdout:
+//   {"scene": "cube", "renderer": "Renderer", "frames": 10, "geometry_us": ..., "upload_us": ..., "simulation_us": ...,
+//    "bus_bytes": ..., "aclk_cycles": ..., "stall_cycles": ..., "eliminated_reg_writes": ..., "culled_triangles": ...}
+// All values except frames are averages per frame. geometry_us is the host CPU time of the GL calls (TnL, rasterizer
+// setup, display list), upload_us the time of commit() without the simulation and simulation_us the time of the model.
+// stall_cycles are the aclk cycles where the driver had data, but s_cmd_axis_tready was low.
+// The upload is pipelined: The data of a frame is mostly sent during the commit() of the next frame. The values are
+// therefore only accurate as an average over many frames.
+//
+// Usage:
+//   benchmark [--scene <name>] [--frames <n>] [--record <file>] [--no-sim]
+//      Renders all scenes (or the given one). --record writes the byte stream of the rendered scene into a trace
+//      file (requires --scene). --no-sim measures only the driver, the data is then discarded.
+//   benchmark --replay <file>
+//      Sends a recorded trace to the Verilator model without the driver. Reports the simulation values of the trace.
+// Define RENDERER_BUCKETS to benchmark the RendererBuckets instead of the Renderer.
+// Define BENCHMARK_NO_VERILATOR to build the benchmark without Verilator (make benchmark_host). It then always measures
+// only the driver like with --no-sim, and --replay is not available.
+
+#ifndef BENCHMARK_NO_VERILATOR
+#include <verilated.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "IceGL.hpp"
+#include "Renderer.hpp"
+#include "RendererBuckets.hpp"
+#ifndef BENCHMARK_NO_VERILATOR
+#include "VerilatorBusConnector.hpp"
+#endif
+#include "TraceBusConnector.hpp"
+
+#ifndef BENCHMARK_NO_VERILATOR
+// Required by older Verilator versions
+double sc_time_stamp()
+{
+    return 0;
+}
+
+using Simulation = VerilatorBusConnector<uint64_t>;
+#else
+// Replaces the Verilator model in the host only build. It is never created, because the benchmark always runs like
+// with --no-sim.
+class Simulation : public IBusConnector
+{
+public:
+    struct Statistics
+    {
+        uint64_t cycles = 0;
+        uint64_t stallCycles = 0;
+        uint64_t bytes = 0;
+    };
+
+    Simulation(uint64_t*, const uint16_t, const uint16_t) {}
+    virtual void writeData(const uint8_t*, const uint32_t) override {}
+    virtual bool clearToSend() override { return true; }
+    virtual void startColorBufferTransfer(const uint8_t, const Window&) override {}
+    void waitForIdle() {}
+    const Statistics& getStatistics() const { return m_statistics; }
+    void resetStatistics() {}
+
+private:
+    Statistics m_statistics;
+};
+#endif
+
+static constexpr uint32_t RESOLUTION_W = 640;
+static constexpr uint32_t RESOLUTION_H = 480;
+static constexpr uint32_t DISPLAY_LINES = 4; // Must match with the Y_LINE_RESOLUTION of rtl/top/Verilator/Makefile
+
+using Clock = std::chrono::steady_clock;
+
+static uint64_t elapsedUs(const Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+}
+
+// Measures the time which is spent in the target connector (the simulation)
+class TimedBusConnector : public IBusConnector
+{
+public:
+    TimedBusConnector(IBusConnector* target)
+        : m_target(target)
+    {
+    }
+
+    virtual void writeData(const uint8_t* data, const uint32_t bytes) override
+    {
+        if (m_target)
+        {
+            const Clock::time_point start = Clock::now();
+            m_target->writeData(data, bytes);
+            m_us += elapsedUs(start);
+        }
+    }
+
+    virtual bool clearToSend() override
+    {
+        return m_target ? m_target->clearToSend() : true;
+    }
+
+    virtual void startColorBufferTransfer(const uint8_t index, const Window& window) override
+    {
+        if (m_target)
+        {
+            m_target->startColorBufferTransfer(index, window);
+        }
+    }
+
+    uint64_t getUs() const { return m_us; }
+
+private:
+    IBusConnector* m_target = nullptr;
+    uint64_t m_us = 0;
+};
+
+// A scene creates its resources in init() and renders one frame in draw()
+class Scene
+{
+public:
+    virtual ~Scene() = default;
+    virtual const char* name() const = 0;
+    virtual void init(IceGL& gl) = 0;
+    virtual void draw(IceGL& gl, const uint32_t frame) = 0;
+
+protected:
+    static GLuint createCheckerTexture(IceGL& gl, const uint32_t size, const uint8_t* color0, const uint8_t* color1)
+    {
+        std::vector<uint8_t> pixels(size * size * 3);
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                const uint8_t* color = (((x / 4) ^ (y / 4)) & 0x1) ? color1 : color0;
+                memcpy(&pixels[((y * size) + x) * 3], color, 3);
+            }
+        }
+        GLuint textureId;
+        gl.glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        gl.glGenTextures(1, &textureId);
+        gl.glBindTexture(GL_TEXTURE_2D, textureId);
+        gl.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+        return textureId;
+    }
+};
+
+// The rotating and lit cube of the arduino example and the qtRasterizer
+class CubeScene : public Scene
+{
+public:
+    virtual const char* name() const override { return "cube"; }
+
+    virtual void init(IceGL& gl) override
+    {
+        static constexpr uint8_t color0[3] = {0xc0, 0x80, 0x40};
+        static constexpr uint8_t color1[3] = {0x40, 0x80, 0xc0};
+        m_textureId = createCheckerTexture(gl, 32, color0, color1);
+
+        gl.glViewport(0, 0, RESOLUTION_W, RESOLUTION_H);
+        gl.glDepthRange(0.0, 1.0);
+        gl.glMatrixMode(GL_PROJECTION);
+        gl.glLoadIdentity();
+        gl.gluPerspective(30.0, (float)RESOLUTION_W / (float)RESOLUTION_H, 1.0, 111.0);
+        gl.glEnable(GL_DEPTH_TEST);
+        gl.glDepthMask(GL_TRUE);
+        gl.glEnable(GL_CULL_FACE);
+        gl.glCullFace(GL_BACK);
+
+        static constexpr GLfloat lightAmbient[] = { 0.5, 0.5, 0.5, 0.0 };
+        static constexpr GLfloat lightDiffuse[] = { 0.5, 0.5, 0.5, 1.0 };
+        static constexpr GLfloat lightSpecular[] = { 1.0, 1.0, 1.0, 1.0 };
+        static constexpr GLfloat lightPosition[] = { 0.0, 3.0, 2.0, 0.0 };
+        gl.glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, 8.0f);
+        gl.glLightfv(GL_LIGHT0, GL_AMBIENT, lightAmbient);
+        gl.glLightfv(GL_LIGHT0, GL_DIFFUSE, lightDiffuse);
+        gl.glLightfv(GL_LIGHT0, GL_SPECULAR, lightSpecular);
+        gl.glLightfv(GL_LIGHT0, GL_POSITION, lightPosition);
+        gl.glEnable(GL_LIGHT0);
+        gl.glEnable(GL_LIGHTING);
+        gl.glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    }
+
+    virtual void draw(IceGL& gl, const uint32_t frame) override
+    {
+        static constexpr uint16_t cubeIndex[] = {
+            0, 1, 2, 0, 2, 3,
+            4, 5, 6, 4, 6, 7,
+            8, 9, 10, 8, 10, 11,
+            12, 13, 14, 12, 14, 15,
+            16, 17, 18, 16, 18, 19,
+            20, 21, 22, 20, 22, 23
+        };
+        static constexpr float cubeVerts[] = {
+            -1.0f, 1.0f, 1.0f,   -1.0f,-1.0f, 1.0f,    1.0f,-1.0f, 1.0f,    1.0f, 1.0f, 1.0f,
+            -1.0f, 1.0f,-1.0f,   -1.0f,-1.0f,-1.0f,   -1.0f,-1.0f, 1.0f,   -1.0f, 1.0f, 1.0f,
+             1.0f, 1.0f, 1.0f,    1.0f,-1.0f, 1.0f,    1.0f,-1.0f,-1.0f,    1.0f, 1.0f,-1.0f,
+            -1.0f, 1.0f,-1.0f,   -1.0f, 1.0f, 1.0f,    1.0f, 1.0f, 1.0f,    1.0f, 1.0f,-1.0f,
+            -1.0f,-1.0f, 1.0f,   -1.0f,-1.0f,-1.0f,    1.0f,-1.0f,-1.0f,    1.0f,-1.0f, 1.0f,
+             1.0f, 1.0f,-1.0f,    1.0f,-1.0f,-1.0f,   -1.0f,-1.0f,-1.0f,   -1.0f, 1.0f,-1.0f,
+        };
+        static constexpr float cubeTexCoords[] = {
+            0.0f, 1.0f,   0.0f, 0.0f,   1.0f, 0.0f,   1.0f, 1.0f,
+            1.0f, 0.0f,   0.0f, 0.0f,   0.0f, 1.0f,   1.0f, 1.0f,
+            1.0f, 1.0f,   0.0f, 1.0f,   0.0f, 0.0f,   1.0f, 0.0f,
+            0.0f, 0.0f,   0.0f, 1.0f,   1.0f, 1.0f,   1.0f, 0.0f,
+            0.0f, 1.0f,   0.0f, 0.0f,   1.0f, 0.0f,   1.0f, 1.0f,
+            1.0f, 1.0f,   1.0f, 0.0f,   0.0f, 0.0f,   0.0f, 1.0f,
+        };
+        static constexpr float cubeNormals[] = {
+             0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 1.0f,
+            -1.0f, 0.0f, 0.0f,   -1.0f, 0.0f, 0.0f,   -1.0f, 0.0f, 0.0f,   -1.0f, 0.0f, 0.0f,
+             1.0f, 0.0f, 0.0f,    1.0f, 0.0f, 0.0f,    1.0f, 0.0f, 0.0f,    1.0f, 0.0f, 0.0f,
+             0.0f, 1.0f, 0.0f,    0.0f, 1.0f, 0.0f,    0.0f, 1.0f, 0.0f,    0.0f, 1.0f, 0.0f,
+             0.0f,-1.0f, 0.0f,    0.0f,-1.0f, 0.0f,    0.0f,-1.0f, 0.0f,    0.0f,-1.0f, 0.0f,
+             0.0f, 0.0f,-1.0f,    0.0f, 0.0f,-1.0f,    0.0f, 0.0f,-1.0f,    0.0f, 0.0f,-1.0f,
+        };
+
+        gl.glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        gl.glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        gl.glMatrixMode(GL_MODELVIEW);
+        gl.glLoadIdentity();
+        gl.gluLookAt(12.0f, -2.0f, 5.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+        gl.glRotatef(frame * 5.0f, 0.0f, 0.0f, 1.0f);
+        gl.glScalef(1.5f, 1.5f, 1.5f);
+
+        gl.glEnable(GL_TEXTURE_2D);
+        gl.glBindTexture(GL_TEXTURE_2D, m_textureId);
+        gl.glEnableClientState(GL_VERTEX_ARRAY);
+        gl.glEnableClientState(GL_NORMAL_ARRAY);
+        gl.glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        gl.glVertexPointer(3, GL_FLOAT, 0, cubeVerts);
+        gl.glTexCoordPointer(2, GL_FLOAT, 0, cubeTexCoords);
+        gl.glNormalPointer(GL_FLOAT, 0, cubeNormals);
+        gl.glDrawElements(GL_TRIANGLES, sizeof(cubeIndex) / sizeof(cubeIndex[0]), GL_UNSIGNED_SHORT, cubeIndex);
+    }
+
+private:
+    GLuint m_textureId = 0;
+};
+
+// A landscape like in tuxracer: A big indexed mesh which alternates between two textures (ice and snow)
+// and covers the whole screen
+class TerrainScene : public Scene
+{
+public:
+    virtual const char* name() const override { return "terrain"; }
+
+    virtual void init(IceGL& gl) override
+    {
+        static constexpr uint8_t snow0[3] = {0xf0, 0xf0, 0xff};
+        static constexpr uint8_t snow1[3] = {0xd0, 0xd0, 0xe0};
+        static constexpr uint8_t ice0[3] = {0x80, 0xc0, 0xff};
+        static constexpr uint8_t ice1[3] = {0x60, 0xa0, 0xe0};
+        m_snowTextureId = createCheckerTexture(gl, 64, snow0, snow1);
+        m_iceTextureId = createCheckerTexture(gl, 64, ice0, ice1);
+
+        // Interleaved float3 position and float2 texture coordinates
+        for (uint32_t y = 0; y <= GRID; y++)
+        {
+            for (uint32_t x = 0; x <= GRID; x++)
+            {
+                const float fx = (static_cast<float>(x) / GRID) * 40.0f - 20.0f;
+                const float fy = (static_cast<float>(y) / GRID) * 80.0f;
+                const float fz = sinf(fx * 0.3f) * cosf(fy * 0.2f) * 1.5f;
+                m_vertices.insert(m_vertices.end(), {fx, fy, fz, x * 0.5f, y * 0.5f});
+            }
+        }
+        // Every band of rows uses another texture
+        m_indices.resize(BANDS);
+        for (uint32_t y = 0; y < GRID; y++)
+        {
+            std::vector<uint16_t>& indices = m_indices[(y / (GRID / BANDS)) % BANDS];
+            for (uint32_t x = 0; x < GRID; x++)
+            {
+                const uint16_t i = (y * (GRID + 1)) + x;
+                indices.insert(indices.end(), {i, static_cast<uint16_t>(i + 1), static_cast<uint16_t>(i + GRID + 1),
+                                               static_cast<uint16_t>(i + 1), static_cast<uint16_t>(i + GRID + 2), static_cast<uint16_t>(i + GRID + 1)});
+            }
+        }
+
+        gl.glViewport(0, 0, RESOLUTION_W, RESOLUTION_H);
+        gl.glMatrixMode(GL_PROJECTION);
+        gl.glLoadIdentity();
+        gl.gluPerspective(50.0, (float)RESOLUTION_W / (float)RESOLUTION_H, 0.5, 100.0);
+        gl.glEnable(GL_DEPTH_TEST);
+        gl.glDepthMask(GL_TRUE);
+        gl.glDisable(GL_LIGHTING);
+        gl.glDisable(GL_CULL_FACE);
+        gl.glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    }
+
+    virtual void draw(IceGL& gl, const uint32_t frame) override
+    {
+        gl.glClearColor(0.5f, 0.6f, 0.8f, 1.0f);
+        gl.glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        gl.glMatrixMode(GL_MODELVIEW);
+        gl.glLoadIdentity();
+        const float pos = frame * 0.5f;
+        gl.gluLookAt(0.0f, pos - 4.0f, 6.0f, 0.0f, pos + 10.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+
+        gl.glEnable(GL_TEXTURE_2D);
+        gl.glDisableClientState(GL_NORMAL_ARRAY);
+        gl.glEnableClientState(GL_VERTEX_ARRAY);
+        gl.glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        gl.glVertexPointer(3, GL_FLOAT, 5 * sizeof(float), m_vertices.data());
+        gl.glTexCoordPointer(2, GL_FLOAT, 5 * sizeof(float), m_vertices.data() + 3);
+        for (uint32_t i = 0; i < BANDS; i++)
+        {
+            gl.glBindTexture(GL_TEXTURE_2D, (i & 0x1) ? m_iceTextureId : m_snowTextureId);
+            gl.glDrawElements(GL_TRIANGLES, m_indices[i].size(), GL_UNSIGNED_SHORT, m_indices[i].data());
+        }
+    }
+
+private:
+    static constexpr uint32_t GRID = 32;
+    static constexpr uint32_t BANDS = 4;
+    GLuint m_snowTextureId = 0;
+    GLuint m_iceTextureId = 0;
+    std::vector<float> m_vertices;
+    std::vector<std::vector<uint16_t>> m_indices;
+};
+
+// A 2D user interface drawn in immediate mode: Many small, blended quads
+class UiScene : public Scene
+{
+public:
+    virtual const char* name() const override { return "ui"; }
+
+    virtual void init(IceGL& gl) override
+    {
+        gl.glViewport(0, 0, RESOLUTION_W, RESOLUTION_H);
+        gl.glMatrixMode(GL_PROJECTION);
+        gl.glLoadIdentity();
+        gl.glOrthof(0.0f, RESOLUTION_W, 0.0f, RESOLUTION_H, -1.0f, 1.0f);
+        gl.glDisable(GL_DEPTH_TEST);
+        gl.glDisable(GL_LIGHTING);
+        gl.glDisable(GL_CULL_FACE);
+        gl.glDisable(GL_TEXTURE_2D);
+        gl.glEnable(GL_BLEND);
+        gl.glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    virtual void draw(IceGL& gl, const uint32_t frame) override
+    {
+        gl.glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        gl.glClear(GL_COLOR_BUFFER_BIT);
+        gl.glMatrixMode(GL_MODELVIEW);
+        gl.glLoadIdentity();
+        for (uint32_t y = 0; y < 12; y++)
+        {
+            for (uint32_t x = 0; x < 16; x++)
+            {
+                const float x0 = (x * 40.0f) + 2.0f + ((frame + y) % 8);
+                const float y0 = (y * 40.0f) + 2.0f;
+                gl.glBegin(GL_TRIANGLE_STRIP);
+                gl.glColor4f(x / 16.0f, y / 12.0f, 0.5f, 0.75f);
+                gl.glVertex2f(x0, y0);
+                gl.glVertex2f(x0 + 30.0f, y0);
+                gl.glVertex2f(x0, y0 + 30.0f);
+                gl.glVertex2f(x0 + 30.0f, y0 + 30.0f);
+                gl.glEnd();
+            }
+        }
+    }
+};
+
+static void printResult(const char* scene, const char* renderer, const uint32_t frames, const uint64_t geometryUs,
+                        const uint64_t uploadUs, const uint64_t simulationUs, const uint64_t bytes,
+                        const uint64_t cycles, const uint64_t stallCycles, const uint32_t eliminatedRegWrites,
+                        const uint32_t culledTriangles)
+{
+    const double f = (frames > 0) ? frames : 1;
+    printf("{\"scene\": \"%s\", \"renderer\": \"%s\", \"frames\": %u, \"geometry_us\": %.1f, \"upload_us\": %.1f, "
+           "\"simulation_us\": %.1f, \"bus_bytes\": %.1f, \"aclk_cycles\": %.1f, \"stall_cycles\": %.1f, "
+           "\"eliminated_reg_writes\": %.1f, \"culled_triangles\": %.1f}\n",
+           scene, renderer, frames, geometryUs / f, uploadUs / f, simulationUs / f, bytes / f, cycles / f,
+           stallCycles / f, eliminatedRegWrites / f, culledTriangles / f);
+    fflush(stdout);
+}
+
+static bool runScene(Scene& scene, const uint32_t frames, const char* recordFile, const bool simulate)
+{
+    // The objects are too big for the stack
+    std::unique_ptr<std::array<uint16_t, RESOLUTION_W * RESOLUTION_H>> framebuffer = std::make_unique<std::array<uint16_t, RESOLUTION_W * RESOLUTION_H>>();
+    std::unique_ptr<Simulation> simulation;
+    if (simulate)
+    {
+        simulation = std::make_unique<Simulation>(reinterpret_cast<uint64_t*>(framebuffer->data()), RESOLUTION_W, RESOLUTION_H);
+    }
+    TimedBusConnector timedBusConnector{simulation.get()};
+    TraceBusConnector busConnector{&timedBusConnector};
+    if (recordFile && !busConnector.startRecording(recordFile))
+    {
+        fprintf(stderr, "Can't create %s\n", recordFile);
+        return false;
+    }
+
+#ifdef RENDERER_BUCKETS
+    static constexpr const char* RENDERER_NAME = "RendererBuckets";
+    using RendererType = RendererBuckets<16384, DISPLAY_LINES, RESOLUTION_H / DISPLAY_LINES, 32>;
+#else
+    static constexpr const char* RENDERER_NAME = "Renderer";
+    using RendererType = Renderer<16384, DISPLAY_LINES, RESOLUTION_H / DISPLAY_LINES, 32>;
+#endif
+    std::unique_ptr<RendererType> renderer = std::make_unique<RendererType>(busConnector);
+    std::unique_ptr<IceGL> gl = std::make_unique<IceGL>(*renderer);
+
+    scene.init(*gl);
+    // The initialization (for instance the texture uploads) is not part of the measurement
+    if (simulation)
+    {
+        simulation->resetStatistics();
+    }
+    const uint32_t regWritesStart = renderer->getNumberOfEliminatedRegWrites();
+    const uint32_t culledTrianglesStart = gl->getNumberOfCulledTriangles();
+
+    uint64_t geometryUs = 0;
+    uint64_t commitUs = 0;
+    const uint64_t simulationUsStart = timedBusConnector.getUs();
+    const uint64_t bytesStart = busConnector.getBytes();
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        Clock::time_point start = Clock::now();
+        scene.draw(*gl, i);
+        geometryUs += elapsedUs(start);
+
+        start = Clock::now();
+        gl->commit();
+        commitUs += elapsedUs(start);
+        busConnector.endFrame();
+    }
+    if (simulation)
+    {
+        simulation->waitForIdle();
+    }
+
+    const uint64_t simulationUs = timedBusConnector.getUs() - simulationUsStart;
+    const uint64_t uploadUs = (commitUs > simulationUs) ? (commitUs - simulationUs) : 0;
+    const Simulation::Statistics statistics = simulation ? simulation->getStatistics() : Simulation::Statistics{};
+    printResult(scene.name(), RENDERER_NAME, frames, geometryUs, uploadUs, simulationUs, busConnector.getBytes() - bytesStart,
+                statistics.cycles, statistics.stallCycles, renderer->getNumberOfEliminatedRegWrites() - regWritesStart,
+                gl->getNumberOfCulledTriangles() - culledTrianglesStart);
+    return true;
+}
+
+#ifndef BENCHMARK_NO_VERILATOR
+static bool replayTrace(const char* traceFile)
+{
+    TraceReader reader;
+    if (!reader.open(traceFile))
+    {
+        fprintf(stderr, "%s is not a valid trace\n", traceFile);
+        return false;
+    }
+
+    std::unique_ptr<std::array<uint16_t, RESOLUTION_W * RESOLUTION_H>> framebuffer = std::make_unique<std::array<uint16_t, RESOLUTION_W * RESOLUTION_H>>();
+    std::unique_ptr<Simulation> simulation = std::make_unique<Simulation>(reinterpret_cast<uint64_t*>(framebuffer->data()), RESOLUTION_W, RESOLUTION_H);
+    TimedBusConnector timedBusConnector{simulation.get()};
+
+    uint32_t frames = 0;
+    while (reader.replayFrame(timedBusConnector))
+    {
+        frames++;
+    }
+    simulation->waitForIdle();
+
+    const Simulation::Statistics& statistics = simulation->getStatistics();
+    printResult(traceFile, "trace", frames, 0, 0, timedBusConnector.getUs(), statistics.bytes, statistics.cycles,
+                statistics.stallCycles, 0, 0);
+    return true;
+}
+#endif
+
+int main(int argc, char** argv)
+{
+#ifndef BENCHMARK_NO_VERILATOR
+    Verilated::commandArgs(argc, argv);
+#endif
+
+    const char* sceneName = nullptr;
+    const char* recordFile = nullptr;
+    const char* replayFile = nullptr;
+    uint32_t frames = 10;
+#ifdef BENCHMARK_NO_VERILATOR
+    bool simulate = false;
+#else
+    bool simulate = true;
+#endif
+    for (int i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "--scene") == 0) && ((i + 1) < argc))
+        {
+            sceneName = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--frames") == 0) && ((i + 1) < argc))
+        {
+            frames = atoi(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "--record") == 0) && ((i + 1) < argc))
+        {
+            recordFile = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--replay") == 0) && ((i + 1) < argc))
+        {
+            replayFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--no-sim") == 0)
+        {
+            simulate = false;
+        }
+        else if (argv[i][0] != '+') // Arguments with + are for Verilator
+        {
+            fprintf(stderr, "Usage: %s [--scene <cube|terrain|ui>] [--frames <n>] [--record <file>] [--no-sim]\n", argv[0]);
+            fprintf(stderr, "       %s --replay <file>\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (replayFile)
+    {
+#ifdef BENCHMARK_NO_VERILATOR
+        fprintf(stderr, "--replay requires the Verilator model (make benchmark)\n");
+        return 1;
+#else
+        return replayTrace(replayFile) ? 0 : 1;
+#endif
+    }
+
+    if (recordFile && !sceneName)
+    {
+        fprintf(stderr, "--record requires --scene\n");
+        return 1;
+    }
+
+    CubeScene cube;
+    TerrainScene terrain;
+    UiScene ui;
+    Scene* scenes[] = {&cube, &terrain, &ui};
+    bool found = false;
+    for (Scene* scene : scenes)
+    {
+        if (!sceneName || (strcmp(sceneName, scene->name()) == 0))
+        {
+            found = true;
+            if (!runScene(*scene, frames, recordFile, simulate))
+            {
+                return 1;
+            }
+        }
+    }
+    if (!found)
+    {
+        fprintf(stderr, "Unknown scene %s\n", sceneName);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,234 @@
+// RasteriCEr
+// https://github.com/ToNi3141/RasteriCEr
+// Copyright (c) 2021 ToNi3141
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef TRACEBUSCONNECTOR_HPP
+#define TRACEBUSCONNECTOR_HPP
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "IBusConnector.hpp"
+
+// Records the byte stream which the driver sends to the hardware into a trace file and forwards it to
+// another bus connector (optional). A trace can be replayed with TraceReader without the driver, which makes
+// the measurements of RTL changes reproducible.
+// Trace format (little endian):
+//   Header:  "RCTR" followed by the uint32_t VERSION
+//   Records: uint8_t type followed by the arguments of the record
+//     DATA:                  uint32_t number of bytes, followed by the bytes
+//     COLOR_BUFFER_TRANSFER: uint8_t index of the display line, followed by the IBusConnector::Window
+//     END_OF_FRAME:          no arguments
+class TraceBusConnector : public IBusConnector
+{
+public:
+    static constexpr uint32_t VERSION = 2;
+
+    enum RecordType : uint8_t
+    {
+        DATA,
+        COLOR_BUFFER_TRANSFER,
+        END_OF_FRAME
+    };
+
+    /// @brief Creates a connector
+    /// @param target The connector which receives the data. Can be nullptr if the data is only recorded or counted.
+    TraceBusConnector(IBusConnector* target = nullptr)
+        : m_target(target)
+    {
+    }
+
+    virtual ~TraceBusConnector()
+    {
+        stopRecording();
+    }
+
+    /// @brief Starts the recording into a file
+    /// @param fileName The name of the trace file
+    /// @return true if the file could be created
+    bool startRecording(const char* fileName)
+    {
+        stopRecording();
+        m_file = fopen(fileName, "wb");
+        if (!m_file)
+        {
+            return false;
+        }
+        fwrite("RCTR", 1, 4, m_file);
+        fwrite(&VERSION, sizeof(VERSION), 1, m_file);
+        return true;
+    }
+
+    void stopRecording()
+    {
+        if (m_file)
+        {
+            fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    /// @brief Marks the end of a frame in the trace. Must be called after the frame is uploaded.
+    void endFrame()
+    {
+        writeRecord(END_OF_FRAME);
+        m_frames++;
+    }
+
+    virtual void writeData(const uint8_t* data, const uint32_t bytes) override
+    {
+        if (writeRecord(DATA))
+        {
+            fwrite(&bytes, sizeof(bytes), 1, m_file);
+            fwrite(data, 1, bytes, m_file);
+        }
+        m_bytes += bytes;
+        if (m_target)
+        {
+            m_target->writeData(data, bytes);
+        }
+    }
+
+    virtual bool clearToSend() override
+    {
+        return m_target ? m_target->clearToSend() : true;
+    }
+
+    virtual void startColorBufferTransfer(const uint8_t index, const Window& window) override
+    {
+        if (writeRecord(COLOR_BUFFER_TRANSFER))
+        {
+            fwrite(&index, sizeof(index), 1, m_file);
+            fwrite(&window, sizeof(window), 1, m_file);
+        }
+        if (m_target)
+        {
+            m_target->startColorBufferTransfer(index, window);
+        }
+    }
+
+    /// @brief Number of bytes which were sent to the hardware
+    uint64_t getBytes() const { return m_bytes; }
+
+    /// @brief Number of frames which are marked with endFrame()
+    uint32_t getFrames() const { return m_frames; }
+
+private:
+    bool writeRecord(const RecordType type)
+    {
+        if (m_file)
+        {
+            fwrite(&type, sizeof(type), 1, m_file);
+            return true;
+        }
+        return false;
+    }
+
+    IBusConnector* m_target = nullptr;
+    FILE* m_file = nullptr;
+    uint64_t m_bytes = 0;
+    uint32_t m_frames = 0;
+};
+
+// Replays a trace which was recorded with the TraceBusConnector
+class TraceReader
+{
+public:
+    ~TraceReader()
+    {
+        if (m_file)
+        {
+            fclose(m_file);
+        }
+    }
+
+    /// @brief Opens a trace file
+    /// @param fileName The name of the trace file
+    /// @return true if the file is a valid trace
+    bool open(const char* fileName)
+    {
+        m_file = fopen(fileName, "rb");
+        if (!m_file)
+        {
+            return false;
+        }
+        char magic[4];
+        uint32_t version = 0;
+        return (fread(magic, 1, 4, m_file) == 4)
+            && (memcmp(magic, "RCTR", 4) == 0)
+            && (fread(&version, sizeof(version), 1, m_file) == 1)
+            && (version == TraceBusConnector::VERSION);
+    }
+
+    /// @brief Sends the next frame of the trace to a bus connector
+    /// @param busConnector The connector which receives the data
+    /// @return false if the trace has no more frames
+    bool replayFrame(IBusConnector& busConnector)
+    {
+        uint8_t type;
+        bool frameStarted = false;
+        while (fread(&type, sizeof(type), 1, m_file) == 1)
+        {
+            frameStarted = true;
+            switch (type)
+            {
+            case TraceBusConnector::DATA:
+            {
+                uint32_t bytes = 0;
+                if (fread(&bytes, sizeof(bytes), 1, m_file) != 1)
+                {
+                    return false;
+                }
+                // The bus connectors are reading the data as 32 bit words
+                m_buffer.resize((bytes + 3) / 4);
+                if (fread(m_buffer.data(), 1, bytes, m_file) != bytes)
+                {
+                    return false;
+                }
+                while (!busConnector.clearToSend())
+                    ;
+                busConnector.writeData(reinterpret_cast<const uint8_t*>(m_buffer.data()), bytes);
+            }
+                break;
+            case TraceBusConnector::COLOR_BUFFER_TRANSFER:
+            {
+                uint8_t index = 0;
+                IBusConnector::Window window {};
+                if ((fread(&index, sizeof(index), 1, m_file) != 1)
+                    || (fread(&window, sizeof(window), 1, m_file) != 1))
+                {
+                    return false;
+                }
+                busConnector.startColorBufferTransfer(index, window);
+            }
+                break;
+            case TraceBusConnector::END_OF_FRAME:
+                return true;
+            default:
+                // Corrupted trace
+                return false;
+            }
+        }
+        return frameStarted;
+    }
+
+private:
+    FILE* m_file = nullptr;
+    std::vector<uint32_t> m_buffer;
+};
+
+#endif // TRACEBUSCONNECTOR_HPP
@@ -9,6 +9,27 @@ template <typename FBType>
 class VerilatorBusConnector : public IBusConnector
 {
 public:
+    // Counters of the simulation since the last resetStatistics()
+    struct Statistics
+    {
+        uint64_t cycles = 0; // aclk cycles
+        uint64_t stallCycles = 0; // Cycles where data was available but s_cmd_axis_tready was low
+        uint64_t bytes = 0; // Bytes sent over the command stream
+    };
+
+    // Counters of the PerformanceCounters block of the RTL (see PERF_COUNTER_* in RegisterAndDescriptorDefines.vh)
+    enum PerformanceCounter : uint8_t
+    {
+        CYCLES,
+        CMD_WAIT_FOR_HOST,
+        CMD_WAIT_FOR_IDLE,
+        CMD_STREAM_STALL,
+        RASTERIZER_BUSY,
+        FRAGMENT_BUSY,
+        FRAGMENT_STALL,
+        FRAGMENTS
+    };
+
     virtual ~VerilatorBusConnector() = default;
 
     VerilatorBusConnector(FBType *framebuffer, const uint16_t resolutionW = 128, const uint16_t resolutionH = 128)
@@ -16,6 +37,8 @@ public:
     {
         m_top.m_framebuffer_axis_tready = 1;
         m_top.s_cmd_axis_tvalid = 0;
+        m_top.perfCounterClear = 0;
+        m_top.perfCounterSelect = 0;
 
         m_top.resetn = 0;
         clk();
@@ -30,7 +53,7 @@ public:
         const uint32_t *data32 = reinterpret_cast<const uint32_t*>(data);
         const uint32_t bytes32 = bytes / 4;
 
-        for (uint16_t i = 0; i < bytes32; )
+        for (uint32_t i = 0; i < bytes32; )
         {
             if (m_top.s_cmd_axis_tready)
             {
@@ -38,9 +61,14 @@ public:
                 m_top.s_cmd_axis_tvalid = 1;
                 i++;
             }
+            else
+            {
+                m_statistics.stallCycles++;
+            }
             clk();
         }
         m_top.s_cmd_axis_tvalid = 0;
+        m_statistics.bytes += bytes;
     }
 
     virtual bool clearToSend() override
@@ -48,12 +76,46 @@ public:
         return true;
     }
 
-    virtual void startColorBufferTransfer(const uint8_t) override
+    virtual void startColorBufferTransfer(const uint8_t, const Window&) override
+    {
+    }
+
+    /// @brief Clocks the model until the frame buffer stream was idle for a number of cycles. Use this after the last
+    /// chunk of a frame, to include the cycles which are required to finish the frame.
+    /// @param idleCycles The number of cycles without activity on the frame buffer stream
+    void waitForIdle(const uint32_t idleCycles = 1024)
+    {
+        uint32_t idle = 0;
+        while (idle < idleCycles)
+        {
+            clk();
+            idle = m_top.m_framebuffer_axis_tvalid ? 0 : (idle + 1);
+        }
+    }
+
+    const Statistics& getStatistics() const
     {
+        return m_statistics;
+    }
+
+    void resetStatistics()
+    {
+        m_statistics = {};
+    }
+
+    /// @brief Reads a counter of the performance counter register block. It takes one clock cycle.
+    /// @param counter The counter to read
+    /// @return The value of the counter (counts since the reset, it wraps around)
+    uint32_t readPerformanceCounter(const PerformanceCounter counter)
+    {
+        m_top.perfCounterSelect = counter;
+        clk();
+        return m_top.perfCounterValue;
     }
 
     void clk()
     {
+        m_statistics.cycles++;
         m_top.aclk = 1;
         m_top.eval();
         m_top.aclk = 0;
@@ -78,6 +140,7 @@ private:
     const uint16_t m_resolutionH = 128;
     FBType *m_framebuffer = nullptr;
     uint32_t m_streamAddr = 0;
+    Statistics m_statistics;
     Vtop m_top;
 };
 
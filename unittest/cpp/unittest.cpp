@@ -0,0 +1,317 @@
+// RasteriCEr
+// https://github.com/ToNi3141/RasteriCEr
+// Copyright (c) 2021 ToNi3141
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Host only tests of the driver. They don't require Verilator, the rendered images are checked with the
+// SoftwareRenderer and the uploads with a bus connector which records them. The Makefile builds the tests with and
+// without TNL_FIX_POINT and with RENDERER_DIRTY_WINDOW (make test).
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+#include <memory>
+#include "TnL.hpp"
+#include "IceGL.hpp"
+#include "SoftwareRenderer.hpp"
+#include "Renderer.hpp"
+#include "RendererBuckets.hpp"
+
+static uint32_t failures = 0;
+
+#define CHECK(cond) \
+    do \
+    { \
+        if (!(cond)) \
+        { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+static constexpr uint16_t RESOLUTION = 64;
+
+// Renders the triangles like the SoftwareRenderer and additionally keeps the vertices it receives from the TnL.
+// The color buffer starts white. Without a texture, the texel is zero, so the triangles are drawn black.
+class CaptureRenderer : public SoftwareRenderer<1, RESOLUTION>
+{
+public:
+    CaptureRenderer()
+        : SoftwareRenderer<1, RESOLUTION>(m_color.data(), m_depth.data(), RESOLUTION, 1)
+    {
+        m_color.fill(WHITE);
+        m_depth.fill(0);
+    }
+
+    virtual bool drawTriangle(const Vertex& v0,
+                              const Vertex& v1,
+                              const Vertex& v2,
+                              const TexCoord& st0,
+                              const TexCoord& st1,
+                              const TexCoord& st2,
+                              const Vec4i& color) override
+    {
+        vertices.push_back(v0);
+        vertices.push_back(v1);
+        vertices.push_back(v2);
+        texCoords.push_back(st0);
+        texCoords.push_back(st1);
+        texCoords.push_back(st2);
+        return SoftwareRenderer<1, RESOLUTION>::drawTriangle(v0, v1, v2, st0, st1, st2, color);
+    }
+
+    bool covered(const uint16_t x, const uint16_t y) const
+    {
+        return m_color[(y * RESOLUTION) + x] != WHITE;
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<TexCoord> texCoords;
+
+private:
+    static constexpr uint16_t WHITE = 0xffff;
+    std::array<uint16_t, RESOLUTION * RESOLUTION> m_color;
+    std::array<uint16_t, RESOLUTION * RESOLUTION> m_depth;
+};
+
+// Checks if a texture coordinate which is passed from the TnL to the renderer has the expected value. The fix point
+// TnL converts the float values into TNL_FIX_POINT_DECIMALS and might be off by one step.
+static bool isTexCoord(const IRenderer::TexCoord& st, const uint8_t index, const float expected)
+{
+#ifdef TNL_FIX_POINT
+    const float value = static_cast<float>(st[index]) / (1 << Rasterizer::TEX_COORD_DECIMALS);
+    return fabsf(value - expected) <= (1.0f / (1 << TNL_FIX_POINT_DECIMALS));
+#else
+    return st[index] == expected;
+#endif
+}
+
+static TnL::Triangle createTriangle(const Vec4& v0, const Vec4& v1, const Vec4& v2)
+{
+    TnL::Triangle triangle;
+    triangle.v0 = v0;
+    triangle.v1 = v1;
+    triangle.v2 = v2;
+    triangle.st0 = Vec2{{0.0f, 0.0f}};
+    triangle.st1 = Vec2{{0.0f, 0.0f}};
+    triangle.st2 = Vec2{{0.0f, 0.0f}};
+    triangle.n0 = Vec3{{0.0f, 0.0f, 1.0f}};
+    triangle.n1 = Vec3{{0.0f, 0.0f, 1.0f}};
+    triangle.n2 = Vec3{{0.0f, 0.0f, 1.0f}};
+    triangle.color0 = Vec4i{{255, 255, 255, 255}};
+    triangle.color1 = Vec4i{{255, 255, 255, 255}};
+    triangle.color2 = Vec4i{{255, 255, 255, 255}};
+    return triangle;
+}
+
+// A triangle which leaves the viewport on the left side, but stays in the guard band, is not clipped. The rasterizer
+// discards the pixels outside of the viewport.
+static void testGuardBand()
+{
+    TnL tnl;
+    CaptureRenderer renderer;
+    tnl.setViewport(0, 0, RESOLUTION, RESOLUTION);
+
+    // In screen coordinates: (-16, 32), (64, 0), (64, 64)
+    CHECK(tnl.drawTriangle(renderer, createTriangle({{-1.5f, 0.0f, 0.0f, 1.0f}}, {{1.0f, -1.0f, 0.0f, 1.0f}}, {{1.0f, 1.0f, 0.0f, 1.0f}})));
+    renderer.commit();
+
+    CHECK(TnL::GUARD_BAND > 1.0f);
+    CHECK(renderer.vertices.size() == 3);
+    CHECK((renderer.vertices.size() == 3) && (renderer.vertices[0][0] < 0));
+    // The triangle covers the left edge only in the middle
+    CHECK(renderer.covered(0, RESOLUTION / 2));
+    CHECK(renderer.covered(RESOLUTION - 1, RESOLUTION / 2));
+    CHECK(!renderer.covered(0, 0));
+    CHECK(!renderer.covered(0, RESOLUTION - 1));
+}
+
+// Negative texture coordinates are passed unchanged to the renderer. The fix point TnL converts them into the format
+// of the rasterizer, which must not shift negative values (see UBSan).
+static void testNegativeTexCoords()
+{
+    TnL tnl;
+    CaptureRenderer renderer;
+    tnl.setViewport(0, 0, RESOLUTION, RESOLUTION);
+
+    TnL::Triangle triangle = createTriangle({{-0.5f, -0.5f, 0.0f, 1.0f}}, {{0.5f, -0.5f, 0.0f, 1.0f}}, {{0.5f, 0.5f, 0.0f, 1.0f}});
+    triangle.st0 = Vec2{{-1.5f, -0.25f}};
+    triangle.st1 = Vec2{{0.5f, -2.0f}};
+    triangle.st2 = Vec2{{-0.125f, 3.0f}};
+    CHECK(tnl.drawTriangle(renderer, triangle));
+
+    CHECK(renderer.texCoords.size() == 3);
+    if (renderer.texCoords.size() == 3)
+    {
+        CHECK(isTexCoord(renderer.texCoords[0], 0, -1.5f));
+        CHECK(isTexCoord(renderer.texCoords[0], 1, -0.25f));
+        CHECK(isTexCoord(renderer.texCoords[1], 0, 0.5f));
+        CHECK(isTexCoord(renderer.texCoords[1], 1, -2.0f));
+        CHECK(isTexCoord(renderer.texCoords[2], 0, -0.125f));
+        CHECK(isTexCoord(renderer.texCoords[2], 1, 3.0f));
+    }
+}
+
+// Draws the same indexed client arrays directly and from a compiled display list. The compiled list copies the
+// vertices, therefore both must result in the same triangles, also when the arrays are changed after the compilation.
+template <typename TIndex>
+static void testCompiledIndexedArrays(const GLenum indexType)
+{
+    const int16_t vertices[] = { -20, -20,   20, -20,   20, 20,   -20, 20 };
+    const GLfloat texCoords[] = { 0.0f, 0.0f,   1.0f, 0.0f,   1.0f, 1.0f,   0.0f, 1.0f };
+    const TIndex indices[] = { 0, 1, 2,   2, 3, 0 };
+
+    CaptureRenderer direct;
+    CaptureRenderer compiled;
+    IceGL glDirect{direct};
+    IceGL glCompiled{compiled};
+    for (IceGL* gl : { &glDirect, &glCompiled })
+    {
+        gl->glViewport(0, 0, RESOLUTION, RESOLUTION);
+        gl->glMatrixMode(GL_PROJECTION);
+        gl->glLoadIdentity();
+        gl->glMatrixMode(GL_MODELVIEW);
+        gl->glLoadIdentity();
+        gl->glScalef(1.0f / 32.0f, 1.0f / 32.0f, 1.0f);
+        gl->glEnableClientState(GL_VERTEX_ARRAY);
+        gl->glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        gl->glVertexPointer(2, GL_SHORT, 0, vertices);
+        gl->glTexCoordPointer(2, GL_FLOAT, 0, texCoords);
+    }
+
+    const GLuint list = glCompiled.glGenLists(1);
+    glCompiled.glNewList(list, GL_COMPILE);
+    glCompiled.glDrawElements(GL_TRIANGLES, 6, indexType, indices);
+    glCompiled.glEndList();
+    // The list must not reference the client arrays
+    const int16_t otherVertices[] = { 0, 0,   0, 0,   0, 0,   0, 0 };
+    glCompiled.glVertexPointer(2, GL_SHORT, 0, otherVertices);
+    CHECK(compiled.vertices.empty());
+    glCompiled.glCallList(list);
+
+    glDirect.glDrawElements(GL_TRIANGLES, 6, indexType, indices);
+
+    CHECK(direct.vertices.size() == 6);
+    CHECK(direct.vertices.size() == compiled.vertices.size());
+    if (direct.vertices.size() == compiled.vertices.size())
+    {
+        for (uint32_t i = 0; i < direct.vertices.size(); i++)
+        {
+            CHECK(direct.vertices[i] == compiled.vertices[i]);
+            CHECK(direct.texCoords[i] == compiled.texCoords[i]);
+        }
+    }
+}
+
+#ifdef RENDERER_DIRTY_WINDOW
+// Discards the uploaded data and records the windows of the committed display lines
+class WindowBusConnector : public IBusConnector
+{
+public:
+    virtual void writeData(const uint8_t*, const uint32_t) override {}
+    virtual bool clearToSend() override { return true; }
+    virtual void startColorBufferTransfer(const uint8_t index, const Window& window) override
+    {
+        indices.push_back(index);
+        windows.push_back(window);
+    }
+
+    std::vector<uint8_t> indices;
+    std::vector<Window> windows;
+};
+
+static bool isWindow(const IBusConnector::Window& window, const IBusConnector::Window& expected)
+{
+    return (window.xStart == expected.xStart) && (window.xEnd == expected.xEnd)
+        && (window.yStart == expected.yStart) && (window.yEnd == expected.yEnd);
+}
+
+// Renders a small triangle in the upper half of the screen without a clear of the color buffer. The second commit
+// waits until the first frame is uploaded.
+template <typename TRenderer>
+static void renderWithoutClear(TRenderer& renderer)
+{
+    TnL tnl;
+    tnl.setViewport(0, 0, RESOLUTION, RESOLUTION);
+    // In screen coordinates: (32, 40), (48, 40), (32, 56)
+    CHECK(tnl.drawTriangle(renderer, createTriangle({{0.0f, 0.25f, 0.0f, 1.0f}}, {{0.5f, 0.25f, 0.0f, 1.0f}}, {{0.0f, 0.75f, 0.0f, 1.0f}})));
+    renderer.commit();
+    renderer.commit();
+}
+
+// With two display lines, the frame buffer of the hardware contains the other display line when the color buffer is
+// not cleared. Both display lines must be committed completely, also the one without a triangle.
+template <typename TRenderer>
+static void testDirtyWindowTwoLines()
+{
+    WindowBusConnector busConnector;
+    std::unique_ptr<TRenderer> renderer = std::make_unique<TRenderer>(busConnector);
+    renderWithoutClear(*renderer);
+
+    CHECK(busConnector.windows.size() >= 2);
+    if (busConnector.windows.size() >= 2)
+    {
+        // The display lines are uploaded in reverse order
+        CHECK(busConnector.indices[0] == 1);
+        CHECK(busConnector.indices[1] == 0);
+        CHECK(isWindow(busConnector.windows[0], DirtyWindow<RESOLUTION / 2>::FULL_LINE));
+        CHECK(isWindow(busConnector.windows[1], DirtyWindow<RESOLUTION / 2>::FULL_LINE));
+    }
+}
+
+// With one display line, only the bounding box of the triangle is committed
+template <typename TRenderer>
+static void testDirtyWindowOneLine()
+{
+    WindowBusConnector busConnector;
+    std::unique_ptr<TRenderer> renderer = std::make_unique<TRenderer>(busConnector);
+    renderWithoutClear(*renderer);
+
+    CHECK(busConnector.windows.size() >= 1);
+    if (busConnector.windows.size() >= 1)
+    {
+        const IBusConnector::Window& window = busConnector.windows[0];
+        CHECK(window.xStart >= RESOLUTION / 2);
+        CHECK(window.xEnd < RESOLUTION);
+        // The window is upside down: The upper half of the screen is at the start
+        CHECK(window.yStart >= RESOLUTION / 8);
+        CHECK(window.yEnd < RESOLUTION / 2);
+    }
+}
+#endif
+
+int main()
+{
+    testGuardBand();
+    testNegativeTexCoords();
+    testCompiledIndexedArrays<uint8_t>(GL_UNSIGNED_BYTE);
+    testCompiledIndexedArrays<uint16_t>(GL_UNSIGNED_SHORT);
+    testCompiledIndexedArrays<uint32_t>(GL_UNSIGNED_INT);
+#ifdef RENDERER_DIRTY_WINDOW
+    testDirtyWindowTwoLines<Renderer<4096, 2, RESOLUTION / 2>>();
+    testDirtyWindowTwoLines<RendererBuckets<4096, 2, RESOLUTION / 2>>();
+    testDirtyWindowOneLine<Renderer<4096, 1, RESOLUTION>>();
+    testDirtyWindowOneLine<RendererBuckets<4096, 1, RESOLUTION>>();
+#endif
+
+    if (failures)
+    {
+        fprintf(stderr, "%u checks failed\n", failures);
+        return 1;
+    }
+    printf("All tests passed\n");
+    return 0;
+}
@@ -6,9 +6,13 @@
 #include <QTimer>
 #include "IceGL.hpp"
 #include "Renderer.hpp"
+#include "RendererBuckets.hpp"
 #include "VerilatorBusConnector.hpp"
+#ifdef RENDERER_THREADED
+#include "RendererUploadThread.hpp"
+#endif
 #ifdef SOFTWARE_RENDERER
-#include "softwarerenderer.h"
+#include "SoftwareRenderer.hpp"
 #endif
 
 namespace Ui {
@@ -34,10 +38,17 @@ private:
 
 #ifdef SOFTWARE_RENDERER
     uint16_t m_zbuffer[RESOLUTION_W*RESOLUTION_H];
-    SoftwareRenderer m_renderer{m_framebuffer, m_zbuffer, RESOLUTION_W, RESOLUTION_H};
+    SoftwareRenderer<4, RESOLUTION_H / 4> m_renderer{m_framebuffer, m_zbuffer, RESOLUTION_W};
 #else
     VerilatorBusConnector<uint64_t> m_busConnector{reinterpret_cast<uint64_t*>(m_framebuffer), RESOLUTION_W, RESOLUTION_H};
+#ifdef RENDERER_BUCKETS
+    RendererBuckets<16384, 4, RESOLUTION_H / 4, 32> m_renderer{m_busConnector};
+#else
     Renderer<16384, 4, RESOLUTION_H / 4, 32> m_renderer{m_busConnector};
+#ifdef RENDERER_THREADED
+    RendererUploadThread<decltype(m_renderer)> m_uploadThread{m_renderer};
+#endif
+#endif
 #endif
     IceGL m_ogl{m_renderer};
 
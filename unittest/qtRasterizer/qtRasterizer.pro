@@ -14,7 +14,12 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 #DEFINES += NO_PERSP_CORRECT
 #DEFINES += NO_ZBUFFER
 DEFINES += HARDWARE_RENDERER
+#DEFINES += RENDERER_BUCKETS
 #DEFINES += SOFTWARE_RENDERER
+#DEFINES += RENDERER_THREADED
+#DEFINES += RENDERER_FRONT_TO_BACK
+#DEFINES += RENDERER_DIRTY_WINDOW
+#DEFINES += ICEGL_STATISTICS
 
 TARGET = qtRasterizer
 TEMPLATE = app
@@ -29,12 +34,21 @@ SOURCES += main.cpp\
     $${VERILATOR_PATH}/include/verilated.cpp
 
 HEADERS  += mainwindow.h\
+    $${ICEGL_PATH}/DirtyWindow.hpp \
     $${ICEGL_PATH}/DisplayList.hpp \
     $${ICEGL_PATH}/IBusConnector.hpp \
     $${ICEGL_PATH}/IRenderer.hpp \
     $${ICEGL_PATH}/IceGLTypes.h \
     $${ICEGL_PATH}/IceGLWrapper.h \
     $${ICEGL_PATH}/Renderer.hpp \
+    $${ICEGL_PATH}/RendererBase.hpp \
+    $${ICEGL_PATH}/RendererBuckets.hpp \
+    $${ICEGL_PATH}/RendererUploadThread.hpp \
+    $${ICEGL_PATH}/SoftwareRenderer.hpp \
+    $${ICEGL_PATH}/Statistics.hpp \
+    $${ICEGL_PATH}/TextureResidency.hpp \
+    $${ICEGL_PATH}/TextureStore.hpp \
+    $${ICEGL_PATH}/ThreadPool.hpp \
     $${ICEGL_PATH}/TnL.hpp \
     $${ICEGL_PATH}/Vec.hpp \
     $${ICEGL_PATH}/Veci.hpp \